@@ -48,6 +48,19 @@ AS_IF([test "x$enable_panic_dumplog" = xyes],
 	[AC_DEFINE(LNET_DUMP_ON_PANIC, 1, [use dumplog on panic])])
 ]) # LIBCFS_CONFIG_PANIC_DUMPLOG
 
+#
+# LIBCFS_BINARY_PRINTF
+#
+# Kernel 2.6.30 added vbin_printf()/bstr_printf() under
+# CONFIG_BINARY_PRINTF, used to record debug messages with
+# deferred formatting.
+#
+AC_DEFUN([LIBCFS_BINARY_PRINTF], [
+LB_CHECK_CONFIG([BINARY_PRINTF],
+	[AC_DEFINE(HAVE_BINARY_PRINTF, 1,
+		[kernel has vbin_printf() and bstr_printf()])])
+]) # LIBCFS_BINARY_PRINTF
+
 #
 # LIBCFS_STACKTRACE_OPS_HAVE_WALK_STACK
 #
@@ -1268,6 +1281,8 @@ AC_MSG_NOTICE([LibCFS kernel checks
 ==============================================================================])
 LIBCFS_CONFIG_PANIC_DUMPLOG
 
+# 2.6.30
+LIBCFS_BINARY_PRINTF
 # 2.6.32
 LIBCFS_STACKTRACE_OPS_HAVE_WALK_STACK
 LC_SHRINKER_WANT_SHRINK_PTR
@@ -51,6 +51,7 @@
 #include <libcfs/libcfs_workitem.h>
 #include <libcfs/libcfs_hash.h>
 #include <libcfs/libcfs_heap.h>
+#include <libcfs/libcfs_calq.h>
 #include <libcfs/libcfs_fail.h>
 #include "curproc.h"
 
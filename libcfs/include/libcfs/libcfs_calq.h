@@ -0,0 +1,160 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License version 2 for more details.  A copy is
+ * included in the COPYING file that accompanied this code.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * GPL HEADER END
+ */
+/*
+ * libcfs/include/libcfs/libcfs_calq.h
+ */
+
+#ifndef __LIBCFS_CALQ_H__
+#define __LIBCFS_CALQ_H__
+
+/** \defgroup calq Calendar queue
+ *
+ * A calendar queue keeps a set of elements ordered by a 64-bit key. Like a
+ * desk calendar, it is an array of "days", each one a sorted list holding the
+ * elements whose key falls in a cq_width wide range; the array wraps around
+ * every "year" of cq_nbuckets days. The smallest element is found by walking
+ * the days from the current one, skipping elements that belong to a later
+ * year.
+ *
+ * When keys are inserted in roughly increasing order, and the width of a day
+ * is close to the average distance between keys, insertion, removal and
+ * lookup of the smallest element all take O(1) time, compared to O(log n)
+ * for a \ref heap. Unless CFS_CALQ_FLAG_FIXED is set, the number of days and
+ * their width are adjusted as the queue grows and shrinks.
+ *
+ * Elements with equal keys are ordered by cfs_calq_ops::cqo_compare(), or in
+ * FIFO order if it is not provided.
+ *
+ * As for the binary heap, no locking is done here, and instances are tied to
+ * a specific CPT.
+ * @{
+ */
+
+/**
+ * Calendar queue node.
+ *
+ * Objects of this type are embedded into objects of the ordered set that is to
+ * be maintained by a \e struct cfs_calq instance.
+ */
+struct cfs_calq_node {
+	/** Linkage into a day of the calendar, sorted by key */
+	struct list_head	cqn_link;
+	/** Ordering key */
+	__u64			cqn_key;
+};
+
+/**
+ * Calendar queue flags.
+ */
+enum {
+	/** Days may be reallocated in atomic context */
+	CFS_CALQ_FLAG_ATOMIC_GROW	= 1,
+	/** Never change the number of days nor their width */
+	CFS_CALQ_FLAG_FIXED		= 2,
+};
+
+#define CFS_CALQ_MIN_BUCKETS	16
+
+/**
+ * Calendar queue operations.
+ */
+struct cfs_calq_ops {
+	/**
+	 * A binary predicate ordering two nodes with equal keys.
+	 *
+	 * Implementing this operation is optional.
+	 *
+	 * \param[in] a The first node
+	 * \param[in] b The second node
+	 *
+	 * \retval 0 Node a > node b
+	 * \retval 1 Node a < node b
+	 */
+	int		(*cqo_compare)(struct cfs_calq_node *a,
+				       struct cfs_calq_node *b);
+};
+
+/**
+ * Calendar queue object.
+ *
+ * Sorts elements of type \e struct cfs_calq_node
+ */
+struct cfs_calq {
+	/** Days of the calendar, in chunks of a page */
+	struct list_head      **cq_days;
+	/** # days in a year, a power of two */
+	unsigned int		cq_nbuckets;
+	/** Key range covered by a day */
+	__u64			cq_width;
+	/** # elements queued */
+	unsigned int		cq_nelements;
+	/** Current day */
+	unsigned int		cq_cur;
+	/** Key ending the current day */
+	__u64			cq_top;
+	/** User flags */
+	unsigned int		cq_flags;
+	/** Operations table */
+	struct cfs_calq_ops    *cq_ops;
+	/** Private data */
+	void		       *cq_private;
+	/** Associated CPT table */
+	struct cfs_cpt_table   *cq_cptab;
+	/** Associated CPT id of this struct cfs_calq::cq_cptab */
+	int			cq_cptid;
+};
+
+struct cfs_calq *
+cfs_calq_create(struct cfs_calq_ops *ops, unsigned int flags,
+		unsigned int nbuckets, __u64 width, void *arg,
+		struct cfs_cpt_table *cptab, int cptid);
+void cfs_calq_destroy(struct cfs_calq *q);
+void cfs_calq_insert(struct cfs_calq *q, struct cfs_calq_node *e);
+void cfs_calq_remove(struct cfs_calq *q, struct cfs_calq_node *e);
+void cfs_calq_relocate(struct cfs_calq *q, struct cfs_calq_node *e);
+struct cfs_calq_node *cfs_calq_first(struct cfs_calq *q);
+
+static inline int
+cfs_calq_size(struct cfs_calq *q)
+{
+	return q->cq_nelements;
+}
+
+static inline int
+cfs_calq_is_empty(struct cfs_calq *q)
+{
+	return q->cq_nelements == 0;
+}
+
+static inline struct cfs_calq_node *
+cfs_calq_remove_first(struct cfs_calq *q)
+{
+	struct cfs_calq_node *e = cfs_calq_first(q);
+
+	if (e != NULL)
+		cfs_calq_remove(q, e);
+	return e;
+}
+
+/** @} calq */
+
+#endif /* __LIBCFS_CALQ_H__ */
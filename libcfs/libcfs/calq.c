@@ -0,0 +1,396 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License version 2 for more details.  A copy is
+ * included in the COPYING file that accompanied this code.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * GPL HEADER END
+ */
+/*
+ * libcfs/libcfs/calq.c
+ *
+ * Calendar queue, see R. Brown, "Calendar Queues: A Fast O(1) Priority Queue
+ * Implementation for the Simulation Event Set Problem", CACM 31(10), 1988.
+ */
+/** \addtogroup calq
+ *
+ * @{
+ */
+
+#define DEBUG_SUBSYSTEM S_LNET
+
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <libcfs/libcfs.h>
+
+/* days are allocated by pages, so that growing never needs vmalloc() */
+#define CFS_CALQ_CHUNK		(PAGE_SIZE / sizeof(struct list_head))
+#define CFS_CALQ_MAX_BUCKETS	(LIBCFS_VMALLOC_SIZE /			\
+				 sizeof(struct list_head *) * CFS_CALQ_CHUNK)
+
+#define CFS_CALQ_ALLOC(ptr, q, size)					\
+do {									\
+	if ((q)->cq_cptab) {						\
+		if ((q)->cq_flags & CFS_CALQ_FLAG_ATOMIC_GROW)		\
+			LIBCFS_CPT_ALLOC_GFP((ptr), (q)->cq_cptab,	\
+					     (q)->cq_cptid, (size),	\
+					     GFP_ATOMIC);		\
+		else							\
+			LIBCFS_CPT_ALLOC((ptr), (q)->cq_cptab,		\
+					 (q)->cq_cptid, (size));	\
+	} else {							\
+		if ((q)->cq_flags & CFS_CALQ_FLAG_ATOMIC_GROW)		\
+			LIBCFS_ALLOC_ATOMIC((ptr), (size));		\
+		else							\
+			LIBCFS_ALLOC((ptr), (size));			\
+	}								\
+} while (0)
+
+static inline unsigned int cfs_calq_per_chunk(unsigned int nbuckets)
+{
+	return min_t(unsigned int, nbuckets, CFS_CALQ_CHUNK);
+}
+
+static inline struct list_head *
+cfs_calq_bucket(struct list_head **days, unsigned int idx)
+{
+	return &days[idx / CFS_CALQ_CHUNK][idx % CFS_CALQ_CHUNK];
+}
+
+static void cfs_calq_days_free(struct list_head **days, unsigned int nbuckets)
+{
+	unsigned int per_chunk = cfs_calq_per_chunk(nbuckets);
+	unsigned int nchunks = nbuckets / per_chunk;
+	unsigned int i;
+
+	for (i = 0; i < nchunks && days[i] != NULL; i++)
+		LIBCFS_FREE(days[i], per_chunk * sizeof(**days));
+
+	LIBCFS_FREE(days, nchunks * sizeof(*days));
+}
+
+static struct list_head **
+cfs_calq_days_alloc(struct cfs_calq *q, unsigned int nbuckets)
+{
+	unsigned int per_chunk = cfs_calq_per_chunk(nbuckets);
+	unsigned int nchunks = nbuckets / per_chunk;
+	struct list_head **days;
+	unsigned int i;
+	unsigned int j;
+
+	CFS_CALQ_ALLOC(days, q, nchunks * sizeof(*days));
+	if (days == NULL)
+		return NULL;
+
+	for (i = 0; i < nchunks; i++) {
+		CFS_CALQ_ALLOC(days[i], q, per_chunk * sizeof(**days));
+		if (days[i] == NULL) {
+			cfs_calq_days_free(days, nbuckets);
+			return NULL;
+		}
+
+		for (j = 0; j < per_chunk; j++)
+			INIT_LIST_HEAD(&days[i][j]);
+	}
+
+	return days;
+}
+
+static inline unsigned int cfs_calq_index(struct cfs_calq *q, __u64 key)
+{
+	return div64_u64(key, q->cq_width) & (q->cq_nbuckets - 1);
+}
+
+/**
+ * Moves the cursor to the day of \a key.
+ */
+static void cfs_calq_set_cursor(struct cfs_calq *q, __u64 key)
+{
+	__u64 day = div64_u64(key, q->cq_width);
+
+	q->cq_cur = day & (q->cq_nbuckets - 1);
+	q->cq_top = (day + 1) * q->cq_width;
+}
+
+static inline bool cfs_calq_before(struct cfs_calq *q,
+				   struct cfs_calq_node *a,
+				   struct cfs_calq_node *b)
+{
+	if (a->cqn_key != b->cqn_key)
+		return a->cqn_key < b->cqn_key;
+
+	return q->cq_ops->cqo_compare != NULL &&
+	       q->cq_ops->cqo_compare(a, b);
+}
+
+/**
+ * Sort-adds \a e to its day. Keys mostly arrive in increasing order, so the
+ * day is searched backwards.
+ */
+static void cfs_calq_enqueue(struct cfs_calq *q, struct cfs_calq_node *e)
+{
+	struct list_head *head;
+	struct cfs_calq_node *pos;
+
+	head = cfs_calq_bucket(q->cq_days, cfs_calq_index(q, e->cqn_key));
+	list_for_each_entry_reverse(pos, head, cqn_link) {
+		if (!cfs_calq_before(q, e, pos))
+			break;
+	}
+	/* if no smaller node was found, \a pos is the head */
+	list_add(&e->cqn_link, &pos->cqn_link);
+}
+
+/**
+ * Rebuilds the calendar with \a nbuckets days, whose width is re-estimated as
+ * three times the average distance between queued keys. On allocation failure
+ * the current calendar is kept; it is only slower.
+ *
+ * \param[in] q	       The calendar queue
+ * \param[in] nbuckets The new number of days
+ */
+static void cfs_calq_resize(struct cfs_calq *q, unsigned int nbuckets)
+{
+	struct list_head **old_days = q->cq_days;
+	unsigned int old_nbuckets = q->cq_nbuckets;
+	struct list_head **days;
+	struct cfs_calq_node *e;
+	struct cfs_calq_node *tmp;
+	struct list_head *head;
+	__u64 min_key = U64_MAX;
+	__u64 max_key = 0;
+	unsigned int i;
+
+	days = cfs_calq_days_alloc(q, nbuckets);
+	if (days == NULL)
+		return;
+
+	for (i = 0; i < old_nbuckets; i++) {
+		head = cfs_calq_bucket(old_days, i);
+		if (list_empty(head))
+			continue;
+
+		e = list_entry(head->next, struct cfs_calq_node, cqn_link);
+		min_key = min(min_key, e->cqn_key);
+		e = list_entry(head->prev, struct cfs_calq_node, cqn_link);
+		max_key = max(max_key, e->cqn_key);
+	}
+
+	if (q->cq_nelements > 1 && max_key > min_key)
+		q->cq_width = max_t(__u64, 3 * div64_u64(max_key - min_key,
+							 q->cq_nelements), 1);
+
+	q->cq_days = days;
+	q->cq_nbuckets = nbuckets;
+
+	for (i = 0; i < old_nbuckets; i++) {
+		head = cfs_calq_bucket(old_days, i);
+		list_for_each_entry_safe(e, tmp, head, cqn_link) {
+			list_del(&e->cqn_link);
+			cfs_calq_enqueue(q, e);
+		}
+	}
+
+	cfs_calq_days_free(old_days, old_nbuckets);
+
+	if (q->cq_nelements > 0)
+		cfs_calq_set_cursor(q, min_key);
+}
+
+/**
+ * Creates and initializes a calendar queue instance.
+ *
+ * \param[in] ops      The operations to be used
+ * \param[in] flags    The calendar queue flags
+ * \param[in] nbuckets The initial number of days, rounded up to a power of two
+ * \param[in] width    The initial key range covered by a day
+ * \param[in] arg      An optional private argument
+ * \param[in] cptab    The CPT table this instance will operate over
+ * \param[in] cptid    The CPT id of \a cptab this instance will operate over
+ *
+ * \retval valid-pointer A newly-created and initialized calendar queue
+ * \retval NULL		 error
+ */
+struct cfs_calq *
+cfs_calq_create(struct cfs_calq_ops *ops, unsigned int flags,
+		unsigned int nbuckets, __u64 width, void *arg,
+		struct cfs_cpt_table *cptab, int cptid)
+{
+	struct cfs_calq *q;
+
+	LASSERT(ops != NULL);
+	LASSERT(width > 0);
+	if (cptab) {
+		LASSERT(cptid == CFS_CPT_ANY ||
+		       (cptid >= 0 && cptid < cptab->ctb_nparts));
+		LIBCFS_CPT_ALLOC(q, cptab, cptid, sizeof(*q));
+	} else {
+		LIBCFS_ALLOC(q, sizeof(*q));
+	}
+	if (!q)
+		return NULL;
+
+	nbuckets = clamp_t(unsigned int, nbuckets, CFS_CALQ_MIN_BUCKETS,
+			   CFS_CALQ_MAX_BUCKETS);
+
+	q->cq_ops	= ops;
+	q->cq_nbuckets	= roundup_pow_of_two(nbuckets);
+	q->cq_width	= width;
+	q->cq_nelements	= 0;
+	q->cq_private	= arg;
+	q->cq_flags	= flags & (~CFS_CALQ_FLAG_ATOMIC_GROW);
+	q->cq_cptab	= cptab;
+	q->cq_cptid	= cptid;
+	cfs_calq_set_cursor(q, 0);
+
+	q->cq_days = cfs_calq_days_alloc(q, q->cq_nbuckets);
+	if (q->cq_days == NULL) {
+		LIBCFS_FREE(q, sizeof(*q));
+		return NULL;
+	}
+
+	q->cq_flags |= flags & CFS_CALQ_FLAG_ATOMIC_GROW;
+
+	return q;
+}
+EXPORT_SYMBOL(cfs_calq_create);
+
+/**
+ * Releases all resources associated with a calendar queue instance.
+ *
+ * \param[in] q The calendar queue object
+ */
+void
+cfs_calq_destroy(struct cfs_calq *q)
+{
+	LASSERT(q != NULL);
+
+	cfs_calq_days_free(q->cq_days, q->cq_nbuckets);
+	LIBCFS_FREE(q, sizeof(*q));
+}
+EXPORT_SYMBOL(cfs_calq_destroy);
+
+/**
+ * Inserts a node into the calendar queue.
+ *
+ * \param[in] q The calendar queue
+ * \param[in] e The node to insert, with its key set
+ */
+void
+cfs_calq_insert(struct cfs_calq *q, struct cfs_calq_node *e)
+{
+	cfs_calq_enqueue(q, e);
+
+	/* the cursor must not be past any queued key */
+	if (++q->cq_nelements == 1 ||
+	    e->cqn_key < q->cq_top - q->cq_width)
+		cfs_calq_set_cursor(q, e->cqn_key);
+
+	if (!(q->cq_flags & CFS_CALQ_FLAG_FIXED) &&
+	    q->cq_nelements > 2 * q->cq_nbuckets &&
+	    q->cq_nbuckets < CFS_CALQ_MAX_BUCKETS)
+		cfs_calq_resize(q, q->cq_nbuckets << 1);
+}
+EXPORT_SYMBOL(cfs_calq_insert);
+
+/**
+ * Removes a node from the calendar queue.
+ *
+ * \param[in] q The calendar queue
+ * \param[in] e The node
+ */
+void
+cfs_calq_remove(struct cfs_calq *q, struct cfs_calq_node *e)
+{
+	LASSERT(q->cq_nelements > 0);
+
+	list_del_init(&e->cqn_link);
+	q->cq_nelements--;
+
+	if (!(q->cq_flags & CFS_CALQ_FLAG_FIXED) &&
+	    q->cq_nelements < q->cq_nbuckets / 2 &&
+	    q->cq_nbuckets > CFS_CALQ_MIN_BUCKETS)
+		cfs_calq_resize(q, q->cq_nbuckets >> 1);
+}
+EXPORT_SYMBOL(cfs_calq_remove);
+
+/**
+ * Moves a node to its new position after its key was changed.
+ *
+ * \param[in] q The calendar queue
+ * \param[in] e The node
+ */
+void
+cfs_calq_relocate(struct cfs_calq *q, struct cfs_calq_node *e)
+{
+	LASSERT(q->cq_nelements > 0);
+
+	list_del(&e->cqn_link);
+	q->cq_nelements--;
+	cfs_calq_insert(q, e);
+}
+EXPORT_SYMBOL(cfs_calq_relocate);
+
+/**
+ * Obtains the node with the smallest key, advancing the cursor over empty
+ * days. If a whole year goes by without finding it, the queue is sparse and
+ * the first node of each day is examined instead.
+ *
+ * \param[in] q The calendar queue
+ *
+ * \retval valid-pointer The node with the smallest key
+ * \retval NULL		 The queue is empty
+ */
+struct cfs_calq_node *
+cfs_calq_first(struct cfs_calq *q)
+{
+	struct cfs_calq_node *first = NULL;
+	struct cfs_calq_node *e;
+	struct list_head *head;
+	unsigned int i;
+
+	if (q->cq_nelements == 0)
+		return NULL;
+
+	for (i = 0; i < q->cq_nbuckets; i++) {
+		head = cfs_calq_bucket(q->cq_days, q->cq_cur);
+		if (!list_empty(head)) {
+			e = list_entry(head->next, struct cfs_calq_node,
+				       cqn_link);
+			if (e->cqn_key < q->cq_top)
+				return e;
+		}
+		q->cq_cur = (q->cq_cur + 1) & (q->cq_nbuckets - 1);
+		q->cq_top += q->cq_width;
+	}
+
+	for (i = 0; i < q->cq_nbuckets; i++) {
+		head = cfs_calq_bucket(q->cq_days, i);
+		if (list_empty(head))
+			continue;
+
+		e = list_entry(head->next, struct cfs_calq_node, cqn_link);
+		if (first == NULL || cfs_calq_before(q, e, first))
+			first = e;
+	}
+	LASSERT(first != NULL);
+	cfs_calq_set_cursor(q, first->cqn_key);
+
+	return first;
+}
+EXPORT_SYMBOL(cfs_calq_first);
+
+/** @} calq */
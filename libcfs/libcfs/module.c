@@ -508,6 +508,8 @@ static const struct lnet_debugfs_symlink_def lnet_debugfs_symlinks[] = {
 	  .target	= "../../../module/libcfs/parameters/libcfs_console_backoff" },
 	{ .name		= "debug_mb",
 	  .target	= "../../../module/libcfs/parameters/libcfs_debug_mb" },
+	{ .name		= "debug_deferred",
+	  .target	= "../../../module/libcfs/parameters/libcfs_debug_deferred" },
 	{ .name		= "console_min_delay_centisecs",
 	  .target	= "../../../module/libcfs/parameters/libcfs_console_min_delay" },
 	{ .name		= "console_max_delay_centisecs",
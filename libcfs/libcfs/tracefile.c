@@ -43,6 +43,7 @@
 #include <linux/ctype.h>
 #include <linux/fs.h>
 #include <linux/kthread.h>
+#include <linux/module.h>
 #include <linux/pagemap.h>
 #include <linux/uaccess.h>
 #include <libcfs/linux/linux-fs.h>
@@ -170,6 +171,7 @@ cfs_trace_get_tage_try(struct cfs_trace_cpu_data *tcd, unsigned long len)
 		tage->used = 0;
 		tage->cpu = smp_processor_id();
 		tage->type = tcd->tcd_type;
+		tage->deferred = 0;
 		list_add_tail(&tage->linkage, &tcd->tcd_pages);
 		tcd->tcd_cur_pages++;
 
@@ -239,11 +241,298 @@ static struct cfs_trace_page *cfs_trace_get_tage(struct cfs_trace_cpu_data *tcd,
         if (tcd->tcd_cur_pages > 0) {
                 tage = cfs_tage_from_list(tcd->tcd_pages.next);
                 tage->used = 0;
+		tage->deferred = 0;
                 cfs_tage_to_tail(tage, &tcd->tcd_pages);
         }
         return tage;
 }
 
+#ifdef HAVE_BINARY_PRINTF
+/*
+ * Body of a deferred-format record, placed after its ptldebug_header at the
+ * next long-aligned address.  Rather than running vsnprintf() for every
+ * message, libcfs_debug_msg() only saves the format and the arguments as
+ * packed by vbin_printf(), and the text is produced by bstr_printf() when
+ * the pages leave the per-CPU buffers (lctl debug_kernel, debug daemon,
+ * console dump), see cfs_trace_expand_pages().
+ */
+struct cfs_trace_bin_rec {
+	const char	*tbr_file;
+	const char	*tbr_fn;
+	const char	*tbr_fmt;
+	u32		 tbr_args[0];
+};
+
+/* average size of the packed arguments of a message, in 32-bit words */
+#define CFS_TRACE_BIN_ARGS_AVG	16
+
+static inline struct cfs_trace_bin_rec *
+cfs_trace_bin_rec(struct ptldebug_header *hdr)
+{
+	return PTR_ALIGN((void *)(hdr + 1), sizeof(long));
+}
+
+/*
+ * vbin_printf() saves pointer arguments as they are, so formats using
+ * pointer extensions that dereference their argument (%pV, %pI4, ...)
+ * cannot be deferred and go through the text path.
+ */
+static bool cfs_trace_fmt_deferrable(const char *format)
+{
+	const char *p = format;
+
+	while ((p = strchr(p, '%')) != NULL) {
+		p++;
+		if (*p == '%') {
+			p++;
+			continue;
+		}
+		p += strspn(p, "-+ #0123456789.*hlLzjt");
+		if (*p == 'p' && isalnum(p[1]))
+			return false;
+	}
+	return true;
+}
+
+static int cfs_trace_msg_deferred(struct cfs_trace_cpu_data *tcd,
+				  struct ptldebug_header *header,
+				  const char *file,
+				  struct libcfs_debug_msg_data *msgdata,
+				  const char *format, va_list args)
+{
+	struct ptldebug_header *hdr;
+	struct cfs_trace_bin_rec *rec;
+	struct cfs_trace_page *tage;
+	int known_size = sizeof(*hdr) + sizeof(long) - 1 + sizeof(*rec);
+	int needed = CFS_TRACE_BIN_ARGS_AVG;
+	int max_words = 0;
+	va_list ap;
+	int i;
+
+	/* called from libcfs_debug_msg(), so a CDEBUG here would recurse */
+	if (!cfs_trace_fmt_deferrable(format))
+		return -EOPNOTSUPP;
+
+	for (i = 0; i < 2; i++) {
+		tage = cfs_trace_get_tage(tcd,
+					  known_size + needed * sizeof(u32));
+		if (tage == NULL)
+			return -ENOMEM;
+
+		hdr = (struct ptldebug_header *)
+		      ((char *)page_address(tage->page) + tage->used);
+		rec = cfs_trace_bin_rec(hdr);
+		max_words = ((char *)page_address(tage->page) + PAGE_SIZE -
+			     (char *)rec->tbr_args) / sizeof(u32);
+
+		va_copy(ap, args);
+		needed = vbin_printf(rec->tbr_args, max_words, format, ap);
+		va_end(ap);
+
+		if (needed <= max_words)
+			break;
+	}
+
+	if (needed > max_words)
+		return -E2BIG;
+
+	memcpy(hdr, header, sizeof(*hdr));
+	hdr->ph_flags |= PH_FLAG_DEFERRED;
+	hdr->ph_len = (char *)(rec->tbr_args + needed) - (char *)hdr;
+	rec->tbr_file = file;
+	rec->tbr_fn = msgdata->msg_fn;
+	rec->tbr_fmt = format;
+
+	tage->used += hdr->ph_len;
+	tage->deferred++;
+	__LASSERT(tage->used <= PAGE_SIZE);
+
+	return 0;
+}
+
+/* return a page of the expansion of \a src that has 'len' bytes left */
+static struct cfs_trace_page *
+cfs_tage_expand_get(struct cfs_trace_page *src, struct cfs_trace_page *dst,
+		    unsigned long len, gfp_t gfp)
+{
+	if (dst != NULL && dst->used + len <= PAGE_SIZE)
+		return dst;
+
+	dst = cfs_tage_alloc(gfp);
+	if (dst == NULL)
+		return NULL;
+
+	dst->used = 0;
+	dst->cpu = src->cpu;
+	dst->type = src->type;
+	dst->deferred = 0;
+	/* keep the expansion in place of the source page */
+	list_add_tail(&dst->linkage, &src->linkage);
+
+	return dst;
+}
+
+/*
+ * Replace \a src by pages holding the same records, with deferred-format
+ * records expanded to ordinary text records.  Returns the change in the
+ * number of pages on the list \a src was on.
+ */
+static int cfs_tage_expand(struct cfs_trace_page *src, gfp_t gfp)
+{
+	struct cfs_trace_page *dst = NULL;
+	char *p = page_address(src->page);
+	char *end = p + src->used;
+	int count = -1;
+
+	while (p < end) {
+		struct ptldebug_header *hdr = (void *)p;
+		struct ptldebug_header *out;
+		struct cfs_trace_bin_rec *rec;
+		struct cfs_trace_page *tage;
+		int known_size;
+		int needed = 85; /* average message length */
+		int max_nob = 0;
+		char *buf;
+		int i;
+
+		if (!(hdr->ph_flags & PH_FLAG_DEFERRED)) {
+			tage = cfs_tage_expand_get(src, dst, hdr->ph_len, gfp);
+			if (tage == NULL)
+				break;
+			if (tage != dst)
+				count++;
+			dst = tage;
+
+			memcpy((char *)page_address(dst->page) + dst->used,
+			       hdr, hdr->ph_len);
+			dst->used += hdr->ph_len;
+			p += hdr->ph_len;
+			continue;
+		}
+
+		rec = cfs_trace_bin_rec(hdr);
+		known_size = sizeof(*hdr) + strlen(rec->tbr_file) + 1;
+		if (rec->tbr_fn != NULL)
+			known_size += strlen(rec->tbr_fn) + 1;
+
+		for (i = 0; i < 2; i++) {
+			tage = cfs_tage_expand_get(src, dst,
+						   min_t(unsigned long,
+							 known_size + needed,
+							 PAGE_SIZE), gfp);
+			if (tage == NULL)
+				goto out;
+			if (tage != dst)
+				count++;
+			dst = tage;
+
+			buf = (char *)page_address(dst->page) + dst->used +
+			      known_size;
+			max_nob = PAGE_SIZE - dst->used - known_size;
+			needed = bstr_printf(buf, max_nob, rec->tbr_fmt,
+					     rec->tbr_args);
+			if (needed < max_nob)
+				break;
+			needed++;
+		}
+		/* truncated, even on an empty page */
+		if (needed >= max_nob)
+			needed = max_nob - 1;
+
+		out = (struct ptldebug_header *)
+		      ((char *)page_address(dst->page) + dst->used);
+		memcpy(out, hdr, sizeof(*out));
+		out->ph_flags &= ~PH_FLAG_DEFERRED;
+		out->ph_len = known_size + needed;
+
+		buf = (char *)(out + 1);
+		strcpy(buf, rec->tbr_file);
+		buf += strlen(rec->tbr_file) + 1;
+		if (rec->tbr_fn != NULL)
+			strcpy(buf, rec->tbr_fn);
+
+		dst->used += out->ph_len;
+		__LASSERT(dst->used <= PAGE_SIZE);
+		p += hdr->ph_len;
+	}
+out:
+	if (p < end && printk_ratelimit())
+		printk(KERN_WARNING "cannot allocate a tage, discarding %ld "
+		       "bytes of debug log\n", (long)(end - p));
+
+	list_del(&src->linkage);
+	cfs_tage_free(src);
+
+	return count;
+}
+
+/*
+ * Expand all deferred-format records on the page list \a pages, see
+ * cfs_tage_expand().  Returns the change in the number of pages.
+ */
+static int cfs_trace_expand_pages(struct list_head *pages, gfp_t gfp)
+{
+	struct cfs_trace_page *tage;
+	struct cfs_trace_page *tmp;
+	int count = 0;
+
+	list_for_each_entry_safe(tage, tmp, pages, linkage) {
+		__LASSERT_TAGE_INVARIANT(tage);
+
+		if (tage->deferred > 0)
+			count += cfs_tage_expand(tage, gfp);
+	}
+
+	return count;
+}
+
+/*
+ * Format strings, file and function names of deferred records point into
+ * the text of the module that logged them, so expand what is buffered
+ * before a module goes away.
+ */
+static int cfs_trace_module_notify(struct notifier_block *nb,
+				   unsigned long val, void *data)
+{
+	struct cfs_trace_cpu_data *tcd;
+	int i, cpu;
+
+	if (val != MODULE_STATE_GOING)
+		return NOTIFY_DONE;
+
+	for_each_possible_cpu(cpu) {
+		cfs_tcd_for_each_type_lock(tcd, i, cpu) {
+			tcd->tcd_cur_pages +=
+				cfs_trace_expand_pages(&tcd->tcd_pages,
+						       GFP_ATOMIC);
+			tcd->tcd_cur_daemon_pages +=
+				cfs_trace_expand_pages(&tcd->tcd_daemon_pages,
+						       GFP_ATOMIC);
+		}
+	}
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block cfs_trace_module_nb = {
+	.notifier_call	= cfs_trace_module_notify,
+};
+#else /* !HAVE_BINARY_PRINTF */
+static inline int cfs_trace_msg_deferred(struct cfs_trace_cpu_data *tcd,
+					 struct ptldebug_header *header,
+					 const char *file,
+					 struct libcfs_debug_msg_data *msgdata,
+					 const char *format, va_list args)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline int cfs_trace_expand_pages(struct list_head *pages, gfp_t gfp)
+{
+	return 0;
+}
+#endif /* HAVE_BINARY_PRINTF */
+
 int libcfs_debug_msg(struct libcfs_debug_msg_data *msgdata,
                      const char *format, ...)
 {
@@ -259,6 +548,7 @@ int libcfs_debug_msg(struct libcfs_debug_msg_data *msgdata,
         va_list                    ap;
         int                        i;
         int                        remain;
+	int			   rc;
         int                        mask = msgdata->msg_mask;
         char                      *file = (char *)msgdata->msg_file;
 	struct cfs_debug_limit_state *cdls = msgdata->msg_cdls;
@@ -285,6 +575,19 @@ int libcfs_debug_msg(struct libcfs_debug_msg_data *msgdata,
                 goto console;
         }
 
+	/* text is only needed now if the message goes to the console */
+	if (libcfs_debug_deferred && libcfs_debug_binary &&
+	    (mask & libcfs_printk) == 0) {
+		va_start(ap, format);
+		rc = cfs_trace_msg_deferred(tcd, &header, file, msgdata,
+					    format, ap);
+		va_end(ap);
+		if (rc == 0) {
+			cfs_trace_put_tcd(tcd);
+			return 1;
+		}
+	}
+
 	known_size = strlen(file) + 1;
         if (msgdata->msg_fn)
                 known_size += strlen(msgdata->msg_fn) + 1;
@@ -607,6 +910,7 @@ void cfs_trace_debug_print(void)
 
 	pc.pc_want_daemon_pages = 1;
 	collect_pages(&pc);
+	cfs_trace_expand_pages(&pc.pc_pages, GFP_ATOMIC);
 	list_for_each_entry_safe(tage, tmp, &pc.pc_pages, linkage) {
 		char *p, *file, *fn;
 		struct page *page;
@@ -658,6 +962,8 @@ int cfs_tracefile_dump_all_pages(char *filename)
 
         pc.pc_want_daemon_pages = 1;
         collect_pages(&pc);
+	cfs_trace_expand_pages(&pc.pc_pages, libcfs_panic_in_progress ?
+					     GFP_ATOMIC : GFP_KERNEL);
 	if (list_empty(&pc.pc_pages)) {
                 rc = 0;
                 goto close;
@@ -930,6 +1236,7 @@ static int tracefiled(void *arg)
 
                 pc.pc_want_daemon_pages = 0;
                 collect_pages(&pc);
+		cfs_trace_expand_pages(&pc.pc_pages, GFP_KERNEL);
 		if (list_empty(&pc.pc_pages))
                         goto end_loop;
 
@@ -1086,6 +1393,9 @@ int cfs_tracefile_init(int max_pages)
 		LASSERT(tcd->tcd_max_pages > 0);
 		tcd->tcd_shutting_down = 0;
 	}
+#ifdef HAVE_BINARY_PRINTF
+	register_module_notifier(&cfs_trace_module_nb);
+#endif
 	return 0;
 }
 
@@ -1124,6 +1434,9 @@ static void cfs_trace_cleanup(void)
 
 void cfs_tracefile_exit(void)
 {
+#ifdef HAVE_BINARY_PRINTF
+	unregister_module_notifier(&cfs_trace_module_nb);
+#endif
         cfs_trace_stop_thread();
         cfs_trace_cleanup();
 }
@@ -247,8 +247,21 @@ struct cfs_trace_page {
 	 * type(context) of this page
 	 */
 	unsigned short		type;
+	/*
+	 * number of records on this page whose formatting was deferred,
+	 * see cfs_trace_expand_pages()
+	 */
+	unsigned int		deferred;
 };
 
+/*
+ * Record flag (ptldebug_header::ph_flags) of a deferred-format record: the
+ * header is followed by struct cfs_trace_bin_rec rather than by strings.
+ * Such records never leave the kernel, they are expanded to ordinary text
+ * records before the pages are written or printed.
+ */
+#define PH_FLAG_DEFERRED	0x80000000
+
 extern void cfs_set_ptldebug_header(struct ptldebug_header *header,
                                     struct libcfs_debug_msg_data *m,
                                     unsigned long stack);
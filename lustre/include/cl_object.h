@@ -719,6 +719,9 @@ enum cl_page_type {
         CPT_TRANSIENT,
 };
 
+/** Largest number of layers of a page: vvp, lov and osc. */
+#define CP_MAX_LAYER	3
+
 /**
  * Fields are protected by the lock on struct page, except for atomics and
  * immutables.
@@ -737,8 +740,15 @@ struct cl_page {
 	struct page		*cp_vmpage;
 	/** Linkage of pages within group. Pages must be owned */
 	struct list_head	 cp_batch;
-	/** List of slices. Immutable after creation. */
-	struct list_head	 cp_layers;
+	/**
+	 * Offsets of the slices, from the end of struct cl_page, top layer
+	 * first. Immutable after creation.
+	 */
+	unsigned char		 cp_layer_offset[CP_MAX_LAYER];
+	/** Number of slices. Immutable after creation. */
+	unsigned char		 cp_layer_count;
+	/** Slab cache the page was allocated from, -1 if none. */
+	short			 cp_kmem_index;
 	/**
 	 * Page state. This field is const to avoid accidental update, it is
 	 * modified only internally within cl_page.c. Protected by a VM lock.
@@ -781,8 +791,6 @@ struct cl_page_slice {
          */
         struct cl_object                *cpl_obj;
         const struct cl_page_operations *cpl_ops;
-        /** Linkage into cl_page::cp_layers. Immutable after creation. */
-	struct list_head		 cpl_linkage;
 };
 
 /**
@@ -1473,6 +1473,24 @@ struct lu_tgt_desc_idx {
 	struct lu_tgt_desc *ldi_tgt[TGT_PTRS_PER_BLOCK];
 };
 
+/* probability 1 in lu_qos_alias_slot::las_prob */
+#define LU_QOS_ALIAS_ONE	(1U << 20)
+
+struct lu_qos_alias_slot {
+	__u32			 las_tgt;	/* target index */
+	__u32			 las_prob;	/* chance to keep las_tgt */
+	__u32			 las_alias;	/* slot used otherwise */
+};
+
+/*
+ * Alias table (Walker/Vose) drawing targets with a probability proportional
+ * to their weight in O(1), see lu_qos_alias_build().
+ */
+struct lu_qos_alias {
+	__u32			 lqa_count;
+	struct lu_qos_alias_slot lqa_slots[0];
+};
+
 /* QoS data for LOD/LMV */
 struct lu_qos {
 	struct list_head	 lq_svr_list;	/* lu_svr_qos list */
@@ -1481,6 +1499,7 @@ struct lu_qos {
 	unsigned int		 lq_prio_free;   /* priority for free space */
 	unsigned int		 lq_threshold_rr;/* priority for rr */
 	struct lu_qos_rr	 lq_rr;          /* round robin qos data */
+	struct lu_qos_alias	*lq_alias;	 /* weights of usable targets */
 	unsigned long		 lq_dirty:1,     /* recalc qos data */
 				 lq_same_space:1,/* the servers all have approx.
 						  * the same space avail */
@@ -1531,6 +1550,11 @@ bool ltd_qos_is_usable(struct lu_tgt_descs *ltd);
 int ltd_qos_penalties_calc(struct lu_tgt_descs *ltd);
 int ltd_qos_update(struct lu_tgt_descs *ltd, struct lu_tgt_desc *tgt,
 		   __u64 *total_wt);
+struct lu_qos_alias *lu_qos_alias_build(const __u32 *tgts,
+					const __u64 *weights, __u32 count);
+void lu_qos_alias_free(struct lu_qos_alias *lqa);
+__u32 lu_qos_alias_draw(const struct lu_qos_alias *lqa);
+int ltd_qos_alias_update(struct lu_tgt_descs *ltd);
 
 static inline struct lu_tgt_desc *ltd_first_tgt(struct lu_tgt_descs *ltd)
 {
@@ -414,6 +414,10 @@ int tgt_connect(struct tgt_session_info *tsi);
 int tgt_disconnect(struct tgt_session_info *uti);
 int tgt_obd_ping(struct tgt_session_info *tsi);
 int tgt_enqueue(struct tgt_session_info *tsi);
+int tgt_enqueue_nowait(struct tgt_session_info *tsi,
+		       const struct ldlm_res_id *res_id,
+		       const struct lustre_handle *remote,
+		       struct lustre_handle *lockh, void *lvb, int *lvb_len);
 int tgt_convert(struct tgt_session_info *tsi);
 int tgt_bl_callback(struct tgt_session_info *tsi);
 int tgt_cp_callback(struct tgt_session_info *tsi);
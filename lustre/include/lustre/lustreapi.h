@@ -345,6 +345,8 @@ struct find_param {
 	__u32			 fp_foreign_type;
 	unsigned long long	 fp_ext_size;
 	unsigned long long	 fp_ext_size_units;
+	/* number of threads walking the tree, output is unordered if > 1 */
+	unsigned int		 fp_threads;
 };
 
 int llapi_ostlist(char *path, struct find_param *param);
@@ -483,6 +485,7 @@ int llapi_changelog_start(void **priv, enum changelog_send_flag flags,
 			  const char *mdtname, long long startrec);
 int llapi_changelog_fini(void **priv);
 int llapi_changelog_recv(void *priv, struct changelog_rec **rech);
+int llapi_changelog_recv_next(void *priv, struct changelog_rec **rech);
 int llapi_changelog_in_buf(void *priv);
 int llapi_changelog_free(struct changelog_rec **rech);
 int llapi_changelog_get_fd(void *priv);
@@ -491,6 +494,8 @@ int llapi_changelog_clear(const char *mdtname, const char *idstr,
 			  long long endrec);
 extern int llapi_changelog_set_xflags(void *priv,
 				    enum changelog_send_extra_flag extra_flags);
+int llapi_changelog_set_filter(void *priv, __u64 type_mask,
+			       const char *jobid);
 
 /* HSM copytool interface.
  * priv is private state, managed internally by these functions
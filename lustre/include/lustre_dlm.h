@@ -68,6 +68,8 @@ extern struct kset *ldlm_svc_kset;
  * client shows interest in that lock, e.g. glimpse is occured. */
 #define LDLM_DIRTY_AGE_LIMIT (10)
 #define LDLM_DEFAULT_PARALLEL_AST_LIMIT 1024
+/* max locks in one blocking AST RPC, their handles fit in LDLM_MAXREQSIZE */
+#define LDLM_BL_AST_BATCH_MAX		512
 
 /**
  * LDLM non-error return states
@@ -313,12 +315,13 @@ enum ldlm_appetite {
 };
 
 /**
- * Default values for the "max_nolock_size", "contention_time" and
- * "contended_locks" namespace tunables.
+ * Default values for the "max_nolock_size", "contention_time",
+ * "contended_locks" and "contended_rate" namespace tunables.
  */
 #define NS_DEFAULT_MAX_NOLOCK_BYTES 0
 #define NS_DEFAULT_CONTENTION_SECONDS 2
 #define NS_DEFAULT_CONTENDED_LOCKS 32
+#define NS_DEFAULT_CONTENDED_RATE 256
 
 struct ldlm_ns_bucket {
 	/** back pointer to namespace */
@@ -492,6 +495,13 @@ struct ldlm_namespace {
 	 */
 	unsigned		ns_contended_locks;
 
+	/**
+	 * A resource whose conflict rate reaches \a ns_contended_rate is
+	 * switched to the server managed contended mode until the rate falls
+	 * below half of it. 0 disables that mode.
+	 */
+	unsigned		ns_contended_rate;
+
 	/**
 	 * The resources in this namespace remember contended state during
 	 * \a ns_contention_time, in seconds.
@@ -509,6 +519,14 @@ struct ldlm_namespace {
 	/** Limit of parallel AST RPC count. */
 	unsigned		ns_max_parallel_ast;
 
+	/** Number of locks per blocking AST RPC sent by this namespace. */
+	struct obd_histogram	ns_bl_ast_locks_hist;
+	/**
+	 * Time in usec to get replies to all the blocking ASTs sent for
+	 * one conflicting enqueue.
+	 */
+	struct obd_histogram	ns_bl_ast_time_hist;
+
 	/**
 	 * Callback to check if a lock is good to be canceled by ELC or
 	 * during recovery.
@@ -620,11 +638,18 @@ struct ldlm_cb_set_arg {
 	ptlrpc_interpterer_t		 gl_interpret_reply;
 	void				*gl_interpret_data;
 	struct ldlm_bl_desc		*bl_desc;
+	/* LDLM_BL_AST_BATCH_MAX locks of a batched blocking AST */
+	struct ldlm_lock		**bl_batch;
+	/* bl_batch was allocated, or its allocation failed */
+	unsigned int			 bl_batch_tried:1;
 };
 
 struct ldlm_cb_async_args {
 	struct ldlm_cb_set_arg	*ca_set_arg;
 	struct ldlm_lock	*ca_lock;
+	/* locks of a batched blocking AST, ca_lock is unused then */
+	struct ldlm_lock	**ca_locks;
+	int			 ca_count;
 };
 
 /** The ldlm_glimpse_work was slab allocated & must be freed accordingly.*/
@@ -1045,11 +1070,24 @@ struct ldlm_resource {
 	};
 
 	union {
-		/**
-		 * When the resource was considered as contended,
-		 * used only on server side.
-		 */
-		time64_t	lr_contention_time;
+		/** Contention state, used only on server side. */
+		struct {
+			/** When the resource was considered as contended */
+			time64_t	lr_contention_time;
+			/** When \a lr_conflict_rate was last decayed */
+			time64_t	lr_conflict_time;
+			/**
+			 * Number of conflicting locks met by recent enqueues,
+			 * halved every ns_contention_time seconds.
+			 */
+			__u32		lr_conflict_rate;
+			/**
+			 * Resource is managed by the server: extent locks
+			 * are not expanded and lockless capable enqueues are
+			 * denied whatever their size.
+			 */
+			__u32		lr_contended:1;
+		};
 		/**
 		 * Associated inode, used only on client side.
 		 */
@@ -1387,6 +1425,13 @@ int ldlm_glimpse_locks(struct ldlm_resource *res,
 int ldlm_handle_enqueue0(struct ldlm_namespace *ns, struct ptlrpc_request *req,
 			 const struct ldlm_request *dlm_req,
 			 const struct ldlm_callback_suite *cbs);
+int ldlm_handle_enqueue_nowait(struct ldlm_namespace *ns,
+			       struct obd_export *exp,
+			       const struct ldlm_res_id *res_id,
+			       const struct lustre_handle *remote,
+			       const struct ldlm_callback_suite *cbs,
+			       struct lustre_handle *lockh,
+			       void *lvb, int *lvb_len);
 int ldlm_handle_convert0(struct ptlrpc_request *req,
 			 const struct ldlm_request *dlm_req);
 int ldlm_handle_cancel(struct ptlrpc_request *req);
@@ -1683,6 +1728,17 @@ struct ptlrpc_request *ldlm_enqueue_pack(struct obd_export *exp, int lvb_len);
 int ldlm_handle_enqueue0(struct ldlm_namespace *ns, struct ptlrpc_request *req,
 			 const struct ldlm_request *dlm_req,
 			 const struct ldlm_callback_suite *cbs);
+int ldlm_cli_enqueue_batch(struct obd_export *exp,
+			   struct ldlm_enqueue_info *einfo,
+			   const struct ldlm_res_id *res_id,
+			   union ldlm_policy_data const *policy,
+			   __u32 lvb_len, enum lvb_type lvb_type,
+			   struct lustre_handle *lockh);
+int ldlm_cli_enqueue_batch_fini(struct obd_export *exp,
+				const struct lustre_handle *lockh,
+				enum ldlm_mode mode,
+				const struct lustre_handle *remote,
+				void *lvb, __u32 lvb_len, int rc);
 int ldlm_cli_enqueue_fini(struct obd_export *exp, struct ptlrpc_request *req,
 			  enum ldlm_type type, __u8 with_policy,
 			  enum ldlm_mode mode, __u64 *flags, void *lvb,
@@ -107,6 +107,11 @@ struct nrs_orr_key {
 struct nrs_orr_data {
 	struct ptlrpc_nrs_resource	od_res;
 	struct cfs_binheap	       *od_binheap;
+	/**
+	 * Calendar queue with a day per round, used instead of od_binheap if
+	 * orr_calendar_queue was set when the policy was started.
+	 */
+	struct cfs_calq		       *od_calq;
 	struct cfs_hash		       *od_obj_hash;
 	struct kmem_cache	       *od_cache;
 	/**
@@ -195,6 +200,12 @@ struct nrs_orr_req {
 	 * the same batch.
 	 */
 	__u64				or_sequence;
+	/**
+	 * Node in the calendar queue of the policy instance, keyed by
+	 * \a or_round; used instead of ptlrpc_nrs_request::nr_node when
+	 * nrs_orr_data::od_calq is set.
+	 */
+	struct cfs_calq_node		or_cqnode;
 	/**
 	 * For debugging purposes.
 	 */
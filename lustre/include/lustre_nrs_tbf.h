@@ -122,6 +122,8 @@ struct nrs_tbf_client {
 	struct list_head		 tc_list;
 	/** Node in binary heap. */
 	struct cfs_binheap_node		 tc_node;
+	/** Node in calendar queue, used instead of \a tc_node if enabled. */
+	struct cfs_calq_node		 tc_cqnode;
 	/** Whether the client is in heap. */
 	bool				 tc_in_heap;
 	/** Sequence of the newest rule. */
@@ -266,6 +268,11 @@ struct nrs_tbf_head {
 	 * Heap of queues.
 	 */
 	struct cfs_binheap		*th_binheap;
+	/**
+	 * Calendar queue of queues, used instead of th_binheap if
+	 * tbf_calendar_queue was set when the policy was started.
+	 */
+	struct cfs_calq			*th_calq;
 	/**
 	 * Hash of clients.
 	 */
@@ -309,6 +309,15 @@ struct osc_object {
 	atomic_t		oo_nr_ios;
 	wait_queue_head_t	oo_io_waitq;
 
+	/**
+	 * Linkage into client_obd::cl_glimpse_batch_list, protected by
+	 * client_obd::cl_glimpse_batch_lock.
+	 */
+	struct list_head	oo_glimpse_item;
+	/** lock requested by the batched glimpse while oo_glimpse_item is
+	 * linked */
+	struct lustre_handle	oo_glimpse_lockh;
+
 	const struct osc_object_operations *oo_obj_ops;
 	bool			oo_initialized;
 };
@@ -502,6 +511,19 @@ static inline int osc_lock_is_lockless(const struct osc_lock *ols)
 	return (ols->ols_cl.cls_ops == ols->ols_lockless_ops);
 }
 
+/**
+ * LRU pages recently added by the threads of one CPU partition. They are
+ * moved to client_obd::cl_lru_list by batches, so that concurrent I/O
+ * threads don't all take client_obd::cl_lru_list_lock for each RPC.
+ */
+struct osc_lru_cpt {
+	spinlock_t		olc_lock;
+	struct list_head	olc_list;
+	long			olc_count;
+	/** stats: how many times olc_lock was found held */
+	__u64			olc_contended;
+};
+
 /**
  * Page state private for osc layer.
  */
@@ -542,6 +564,11 @@ struct osc_page {
 	 * lru page list. See osc_lru_{del|use}() in osc_page.c for usage.
 	 */
 	struct list_head	ops_lru;
+	/**
+	 * CPU partition of the osc_lru_cpt list the page is on, or -1 if it
+	 * is on client_obd::cl_lru_list. Changed with the lock of that list.
+	 */
+	int			ops_lru_cpt;
 	/**
 	 * Submit time - the time when the page is starting RPC. For debugging.
 	 */
@@ -584,6 +611,9 @@ void osc_page_submit(const struct lu_env *env, struct osc_page *opg,
 int lru_queue_work(const struct lu_env *env, void *data);
 long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 		    long target, bool force);
+int osc_lru_cpts_init(struct client_obd *cli);
+void osc_lru_cpts_fini(struct client_obd *cli);
+__u64 osc_lru_contended(struct client_obd *cli);
 
 /* osc_cache.c */
 int osc_cancel_async_page(const struct lu_env *env, struct osc_page *ops);
@@ -208,6 +208,7 @@ extern struct req_format RQF_OST_GET_INFO_LAST_FID;
 extern struct req_format RQF_OST_SET_INFO_LAST_FID;
 extern struct req_format RQF_OST_GET_INFO_FIEMAP;
 extern struct req_format RQF_OST_LADVISE;
+extern struct req_format RQF_OST_BATCH_GLIMPSE;
 
 /* LDLM req_format */
 extern struct req_format RQF_LDLM_ENQUEUE;
@@ -225,6 +226,7 @@ extern struct req_format RQF_LDLM_CANCEL;
 extern struct req_format RQF_LDLM_CALLBACK;
 extern struct req_format RQF_LDLM_CP_CALLBACK;
 extern struct req_format RQF_LDLM_BL_CALLBACK;
+extern struct req_format RQF_LDLM_BL_CALLBACK_BATCH;
 extern struct req_format RQF_LDLM_GL_CALLBACK;
 extern struct req_format RQF_LDLM_GL_CALLBACK_DESC;
 /* LOG req_format */
@@ -342,6 +344,7 @@ extern struct req_msg_field RMF_LFSCK_REPLY;
 
 extern struct req_msg_field RMF_OST_LADVISE_HDR;
 extern struct req_msg_field RMF_OST_LADVISE;
+extern struct req_msg_field RMF_OST_GLIMPSE_REC;
 /** @} req_layout */
 
 #endif /* _LUSTRE_REQ_LAYOUT_H__ */
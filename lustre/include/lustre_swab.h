@@ -62,6 +62,7 @@ void lustre_swab_obd_ioobj(struct obd_ioobj *ioo);
 void lustre_swab_niobuf_remote(struct niobuf_remote *nbr);
 void lustre_swab_ost_lvb_v1(struct ost_lvb_v1 *lvb);
 void lustre_swab_ost_lvb(struct ost_lvb *lvb);
+void lustre_swab_ost_glimpse_rec(struct ost_glimpse_rec *ogr);
 void lustre_swab_obd_quotactl(struct obd_quotactl *q);
 void lustre_swab_quota_body(struct quota_body *b);
 void lustre_swab_lquota_lvb(struct lquota_lvb *lvb);
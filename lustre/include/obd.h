@@ -135,6 +135,7 @@ struct timeout_item {
 #define OSC_MAX_DIRTY_DEFAULT	2000	 /* Arbitrary large value */
 #define OSC_MAX_DIRTY_MB_MAX	2048     /* arbitrary, but < MAX_LONG bytes */
 #define OSC_DEFAULT_RESENDS	10
+#define OSC_GLIMPSE_BATCH_DEFAULT 64	 /* objects per OST_BATCH_GLIMPSE */
 
 /* possible values for fo_sync_lock_cancel */
 enum {
@@ -169,6 +170,7 @@ enum obd_cl_sem_lock_class {
 
 struct mdc_rpc_lock;
 struct obd_import;
+struct osc_lru_cpt;
 struct client_obd {
 	struct rw_semaphore	 cl_sem;
 	struct obd_uuid		 cl_target_uuid;
@@ -303,6 +305,11 @@ struct client_obd {
 	struct list_head         cl_lru_list;
 	/** Lock for LRU page list */
 	spinlock_t		 cl_lru_list_lock;
+	/** stats: how many times cl_lru_list_lock was found held */
+	__u64			 cl_lru_contended;
+	/** Per-CPT lists of the pages added to the LRU recently, moved to
+	 * cl_lru_list by batches. See osc_lru_add_batch(). */
+	struct osc_lru_cpt	**cl_lru_cpts;
 	/** # of unstable pages in this client_obd.
 	 * An unstable page is a page state that WRITE RPC has finished but
 	 * the transaction has NOT yet committed. */
@@ -314,6 +321,14 @@ struct client_obd {
 	atomic_t		 cl_destroy_in_flight;
 	wait_queue_head_t	 cl_destroy_waitq;
 
+	/* speculative glimpses waiting to be sent in one OST_BATCH_GLIMPSE
+	 * RPC, see osc_glimpse_batch_add() */
+	spinlock_t		 cl_glimpse_batch_lock;
+	struct list_head	 cl_glimpse_batch_list;
+	unsigned int		 cl_glimpse_batch_count;
+	/* # of objects per OST_BATCH_GLIMPSE RPC, 0 to disable batching */
+	unsigned int		 cl_glimpse_batch_max;
+
 	/* modify rpcs in flight
 	 * currently used for metadata only */
 	spinlock_t		 cl_mod_rpcs_lock;
@@ -773,6 +788,7 @@ struct obd_device {
 #define KEY_SPTLRPC_CONF        "sptlrpc_conf"
 
 #define KEY_CACHE_LRU_SHRINK	"cache_lru_shrink"
+#define KEY_GLIMPSE_BATCH_FLUSH	"glimpse_batch_flush"
 #define KEY_OSP_CONNECTED	"osp_connected"
 
 /* Flags for op_xvalid */
@@ -820,6 +836,7 @@ enum md_cli_flags {
 	CLI_HASH64      = 1 << 2,
 	CLI_API32       = 1 << 3,
 	CLI_MIGRATE     = 1 << 4,
+	CLI_DOM_PREFETCH = 1 << 5,
 };
 
 enum md_op_code {
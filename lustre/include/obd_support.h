@@ -350,6 +350,7 @@ extern char obd_jobid_var[];
 #define OBD_FAIL_OST_DELAY_TRANS	 0x246
 #define OBD_FAIL_OST_PREPARE_DELAY	 0x247
 #define OBD_FAIL_OST_2BIG_NIOBUF	 0x248
+#define OBD_FAIL_OST_BATCH_GLIMPSE_NET	 0x249
 
 #define OBD_FAIL_LDLM                    0x300
 #define OBD_FAIL_LDLM_NAMESPACE_NEW      0x301
@@ -635,6 +636,7 @@ extern char obd_jobid_var[];
 #define OBD_FAIL_LFSCK_BAD_PFL_RANGE	0x162f
 #define OBD_FAIL_LFSCK_NO_AGENTOBJ	0x1630
 #define OBD_FAIL_LFSCK_NO_AGENTENT	0x1631
+#define OBD_FAIL_LFSCK_LOST_LSOM	0x1632
 
 #define OBD_FAIL_LFSCK_NOTIFY_NET	0x16f0
 #define OBD_FAIL_LFSCK_QUERY_NET	0x16f1
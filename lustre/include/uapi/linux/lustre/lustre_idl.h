@@ -840,6 +840,12 @@ struct ptlrpc_body_v2 {
 #define OBD_CONNECT2_PCC		0x1000ULL /* Persistent Client Cache */
 #define OBD_CONNECT2_ASYNC_DISCARD	0x4000ULL /* support async DoM data discard */
 #define OBD_CONNECT2_ENCRYPT		0x8000ULL /* client-to-disk encrypt */
+/* Flags not reserved on the other branches are allocated down from the
+ * highest bit, so they do not collide with the ones added there upwards */
+#define OBD_CONNECT2_BATCH_BL_AST	0x8000000000000000ULL /* multi-lock
+							       * blocking AST */
+#define OBD_CONNECT2_BATCH_GLIMPSE	0x4000000000000000ULL /* OST_BATCH_GLIMPSE
+							       * RPC */
 /* XXX README XXX:
  * Please DO NOT add flag values here before first ensuring that this same
  * flag value is not in use on some other branch.  Please clear any such
@@ -922,7 +928,9 @@ struct ptlrpc_body_v2 {
 				OBD_CONNECT_GRANT_PARAM | \
 				OBD_CONNECT_SHORTIO | OBD_CONNECT_FLAGS2)
 
-#define OST_CONNECT_SUPPORTED2 (OBD_CONNECT2_LOCKAHEAD | OBD_CONNECT2_INC_XID)
+#define OST_CONNECT_SUPPORTED2 (OBD_CONNECT2_LOCKAHEAD | OBD_CONNECT2_INC_XID | \
+				OBD_CONNECT2_BATCH_GLIMPSE | \
+				OBD_CONNECT2_BATCH_BL_AST)
 
 #define ECHO_CONNECT_SUPPORTED (OBD_CONNECT_FID)
 #define ECHO_CONNECT_SUPPORTED2 0
@@ -1050,6 +1058,9 @@ enum ost_cmd {
         OST_QUOTACTL   = 19,
 	OST_QUOTA_ADJUST_QUNIT = 20, /* not used since 2.4 */
 	OST_LADVISE    = 21,
+	/* opcodes not reserved on the other branches are allocated down from
+	 * OST_LAST_OPC, so they do not collide with the ones added upwards */
+	OST_BATCH_GLIMPSE = 31,
 	OST_LAST_OPC /* must be < 33 to avoid MDS_GETATTR */
 };
 #define OST_FIRST_OPC  OST_REPLY
@@ -1313,6 +1324,8 @@ lov_mds_md_max_stripe_count(size_t buf_size, __u32 lmm_magic)
 
 #define OBD_MD_FLLAZYSIZE    (0x0400000000000000ULL) /* Lazy size */
 #define OBD_MD_FLLAZYBLOCKS  (0x0800000000000000ULL) /* Lazy blocks */
+#define OBD_MD_DOM_PREFETCH  (0x1000000000000000ULL) /* return DoM data with
+						      * getattr intent */
 
 #define OBD_MD_FLALLQUOTA (OBD_MD_FLUSRQUOTA | \
 			   OBD_MD_FLGRPQUOTA | \
@@ -1443,6 +1456,19 @@ struct ost_lvb {
 	__u32	lvb_padding;
 };
 
+/* One OST-object in the OST_BATCH_GLIMPSE request and reply. The client
+ * fills ogr_oi and the handle of its PR lock on the whole object in
+ * ogr_handle. The OST returns ogr_rc, and the handle of the granted lock
+ * in ogr_handle with the LVB of the object in ogr_lvb if it is 0. -EAGAIN
+ * is returned if the lock would conflict with another one. */
+struct ost_glimpse_rec {
+	struct ost_id		ogr_oi;
+	struct lustre_handle	ogr_handle;
+	__s32			ogr_rc;
+	__u32			ogr_padding;
+	struct ost_lvb		ogr_lvb;
+};
+
 /*
  *   lquota data structures
  */
@@ -1612,6 +1612,12 @@ enum changelog_send_extra_flag {
 /* 31 usable bytes string + null terminator. */
 #define LUSTRE_JOBID_SIZE	32
 
+/* Records wanted by a changelog reader, see OBD_IOC_CHLG_FILTER */
+struct changelog_filter {
+	__u64	cf_type_mask;	/* 1 << CL_* of the wanted types, 0 for all */
+	char	cf_jobid[LUSTRE_JOBID_SIZE]; /* wanted jobid, "" for all */
+};
+
 /* This is the minimal changelog record. It can contain extensions
  * such as rename fields or process jobid. Its exact content is described
  * by the cr_flags and cr_extra_flags.
@@ -2530,6 +2536,7 @@ struct lu_heat {
 enum lu_pcc_type {
 	LU_PCC_NONE = 0,
 	LU_PCC_READWRITE,
+	LU_PCC_READONLY,
 	LU_PCC_MAX
 };
 
@@ -2540,6 +2547,8 @@ static inline const char *pcc_type2string(enum lu_pcc_type type)
 		return "none";
 	case LU_PCC_READWRITE:
 		return "readwrite";
+	case LU_PCC_READONLY:
+		return "readonly";
 	default:
 		return "fault";
 	}
@@ -2581,6 +2590,12 @@ enum lu_pcc_state_flags {
 	PCC_STATE_FL_AUTO_ATTACH	= PCC_STATE_FL_OPEN_ATTACH |
 					  PCC_STATE_FL_IO_ATTACH |
 					  PCC_STATE_FL_STAT_ATTACH,
+	/* Waiting to be written back to Lustre once idle */
+	PCC_STATE_FL_WB_PENDING		= 0x20,
+	/* Being written back to Lustre */
+	PCC_STATE_FL_WB_FLUSHING	= 0x40,
+	/* Being prefetched into RO-PCC */
+	PCC_STATE_FL_RO_PREFETCH	= 0x80,
 };
 
 struct lu_pcc_state {
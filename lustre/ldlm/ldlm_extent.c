@@ -289,11 +289,19 @@ static void ldlm_extent_policy(struct ldlm_resource *res,
 	/* Because reprocess_queue zeroes flags and uses it to return
 	 * LDLM_FL_LOCK_CHANGED, we must check for the NO_EXPANSION flag
 	 * in the lock flags rather than the 'flags' argument */
-	if (likely(!(lock->l_flags & LDLM_FL_NO_EXPANSION))) {
+	if (likely(!(lock->l_flags & LDLM_FL_NO_EXPANSION) &&
+		   !res->lr_contended)) {
 		ldlm_extent_internal_policy_granted(lock, &new_ex);
 		ldlm_extent_internal_policy_waiting(lock, &new_ex);
 	} else {
-		LDLM_DEBUG(lock, "Not expanding manually requested lock.\n");
+		/* On a contended resource, any extent wider than requested
+		 * would just be called back by the next enqueue. */
+		if (res->lr_contended)
+			LDLM_DEBUG(lock, "Not expanding lock on contended "
+				   "resource.\n");
+		else
+			LDLM_DEBUG(lock, "Not expanding manually requested "
+				   "lock.\n");
 		new_ex.start = lock->l_policy_data.l_extent.start;
 		new_ex.end = lock->l_policy_data.l_extent.end;
 		/* In case the request is not on correct boundaries, we call
@@ -395,6 +403,7 @@ ldlm_extent_compat_queue(struct list_head *queue, struct ldlm_lock *req,
 	int check_contention;
 	int compat = 1;
 	int scan = 0;
+	bool contended;
 	ENTRY;
 
         lockmode_verify(req_mode);
@@ -651,13 +660,17 @@ ldlm_extent_compat_queue(struct list_head *queue, struct ldlm_lock *req,
                 }
         }
 
-        if (ldlm_check_contention(req, *contended_locks) &&
-            compat == 0 &&
-            (*flags & LDLM_FL_DENY_ON_CONTENTION) &&
-            req->l_req_mode != LCK_GROUP &&
-            req_end - req_start <=
-            ldlm_res_to_ns(req->l_resource)->ns_max_nolock_size)
-                GOTO(destroylock, compat = -EUSERS);
+	/* Small lockless capable IO is denied on a contended resource, any
+	 * lockless capable IO is denied while the server manages it. The
+	 * client then does lockless IO, ordered by the server local locks. */
+	contended = ldlm_check_contention(req, *contended_locks);
+	if (compat == 0 &&
+	    (*flags & LDLM_FL_DENY_ON_CONTENTION) &&
+	    req->l_req_mode != LCK_GROUP &&
+	    (res->lr_contended ||
+	     (contended && req_end - req_start <=
+	      ldlm_res_to_ns(res)->ns_max_nolock_size)))
+		GOTO(destroylock, compat = -EUSERS);
 
         RETURN(compat);
 destroylock:
@@ -851,6 +864,7 @@ int ldlm_process_extent_lock(struct ldlm_lock *lock, __u64 *flags,
 	rc = LDLM_ITER_CONTINUE;
 
 out_rpc_list:
+	ldlm_resource_contention_update(res, contended_locks);
 	RETURN(rc);
 }
 #endif /* HAVE_SERVER_SUPPORT */
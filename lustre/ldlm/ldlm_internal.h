@@ -125,6 +125,9 @@ extern struct kmem_cache *ldlm_interval_tree_slab;
 
 void ldlm_resource_insert_lock_after(struct ldlm_lock *original,
                                      struct ldlm_lock *new);
+#ifdef HAVE_SERVER_SUPPORT
+bool ldlm_resource_contention_update(struct ldlm_resource *res, int conflicts);
+#endif
 
 /* ldlm_lock.c */
 
@@ -182,6 +185,11 @@ int ldlm_export_cancel_locks(struct obd_export *exp);
 void ldlm_grant_lock_with_skiplist(struct ldlm_lock *lock);
 
 /* ldlm_lockd.c */
+#ifdef HAVE_SERVER_SUPPORT
+int ldlm_server_blocking_ast_batch(struct ldlm_lock **locks, int count,
+				   struct ldlm_lock_desc *desc,
+				   struct ldlm_cb_set_arg *arg);
+#endif
 int ldlm_bl_to_thread_lock(struct ldlm_namespace *ns, struct ldlm_lock_desc *ld,
                            struct ldlm_lock *lock);
 int ldlm_bl_to_thread_list(struct ldlm_namespace *ns,
@@ -413,6 +413,11 @@ int client_obd_setup(struct obd_device *obddev, struct lustre_cfg *lcfg)
 	init_waitqueue_head(&cli->cl_destroy_waitq);
 	atomic_set(&cli->cl_destroy_in_flight, 0);
 
+	spin_lock_init(&cli->cl_glimpse_batch_lock);
+	INIT_LIST_HEAD(&cli->cl_glimpse_batch_list);
+	cli->cl_glimpse_batch_count = 0;
+	cli->cl_glimpse_batch_max = OSC_GLIMPSE_BATCH_DEFAULT;
+
 
 	cli->cl_supp_cksum_types = OBD_CKSUM_CRC32;
 	cli->cl_preferred_cksum_type = 0;
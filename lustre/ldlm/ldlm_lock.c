@@ -37,6 +37,7 @@
 
 #define DEBUG_SUBSYSTEM S_LDLM
 
+#include <linux/list_sort.h>
 #include <libcfs/libcfs.h>
 
 #include <lustre_swab.h>
@@ -2062,6 +2063,111 @@ void ldlm_discard_bl_list(struct list_head *bl_list)
 	EXIT;
 }
 
+/**
+ * Blocking ASTs of the extent locks of a client supporting it can be sent
+ * together. The target blocking callback only syncs data on cancel, for a
+ * blocking AST it does nothing else than ldlm_server_blocking_ast().
+ */
+static inline bool ldlm_bl_ast_batchable(struct ldlm_lock *lock)
+{
+	return lock->l_export != NULL &&
+	       lock->l_resource->lr_type == LDLM_EXTENT &&
+	       exp_connect_batch_bl_ast(lock->l_export) &&
+	       !ldlm_is_cancel_on_block(lock);
+}
+
+/**
+ * Order the ast_work list by client and blocking lock, so the locks which can
+ * be sent in the same blocking AST follow each other.
+ */
+static int ldlm_bl_ast_cmp(void *priv, struct list_head *a,
+			   struct list_head *b)
+{
+	struct ldlm_lock *l0 = list_entry(a, struct ldlm_lock, l_bl_ast);
+	struct ldlm_lock *l1 = list_entry(b, struct ldlm_lock, l_bl_ast);
+
+	if (l0->l_export != l1->l_export)
+		return l0->l_export < l1->l_export ? -1 : 1;
+	if (l0->l_blocking_lock != l1->l_blocking_lock)
+		return l0->l_blocking_lock < l1->l_blocking_lock ? -1 : 1;
+	return 0;
+}
+
+/**
+ * Send one blocking AST for \a first and the locks of the same client that
+ * are blocked by the same lock in the ast_work list. The list is sorted by
+ * ldlm_bl_ast_cmp(), so only the locks following \a first are looked at.
+ */
+static int ldlm_work_bl_ast_batch(struct ldlm_cb_set_arg *arg,
+				  struct ldlm_lock *first)
+{
+	struct ldlm_lock **locks = arg->bl_batch;
+	struct ldlm_lock *blocking = NULL;
+	struct ldlm_lock *lock, *tmp;
+	struct ldlm_lock_desc d;
+	__u64 ast_flags = 0;
+	int count = 0;
+	int rc = 0;
+	int i;
+
+	ENTRY;
+
+	list_for_each_entry_safe(lock, tmp, arg->list, l_bl_ast) {
+		if (count == LDLM_BL_AST_BATCH_MAX)
+			break;
+		if (lock != first && lock->l_export != first->l_export)
+			break;
+		if (lock != first && !ldlm_bl_ast_batchable(lock))
+			continue;
+
+		lock_res_and_lock(lock);
+		if (lock != first && lock->l_blocking_lock != blocking) {
+			unlock_res_and_lock(lock);
+			break;
+		}
+		if (lock != first &&
+		    (lock->l_flags & LDLM_FL_AST_MASK) != ast_flags) {
+			unlock_res_and_lock(lock);
+			continue;
+		}
+
+		list_del_init(&lock->l_bl_ast);
+		/* see ldlm_work_bl_ast_lock() */
+		if (!ldlm_is_ast_sent(lock)) {
+			unlock_res_and_lock(lock);
+			LDLM_LOCK_RELEASE(lock);
+			if (lock == first)
+				break;
+			continue;
+		}
+
+		LASSERT(lock->l_blocking_lock);
+		if (lock == first) {
+			blocking = LDLM_LOCK_GET(lock->l_blocking_lock);
+			ast_flags = lock->l_flags & LDLM_FL_AST_MASK;
+		}
+		LASSERT(lock->l_bl_ast_run == 0);
+		lock->l_bl_ast_run++;
+		ldlm_clear_blocking_lock(lock);
+		unlock_res_and_lock(lock);
+
+		locks[count++] = lock;
+	}
+
+	if (count > 0) {
+		ldlm_lock2desc(blocking, &d);
+		d.l_policy_data.l_inodebits.cancel_bits =
+			blocking->l_policy_data.l_inodebits.bits;
+
+		rc = ldlm_server_blocking_ast_batch(locks, count, &d, arg);
+		for (i = 0; i < count; i++)
+			LDLM_LOCK_RELEASE(locks[i]);
+		LDLM_LOCK_RELEASE(blocking);
+	}
+
+	RETURN(rc);
+}
+
 /**
  * Process a call to blocking AST callback for a lock in ast_work list
  */
@@ -2081,6 +2187,24 @@ ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 
 	lock = list_entry(arg->list->next, struct ldlm_lock, l_bl_ast);
 
+	/* most namespaces and clients never batch, so set the batch up and
+	 * group the rest of the list only when the first batchable lock
+	 * shows up */
+	if (!arg->bl_batch_tried && ldlm_bl_ast_batchable(lock)) {
+		arg->bl_batch_tried = 1;
+		OBD_ALLOC(arg->bl_batch,
+			  sizeof(*arg->bl_batch) * LDLM_BL_AST_BATCH_MAX);
+		if (arg->bl_batch != NULL) {
+			list_sort(NULL, arg->list, ldlm_bl_ast_cmp);
+			lock = list_entry(arg->list->next, struct ldlm_lock,
+					  l_bl_ast);
+		}
+	}
+
+	/* send it alone if there was no memory for a batch */
+	if (arg->bl_batch != NULL && ldlm_bl_ast_batchable(lock))
+		RETURN(ldlm_work_bl_ast_batch(arg, lock));
+
 	/* nobody should touch l_bl_ast but some locks in the list may become
 	 * granted after lock convert or COS downgrade, these locks should be
 	 * just skipped here and removed from the list.
@@ -2254,6 +2378,7 @@ int ldlm_run_ast_work(struct ldlm_namespace *ns, struct list_head *rpc_list,
 {
 	struct ldlm_cb_set_arg *arg;
 	set_producer_func work_ast_lock;
+	ktime_t start = ktime_get();
 	int rc;
 
 	if (list_empty(rpc_list))
@@ -2301,9 +2426,16 @@ int ldlm_run_ast_work(struct ldlm_namespace *ns, struct list_head *rpc_list,
 	ptlrpc_set_wait(NULL, arg->set);
 	ptlrpc_set_destroy(arg->set);
 
+	if (ast_type == LDLM_WORK_BL_AST)
+		lprocfs_oh_tally_log2(&ns->ns_bl_ast_time_hist,
+				      ktime_us_delta(ktime_get(), start));
+
 	rc = atomic_read(&arg->restart) ? -ERESTART : 0;
 	GOTO(out, rc);
 out:
+	if (arg->bl_batch != NULL)
+		OBD_FREE(arg->bl_batch,
+			 sizeof(*arg->bl_batch) * LDLM_BL_AST_BATCH_MAX);
 	OBD_FREE_PTR(arg);
 	return rc;
 }
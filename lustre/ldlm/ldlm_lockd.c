@@ -94,10 +94,17 @@ struct ldlm_bl_pool {
 
 	/*
 	 * blp_list is used for all other callbacks which are likely
-	 * to take longer to process.
+	 * to take longer to process, when they are not queued to a CPT.
 	 */
 	struct list_head blp_list;
 
+	/*
+	 * Per-CPT lists of the callbacks queued from a CPU of that CPT,
+	 * a thread takes work from its own CPT first.
+	 */
+	struct list_head *blp_cpt_lists;
+	int blp_ncpts;
+
 	wait_queue_head_t blp_waitq;
 	struct completion blp_comp;
 	atomic_t blp_num_threads;
@@ -116,6 +123,7 @@ struct ldlm_bl_work_item {
 	struct completion	blwi_comp;
 	enum ldlm_cancel_flags	blwi_flags;
 	int			blwi_mem_pressure;
+	int			blwi_cpt;
 };
 
 #ifdef HAVE_SERVER_SUPPORT
@@ -735,6 +743,72 @@ static int ldlm_handle_ast_error(struct ldlm_lock *lock,
 	return rc;
 }
 
+/**
+ * Interpret the reply to a batched blocking AST.
+ *
+ * The reply lists the handles of the locks the client doesn't have anymore,
+ * these are handled as if the client returned -EINVAL for them. If the whole
+ * request failed, it is reported and the client evicted for the first lock
+ * only, the eviction cleans up the other locks of the export.
+ */
+static int ldlm_cb_batch_interpret(struct ptlrpc_request *req,
+				   struct ldlm_cb_async_args *ca, int rc)
+{
+	struct ldlm_request *rep = NULL;
+	struct ldlm_lock *lock;
+	bool handled = false;
+	int lock_rc;
+	int i, j;
+
+	ENTRY;
+
+	if (rc == 0) {
+		rep = req_capsule_server_get(&req->rq_pill, &RMF_DLM_REQ);
+		if (rep == NULL ||
+		    rep->lock_count > ca->ca_count ||
+		    req_capsule_get_size(&req->rq_pill, &RMF_DLM_REQ,
+					 RCL_SERVER) <
+		    ldlm_request_bufsize(rep->lock_count, LDLM_BL_CALLBACK))
+			rc = -EPROTO;
+	}
+
+	for (i = 0; i < ca->ca_count; i++) {
+		lock = ca->ca_locks[i];
+		if (lock == NULL)
+			continue;
+
+		lock_rc = rc;
+		for (j = 0; rc == 0 && j < rep->lock_count; j++) {
+			if (rep->lock_handle[j].cookie ==
+			    lock->l_remote_handle.cookie) {
+				lock_rc = -EINVAL;
+				break;
+			}
+		}
+
+		/* a lock cancelled meanwhile is still cancelled here, see
+		 * ldlm_handle_ast_error()
+		 */
+		if (rc != 0 && rc != -EINVAL && !ldlm_is_cancel(lock)) {
+			if (handled)
+				lock_rc = 0;
+			handled = true;
+		}
+
+		if (lock_rc != 0)
+			lock_rc = ldlm_handle_ast_error(lock, req, lock_rc,
+							"blocking");
+		if (lock_rc == -ERESTART)
+			atomic_inc(&ca->ca_set_arg->restart);
+
+		/* release extra reference taken when the AST was packed */
+		LDLM_LOCK_RELEASE(lock);
+	}
+	OBD_FREE(ca->ca_locks, sizeof(*ca->ca_locks) * ca->ca_count);
+
+	RETURN(0);
+}
+
 static int ldlm_cb_interpret(const struct lu_env *env,
 			     struct ptlrpc_request *req, void *args, int rc)
 {
@@ -744,6 +818,9 @@ static int ldlm_cb_interpret(const struct lu_env *env,
 
 	ENTRY;
 
+	if (ca->ca_locks != NULL)
+		RETURN(ldlm_cb_batch_interpret(req, ca, rc));
+
 	LASSERT(lock != NULL);
 
 	switch (arg->type) {
@@ -797,8 +874,18 @@ static void ldlm_update_resend(struct ptlrpc_request *req, void *data)
 {
 	struct ldlm_cb_async_args *ca = data;
 	struct ldlm_lock *lock = ca->ca_lock;
+	int i;
+
+	if (ca->ca_locks == NULL) {
+		ldlm_refresh_waiting_lock(lock, ldlm_bl_timeout(lock));
+		return;
+	}
 
-	ldlm_refresh_waiting_lock(lock, ldlm_bl_timeout(lock));
+	for (i = 0; i < ca->ca_count; i++) {
+		lock = ca->ca_locks[i];
+		if (lock != NULL)
+			ldlm_refresh_waiting_lock(lock, ldlm_bl_timeout(lock));
+	}
 }
 
 static inline int ldlm_ast_fini(struct ptlrpc_request *req,
@@ -964,11 +1051,139 @@ int ldlm_server_blocking_ast(struct ldlm_lock *lock,
 		lprocfs_counter_incr(lock->l_export->exp_nid_stats->nid_ldlm_stats,
 				     LDLM_BL_CALLBACK - LDLM_FIRST_OPC);
 
+	lprocfs_oh_tally_log2(&ldlm_lock_to_ns(lock)->ns_bl_ast_locks_hist, 1);
+
 	rc = ldlm_ast_fini(req, arg, lock, instant_cancel);
 
 	RETURN(rc);
 }
 
+/**
+ * Send a single blocking AST RPC for \a count granted locks of the same
+ * client, all blocked by the lock described by \a desc.
+ *
+ * This does what ldlm_server_blocking_ast() does for each lock, the handles
+ * of all the locks are packed in the same ldlm_request. Used for clients
+ * connected with OBD_CONNECT2_BATCH_BL_AST only, the locks must not be
+ * LDLM_FL_CANCEL_ON_BLOCK ones.
+ */
+int ldlm_server_blocking_ast_batch(struct ldlm_lock **locks, int count,
+				   struct ldlm_lock_desc *desc,
+				   struct ldlm_cb_set_arg *arg)
+{
+	struct obd_export *exp = locks[0]->l_export;
+	struct ldlm_cb_async_args *ca;
+	struct ldlm_request *body;
+	struct ptlrpc_request *req;
+	struct ldlm_lock **sent; /* locks[i] if its handle was packed */
+	struct ldlm_lock *lock;
+	time64_t timeout = 0;
+	int n = 0;
+	int rc;
+	int i;
+
+	ENTRY;
+
+	if (OBD_FAIL_PRECHECK(OBD_FAIL_LDLM_SRV_BL_AST)) {
+		LDLM_DEBUG(locks[0], "dropping batched BL AST");
+		RETURN(0);
+	}
+
+	if (exp->exp_obd->obd_recovering != 0)
+		LDLM_ERROR(locks[0], "BUG 6063: lock collide during recovery");
+
+	OBD_ALLOC(sent, sizeof(*sent) * count);
+	if (sent == NULL)
+		RETURN(-ENOMEM);
+
+	req = ptlrpc_request_alloc(exp->exp_imp_reverse,
+				   &RQF_LDLM_BL_CALLBACK_BATCH);
+	if (req == NULL)
+		GOTO(out_free, rc = -ENOMEM);
+
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_CLIENT,
+			     ldlm_request_bufsize(count, LDLM_BL_CALLBACK));
+	rc = ptlrpc_request_pack(req, LUSTRE_DLM_VERSION, LDLM_BL_CALLBACK);
+	if (rc != 0) {
+		ptlrpc_request_free(req);
+		GOTO(out_free, rc);
+	}
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_DLM_REQ);
+	body->lock_desc = *desc;
+	body->lock_flags = ldlm_flags_to_wire(locks[0]->l_flags &
+					      LDLM_FL_AST_MASK);
+
+	for (i = 0; i < count; i++) {
+		lock = locks[i];
+		ldlm_lock_reorder_req(lock);
+
+		lock_res_and_lock(lock);
+		if (ldlm_is_destroyed(lock)) {
+			unlock_res_and_lock(lock);
+			continue;
+		}
+
+		if (!ldlm_is_granted(lock)) {
+			/* see ldlm_server_blocking_ast() */
+			ldlm_add_blocked_lock(lock);
+			ldlm_set_waited(lock);
+			unlock_res_and_lock(lock);
+			LDLM_DEBUG(lock,
+				   "lock not granted, not sending blocking AST");
+			continue;
+		}
+
+		LDLM_DEBUG(lock, "server preparing batched blocking AST");
+		ldlm_set_cbpending(lock);
+		ldlm_add_waiting_lock(lock, ldlm_bl_timeout(lock));
+		unlock_res_and_lock(lock);
+
+		timeout = max(timeout, ldlm_bl_timeout(lock));
+		body->lock_handle[n++] = lock->l_remote_handle;
+		sent[i] = LDLM_LOCK_GET(lock);
+	}
+
+	if (n == 0) {
+		ptlrpc_req_finished(req);
+		GOTO(out_free, rc = 0);
+	}
+	body->lock_count = n;
+
+	/* the client returns the handles of the locks it doesn't know */
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_SERVER,
+			     ldlm_request_bufsize(n, LDLM_BL_CALLBACK));
+	ptlrpc_request_set_replen(req);
+
+	ca = ptlrpc_req_async_args(ca, req);
+	ca->ca_set_arg = arg;
+	ca->ca_locks = sent;
+	ca->ca_count = count;
+	req->rq_interpret_reply = ldlm_cb_interpret;
+
+	/* Do not resend after lock callback timeout */
+	req->rq_delay_limit = timeout;
+	req->rq_resend_cb = ldlm_update_resend;
+	req->rq_send_state = LUSTRE_IMP_FULL;
+	/* ptlrpc_request_alloc already set timeout */
+	if (AT_OFF)
+		req->rq_timeout = ldlm_get_rq_timeout();
+
+	if (exp->exp_nid_stats && exp->exp_nid_stats->nid_ldlm_stats)
+		lprocfs_counter_incr(exp->exp_nid_stats->nid_ldlm_stats,
+				     LDLM_BL_CALLBACK - LDLM_FIRST_OPC);
+	lprocfs_oh_tally_log2(&ldlm_lock_to_ns(locks[0])->ns_bl_ast_locks_hist,
+			      n);
+
+	ptlrpc_set_add_req(arg->set, req);
+
+	RETURN(0);
+
+out_free:
+	OBD_FREE(sent, sizeof(*sent) * count);
+	return rc;
+}
+
 /**
  * ->l_completion_ast callback for a remote lock in server namespace.
  *
@@ -1551,6 +1766,111 @@ retry:
 	return rc;
 }
 
+/**
+ * Server-side enqueue of a PR extent lock on a whole object, for a lock
+ * request carried by a batched RPC rather than by LDLM_ENQUEUE.
+ *
+ * The lock is only granted if it is compatible with the granted and waiting
+ * locks, no blocking or glimpse AST is sent, as for an AGL glimpse enqueue.
+ * There is no resend nor replay of the batched RPC, the lock granted is
+ * replayed by the client as any other lock.
+ *
+ * \param[in] ns	namespace of the lock
+ * \param[in] exp	export of the client
+ * \param[in] res_id	resource of the lock
+ * \param[in] remote	handle of the client lock
+ * \param[in] cbs	lock callbacks
+ * \param[out] lockh	handle of the granted lock
+ * \param[out] lvb	LVB of the resource
+ * \param[in,out] lvb_len	size of \a lvb, size filled on return
+ *
+ * 
+etval 0		lock granted, \a lockh and \a lvb filled
+ * 
+etval -EAGAIN	the lock can't be granted right now
+ * 
+etval negative	other errors
+ */
+int ldlm_handle_enqueue_nowait(struct ldlm_namespace *ns,
+			       struct obd_export *exp,
+			       const struct ldlm_res_id *res_id,
+			       const struct lustre_handle *remote,
+			       const struct ldlm_callback_suite *cbs,
+			       struct lustre_handle *lockh,
+			       void *lvb, int *lvb_len)
+{
+	ldlm_processing_policy policy;
+	enum ldlm_error err;
+	struct ldlm_lock *lock;
+	__u64 flags = 0;
+	int rc;
+
+	ENTRY;
+
+	if (ldlm_reclaim_full())
+		RETURN(-EAGAIN);
+
+	lock = ldlm_lock_create(ns, res_id, LDLM_EXTENT, LCK_PR, cbs, NULL, 0,
+				LVB_T_NONE);
+	if (IS_ERR(lock))
+		RETURN(PTR_ERR(lock));
+
+	lock->l_remote_handle = *remote;
+	lock->l_policy_data.l_extent.start = 0;
+	lock->l_policy_data.l_extent.end = OBD_OBJECT_EOF;
+	lock->l_req_extent = lock->l_policy_data.l_extent;
+	LDLM_DEBUG(lock, "server-side batched enqueue, new lock created");
+
+	rc = ldlm_lvbo_init(lock->l_resource);
+	if (rc < 0) {
+		LDLM_DEBUG(lock, "delayed lvb init failed (rc %d)", rc);
+		GOTO(out_destroy, rc);
+	}
+
+	/* see ldlm_handle_enqueue0() */
+	if (exp->exp_disconnected)
+		GOTO(out_destroy, rc = -ENOTCONN);
+
+	lock->l_export = class_export_lock_get(exp, lock);
+	if (exp->exp_lock_hash)
+		cfs_hash_add(exp->exp_lock_hash, &lock->l_remote_handle,
+			     &lock->l_exp_hash);
+
+	policy = ldlm_get_processing_policy(lock->l_resource);
+	lock_res_and_lock(lock);
+	rc = policy(lock, &flags, LDLM_PROCESS_RESCAN, &err, NULL);
+	unlock_res_and_lock(lock);
+	if (rc != LDLM_ITER_CONTINUE)
+		GOTO(out_cancel, rc = -EAGAIN);
+
+	ldlm_lock2handle(lock, lockh);
+	rc = ldlm_lvbo_fill(lock, lvb, lvb_len);
+	if (rc <= 0)
+		GOTO(out_cancel, rc = rc ?: -ENODATA);
+	*lvb_len = rc;
+
+	LDLM_DEBUG(lock, "server-side batched enqueue, lock granted");
+	LDLM_LOCK_RELEASE(lock);
+
+	RETURN(0);
+
+out_cancel:
+	LDLM_DEBUG(lock, "server-side batched enqueue, lock not granted: rc = %d",
+		   rc);
+	ldlm_lock_cancel(lock);
+	LDLM_LOCK_RELEASE(lock);
+	RETURN(rc);
+
+out_destroy:
+	lock_res_and_lock(lock);
+	ldlm_resource_unlink_lock(lock);
+	ldlm_lock_destroy_nolock(lock);
+	unlock_res_and_lock(lock);
+	LDLM_LOCK_RELEASE(lock);
+	RETURN(rc);
+}
+EXPORT_SYMBOL(ldlm_handle_enqueue_nowait);
+
 /*
  * Clear the blocking lock, the race is possible between ldlm_handle_convert0()
  * and ldlm_work_bl_ast_lock(), so this is done under lock with check for NULL.
@@ -2069,8 +2389,10 @@ static int __ldlm_bl_to_thread(struct ldlm_bl_work_item *blwi,
 		/* add LDLM_FL_DISCARD_DATA requests to the priority list */
 		list_add_tail(&blwi->blwi_entry, &blp->blp_prio_list);
 	} else {
-		/* other blocking callbacks are added to the regular list */
-		list_add_tail(&blwi->blwi_entry, &blp->blp_list);
+		/* other blocking callbacks are added to the list of the CPT
+		 * they come from, to be handled by a thread of that CPT */
+		list_add_tail(&blwi->blwi_entry,
+			      &blp->blp_cpt_lists[blwi->blwi_cpt]);
 	}
 	spin_unlock(&blp->blp_lock);
 
@@ -2099,6 +2421,7 @@ static inline void init_blwi(struct ldlm_bl_work_item *blwi,
 	if (memory_pressure_get())
 		blwi->blwi_mem_pressure = 1;
 
+	blwi->blwi_cpt = cfs_cpt_current(cfs_cpt_table, 1);
 	blwi->blwi_ns = ns;
 	blwi->blwi_flags = cancel_flags;
 	if (ld != NULL)
@@ -2233,6 +2556,124 @@ static inline void ldlm_callback_errmsg(struct ptlrpc_request *req,
 		CWARN("Send reply failed, maybe cause b=21636.\n");
 }
 
+/**
+ * Callback handler for a blocking AST sent for several extent locks at once,
+ * see ldlm_server_blocking_ast_batch().
+ *
+ * The unused locks are cancelled together by a blocking thread, so that the
+ * server gets one LDLM_CANCEL RPC for them, the locks still in use are handled
+ * one by one as for a single lock blocking AST. The reply lists the handles
+ * of the locks the client doesn't have anymore.
+ */
+static void ldlm_handle_bl_callback_batch(struct ptlrpc_request *req,
+					  struct ldlm_namespace *ns,
+					  struct ldlm_request *dlm_req)
+{
+	struct ldlm_request *rep;
+	struct ldlm_lock *lock;
+	LIST_HEAD(cancels);
+	int count = dlm_req->lock_count;
+	int nr_stale = 0;
+	int nr = 0;
+	int rc;
+	int i;
+
+	ENTRY;
+
+	if (count > LDLM_BL_AST_BATCH_MAX ||
+	    req_capsule_get_size(&req->rq_pill, &RMF_DLM_REQ, RCL_CLIENT) <
+	    ldlm_request_bufsize(count, LDLM_BL_CALLBACK)) {
+		rc = ldlm_callback_reply(req, -EPROTO);
+		ldlm_callback_errmsg(req, "Operate with invalid lock count",
+				     rc, NULL);
+		RETURN_EXIT;
+	}
+
+	req_capsule_extend(&req->rq_pill, &RQF_LDLM_BL_CALLBACK_BATCH);
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_SERVER,
+			     ldlm_request_bufsize(count, LDLM_BL_CALLBACK));
+	rc = req_capsule_server_pack(&req->rq_pill);
+	if (rc != 0) {
+		rc = ldlm_callback_reply(req, rc);
+		ldlm_callback_errmsg(req, "Cannot pack batched reply", rc,
+				     NULL);
+		RETURN_EXIT;
+	}
+	rep = req_capsule_server_get(&req->rq_pill, &RMF_DLM_REQ);
+
+	for (i = 0; i < count; i++) {
+		lock = ldlm_handle2lock_long(&dlm_req->lock_handle[i], 0);
+		if (lock == NULL) {
+			CDEBUG(D_DLMTRACE,
+			       "callback on lock %#llx - lock disappeared\n",
+			       dlm_req->lock_handle[i].cookie);
+			rep->lock_handle[nr_stale++] = dlm_req->lock_handle[i];
+			continue;
+		}
+
+		lock_res_and_lock(lock);
+		/* see ldlm_callback_handler() */
+		if ((ldlm_is_canceling(lock) && ldlm_is_bl_done(lock)) ||
+		    ldlm_is_failed(lock)) {
+			LDLM_DEBUG(lock, "batched callback on stale lock");
+			unlock_res_and_lock(lock);
+			LDLM_LOCK_RELEASE(lock);
+			rep->lock_handle[nr_stale++] = dlm_req->lock_handle[i];
+			continue;
+		}
+
+		lock->l_flags |= ldlm_flags_from_wire(dlm_req->lock_flags &
+						      LDLM_FL_AST_MASK);
+		ldlm_lock_remove_from_lru(lock);
+		ldlm_set_bl_ast(lock);
+
+		if (ldlm_is_canceling(lock)) {
+			/* somebody else sends the cancel */
+			unlock_res_and_lock(lock);
+			LDLM_LOCK_RELEASE(lock);
+			continue;
+		}
+
+		if (lock->l_readers == 0 && lock->l_writers == 0 &&
+		    lock->l_resource->lr_type == LDLM_EXTENT &&
+		    !ldlm_is_cancel_on_block(lock)) {
+			/* same as ldlm_prepare_lru_list(), the reference
+			 * from ldlm_handle2lock() is kept for the list */
+			lock->l_flags |= LDLM_FL_CBPENDING | LDLM_FL_CANCELING;
+			LASSERT(list_empty(&lock->l_bl_ast));
+			list_add(&lock->l_bl_ast, &cancels);
+			unlock_res_and_lock(lock);
+			nr++;
+			continue;
+		}
+		unlock_res_and_lock(lock);
+
+		/* lock in use, cancelled on its last dereference */
+		if (ldlm_bl_to_thread_lock(ns, &dlm_req->lock_desc, lock))
+			ldlm_handle_bl_callback(ns, &dlm_req->lock_desc, lock);
+	}
+
+	rep->lock_count = nr_stale;
+	req_capsule_shrink(&req->rq_pill, &RMF_DLM_REQ,
+			   ldlm_request_bufsize(nr_stale, LDLM_BL_CALLBACK),
+			   RCL_SERVER);
+	rc = ldlm_callback_reply(req, 0);
+	if (req->rq_no_reply || rc)
+		ldlm_callback_errmsg(req, "Batched process", rc,
+				     &dlm_req->lock_handle[0]);
+
+	CDEBUG(D_DLMTRACE, "batched blocking ast: %d locks, %d unused, %d stale\n",
+	       count, nr, nr_stale);
+	if (nr > 0 && ldlm_bl_to_thread_list(ns, &dlm_req->lock_desc,
+					     &cancels, nr, LCF_ASYNC)) {
+		/* see ldlm_bl_thread_blwi() */
+		nr = ldlm_cli_cancel_list_local(&cancels, nr, LCF_BL_AST);
+		ldlm_cli_cancel_list(&cancels, nr, NULL, 0);
+	}
+
+	EXIT;
+}
+
 /* TODO: handle requests in a similar way as MDT: see mdt_handle_common() */
 static int ldlm_callback_handler(struct ptlrpc_request *req)
 {
@@ -2317,6 +2758,13 @@ static int ldlm_callback_handler(struct ptlrpc_request *req)
 			CERROR("ldlm_cli_cancel: %d\n", rc);
 	}
 
+	if (lustre_msg_get_opc(req->rq_reqmsg) == LDLM_BL_CALLBACK &&
+	    dlm_req->lock_count > 0) {
+		CDEBUG(D_INODE, "batched blocking ast\n");
+		ldlm_handle_bl_callback_batch(req, ns, dlm_req);
+		RETURN(0);
+	}
+
 	lock = ldlm_handle2lock_long(&dlm_req->lock_handle[0], 0);
 	if (!lock) {
 		CDEBUG(D_DLMTRACE,
@@ -2649,11 +3097,36 @@ void ldlm_revoke_export_locks(struct obd_export *exp)
 EXPORT_SYMBOL(ldlm_revoke_export_locks);
 #endif /* HAVE_SERVER_SUPPORT */
 
-static int ldlm_bl_get_work(struct ldlm_bl_pool *blp,
+/**
+ * Returns the first list with regular work for a thread of CPT \a cpt:
+ * blp_list, then the list of \a cpt, then the lists of the other CPTs.
+ * Called with blp_lock held.
+ */
+static struct list_head *ldlm_bl_regular_list(struct ldlm_bl_pool *blp,
+					      int cpt)
+{
+	int i;
+
+	if (!list_empty(&blp->blp_list))
+		return &blp->blp_list;
+
+	for (i = 0; i < blp->blp_ncpts; i++) {
+		struct list_head *list;
+
+		list = &blp->blp_cpt_lists[(cpt + i) % blp->blp_ncpts];
+		if (!list_empty(list))
+			return list;
+	}
+
+	return NULL;
+}
+
+static int ldlm_bl_get_work(struct ldlm_bl_pool *blp, int cpt,
 			    struct ldlm_bl_work_item **p_blwi,
 			    struct obd_export **p_exp)
 {
 	struct ldlm_bl_work_item *blwi = NULL;
+	struct list_head *list;
 	static unsigned int num_bl;
 	static unsigned int num_stale;
 	int num_th = atomic_read(&blp->blp_num_threads);
@@ -2669,10 +3142,11 @@ static int ldlm_bl_get_work(struct ldlm_bl_pool *blp,
 		num_stale = 0;
 	}
 
-	/* process a request from the blp_list at least every blp_num_threads */
-	if (!list_empty(&blp->blp_list) &&
+	/* process a regular request at least every blp_num_threads */
+	list = ldlm_bl_regular_list(blp, cpt);
+	if (list != NULL &&
 	    (list_empty(&blp->blp_prio_list) || num_bl == 0))
-		blwi = list_entry(blp->blp_list.next,
+		blwi = list_entry(list->next,
 				  struct ldlm_bl_work_item, blwi_entry);
 	else
 		if (!list_empty(&blp->blp_prio_list))
@@ -2835,6 +3309,7 @@ static int ldlm_bl_thread_main(void *arg)
 	struct lu_env *env;
 	struct ldlm_bl_pool *blp;
 	struct ldlm_bl_thread_data *bltd = arg;
+	int cpt;
 	int rc;
 
 	ENTRY;
@@ -2851,6 +3326,16 @@ static int ldlm_bl_thread_main(void *arg)
 
 	blp = bltd->bltd_blp;
 
+	/* spread the threads over the CPTs, each one prefers the callbacks
+	 * queued from its own CPT */
+	cpt = (bltd->bltd_num - 1) % blp->blp_ncpts;
+	if (ldlm_cpu_bind && blp->blp_ncpts > 1) {
+		rc = cfs_cpt_bind(cfs_cpt_table, cpt);
+		if (rc != 0)
+			CWARN("%s: failed to bind to CPT %d: rc = %d\n",
+			      current->comm, cpt, rc);
+	}
+
 	complete(&bltd->bltd_comp);
 	/* cannot use bltd after this, it is only on caller's stack */
 
@@ -2860,12 +3345,12 @@ static int ldlm_bl_thread_main(void *arg)
 		struct obd_export *exp = NULL;
 		int rc;
 
-		rc = ldlm_bl_get_work(blp, &blwi, &exp);
+		rc = ldlm_bl_get_work(blp, cpt, &blwi, &exp);
 
 		if (rc == 0)
 			l_wait_event_exclusive(blp->blp_waitq,
-					       ldlm_bl_get_work(blp, &blwi,
-								&exp),
+					       ldlm_bl_get_work(blp, cpt,
+								&blwi, &exp),
 					       &lwi);
 		atomic_inc(&blp->blp_busy_threads);
 
@@ -3217,6 +3702,13 @@ static int ldlm_setup(void)
 	spin_lock_init(&blp->blp_lock);
 	INIT_LIST_HEAD(&blp->blp_list);
 	INIT_LIST_HEAD(&blp->blp_prio_list);
+	blp->blp_ncpts = cfs_cpt_number(cfs_cpt_table);
+	OBD_ALLOC(blp->blp_cpt_lists,
+		  sizeof(*blp->blp_cpt_lists) * blp->blp_ncpts);
+	if (blp->blp_cpt_lists == NULL)
+		GOTO(out, rc = -ENOMEM);
+	for (i = 0; i < blp->blp_ncpts; i++)
+		INIT_LIST_HEAD(&blp->blp_cpt_lists[i]);
 	init_waitqueue_head(&blp->blp_waitq);
 	atomic_set(&blp->blp_num_threads, 0);
 	atomic_set(&blp->blp_busy_threads, 0);
@@ -3297,6 +3789,9 @@ static int ldlm_cleanup(void)
 			wait_for_completion(&blp->blp_comp);
 		}
 
+		if (blp->blp_cpt_lists != NULL)
+			OBD_FREE(blp->blp_cpt_lists,
+				 sizeof(*blp->blp_cpt_lists) * blp->blp_ncpts);
 		OBD_FREE(blp, sizeof(*blp));
 	}
 
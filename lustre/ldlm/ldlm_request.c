@@ -784,6 +784,124 @@ cleanup:
 }
 EXPORT_SYMBOL(ldlm_cli_enqueue_fini);
 
+/**
+ * Create a client extent lock to be granted by a request batching lock
+ * requests for many resources, rather than by LDLM_ENQUEUE.
+ *
+ * The handle of the lock is packed in the request by the caller, which
+ * calls ldlm_cli_enqueue_batch_fini() for the reply. Like for
+ * ldlm_cli_enqueue(), the lock has a reference of \a einfo->ei_mode.
+ */
+int ldlm_cli_enqueue_batch(struct obd_export *exp,
+			   struct ldlm_enqueue_info *einfo,
+			   const struct ldlm_res_id *res_id,
+			   union ldlm_policy_data const *policy,
+			   __u32 lvb_len, enum lvb_type lvb_type,
+			   struct lustre_handle *lockh)
+{
+	const struct ldlm_callback_suite cbs = {
+		.lcs_completion = einfo->ei_cb_cp,
+		.lcs_blocking	= einfo->ei_cb_bl,
+		.lcs_glimpse	= einfo->ei_cb_gl
+	};
+	struct ldlm_lock *lock;
+
+	ENTRY;
+
+	LASSERT(einfo->ei_type == LDLM_EXTENT);
+
+	lock = ldlm_lock_create(exp->exp_obd->obd_namespace, res_id,
+				einfo->ei_type, einfo->ei_mode, &cbs,
+				einfo->ei_cbdata, lvb_len, lvb_type);
+	if (IS_ERR(lock))
+		RETURN(PTR_ERR(lock));
+
+	/* for the local lock, add the reference */
+	ldlm_lock_addref_internal(lock, einfo->ei_mode);
+	ldlm_lock2handle(lock, lockh);
+	lock->l_policy_data = *policy;
+	lock->l_req_extent = policy->l_extent;
+	lock->l_conn_export = exp;
+	lock->l_export = NULL;
+	lock->l_activity = ktime_get_real_seconds();
+	LDLM_DEBUG(lock, "client-side batched enqueue START");
+
+	/* the reference of ldlm_lock_create() is put by the fini */
+	RETURN(0);
+}
+EXPORT_SYMBOL(ldlm_cli_enqueue_batch);
+
+/**
+ * Finishing portion of the enqueue of a lock created by
+ * ldlm_cli_enqueue_batch(), called for the reply to the batched request.
+ *
+ * \param[in] exp	export the request was sent to
+ * \param[in] lockh	handle of the client lock
+ * \param[in] mode	mode of the client lock
+ * \param[in] remote	handle of the lock granted by the server
+ * \param[in] lvb	LVB returned with the lock
+ * \param[in] lvb_len	size of \a lvb
+ * \param[in] rc	0 if the lock was granted, negative errno else
+ *
+ * \retval 0		the lock is granted, with a reference of \a mode
+ * \retval negative	the lock is failed, with no reference left
+ */
+int ldlm_cli_enqueue_batch_fini(struct obd_export *exp,
+				const struct lustre_handle *lockh,
+				enum ldlm_mode mode,
+				const struct lustre_handle *remote,
+				void *lvb, __u32 lvb_len, int rc)
+{
+	struct ldlm_namespace *ns = exp->exp_obd->obd_namespace;
+	struct ldlm_lock *lock;
+	__u64 flags = 0;
+
+	ENTRY;
+
+	lock = ldlm_handle2lock(lockh);
+	LASSERT(lock != NULL);
+
+	if (rc != 0) {
+		LDLM_DEBUG(lock, "client-side batched enqueue END (FAILED)");
+		GOTO(cleanup, rc);
+	}
+
+	if (unlikely(lvb_len > lock->l_lvb_len)) {
+		LDLM_ERROR(lock,
+			   "Replied LVB is larger than expectation, expected = %d, replied = %d",
+			   lock->l_lvb_len, lvb_len);
+		GOTO(cleanup, rc = -EINVAL);
+	}
+
+	lock_res_and_lock(lock);
+	/* see ldlm_cli_enqueue_fini() */
+	if (exp->exp_lock_hash)
+		cfs_hash_rehash_key(exp->exp_lock_hash,
+				    &lock->l_remote_handle, (void *)remote,
+				    &lock->l_exp_hash);
+	else
+		lock->l_remote_handle = *remote;
+	memcpy(lock->l_lvb_data, lvb, lvb_len);
+	unlock_res_and_lock(lock);
+
+	rc = ldlm_lock_enqueue(NULL, ns, &lock, NULL, &flags);
+	if (rc == ELDLM_OK && lock->l_completion_ast != NULL)
+		rc = lock->l_completion_ast(lock, flags, NULL);
+
+	LDLM_DEBUG(lock, "client-side batched enqueue END");
+	EXIT;
+cleanup:
+	if (rc)
+		failed_lock_cleanup(ns, lock, mode);
+	/* Put lock 2 times, the second reference is held since
+	 * ldlm_cli_enqueue_batch()
+	 */
+	LDLM_LOCK_PUT(lock);
+	LDLM_LOCK_RELEASE(lock);
+	return rc;
+}
+EXPORT_SYMBOL(ldlm_cli_enqueue_batch_fini);
+
 /**
  * Estimate number of lock handles that would fit into request of given
  * size.  PAGE_SIZE-512 is to allow TCP/IP and LNET headers to fit into
@@ -636,6 +636,34 @@ static ssize_t contended_locks_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(contended_locks);
 
+static ssize_t contended_rate_show(struct kobject *kobj,
+				   struct attribute *attr, char *buf)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+
+	return sprintf(buf, "%u\n", ns->ns_contended_rate);
+}
+
+static ssize_t contended_rate_store(struct kobject *kobj,
+				    struct attribute *attr,
+				    const char *buffer, size_t count)
+{
+	struct ldlm_namespace *ns = container_of(kobj, struct ldlm_namespace,
+						 ns_kobj);
+	unsigned long tmp;
+	int err;
+
+	err = kstrtoul(buffer, 10, &tmp);
+	if (err != 0)
+		return -EINVAL;
+
+	ns->ns_contended_rate = tmp;
+
+	return count;
+}
+LUSTRE_RW_ATTR(contended_rate);
+
 static ssize_t max_parallel_ast_show(struct kobject *kobj,
 				     struct attribute *attr, char *buf)
 {
@@ -681,6 +709,7 @@ static struct attribute *ldlm_ns_attrs[] = {
 	&lustre_attr_max_nolock_bytes.attr,
 	&lustre_attr_contention_seconds.attr,
 	&lustre_attr_contended_locks.attr,
+	&lustre_attr_contended_rate.attr,
 	&lustre_attr_max_parallel_ast.attr,
 #endif
 	NULL,
@@ -699,6 +728,170 @@ static struct kobj_type ldlm_ns_ktype = {
 	.release	= ldlm_ns_release,
 };
 
+#ifdef HAVE_SERVER_SUPPORT
+/* Number of resources listed in "contended_resources". */
+#define LDLM_CONTENDED_TOP	16
+
+struct ldlm_contended_res {
+	struct ldlm_res_id	lcr_name;
+	__u32			lcr_rate;
+	__u32			lcr_contended;
+};
+
+struct ldlm_contended_top {
+	int			  lct_count;
+	struct ldlm_contended_res lct_res[LDLM_CONTENDED_TOP];
+};
+
+static int ldlm_res_hash_contended(struct cfs_hash *hs, struct cfs_hash_bd *bd,
+				   struct hlist_node *hnode, void *arg)
+{
+	struct ldlm_resource *res = cfs_hash_object(hs, hnode);
+	struct ldlm_contended_top *top = arg;
+	struct ldlm_contended_res *lcr;
+	__u32 rate;
+	bool contended;
+	int i;
+
+	if (res->lr_type != LDLM_EXTENT)
+		return 0;
+
+	lock_res(res);
+	contended = ldlm_resource_contention_update(res, 0);
+	rate = res->lr_conflict_rate;
+	unlock_res(res);
+
+	if (rate == 0)
+		return 0;
+
+	/* keep lct_res sorted by decreasing rate */
+	for (i = top->lct_count; i > 0; i--) {
+		if (top->lct_res[i - 1].lcr_rate >= rate)
+			break;
+		if (i < LDLM_CONTENDED_TOP)
+			top->lct_res[i] = top->lct_res[i - 1];
+	}
+	if (i == LDLM_CONTENDED_TOP)
+		return 0;
+
+	lcr = &top->lct_res[i];
+	lcr->lcr_name = res->lr_name;
+	lcr->lcr_rate = rate;
+	lcr->lcr_contended = contended;
+	if (top->lct_count < LDLM_CONTENDED_TOP)
+		top->lct_count++;
+
+	return 0;
+}
+
+static int seq_contended_resources_show(struct seq_file *m, void *data)
+{
+	struct ldlm_namespace *ns = m->private;
+	struct ldlm_contended_top *top;
+	struct ldlm_contended_res *lcr;
+	int i;
+
+	OBD_ALLOC_PTR(top);
+	if (top == NULL)
+		return -ENOMEM;
+
+	cfs_hash_for_each_nolock(ns->ns_rs_hash, ldlm_res_hash_contended,
+				 top, 0);
+
+	for (i = 0; i < top->lct_count; i++) {
+		lcr = &top->lct_res[i];
+		seq_printf(m, "- resource: "DLDLMRES"\n"
+			   "  conflict_rate: %u\n"
+			   "  mode: %s\n",
+			   lcr->lcr_name.name[0], lcr->lcr_name.name[1],
+			   lcr->lcr_name.name[2], lcr->lcr_name.name[3],
+			   lcr->lcr_rate,
+			   lcr->lcr_contended ? "managed" : "normal");
+	}
+	OBD_FREE_PTR(top);
+
+	return 0;
+}
+
+static int seq_contended_resources_open(struct inode *inode,
+					struct file *file)
+{
+	return single_open(file, seq_contended_resources_show,
+			   inode->i_private);
+}
+
+static const struct file_operations ldlm_contended_resources_fops = {
+	.owner	= THIS_MODULE,
+	.open	= seq_contended_resources_open,
+	.read	= seq_read,
+	.llseek	= seq_lseek,
+	.release = single_release,
+};
+
+static void seq_hist_show(struct seq_file *m, const char *title,
+			  struct obd_histogram *oh)
+{
+	unsigned long tot = lprocfs_oh_sum(oh);
+	unsigned long cum = 0;
+	int i;
+
+	seq_printf(m, "\n%-21s   count   %% cum %%\n", title);
+	if (tot == 0)
+		return;
+
+	for (i = 0; i < OBD_HIST_MAX; i++) {
+		unsigned long n = oh->oh_buckets[i];
+
+		cum += n;
+		seq_printf(m, "%u:\t\t%10lu %3u %3u\n", 1U << i, n,
+			   pct(n, tot), pct(cum, tot));
+		if (cum == tot)
+			break;
+	}
+}
+
+static int seq_bl_ast_stats_show(struct seq_file *m, void *data)
+{
+	struct ldlm_namespace *ns = m->private;
+	struct timespec64 now;
+
+	ktime_get_real_ts64(&now);
+	seq_printf(m, "snapshot_time:         %lld.%09lu (secs.nsecs)\n",
+		   (s64)now.tv_sec, now.tv_nsec);
+	seq_hist_show(m, "locks per bl AST", &ns->ns_bl_ast_locks_hist);
+	seq_hist_show(m, "bl AST fan-out usec", &ns->ns_bl_ast_time_hist);
+
+	return 0;
+}
+
+static ssize_t seq_bl_ast_stats_write(struct file *file,
+				      const char __user *buffer,
+				      size_t count, loff_t *off)
+{
+	struct ldlm_namespace *ns =
+		((struct seq_file *)file->private_data)->private;
+
+	lprocfs_oh_clear(&ns->ns_bl_ast_locks_hist);
+	lprocfs_oh_clear(&ns->ns_bl_ast_time_hist);
+
+	return count;
+}
+
+static int seq_bl_ast_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, seq_bl_ast_stats_show, inode->i_private);
+}
+
+static const struct file_operations ldlm_bl_ast_stats_fops = {
+	.owner	= THIS_MODULE,
+	.open	= seq_bl_ast_stats_open,
+	.read	= seq_read,
+	.write	= seq_bl_ast_stats_write,
+	.llseek	= seq_lseek,
+	.release = single_release,
+};
+#endif /* HAVE_SERVER_SUPPORT */
+
 static void ldlm_namespace_debugfs_unregister(struct ldlm_namespace *ns)
 {
 	if (IS_ERR_OR_NULL(ns->ns_debugfs_entry))
@@ -750,6 +943,16 @@ static int ldlm_namespace_debugfs_register(struct ldlm_namespace *ns)
 		if (!ns_entry)
 			return -ENOMEM;
 		ns->ns_debugfs_entry = ns_entry;
+#ifdef HAVE_SERVER_SUPPORT
+		if (ns_is_server(ns)) {
+			debugfs_create_file("contended_resources", 0444,
+					    ns_entry, ns,
+					    &ldlm_contended_resources_fops);
+			debugfs_create_file("bl_ast_stats", 0644,
+					    ns_entry, ns,
+					    &ldlm_bl_ast_stats_fops);
+		}
+#endif
 	}
 
 	return 0;
@@ -985,8 +1188,11 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
 	ns->ns_max_nolock_size    = NS_DEFAULT_MAX_NOLOCK_BYTES;
 	ns->ns_contention_time    = NS_DEFAULT_CONTENTION_SECONDS;
 	ns->ns_contended_locks    = NS_DEFAULT_CONTENDED_LOCKS;
+	ns->ns_contended_rate     = NS_DEFAULT_CONTENDED_RATE;
 
 	ns->ns_max_parallel_ast   = LDLM_DEFAULT_PARALLEL_AST_LIMIT;
+	spin_lock_init(&ns->ns_bl_ast_locks_hist.oh_lock);
+	spin_lock_init(&ns->ns_bl_ast_time_hist.oh_lock);
 	ns->ns_nr_unused          = 0;
 	ns->ns_max_unused         = LDLM_DEFAULT_LRU_SIZE;
 	ns->ns_max_age            = ktime_set(LDLM_DEFAULT_MAX_ALIVE, 0);
@@ -1672,6 +1878,58 @@ void ldlm_resource_insert_lock_after(struct ldlm_lock *original,
  out:;
 }
 
+#ifdef HAVE_SERVER_SUPPORT
+/**
+ * Account \a conflicts conflicting locks met by an enqueue on \a res.
+ *
+ * The conflict rate of the resource is halved every ns_contention_time
+ * seconds, so it follows how much the resource is fought over lately. Once
+ * it reaches ns_contended_rate, the resource is switched to the server
+ * managed contended mode, which is left when the rate decays below half of
+ * that threshold.
+ *
+ * \retval true if the resource is in the contended mode
+ */
+bool ldlm_resource_contention_update(struct ldlm_resource *res, int conflicts)
+{
+	struct ldlm_namespace *ns = ldlm_res_to_ns(res);
+	time64_t now = ktime_get_seconds();
+	time64_t period = max_t(time64_t, ns->ns_contention_time, 1);
+	time64_t shift;
+
+	check_res_locked(res);
+
+	shift = div64_s64(now - res->lr_conflict_time, period);
+	if (shift > 0) {
+		res->lr_conflict_rate = shift < 32 ?
+					res->lr_conflict_rate >> shift : 0;
+		res->lr_conflict_time = shift < 32 ?
+					res->lr_conflict_time + shift * period :
+					now;
+	}
+	if (conflicts > 0 && res->lr_conflict_rate < UINT_MAX - conflicts)
+		res->lr_conflict_rate += conflicts;
+
+	if (ns->ns_contended_rate == 0) {
+		res->lr_contended = 0;
+	} else if (!res->lr_contended &&
+		   res->lr_conflict_rate >= ns->ns_contended_rate) {
+		res->lr_contended = 1;
+		CDEBUG(D_DLMTRACE, "%s: resource "DLDLMRES" is contended, "
+		       "conflict rate %u\n", ldlm_ns_name(ns), PLDLMRES(res),
+		       res->lr_conflict_rate);
+	} else if (res->lr_contended &&
+		   res->lr_conflict_rate < ns->ns_contended_rate / 2) {
+		res->lr_contended = 0;
+		CDEBUG(D_DLMTRACE, "%s: resource "DLDLMRES" is no longer "
+		       "contended, conflict rate %u\n", ldlm_ns_name(ns),
+		       PLDLMRES(res), res->lr_conflict_rate);
+	}
+
+	return res->lr_contended;
+}
+#endif /* HAVE_SERVER_SUPPORT */
+
 void ldlm_resource_unlink_lock(struct ldlm_lock *lock)
 {
 	int type = lock->l_resource->lr_type;
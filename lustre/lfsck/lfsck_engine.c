@@ -1556,6 +1556,101 @@ again:
 	RETURN(rc != 0 ? rc : rc1);
 }
 
+/* Return the first phase1 request that no assistant thread is handling.
+ * The caller should hold lad_lock. */
+static struct lfsck_assistant_req *
+lfsck_assistant_req_next(struct lfsck_assistant_data *lad)
+{
+	struct lfsck_assistant_req *lar;
+
+	list_for_each_entry(lar, &lad->lad_req_list, lar_list) {
+		if (!lar->lar_busy)
+			return lar;
+	}
+
+	return NULL;
+}
+
+static inline bool lfsck_assistant_req_ready(struct lfsck_assistant_data *lad)
+{
+	bool ready;
+
+	spin_lock(&lad->lad_lock);
+	ready = lfsck_assistant_req_next(lad) != NULL;
+	spin_unlock(&lad->lad_lock);
+
+	return ready;
+}
+
+/**
+ * Handle one phase1 request.
+ *
+ * The handled request is kept on lad_req_list until it has been done, so
+ * the head of the list is always the earliest unfinished one, which is
+ * what la_fill_pos() and the checkpoint rely on. Only the LFSCK engine
+ * adds new requests at the end of the list.
+ *
+ * \param[in] env	pointer to the thread context
+ * \param[in] com	pointer to the lfsck component
+ * \param[in] idx	index of the calling assistant thread
+ *
+ * \retval		1 if some request has been handled
+ * \retval		0 if there is no request to be handled
+ * \retval		negative error number on failure with LPF_FAILOUT
+ */
+static int lfsck_assistant_handle_one(const struct lu_env *env,
+				      struct lfsck_component *com, int idx)
+{
+	struct lfsck_instance		*lfsck	 = com->lc_lfsck;
+	struct lfsck_bookmark		*bk	 = &lfsck->li_bookmark_ram;
+	struct lfsck_assistant_data	*lad	 = com->lc_data;
+	struct ptlrpc_thread		*mthread = &lfsck->li_thread;
+	struct ptlrpc_thread		*athread = &lad->lad_thread;
+	struct lfsck_assistant_req	*lar;
+	bool				 wakeup  = false;
+	bool				 more	 = false;
+	int				 rc;
+
+	spin_lock(&lad->lad_lock);
+	lar = lfsck_assistant_req_next(lad);
+	if (lar == NULL) {
+		spin_unlock(&lad->lad_lock);
+		return 0;
+	}
+
+	lar->lar_busy = true;
+	/* Let another idle thread take the next request. */
+	if (lad->lad_workers > 0 && lar->lar_list.next != &lad->lad_req_list)
+		more = true;
+	spin_unlock(&lad->lad_lock);
+	if (more)
+		wake_up_all(&athread->t_ctl_waitq);
+
+	rc = lad->lad_ops->la_handler_p1(env, com, lar);
+	spin_lock(&lad->lad_lock);
+	list_del_init(&lar->lar_list);
+	lad->lad_prefetched--;
+	lad->lad_handled[idx]++;
+	/* Wake up the main engine thread only when the list
+	 * is empty or half of the prefetched items have been
+	 * handled to avoid too frequent thread schedule. */
+	if (lad->lad_prefetched <= (bk->lb_async_windows / 2))
+		wakeup = true;
+	/* The assistant may wait for the workers to drain the list. */
+	more = lad->lad_workers > 0 && list_empty(&lad->lad_req_list);
+	spin_unlock(&lad->lad_lock);
+	if (wakeup)
+		wake_up_all(&mthread->t_ctl_waitq);
+	if (more)
+		wake_up_all(&athread->t_ctl_waitq);
+
+	lad->lad_ops->la_req_fini(env, lar);
+	if (rc < 0 && bk->lb_param & LPF_FAILOUT)
+		return rc;
+
+	return 1;
+}
+
 /**
  * The LFSCK assistant thread is triggered by the LFSCK main engine.
  * They co-work together as an asynchronous pipeline: the LFSCK main
@@ -1580,7 +1675,6 @@ int lfsck_assistant_engine(void *args)
 	struct lu_env			  *env	   = &lta->lta_env;
 	struct lfsck_component		  *com     = lta->lta_com;
 	struct lfsck_instance		  *lfsck   = lta->lta_lfsck;
-	struct lfsck_bookmark		  *bk	   = &lfsck->li_bookmark_ram;
 	struct lfsck_position		  *pos     = &com->lc_pos_start;
 	struct lfsck_thread_info	  *info    = lfsck_env_info(env);
 	struct lfsck_request		  *lr      = &info->lti_lr;
@@ -1616,51 +1710,40 @@ int lfsck_assistant_engine(void *args)
 	spin_unlock(&lad->lad_lock);
 	wake_up_all(&mthread->t_ctl_waitq);
 
-	while (1) {
-		while (!list_empty(&lad->lad_req_list)) {
-			bool wakeup = false;
+	lfsck_start_assistant_workers(com);
 
+	while (1) {
+		while (1) {
 			if (unlikely(test_bit(LAD_EXIT, &lad->lad_flags) ||
 				     !thread_is_running(mthread)))
 				GOTO(cleanup, rc = lad->lad_post_result);
 
-			lar = list_entry(lad->lad_req_list.next,
-					 struct lfsck_assistant_req,
-					 lar_list);
-			/* Only the lfsck_assistant_engine thread itself can
-			 * remove the "lar" from the head of the list, LFSCK
-			 * engine thread only inserts other new "lar" at the
-			 * end of the list. So it is safe to handle current
-			 * "lar" without the spin_lock. */
-			rc = lao->la_handler_p1(env, com, lar);
-			spin_lock(&lad->lad_lock);
-			list_del_init(&lar->lar_list);
-			lad->lad_prefetched--;
-			/* Wake up the main engine thread only when the list
-			 * is empty or half of the prefetched items have been
-			 * handled to avoid too frequent thread schedule. */
-			if (lad->lad_prefetched <= (bk->lb_async_windows / 2))
-				wakeup = true;
-			spin_unlock(&lad->lad_lock);
-			if (wakeup)
-				wake_up_all(&mthread->t_ctl_waitq);
+			if (unlikely(lad->lad_workers_status < 0))
+				GOTO(cleanup, rc = lad->lad_workers_status);
 
-			lao->la_req_fini(env, lar);
-			if (rc < 0 && bk->lb_param & LPF_FAILOUT)
+			rc = lfsck_assistant_handle_one(env, com, 0);
+			if (rc < 0)
 				GOTO(cleanup, rc);
+
+			if (rc == 0)
+				break;
 		}
 
+		/* Some requests may be still in handling by the workers,
+		 * wait for them before the post or the double scan. */
 		l_wait_event(athread->t_ctl_waitq,
-			     !lfsck_assistant_req_empty(lad) ||
+			     lfsck_assistant_req_ready(lad) ||
 			     test_bit(LAD_EXIT, &lad->lad_flags) ||
-			     test_bit(LAD_TO_POST, &lad->lad_flags) ||
-			     test_bit(LAD_TO_DOUBLE_SCAN, &lad->lad_flags),
+			     lad->lad_workers_status < 0 ||
+			     (lfsck_assistant_req_empty(lad) &&
+			      (test_bit(LAD_TO_POST, &lad->lad_flags) ||
+			       test_bit(LAD_TO_DOUBLE_SCAN, &lad->lad_flags))),
 			     &lwi);
 
 		if (unlikely(test_bit(LAD_EXIT, &lad->lad_flags)))
 			GOTO(cleanup, rc = lad->lad_post_result);
 
-		if (!list_empty(&lad->lad_req_list))
+		if (!lfsck_assistant_req_empty(lad))
 			continue;
 
 		if (test_bit(LAD_TO_POST, &lad->lad_flags)) {
@@ -1758,6 +1841,8 @@ p2_next:
 	}
 
 cleanup:
+	lfsck_stop_assistant_workers(com);
+
 	/* Cleanup the unfinished requests. */
 	spin_lock(&lad->lad_lock);
 	if (rc < 0)
@@ -1865,3 +1950,63 @@ fini:
 
 	return rc;
 }
+
+/**
+ * The LFSCK assistant worker is started by the assistant thread of the
+ * component whose la_handler_p1() can run concurrently. It handles the
+ * phase1 requests in parallel with the assistant thread, which remains
+ * the only one to drive the post, the double scan and the notifications
+ * to other targets. The worker exits when the assistant stops it, or on
+ * the first failure with LPF_FAILOUT, which is then reported to the
+ * assistant through lad_workers_status.
+ */
+int lfsck_assistant_worker(void *args)
+{
+	struct lfsck_thread_args	*lta	 = args;
+	struct lu_env			*env	 = &lta->lta_env;
+	struct lfsck_component		*com	 = lta->lta_com;
+	struct lfsck_instance		*lfsck	 = lta->lta_lfsck;
+	struct lfsck_assistant_data	*lad	 = com->lc_data;
+	struct ptlrpc_thread		*mthread = &lfsck->li_thread;
+	struct ptlrpc_thread		*athread = &lad->lad_thread;
+	struct l_wait_info		 lwi	 = { 0 };
+	int				 rc	 = 0;
+
+	CDEBUG(D_LFSCK, "%s: %s LFSCK assistant worker %d start\n",
+	       lfsck_lfsck2name(lfsck), lad->lad_name, lta->lta_idx);
+
+	while (1) {
+		l_wait_event(athread->t_ctl_waitq,
+			     lfsck_assistant_req_ready(lad) ||
+			     test_bit(LAD_WORKERS_STOP, &lad->lad_flags) ||
+			     test_bit(LAD_EXIT, &lad->lad_flags),
+			     &lwi);
+
+		if (test_bit(LAD_WORKERS_STOP, &lad->lad_flags) ||
+		    test_bit(LAD_EXIT, &lad->lad_flags) ||
+		    !thread_is_running(mthread))
+			break;
+
+		rc = lfsck_assistant_handle_one(env, com, lta->lta_idx);
+		if (rc < 0) {
+			spin_lock(&lad->lad_lock);
+			if (lad->lad_workers_status == 0)
+				lad->lad_workers_status = rc;
+			spin_unlock(&lad->lad_lock);
+			break;
+		}
+	}
+
+	CDEBUG(D_LFSCK, "%s: %s LFSCK assistant worker %d exit: rc = %d\n",
+	       lfsck_lfsck2name(lfsck), lad->lad_name, lta->lta_idx, rc);
+
+	lfsck_thread_args_fini(lta);
+	/* The assistant holds lad_lock after the last worker exits, so
+	 * the component cannot be released before the wakeup is done. */
+	spin_lock(&lad->lad_lock);
+	atomic_dec(&lad->lad_workers_running);
+	wake_up_all(&athread->t_ctl_waitq);
+	spin_unlock(&lad->lad_lock);
+
+	return rc < 0 ? rc : 0;
+}
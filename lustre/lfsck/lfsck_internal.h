@@ -364,8 +364,17 @@ struct lfsck_layout {
 	/* The latest object has been processed (failed) during double scan. */
 	struct lfsck_layout_dangling_key ll_lldk_latest_scanned_phase2;
 
+	/* How many regular files have had their LSOM checked. */
+	u64	ll_som_checked;
+
+	/* How many of them had a missing or out-of-date LSOM. */
+	u64	ll_som_stale;
+
+	/* How many LSOM have been refreshed from the OST-objects. */
+	u64	ll_som_refreshed;
+
 	/* For further using */
-	u64	ll_reserved_2[7];
+	u64	ll_reserved_2[4];
 
 	/* The OST targets bitmap to record the OSTs that contain
 	 * non-verified OST-objects. */
@@ -379,6 +388,16 @@ struct lfsck_assistant_object {
 	atomic_t		lso_ref;
 	unsigned int		lso_dead:1,
 				lso_is_dir:1;
+
+	/* The size and blocks of the file accumulated by the layout LFSCK
+	 * from its OST-objects, to refresh the LSOM. */
+	spinlock_t		lso_som_lock;
+	__u64			lso_som_size;
+	__u64			lso_som_blocks;
+	/* # of OST-objects not accounted yet, plus one for the master */
+	atomic_t		lso_som_pending;
+	/* Some OST-object cannot be accounted, do not touch the LSOM. */
+	bool			lso_som_skip;
 };
 
 struct lfsck_component;
@@ -767,11 +786,15 @@ struct lfsck_thread_args {
 	struct lfsck_instance		*lta_lfsck;
 	struct lfsck_component		*lta_com;
 	struct lfsck_start_param	*lta_lsp;
+	/* index of the assistant worker, 0 for the assistant itself */
+	int				 lta_idx;
 };
 
 struct lfsck_assistant_req {
 	struct list_head		 lar_list;
 	struct lfsck_assistant_object	*lar_parent;
+	/* some assistant thread is handling this request */
+	bool				 lar_busy;
 };
 
 struct lfsck_namespace_req {
@@ -792,6 +815,10 @@ struct lfsck_layout_req {
 	__u32				 llr_comp_id;
 	__u32				 llr_ost_idx;
 	__u32				 llr_lov_idx; /* offset in LOV EA */
+	__u32				 llr_stripe_size;
+	__u16				 llr_stripe_count;
+	bool				 llr_som_done;
+	__u64				 llr_comp_end;
 };
 
 struct lfsck_assistant_operations {
@@ -816,8 +843,14 @@ struct lfsck_assistant_operations {
 	void (*la_sync_failures)(const struct lu_env *env,
 				 struct lfsck_component *com,
 				 struct lfsck_request *lr);
+
+	/* la_handler_p1() can handle several requests concurrently */
+	bool la_parallel_p1;
 };
 
+/* the assistant plus its workers */
+#define LFSCK_ASSISTANT_THREADS_MAX	32
+
 struct lfsck_assistant_data {
 	spinlock_t				 lad_lock;
 	struct list_head			 lad_req_list;
@@ -854,6 +887,21 @@ struct lfsck_assistant_data {
 	int					 lad_post_result;
 	unsigned long				 lad_flags;
 	bool					 lad_advance_lock;
+
+	/* # of workers handling phase1 requests besides the assistant */
+	int					 lad_workers;
+	atomic_t				 lad_workers_running;
+	/* failure of some worker, to be reported by the assistant */
+	int					 lad_workers_status;
+	/* # of phase1 requests handled per thread, [0] is the assistant */
+	__u64				lad_handled[LFSCK_ASSISTANT_THREADS_MAX];
+
+	/* files whose LSOM is to be checked by the layout LFSCK in the
+	 * next grouped transaction, protected by lad_lock */
+	struct list_head			 lad_som_list;
+	int					 lad_som_count;
+	/* serialize the LSOM transactions */
+	struct mutex				 lad_som_mutex;
 };
 enum {
 	LAD_TO_POST = 0,
@@ -861,6 +909,7 @@ enum {
 	LAD_IN_DOUBLE_SCAN = 2,
 	LAD_EXIT = 3,
 	LAD_INCOMPLETE = 4,
+	LAD_WORKERS_STOP = 5,
 };
 
 #define LFSCK_TMPBUF_LEN	64
@@ -902,6 +951,7 @@ struct lfsck_thread_info {
 	struct ldlm_enqueue_info lti_einfo;
 	struct ldlm_res_id	lti_resid;
 	struct filter_fid	lti_ff;
+	struct lustre_som_attrs	lti_som;
 	struct dt_allocation_hint lti_hint;
 	struct lu_orphan_rec_v3	lti_rec;
 	struct lov_user_md	lti_lum;
@@ -976,6 +1026,10 @@ int lfsck_async_request(const struct lu_env *env, struct obd_export *exp,
 int lfsck_query_all(const struct lu_env *env, struct lfsck_component *com);
 int lfsck_start_assistant(const struct lu_env *env, struct lfsck_component *com,
 			  struct lfsck_start_param *lsp);
+void lfsck_start_assistant_workers(struct lfsck_component *com);
+void lfsck_stop_assistant_workers(struct lfsck_component *com);
+void lfsck_assistant_handled_dump(struct seq_file *m,
+				  struct lfsck_assistant_data *lad);
 int lfsck_checkpoint_generic(const struct lu_env *env,
 			     struct lfsck_component *com);
 void lfsck_post_generic(const struct lu_env *env,
@@ -1003,6 +1057,7 @@ int lfsck_open_dir(const struct lu_env *env,
 		   struct lfsck_instance *lfsck, __u64 cookie);
 int lfsck_master_engine(void *args);
 int lfsck_assistant_engine(void *args);
+int lfsck_assistant_worker(void *args);
 
 /* lfsck_bookmark.c */
 void lfsck_bookmark_cpu_to_le(struct lfsck_bookmark *des,
@@ -851,6 +851,9 @@ static void lfsck_layout_le_to_cpu(struct lfsck_layout *des,
 	des->ll_bitmap_size = le32_to_cpu(src->ll_bitmap_size);
 	lldk_le_to_cpu(&des->ll_lldk_latest_scanned_phase2,
 		       &src->ll_lldk_latest_scanned_phase2);
+	des->ll_som_checked = le64_to_cpu(src->ll_som_checked);
+	des->ll_som_stale = le64_to_cpu(src->ll_som_stale);
+	des->ll_som_refreshed = le64_to_cpu(src->ll_som_refreshed);
 }
 
 static void lfsck_layout_cpu_to_le(struct lfsck_layout *des,
@@ -883,6 +886,9 @@ static void lfsck_layout_cpu_to_le(struct lfsck_layout *des,
 	des->ll_bitmap_size = cpu_to_le32(src->ll_bitmap_size);
 	lldk_cpu_to_le(&des->ll_lldk_latest_scanned_phase2,
 		       &src->ll_lldk_latest_scanned_phase2);
+	des->ll_som_checked = cpu_to_le64(src->ll_som_checked);
+	des->ll_som_stale = cpu_to_le64(src->ll_som_stale);
+	des->ll_som_refreshed = cpu_to_le64(src->ll_som_refreshed);
 }
 
 /**
@@ -4238,9 +4244,306 @@ out:
 	return rc;
 }
 
-static int lfsck_layout_assistant_handler_p1(const struct lu_env *env,
-					     struct lfsck_component *com,
-					     struct lfsck_assistant_req *lar)
+/* How many files have their LSOM checked in one local transaction. */
+#define LFSCK_SOM_BATCH		64
+
+struct lfsck_layout_som {
+	struct list_head	 lls_list;
+	struct lu_fid		 lls_fid;
+	struct dt_object	*lls_obj;
+	__u64			 lls_size;
+	__u64			 lls_blocks;
+	/* the LSOM xattr as found by the check, in disk order */
+	struct lustre_som_attrs	 lls_som;
+	/* the size of the LSOM xattr found, 0 if there was none */
+	int			 lls_som_len;
+	bool			 lls_update;
+};
+
+/**
+ * Account the OST-object size and blocks for the LSOM of the file.
+ *
+ * The end of the data in the OST-object is mapped back to the file offset
+ * in the same way as the client does to merge the glimpse results, then it
+ * is capped by the end of the component. The file size is the largest one
+ * over all the OST-objects, the blocks are the sum of them.
+ *
+ * \param[in] lso	the file to be refreshed
+ * \param[in] llr	the stripe that has been checked
+ * \param[in] cla	the OST-object attribute
+ */
+static void lfsck_layout_som_account(struct lfsck_assistant_object *lso,
+				     struct lfsck_layout_req *llr,
+				     const struct lu_attr *cla)
+{
+	__u64 size = 0;
+
+	if (cla->la_size > 0 && llr->llr_stripe_size > 0) {
+		__u64 chunk = cla->la_size - 1;
+		__u32 off = do_div(chunk, llr->llr_stripe_size);
+
+		size = (chunk * llr->llr_stripe_count + llr->llr_lov_idx) *
+		       llr->llr_stripe_size + off + 1;
+		if (size > llr->llr_comp_end)
+			size = llr->llr_comp_end;
+	}
+
+	spin_lock(&lso->lso_som_lock);
+	if (size > lso->lso_som_size)
+		lso->lso_som_size = size;
+	lso->lso_som_blocks += cla->la_blocks;
+	spin_unlock(&lso->lso_som_lock);
+	llr->llr_som_done = true;
+}
+
+static void lfsck_layout_som_free(const struct lu_env *env,
+				  struct list_head *head)
+{
+	struct lfsck_layout_som *lls;
+	struct lfsck_layout_som *next;
+
+	list_for_each_entry_safe(lls, next, head, lls_list) {
+		list_del(&lls->lls_list);
+		if (lls->lls_obj != NULL)
+			lfsck_object_put(env, lls->lls_obj);
+		OBD_FREE_PTR(lls);
+	}
+}
+
+/**
+ * Check whether the LSOM of the file changed since it was checked.
+ *
+ * The MDT updates the LSOM on close and on setattr under the object write
+ * lock, which the caller holds. If it did so after the check, its value is
+ * newer than the one computed from the OST-objects, and must be kept.
+ *
+ * \param[in] env	pointer to the thread context
+ * \param[in] lls	the file to be refreshed
+ *
+ * \retval		true if the LSOM changed or cannot be read
+ * \retval		false if it is still the one that was checked
+ */
+static bool lfsck_layout_som_changed(const struct lu_env *env,
+				     struct lfsck_layout_som *lls)
+{
+	struct lustre_som_attrs som;
+	struct lu_buf buf;
+	int rc;
+
+	lfsck_buf_init(&buf, &som, sizeof(som));
+	rc = dt_xattr_get(env, lls->lls_obj, &buf, XATTR_NAME_SOM);
+	if (rc == -ENODATA)
+		rc = 0;
+	if (rc < 0 || rc != lls->lls_som_len)
+		return true;
+
+	return rc > 0 && memcmp(&som, &lls->lls_som, rc) != 0;
+}
+
+/**
+ * Refresh the LSOM of the files on the lad_som_list.
+ *
+ * The LSOM of every file is compared with the size and blocks accumulated
+ * from its OST-objects. The files with strict SOM are left alone, and so
+ * are the ones whose lazy SOM is up to date. All the others get a lazy SOM
+ * in one local transaction, then the clients, 'lfs find --lazy' or any
+ * scanner can trust the LSOM instead of glimpsing the OST-objects.
+ *
+ * As for the lazy SOM set at close time, some client may have written more
+ * data in its cache that is not on the OSTs yet.
+ *
+ * \param[in] env	pointer to the thread context
+ * \param[in] com	pointer to the lfsck component
+ *
+ * \retval		0 for success
+ * \retval		negative error number on failure
+ */
+static int lfsck_layout_som_flush(const struct lu_env *env,
+				  struct lfsck_component *com)
+{
+	struct lfsck_thread_info	*info	= lfsck_env_info(env);
+	struct lustre_som_attrs		*som	= &info->lti_som;
+	struct lfsck_instance		*lfsck	= com->lc_lfsck;
+	struct lfsck_bookmark		*bk	= &lfsck->li_bookmark_ram;
+	struct lfsck_layout		*lo	= com->lc_file_ram;
+	struct lfsck_assistant_data	*lad	= com->lc_data;
+	struct dt_device		*dev	= lfsck->li_bottom;
+	struct thandle			*handle = NULL;
+	struct lfsck_layout_som		*lls;
+	struct lfsck_layout_som		*next;
+	struct lu_buf			 buf;
+	LIST_HEAD(head);
+	__u64				 checked = 0;
+	__u64				 stale	 = 0;
+	__u64				 refreshed = 0;
+	int				 rc	 = 0;
+	ENTRY;
+
+	mutex_lock(&lad->lad_som_mutex);
+	spin_lock(&lad->lad_lock);
+	list_splice_init(&lad->lad_som_list, &head);
+	lad->lad_som_count = 0;
+	spin_unlock(&lad->lad_lock);
+
+	list_for_each_entry_safe(lls, next, &head, lls_list) {
+		struct dt_object *obj;
+
+		obj = lfsck_object_find_bottom(env, lfsck, &lls->lls_fid);
+		if (IS_ERR(obj)) {
+			list_del(&lls->lls_list);
+			OBD_FREE_PTR(lls);
+			continue;
+		}
+
+		lls->lls_obj = obj;
+		if (!dt_object_exists(obj) || lfsck_is_dead_obj(obj))
+			continue;
+
+		lfsck_buf_init(&buf, som, sizeof(*som));
+		rc = dt_xattr_get(env, obj, &buf, XATTR_NAME_SOM);
+		if (rc < 0 && rc != -ENODATA)
+			continue;
+
+		checked++;
+		lls->lls_som_len = rc > 0 ? rc : 0;
+		lls->lls_som = *som;
+		if (rc == sizeof(*som)) {
+			lustre_som_swab(som);
+			if (som->lsa_valid & SOM_FL_STRICT)
+				continue;
+
+			if (som->lsa_valid & SOM_FL_LAZY &&
+			    som->lsa_size == lls->lls_size &&
+			    som->lsa_blocks == lls->lls_blocks)
+				continue;
+		}
+
+		stale++;
+		if (bk->lb_param & LPF_DRYRUN)
+			continue;
+
+		lls->lls_update = true;
+		if (handle == NULL) {
+			handle = dt_trans_create(env, dev);
+			if (IS_ERR(handle))
+				GOTO(out, rc = PTR_ERR(handle));
+		}
+
+		lfsck_buf_init(&buf, som, sizeof(*som));
+		rc = dt_declare_xattr_set(env, obj, &buf, XATTR_NAME_SOM, 0,
+					  handle);
+		if (rc != 0)
+			GOTO(out, rc);
+	}
+
+	rc = 0;
+	if (handle == NULL)
+		GOTO(out, rc);
+
+	rc = dt_trans_start_local(env, dev, handle);
+	if (rc != 0)
+		GOTO(out, rc);
+
+	list_for_each_entry(lls, &head, lls_list) {
+		if (!lls->lls_update)
+			continue;
+
+		som->lsa_valid = SOM_FL_LAZY;
+		som->lsa_size = lls->lls_size;
+		som->lsa_blocks = lls->lls_blocks;
+		memset(&som->lsa_reserved, 0, sizeof(som->lsa_reserved));
+		lustre_som_swab(som);
+		lfsck_buf_init(&buf, som, sizeof(*som));
+
+		dt_write_lock(env, lls->lls_obj, 0);
+		if (unlikely(lfsck_is_dead_obj(lls->lls_obj)) ||
+		    lfsck_layout_som_changed(env, lls)) {
+			dt_write_unlock(env, lls->lls_obj);
+			continue;
+		}
+
+		rc = dt_xattr_set(env, lls->lls_obj, &buf, XATTR_NAME_SOM, 0,
+				  handle);
+		dt_write_unlock(env, lls->lls_obj);
+		if (rc != 0)
+			GOTO(out, rc);
+
+		refreshed++;
+	}
+
+	GOTO(out, rc);
+
+out:
+	if (handle != NULL && !IS_ERR(handle))
+		rc = lfsck_layout_trans_stop(env, dev, handle, rc);
+
+	lfsck_layout_som_free(env, &head);
+	mutex_unlock(&lad->lad_som_mutex);
+
+	down_write(&com->lc_sem);
+	lo->ll_som_checked += checked;
+	lo->ll_som_stale += stale;
+	lo->ll_som_refreshed += refreshed;
+	if (rc < 0)
+		lo->ll_objs_failed_phase1++;
+	up_write(&com->lc_sem);
+
+	CDEBUG(D_LFSCK, "%s: layout LFSCK %s %llu/%llu LSOM: rc = %d\n",
+	       lfsck_lfsck2name(lfsck),
+	       bk->lb_param & LPF_DRYRUN ? "found" : "refreshed",
+	       bk->lb_param & LPF_DRYRUN ? stale : refreshed, checked, rc);
+
+	RETURN(rc);
+}
+
+/**
+ * Drop one reference on the LSOM accounting of the file.
+ *
+ * The master holds one reference until all the stripes of the file have
+ * been queued, and each queued stripe holds one until it is handled by
+ * some assistant thread. The last one queues the file for the LSOM check,
+ * unless some OST-object could not be accounted.
+ *
+ * \param[in] env	pointer to the thread context
+ * \param[in] com	pointer to the lfsck component
+ * \param[in] lso	the file to be refreshed
+ */
+static void lfsck_layout_som_put(const struct lu_env *env,
+				 struct lfsck_component *com,
+				 struct lfsck_assistant_object *lso)
+{
+	struct lfsck_assistant_data	*lad = com->lc_data;
+	struct lfsck_layout_som		*lls;
+	bool				 flush = false;
+
+	if (!atomic_dec_and_test(&lso->lso_som_pending))
+		return;
+
+	if (lso->lso_som_skip || lso->lso_dead || lso->lso_attr.la_nlink == 0)
+		return;
+
+	OBD_ALLOC_PTR(lls);
+	if (lls == NULL)
+		return;
+
+	lls->lls_fid = lso->lso_fid;
+	lls->lls_size = lso->lso_som_size;
+	lls->lls_blocks = lso->lso_som_blocks;
+
+	spin_lock(&lad->lad_lock);
+	list_add_tail(&lls->lls_list, &lad->lad_som_list);
+	if (++lad->lad_som_count >= LFSCK_SOM_BATCH)
+		flush = true;
+	spin_unlock(&lad->lad_lock);
+
+	if (flush)
+		lfsck_layout_som_flush(env, com);
+}
+
+static int
+__lfsck_layout_assistant_handler_p1(const struct lu_env *env,
+				    struct lfsck_component *com,
+				    struct lfsck_assistant_req *lar)
 {
 	struct lfsck_layout_req		     *llr    =
 			container_of0(lar, struct lfsck_layout_req, llr_lar);
@@ -4315,8 +4618,10 @@ check_owner:
 	}
 
 repair:
-	if (type == LLIT_NONE)
+	if (type == LLIT_NONE) {
+		lfsck_layout_som_account(lso, llr, cla);
 		GOTO(out, rc = 0);
+	}
 
 	if (bk->lb_param & LPF_DRYRUN)
 		GOTO(out, rc = 1);
@@ -4407,6 +4712,22 @@ out:
 	return rc;
 }
 
+static int lfsck_layout_assistant_handler_p1(const struct lu_env *env,
+					     struct lfsck_component *com,
+					     struct lfsck_assistant_req *lar)
+{
+	struct lfsck_layout_req *llr =
+			container_of0(lar, struct lfsck_layout_req, llr_lar);
+	int rc;
+
+	rc = __lfsck_layout_assistant_handler_p1(env, com, lar);
+	if (!llr->llr_som_done)
+		lar->lar_parent->lso_som_skip = true;
+	lfsck_layout_som_put(env, com, lar->lar_parent);
+
+	return rc;
+}
+
 static int
 lfsck_layout_double_scan_one_trace_file(const struct lu_env *env,
 					struct lfsck_component *com,
@@ -5354,14 +5675,17 @@ log:
 static int lfsck_layout_scan_stripes(const struct lu_env *env,
 				     struct lfsck_component *com,
 				     struct dt_object *parent,
-				     struct lov_mds_md_v1 *lmm, __u32 comp_id)
+				     struct lov_mds_md_v1 *lmm, __u32 comp_id,
+				     __u64 comp_end,
+				     struct lfsck_assistant_object **lsop,
+				     bool *som)
 {
 	struct lfsck_thread_info	*info	 = lfsck_env_info(env);
 	struct lfsck_instance		*lfsck	 = com->lc_lfsck;
 	struct lfsck_bookmark		*bk	 = &lfsck->li_bookmark_ram;
 	struct lfsck_layout		*lo	 = com->lc_file_ram;
 	struct lfsck_assistant_data	*lad	 = com->lc_data;
-	struct lfsck_assistant_object	*lso	 = NULL;
+	struct lfsck_assistant_object	*lso	 = *lsop;
 	struct lov_ost_data_v1		*objs;
 	struct lfsck_tgt_descs		*ltds	 = &lfsck->li_ost_descs;
 	struct ptlrpc_thread		*mthread = &lfsck->li_thread;
@@ -5392,9 +5716,12 @@ static int lfsck_layout_scan_stripes(const struct lu_env *env,
 		struct dt_object	*cobj	= NULL;
 		__u32			 index;
 		bool			 wakeup = false;
+		bool			 queued = false;
 
-		if (unlikely(lovea_slot_is_dummy(objs)))
+		if (unlikely(lovea_slot_is_dummy(objs))) {
+			*som = false;
 			continue;
+		}
 
 		l_wait_event(mthread->t_ctl_waitq,
 			     lad->lad_prefetched < bk->lb_async_windows ||
@@ -5491,6 +5818,10 @@ static int lfsck_layout_scan_stripes(const struct lu_env *env,
 
 				goto next;
 			}
+
+			/* Held by the master until all stripes are queued. */
+			atomic_set(&lso->lso_som_pending, 1);
+			*lsop = lso;
 		}
 
 		llr = lfsck_layout_assistant_req_init(lso, cobj, comp_id,
@@ -5500,17 +5831,25 @@ static int lfsck_layout_scan_stripes(const struct lu_env *env,
 			goto next;
 		}
 
+		llr->llr_stripe_size = le32_to_cpu(lmm->lmm_stripe_size);
+		llr->llr_stripe_count = count;
+		llr->llr_comp_end = comp_end;
+		atomic_inc(&lso->lso_som_pending);
+		queued = true;
+
 		cobj = NULL;
 		spin_lock(&lad->lad_lock);
 		if (lad->lad_assistant_status < 0) {
 			spin_unlock(&lad->lad_lock);
 			lfsck_layout_assistant_req_fini(env, &llr->llr_lar);
 			lfsck_tgt_put(tgt);
+			*som = false;
 			RETURN(lad->lad_assistant_status);
 		}
 
 		list_add_tail(&llr->llr_lar.lar_list, &lad->lad_req_list);
-		if (lad->lad_prefetched == 0)
+		/* Some assistant thread may be idle. */
+		if (lad->lad_prefetched <= lad->lad_workers)
 			wakeup = true;
 
 		lad->lad_prefetched++;
@@ -5525,6 +5864,9 @@ next:
 			lfsck_layout_record_failure(env, lfsck, lo);
 		up_write(&com->lc_sem);
 
+		if (!queued)
+			*som = false;
+
 		if (cobj != NULL && !IS_ERR(cobj))
 			lfsck_object_put(env, cobj);
 
@@ -5538,8 +5880,8 @@ next:
 	GOTO(out, rc = 0);
 
 out:
-	if (lso != NULL)
-		lfsck_assistant_object_put(env, lso);
+	if (i < count)
+		*som = false;
 
 	return rc;
 }
@@ -5704,6 +6046,9 @@ out:
 		       PFID(lfsck_dto2fid(obj)), rc);
 
 	if (stripe) {
+		struct lfsck_assistant_object *lso = NULL;
+		bool som = true;
+
 		if (magic == LOV_MAGIC_COMP_V1) {
 			int i;
 
@@ -5713,13 +6058,29 @@ out:
 				      LCME_FL_INIT))
 					continue;
 
+				lmm = buf->lb_buf +
+				      le32_to_cpu(lcme->lcme_offset);
+				/* The data on the MDT is not accounted. */
+				if (lov_pattern(le32_to_cpu(lmm->lmm_pattern)) ==
+				    LOV_PATTERN_MDT)
+					som = false;
+
 				rc = lfsck_layout_scan_stripes(env, com, obj,
-					(struct lov_mds_md_v1 *)(buf->lb_buf +
-					le32_to_cpu(lcme->lcme_offset)),
-					le32_to_cpu(lcme->lcme_id));
+					lmm, le32_to_cpu(lcme->lcme_id),
+					le64_to_cpu(lcme->lcme_extent.e_end),
+					&lso, &som);
 			}
 		} else {
-			rc = lfsck_layout_scan_stripes(env, com, obj, lmm, 0);
+			rc = lfsck_layout_scan_stripes(env, com, obj, lmm, 0,
+						       OBD_OBJECT_EOF, &lso,
+						       &som);
+		}
+
+		if (lso != NULL) {
+			if (!som)
+				lso->lso_som_skip = true;
+			lfsck_layout_som_put(env, com, lso);
+			lfsck_assistant_object_put(env, lso);
 		}
 	} else {
 		down_write(&com->lc_sem);
@@ -5857,13 +6218,27 @@ static int lfsck_layout_master_post(const struct lu_env *env,
 				    struct lfsck_component *com,
 				    int result, bool init)
 {
-	struct lfsck_instance	*lfsck	= com->lc_lfsck;
-	struct lfsck_layout	*lo	= com->lc_file_ram;
-	int			 rc;
+	struct lfsck_instance		*lfsck	= com->lc_lfsck;
+	struct lfsck_layout		*lo	= com->lc_file_ram;
+	struct lfsck_assistant_data	*lad	= com->lc_data;
+	int				 rc;
 	ENTRY;
 
 	lfsck_post_generic(env, com, &result);
 
+	/* All the stripes have been handled, check the remaining files. */
+	if (result > 0) {
+		lfsck_layout_som_flush(env, com);
+	} else {
+		LIST_HEAD(head);
+
+		spin_lock(&lad->lad_lock);
+		list_splice_init(&lad->lad_som_list, &head);
+		lad->lad_som_count = 0;
+		spin_unlock(&lad->lad_lock);
+		lfsck_layout_som_free(env, &head);
+	}
+
 	down_write(&com->lc_sem);
 	spin_lock(&lfsck->li_lock);
 	if (!init)
@@ -6038,6 +6413,22 @@ static void lfsck_layout_dump(const struct lu_env *env,
 		   lo->ll_objs_failed_phase1,
 		   lo->ll_objs_failed_phase2);
 
+	/* The LSOM coverage is the percentage of the checked files
+	 * whose LSOM was or has been made up to date. */
+	seq_printf(m, "som_checked: %llu\n"
+		   "som_stale: %llu\n"
+		   "som_refreshed: %llu\n",
+		   lo->ll_som_checked,
+		   lo->ll_som_stale,
+		   lo->ll_som_refreshed);
+	if (lo->ll_som_checked != 0)
+		seq_printf(m, "som_coverage: %llu%%\n",
+			   div64_u64((lo->ll_som_checked - lo->ll_som_stale +
+				      lo->ll_som_refreshed) * 100,
+				     lo->ll_som_checked));
+	else
+		seq_printf(m, "som_coverage: N/A\n");
+
 	if (lo->ll_status == LS_SCANNING_PHASE1) {
 		time64_t duration = ktime_get_seconds() -
 				    lfsck->li_time_last_checkpoint;
@@ -6083,6 +6474,8 @@ static void lfsck_layout_dump(const struct lu_env *env,
 		}
 
 		seq_printf(m, "current_position: %llu\n", pos);
+		if (lfsck->li_master)
+			lfsck_assistant_handled_dump(m, com->lc_data);
 	} else if (lo->ll_status == LS_SCANNING_PHASE2) {
 		time64_t duration = ktime_get_seconds() -
 				    com->lc_time_last_checkpoint;
@@ -6303,6 +6696,7 @@ static void lfsck_layout_master_data_release(const struct lu_env *env,
 	}
 	spin_unlock(&ltds->ltd_lock);
 
+	lfsck_layout_som_free(env, &lad->lad_som_list);
 	if (likely(lad->lad_bitmap != NULL))
 		CFS_FREE_BITMAP(lad->lad_bitmap);
 
@@ -6808,6 +7202,7 @@ struct lfsck_assistant_operations lfsck_layout_assistant_ops = {
 	.la_double_scan_result	= lfsck_layout_double_scan_result,
 	.la_req_fini		= lfsck_layout_assistant_req_fini,
 	.la_sync_failures	= lfsck_layout_assistant_sync_failures,
+	.la_parallel_p1		= true,
 };
 
 int lfsck_layout_setup(const struct lu_env *env, struct lfsck_instance *lfsck)
@@ -67,6 +67,13 @@ static struct list_head lfsck_ost_orphan_list;
 static struct list_head lfsck_mdt_orphan_list;
 static DEFINE_SPINLOCK(lfsck_instance_lock);
 
+/* The number of threads handling the phase1 requests of the components
+ * that support it (layout LFSCK on the MDT), including the assistant. */
+static int lfsck_assistant_threads = 1;
+module_param(lfsck_assistant_threads, int, 0644);
+MODULE_PARM_DESC(lfsck_assistant_threads,
+		 "number of threads handling LFSCK phase1 requests per component");
+
 const char *lfsck_flags_names[] = {
 	"scanned-once",
 	"inconsistent",
@@ -1985,6 +1992,9 @@ lfsck_assistant_data_init(struct lfsck_assistant_operations *lao,
 		INIT_LIST_HEAD(&lad->lad_mdt_phase1_list);
 		INIT_LIST_HEAD(&lad->lad_mdt_phase2_list);
 		init_waitqueue_head(&lad->lad_thread.t_ctl_waitq);
+		atomic_set(&lad->lad_workers_running, 0);
+		INIT_LIST_HEAD(&lad->lad_som_list);
+		mutex_init(&lad->lad_som_mutex);
 		lad->lad_ops = lao;
 		lad->lad_name = name;
 	}
@@ -2008,6 +2018,7 @@ lfsck_assistant_object_init(const struct lu_env *env, const struct lu_fid *fid,
 		lso->lso_attr = *attr;
 
 	atomic_set(&lso->lso_ref, 1);
+	spin_lock_init(&lso->lso_som_lock);
 	lso->lso_oit_cookie = cookie;
 	if (is_dir)
 		lso->lso_is_dir = 1;
@@ -2540,6 +2551,9 @@ int lfsck_start_assistant(const struct lu_env *env, struct lfsck_component *com,
 	lad->lad_post_result = 0;
 	lad->lad_flags = 0;
 	lad->lad_advance_lock = false;
+	lad->lad_workers = 0;
+	lad->lad_workers_status = 0;
+	memset(lad->lad_handled, 0, sizeof(lad->lad_handled));
 	thread_set_flags(athread, 0);
 
 	lta = lfsck_thread_args_init(lfsck, com, lsp);
@@ -2572,6 +2586,98 @@ int lfsck_start_assistant(const struct lu_env *env, struct lfsck_component *com,
 	RETURN(rc);
 }
 
+/**
+ * Start the workers helping the assistant thread to handle the phase1
+ * requests, as configured by the lfsck_assistant_threads parameter.
+ *
+ * It is called by the assistant thread itself after it becomes running.
+ * Failing to start some worker is not fatal, the requests will be handled
+ * by the threads that have been started.
+ *
+ * \param[in] com	pointer to the lfsck component
+ */
+void lfsck_start_assistant_workers(struct lfsck_component *com)
+{
+	struct lfsck_instance		*lfsck	= com->lc_lfsck;
+	struct lfsck_assistant_data	*lad	= com->lc_data;
+	struct lfsck_thread_args	*lta;
+	struct task_struct		*task;
+	int				 threads = lfsck_assistant_threads;
+	int				 i;
+
+	if (!lad->lad_ops->la_parallel_p1 || threads <= 1)
+		return;
+
+	if (threads > LFSCK_ASSISTANT_THREADS_MAX)
+		threads = LFSCK_ASSISTANT_THREADS_MAX;
+
+	for (i = 1; i < threads; i++) {
+		lta = lfsck_thread_args_init(lfsck, com, NULL);
+		if (IS_ERR(lta))
+			break;
+
+		lta->lta_idx = i;
+		spin_lock(&lad->lad_lock);
+		lad->lad_workers++;
+		spin_unlock(&lad->lad_lock);
+		atomic_inc(&lad->lad_workers_running);
+		task = kthread_run(lfsck_assistant_worker, lta, "%s_%02d",
+				   lad->lad_name, i);
+		if (IS_ERR(task)) {
+			CDEBUG(D_LFSCK, "%s: cannot start %s LFSCK assistant "
+			       "worker %d: rc = %ld\n", lfsck_lfsck2name(lfsck),
+			       lad->lad_name, i, PTR_ERR(task));
+			atomic_dec(&lad->lad_workers_running);
+			spin_lock(&lad->lad_lock);
+			lad->lad_workers--;
+			spin_unlock(&lad->lad_lock);
+			lfsck_thread_args_fini(lta);
+			break;
+		}
+	}
+
+	CDEBUG(D_LFSCK, "%s: %s LFSCK assistant started %d workers\n",
+	       lfsck_lfsck2name(lfsck), lad->lad_name, lad->lad_workers);
+}
+
+/**
+ * Stop the assistant workers and wait for them to exit.
+ *
+ * The requests being handled by the workers are finished before they exit,
+ * so the remaining requests on lad_req_list are not in use after return.
+ *
+ * \param[in] com	pointer to the lfsck component
+ */
+void lfsck_stop_assistant_workers(struct lfsck_component *com)
+{
+	struct lfsck_assistant_data	*lad	 = com->lc_data;
+	struct ptlrpc_thread		*athread = &lad->lad_thread;
+	struct l_wait_info		 lwi	 = { 0 };
+
+	if (lad->lad_workers == 0)
+		return;
+
+	set_bit(LAD_WORKERS_STOP, &lad->lad_flags);
+	wake_up_all(&athread->t_ctl_waitq);
+	l_wait_event(athread->t_ctl_waitq,
+		     atomic_read(&lad->lad_workers_running) == 0,
+		     &lwi);
+	/* Wait for the last worker to leave lad_lock. */
+	spin_lock(&lad->lad_lock);
+	spin_unlock(&lad->lad_lock);
+}
+
+void lfsck_assistant_handled_dump(struct seq_file *m,
+				  struct lfsck_assistant_data *lad)
+{
+	int i;
+
+	seq_printf(m, "assistant_handled_phase1: [%llu", lad->lad_handled[0]);
+	for (i = 1; i <= lad->lad_workers; i++)
+		seq_printf(m, ", %llu", lad->lad_handled[i]);
+	seq_puts(m, "]\n");
+}
+
 int lfsck_checkpoint_generic(const struct lu_env *env,
 			     struct lfsck_component *com)
 {
@@ -401,6 +401,12 @@ int ll_file_release(struct inode *inode, struct file *file)
 
 	pcc_file_release(inode, file);
 
+	if (fd->fd_las.las_requested > 0)
+		CDEBUG(D_VFSTRACE, DFID": %llu locks requested ahead, "
+		       "%llu hits, %llu misses\n", PFID(ll_inode2fid(inode)),
+		       fd->fd_las.las_requested, fd->fd_las.las_hits,
+		       fd->fd_las.las_misses);
+
 	if (!S_ISDIR(inode->i_mode)) {
 		if (lli->lli_clob != NULL)
 			lov_read_and_clear_async_rc(lli->lli_clob);
@@ -433,8 +439,14 @@ static inline int ll_dom_readpage(void *data, struct page *page)
 	return 0;
 }
 
-void ll_dom_finish_open(struct inode *inode, struct ptlrpc_request *req,
-			struct lookup_intent *it)
+/**
+ * Fill the page cache with the Data-on-MDT file data returned in reply to
+ * an open or to a getattr intent of statahead.
+ *
+ * \retval	number of pages filled
+ */
+int ll_dom_finish_open(struct inode *inode, struct ptlrpc_request *req,
+		       struct lookup_intent *it)
 {
 	struct ll_inode_info *lli = ll_i2info(inode);
 	struct cl_object *obj = lli->lli_clob;
@@ -449,15 +461,17 @@ void ll_dom_finish_open(struct inode *inode, struct ptlrpc_request *req,
 	ENTRY;
 
 	if (obj == NULL)
-		RETURN_EXIT;
+		RETURN(0);
 
 	if (!req_capsule_has_field(&req->rq_pill, &RMF_NIOBUF_INLINE,
-				   RCL_SERVER))
-		RETURN_EXIT;
+				   RCL_SERVER) ||
+	    !req_capsule_field_present(&req->rq_pill, &RMF_NIOBUF_INLINE,
+				       RCL_SERVER))
+		RETURN(0);
 
 	rnb = req_capsule_server_get(&req->rq_pill, &RMF_NIOBUF_INLINE);
 	if (rnb == NULL || rnb->rnb_len == 0)
-		RETURN_EXIT;
+		RETURN(0);
 
 	/* LU-11595: Server may return whole file and that is OK always or
 	 * it may return just file tail and its offset must be aligned with
@@ -465,7 +479,7 @@ void ll_dom_finish_open(struct inode *inode, struct ptlrpc_request *req,
 	 * smaller then offset may be not aligned and that data is just ignored.
 	 */
 	if (rnb->rnb_offset % PAGE_SIZE)
-		RETURN_EXIT;
+		RETURN(0);
 
 	/* Server returns whole file or just file tail if it fills in reply
 	 * buffer, in both cases total size should be equal to the file size.
@@ -475,7 +489,7 @@ void ll_dom_finish_open(struct inode *inode, struct ptlrpc_request *req,
 		CERROR("%s: server returns off/len %llu/%u but size %llu\n",
 		       ll_i2sbi(inode)->ll_fsname, rnb->rnb_offset,
 		       rnb->rnb_len, body->mbo_dom_size);
-		RETURN_EXIT;
+		RETURN(0);
 	}
 
 	CDEBUG(D_INFO, "Get data along with open at %llu len %i, size %llu\n",
@@ -507,7 +521,8 @@ void ll_dom_finish_open(struct inode *inode, struct ptlrpc_request *req,
 		put_page(vmpage);
 		index++;
 	} while (rnb->rnb_len > (index << PAGE_SHIFT));
-	EXIT;
+
+	RETURN(index);
 }
 
 static int ll_intent_file_open(struct dentry *de, void *lmm, int lmmsize,
@@ -663,6 +678,7 @@ static int ll_local_open(struct file *file, struct lookup_intent *it,
 
 	LUSTRE_FPRIVATE(file) = fd;
 	ll_readahead_init(inode, &fd->fd_ras);
+	spin_lock_init(&fd->fd_las.las_lock);
 	fd->fd_omode = it->it_flags & (FMODE_READ | FMODE_WRITE | FMODE_EXEC);
 
 	/* ll_cl_context initialize */
@@ -1453,6 +1469,115 @@ static void ll_heat_add(struct inode *inode, enum cl_io_type iot,
 	spin_unlock(&lli->lli_heat_lock);
 }
 
+/* # of writes at the same stride needed before locks are requested ahead */
+#define LL_LOCKAHEAD_MIN_HITS	2
+
+/**
+ * Request the extent locks of the next writes of \a file ahead of time,
+ * when its writes follow a strided pattern, like the ranks of a MPI-IO
+ * application writing their parts of a shared file. This saves the
+ * enqueue round trip on the first touch of each part.
+ *
+ * The locks are requested like for the lockahead ladvise: asynchronously
+ * and not expanded, so they don't conflict with the parts of the other
+ * clients. Contiguous writes are left alone, they get large locks by
+ * expansion anyway.
+ *
+ * \param[in] file	file written to
+ * \param[in] pos	start of the write
+ * \param[in] count	size of the write
+ */
+static void ll_lockahead_prefetch(struct file *file, loff_t pos, size_t count)
+{
+	struct ll_file_data *fd = LUSTRE_FPRIVATE(file);
+	struct ll_sb_info *sbi = ll_i2sbi(file_inode(file));
+	struct ll_lockahead_state *las = &fd->fd_las;
+	unsigned int depth = sbi->ll_lockahead_depth;
+	struct llapi_lu_ladvise ladvise;
+	unsigned int requested = 0;
+	loff_t stride;
+	loff_t start;
+	loff_t next;
+	int i;
+	int rc;
+
+	if (depth == 0 || count == 0 || las->las_disabled ||
+	    fd->ll_lock_no_expand || file->f_flags & O_APPEND ||
+	    fd->fd_flags & LL_FILE_GROUP_LOCKED)
+		return;
+
+	spin_lock(&las->las_lock);
+	stride = pos - las->las_last_pos;
+	if (las->las_next > 0) {
+		/* was this write predicted by the previous one? */
+		if (stride == las->las_stride &&
+		    count == las->las_last_count &&
+		    pos + count <= las->las_next) {
+			las->las_hits++;
+			ll_stats_ops_tally(sbi, LPROC_LL_LOCKAHEAD_HIT, 1);
+		} else {
+			las->las_misses++;
+			ll_stats_ops_tally(sbi, LPROC_LL_LOCKAHEAD_MISS, 1);
+		}
+	}
+
+	if (stride == las->las_stride && count == las->las_last_count) {
+		las->las_stride_hits++;
+	} else {
+		las->las_stride = stride;
+		las->las_stride_hits = 0;
+		las->las_next = 0;
+	}
+	las->las_last_pos = pos;
+	las->las_last_count = count;
+
+	if (stride <= (loff_t)count ||
+	    las->las_stride_hits < LL_LOCKAHEAD_MIN_HITS) {
+		spin_unlock(&las->las_lock);
+		return;
+	}
+
+	/* check the client side before the first request, each OST may
+	 * still refuse it, see below */
+	if (las->las_requested == 0 &&
+	    !exp_connect_lockahead(ll_i2dtexp(file_inode(file)))) {
+		las->las_disabled = true;
+		spin_unlock(&las->las_lock);
+		return;
+	}
+
+	next = las->las_next;
+	las->las_next = pos + depth * stride + count;
+	spin_unlock(&las->las_lock);
+
+	memset(&ladvise, 0, sizeof(ladvise));
+	ladvise.lla_advice = LU_LADVISE_LOCKAHEAD;
+	ladvise.lla_lockahead_mode = MODE_WRITE_USER;
+	ladvise.lla_peradvice_flags = LF_ASYNC;
+	for (i = 1; i <= depth; i++) {
+		start = pos + i * stride;
+		/* already requested by a previous write */
+		if (start < next)
+			continue;
+
+		ladvise.lla_start = start;
+		ladvise.lla_end = start + count - 1;
+		rc = ll_file_lock_ahead(file, &ladvise);
+		if (rc == -EOPNOTSUPP)
+			las->las_disabled = true;
+		if (rc < 0)
+			break;
+		requested++;
+	}
+
+	if (requested > 0) {
+		spin_lock(&las->las_lock);
+		las->las_requested += requested;
+		spin_unlock(&las->las_lock);
+		ll_stats_ops_tally(sbi, LPROC_LL_LOCKAHEAD, requested);
+	}
+}
+
 static ssize_t
 ll_file_io_generic(const struct lu_env *env, struct vvp_io_args *args,
 		   struct file *file, enum cl_io_type iot,
@@ -1475,6 +1600,9 @@ ll_file_io_generic(const struct lu_env *env, struct vvp_io_args *args,
 		file_dentry(file)->d_name.name,
 		iot == CIT_READ ? "read" : "write", *ppos, count);
 
+	if (iot == CIT_WRITE && args->via_io_subtype == IO_NORMAL)
+		ll_lockahead_prefetch(file, *ppos, count);
+
 restart:
 	io = vvp_env_thread_io(env);
 	ll_io_init(io, file, iot, args);
@@ -1682,12 +1810,24 @@ static ssize_t ll_file_read_iter(struct kiocb *iocb, struct iov_iter *to)
 	 * path: read data from data copy on OSTs.
 	 */
 	result = pcc_file_read_iter(iocb, to, &cached);
-	if (cached)
+	if (cached) {
+		/* RO-PCC eviction is driven by the heat of PCC reads */
+		if (result > 0)
+			ll_heat_add(file_inode(file), CIT_READ, result);
 		return result;
+	}
 
 	ll_ras_enter(file);
 
 	result = ll_do_fast_read(iocb, to);
+
+	/* count the statahead DoM prefetch as hit only if its pages are
+	 * still cached and the first read is served from them */
+	if (test_and_clear_bit(LLIF_DOM_PREFETCHED,
+			       &ll_i2info(file_inode(file))->lli_flags) &&
+	    result > 0)
+		atomic_inc(&ll_i2sbi(file_inode(file))->ll_sa_dom_hit);
+
 	if (result < 0 || iov_iter_count(to) == 0)
 		GOTO(out, result);
 
@@ -1804,8 +1944,12 @@ static ssize_t ll_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 	 * from PCC cache automatically.
 	 */
 	result = pcc_file_write_iter(iocb, from, &cached);
-	if (cached && result != -ENOSPC && result != -EDQUOT)
+	if (cached && result != -ENOSPC && result != -EDQUOT) {
+		if (result > 0)
+			ll_heat_add(file_inode(iocb->ki_filp), CIT_WRITE,
+				    result);
 		return result;
+	}
 
 	/* NB: we can't do direct IO for tiny writes because they use the page
 	 * cache, we can't do sync writes because tiny writes can't flush
@@ -3835,6 +3979,9 @@ out:
 					       k_ladvise->lla_peradvice_flags);
 				GOTO(out_ladvise, rc);
 			case LU_LADVISE_LOCKAHEAD:
+				/* the application requests its locks itself,
+				 * don't guess them too */
+				fd->fd_las.las_disabled = true;
 
 				rc = ll_file_lock_ahead(file, k_ladvise);
 
@@ -269,6 +269,8 @@ enum ll_file_flags {
 	LLIF_XATTR_CACHE	= 2,
 	/* Project inherit */
 	LLIF_PROJECT_INHERIT	= 3,
+	/* DoM file data was prefetched by statahead and not read yet */
+	LLIF_DOM_PREFETCHED	= 4,
 };
 
 static inline void ll_file_set_flag(struct ll_inode_info *lli,
@@ -481,6 +483,7 @@ enum stats_track_type {
 					 2.10, abandoned */
 #define LL_SBI_TINY_WRITE   0x2000000 /* tiny write support */
 #define LL_SBI_FILE_HEAT    0x4000000 /* file heat support */
+#define LL_SBI_SA_DOM       0x8000000 /* DoM data prefetch by statahead */
 #define LL_SBI_FLAGS { 	\
 	"nolck",	\
 	"checksum",	\
@@ -509,6 +512,7 @@ enum stats_track_type {
 	"pio",		\
 	"tiny_write",	\
 	"file_heat",	\
+	"sa_dom",	\
 }
 
 /* This is embedded into llite super-blocks to keep track of connect
@@ -584,6 +588,10 @@ struct ll_sb_info {
 	atomic_t		  ll_sa_running; /* running statahead thread
 						  * count */
 	atomic_t		  ll_agl_total;  /* AGL thread started count */
+	atomic_t		  ll_sa_dom_total; /* files with DoM data
+						    * prefetched by statahead */
+	atomic_t		  ll_sa_dom_hit; /* prefetched files which
+						  * were read from cache */
 
 	dev_t			  ll_sdev_orig; /* save s_dev before assign for
 						 * clustred nfs */
@@ -604,6 +612,9 @@ struct ll_sb_info {
 	unsigned int		  ll_heat_decay_weight;
 	unsigned int		  ll_heat_period_second;
 
+	/* # of strided writes whose locks are requested ahead */
+	unsigned int		  ll_lockahead_depth;
+
 	/* filesystem fsname */
 	char			  ll_fsname[LUSTRE_MAXFSNAME + 1];
 
@@ -613,6 +624,9 @@ struct ll_sb_info {
 
 #define SBI_DEFAULT_HEAT_DECAY_WEIGHT	((80 * 256 + 50) / 100)
 #define SBI_DEFAULT_HEAT_PERIOD_SECOND	(60)
+
+#define LL_LOCKAHEAD_DEPTH_DEF		4
+#define LL_LOCKAHEAD_DEPTH_MAX		64
 /*
  * per file-descriptor read-ahead data.
  */
@@ -706,10 +720,35 @@ struct ll_readahead_work {
 	struct work_struct		 lrw_readahead_work;
 };
 
+/*
+ * per file-descriptor lock prefetch data, see ll_lockahead_prefetch().
+ */
+struct ll_lockahead_state {
+	spinlock_t	las_lock;
+	/* start and size of the previous write */
+	loff_t		las_last_pos;
+	size_t		las_last_count;
+	/* distance between the starts of the last writes */
+	loff_t		las_stride;
+	/* # of consecutive writes seen at that stride */
+	unsigned int	las_stride_hits;
+	/* end of the extents already requested ahead */
+	loff_t		las_next;
+	/* no prefetch for this descriptor: the OSTs do not support
+	 * lockahead, or the application uses the lockahead ladvise */
+	bool		las_disabled;
+	/* # of extent locks requested ahead, writes which found their
+	 * extent requested or not, reported on close */
+	__u64		las_requested;
+	__u64		las_hits;
+	__u64		las_misses;
+};
+
 extern struct kmem_cache *ll_file_data_slab;
 struct lustre_handle;
 struct ll_file_data {
 	struct ll_readahead_state fd_ras;
+	struct ll_lockahead_state fd_las;
 	struct ll_grouplock fd_grouplock;
 	__u64 lfd_pos;
 	__u32 fd_flags;
@@ -830,6 +869,9 @@ enum {
 	LPROC_LL_LISTXATTR,
 	LPROC_LL_REMOVEXATTR,
 	LPROC_LL_INODE_PERM,
+	LPROC_LL_LOCKAHEAD,
+	LPROC_LL_LOCKAHEAD_HIT,
+	LPROC_LL_LOCKAHEAD_MISS,
 	LPROC_LL_FILE_OPCODES
 };
 
@@ -1015,8 +1057,8 @@ ssize_t ll_copy_user_md(const struct lov_user_md __user *md,
 			struct lov_user_md **kbuf);
 void ll_open_cleanup(struct super_block *sb, struct ptlrpc_request *open_req);
 
-void ll_dom_finish_open(struct inode *inode, struct ptlrpc_request *req,
-			struct lookup_intent *it);
+int ll_dom_finish_open(struct inode *inode, struct ptlrpc_request *req,
+		       struct lookup_intent *it);
 
 /* Compute expected user md size when passing in a md from user space */
 static inline ssize_t ll_lov_user_md_size(const struct lov_user_md *lum)
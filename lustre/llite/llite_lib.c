@@ -147,7 +147,10 @@ static struct ll_sb_info *ll_init_sbi(void)
 	atomic_set(&sbi->ll_sa_wrong, 0);
 	atomic_set(&sbi->ll_sa_running, 0);
 	atomic_set(&sbi->ll_agl_total, 0);
+	atomic_set(&sbi->ll_sa_dom_total, 0);
+	atomic_set(&sbi->ll_sa_dom_hit, 0);
 	sbi->ll_flags |= LL_SBI_AGL_ENABLED;
+	sbi->ll_flags |= LL_SBI_SA_DOM;
 	sbi->ll_flags |= LL_SBI_FAST_READ;
 	sbi->ll_flags |= LL_SBI_TINY_WRITE;
 
@@ -160,6 +163,8 @@ static struct ll_sb_info *ll_init_sbi(void)
 	/* Per-filesystem file heat */
 	sbi->ll_heat_decay_weight = SBI_DEFAULT_HEAT_DECAY_WEIGHT;
 	sbi->ll_heat_period_second = SBI_DEFAULT_HEAT_PERIOD_SECOND;
+
+	sbi->ll_lockahead_depth = LL_LOCKAHEAD_DEPTH_DEF;
 	RETURN(sbi);
 out_destroy_ra:
 	destroy_workqueue(sbi->ll_ra_info.ll_readahead_wq);
@@ -466,7 +471,9 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt,
 #endif
 
 	data->ocd_connect_flags2 = OBD_CONNECT2_LOCKAHEAD |
-				   OBD_CONNECT2_INC_XID;
+				   OBD_CONNECT2_INC_XID |
+				   OBD_CONNECT2_BATCH_GLIMPSE |
+				   OBD_CONNECT2_BATCH_BL_AST;
 
 	if (!OBD_FAIL_CHECK(OBD_FAIL_OSC_CONNECT_GRANT_PARAM))
 		data->ocd_connect_flags |= OBD_CONNECT_GRANT_PARAM;
@@ -1220,6 +1227,9 @@ void ll_put_super(struct super_block *sb)
 	CDEBUG(D_VFSTRACE, "VFS Op: cfg_instance %s-%016lx (sb %p)\n",
 	       profilenm, cfg_instance, sb);
 
+	/* No PCC write-back may hold an inode while they are evicted */
+	pcc_super_wb_stop(&sbi->ll_pcc_super);
+
 	cfg.cfg_instance = cfg_instance;
 	lustre_end_log(sb, profilenm, &cfg);
 
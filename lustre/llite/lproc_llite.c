@@ -826,6 +826,39 @@ static ssize_t statahead_agl_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(statahead_agl);
 
+static ssize_t statahead_dom_show(struct kobject *kobj,
+				  struct attribute *attr,
+				  char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return sprintf(buf, "%u\n", sbi->ll_flags & LL_SBI_SA_DOM ? 1 : 0);
+}
+
+static ssize_t statahead_dom_store(struct kobject *kobj,
+				   struct attribute *attr,
+				   const char *buffer,
+				   size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	bool val;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc)
+		return rc;
+
+	if (val)
+		sbi->ll_flags |= LL_SBI_SA_DOM;
+	else
+		sbi->ll_flags &= ~LL_SBI_SA_DOM;
+
+	return count;
+}
+LUSTRE_RW_ATTR(statahead_dom);
+
 static int ll_statahead_stats_seq_show(struct seq_file *m, void *v)
 {
 	struct super_block *sb = m->private;
@@ -833,10 +866,14 @@ static int ll_statahead_stats_seq_show(struct seq_file *m, void *v)
 
 	seq_printf(m, "statahead total: %u\n"
 		      "statahead wrong: %u\n"
-		      "agl total: %u\n",
+		      "agl total: %u\n"
+		      "dom prefetch total: %u\n"
+		      "dom prefetch hit: %u\n",
 		   atomic_read(&sbi->ll_sa_total),
 		   atomic_read(&sbi->ll_sa_wrong),
-		   atomic_read(&sbi->ll_agl_total));
+		   atomic_read(&sbi->ll_agl_total),
+		   atomic_read(&sbi->ll_sa_dom_total),
+		   atomic_read(&sbi->ll_sa_dom_hit));
 	return 0;
 }
 
@@ -1307,6 +1344,39 @@ static ssize_t heat_period_second_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(heat_period_second);
 
+static ssize_t lockahead_prefetch_show(struct kobject *kobj,
+				       struct attribute *attr,
+				       char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return snprintf(buf, PAGE_SIZE, "%u\n", sbi->ll_lockahead_depth);
+}
+
+static ssize_t lockahead_prefetch_store(struct kobject *kobj,
+					struct attribute *attr,
+					const char *buffer,
+					size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc)
+		return rc;
+
+	if (val > LL_LOCKAHEAD_DEPTH_MAX)
+		return -ERANGE;
+
+	sbi->ll_lockahead_depth = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(lockahead_prefetch);
+
 static int ll_unstable_stats_seq_show(struct seq_file *m, void *v)
 {
 	struct super_block	*sb    = m->private;
@@ -1510,6 +1580,7 @@ static struct attribute *llite_attrs[] = {
 	&lustre_attr_statahead_running_max.attr,
 	&lustre_attr_statahead_max.attr,
 	&lustre_attr_statahead_agl.attr,
+	&lustre_attr_statahead_dom.attr,
 	&lustre_attr_lazystatfs.attr,
 	&lustre_attr_statfs_max_age.attr,
 	&lustre_attr_max_easize.attr,
@@ -1520,6 +1591,7 @@ static struct attribute *llite_attrs[] = {
 	&lustre_attr_file_heat.attr,
 	&lustre_attr_heat_decay_percentage.attr,
 	&lustre_attr_heat_period_second.attr,
+	&lustre_attr_lockahead_prefetch.attr,
 	&lustre_attr_max_read_ahead_async_active.attr,
 	&lustre_attr_read_ahead_async_file_threshold_mb.attr,
 	NULL,
@@ -1580,6 +1652,9 @@ static const struct llite_file_opcode {
 	{ LPROC_LL_LISTXATTR,      LPROCFS_TYPE_REGS, "listxattr" },
 	{ LPROC_LL_REMOVEXATTR,    LPROCFS_TYPE_REGS, "removexattr" },
 	{ LPROC_LL_INODE_PERM,     LPROCFS_TYPE_REGS, "inode_permission" },
+	{ LPROC_LL_LOCKAHEAD,      LPROCFS_TYPE_REGS, "lockahead_prefetch" },
+	{ LPROC_LL_LOCKAHEAD_HIT,  LPROCFS_TYPE_REGS, "lockahead_hit" },
+	{ LPROC_LL_LOCKAHEAD_MISS, LPROCFS_TYPE_REGS, "lockahead_miss" },
 };
 
 void ll_stats_ops_tally(struct ll_sb_info *sbi, int op, int count)
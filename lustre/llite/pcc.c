@@ -112,6 +112,27 @@
 
 struct kmem_cache *pcc_inode_slab;
 
+/* Seconds between two scans of the RW-PCC files waiting for write-back */
+#define PCC_WB_SCAN_INTERVAL	5
+
+/* Largest number of hot files waiting to be prefetched into RO-PCC */
+#define PCC_RO_REQS_MAX		64
+
+/* Files written more than 1/16 as often as read are not prefetched */
+#define PCC_RO_WRITE_RATIO	16
+
+/* Seconds a checked data version of a RO-PCC file is trusted at open */
+#define PCC_RO_DV_MAX_AGE	1
+
+static void pcc_wb_scan(struct work_struct *work);
+static void pcc_ro_work(struct work_struct *work);
+static void __pcc_readonly_detach(struct pcc_inode *pcci);
+static void pcc_readonly_invalidate(struct inode *inode);
+static bool pcc_readonly_valid(struct inode *inode, struct file *file,
+			       struct pcc_inode *pcci);
+static void pcc_readonly_prefetch_check(struct inode *inode,
+					struct file *file);
+
 int pcc_super_init(struct pcc_super *super)
 {
 	struct cred *cred;
@@ -124,6 +145,15 @@ int pcc_super_init(struct pcc_super *super)
 	cap_lower(cred->cap_effective, CAP_SYS_RESOURCE);
 	init_rwsem(&super->pccs_rw_sem);
 	INIT_LIST_HEAD(&super->pccs_datasets);
+	spin_lock_init(&super->pccs_wb_lock);
+	INIT_LIST_HEAD(&super->pccs_wb_list);
+	super->pccs_wb_stopping = false;
+	INIT_DELAYED_WORK(&super->pccs_wb_work, pcc_wb_scan);
+	spin_lock_init(&super->pccs_ro_lock);
+	INIT_LIST_HEAD(&super->pccs_ro_reqs);
+	super->pccs_ro_nr_reqs = 0;
+	INIT_LIST_HEAD(&super->pccs_ro_free);
+	INIT_WORK(&super->pccs_ro_work, pcc_ro_work);
 
 	return 0;
 }
@@ -495,6 +525,26 @@ pcc_parse_value_pair(struct pcc_cmd *cmd, char *buffer)
 			return rc;
 		if (id > 0)
 			cmd->u.pccc_add.pccc_flags |= PCC_DATASET_ROPCC;
+	} else if (strcmp(key, "wb_delay") == 0) {
+		rc = kstrtoul(val, 10, &id);
+		if (rc)
+			return rc;
+		if (id > UINT_MAX)
+			return -EINVAL;
+		cmd->u.pccc_add.pccc_wb_delay = id;
+	} else if (strcmp(key, "ro_heat") == 0) {
+		rc = kstrtoul(val, 10, &id);
+		if (rc)
+			return rc;
+		if (id > UINT_MAX)
+			return -EINVAL;
+		cmd->u.pccc_add.pccc_ro_heat = id;
+	} else if (strcmp(key, "ro_budget") == 0) {
+		/* in MiB */
+		rc = kstrtoul(val, 10, &id);
+		if (rc)
+			return rc;
+		cmd->u.pccc_add.pccc_ro_budget = (__u64)id << 20;
 	} else {
 		return -EINVAL;
 	}
@@ -743,7 +793,17 @@ pcc_dataset_add(struct pcc_super *super, struct pcc_cmd *cmd)
 	dataset->pccd_rwid = cmd->u.pccc_add.pccc_rwid;
 	dataset->pccd_roid = cmd->u.pccc_add.pccc_roid;
 	dataset->pccd_flags = cmd->u.pccc_add.pccc_flags;
+	dataset->pccd_wb_delay = cmd->u.pccc_add.pccc_wb_delay;
 	atomic_set(&dataset->pccd_refcount, 1);
+	atomic_set(&dataset->pccd_wb_pending, 0);
+	atomic64_set(&dataset->pccd_wb_bytes, 0);
+	atomic64_set(&dataset->pccd_wb_time, 0);
+	dataset->pccd_ro_heat = cmd->u.pccc_add.pccc_ro_heat;
+	dataset->pccd_ro_budget = cmd->u.pccc_add.pccc_ro_budget;
+	dataset->pccd_ro_used = 0;
+	INIT_LIST_HEAD(&dataset->pccd_ro_list);
+	atomic_set(&dataset->pccd_ro_prefetched, 0);
+	atomic_set(&dataset->pccd_ro_evicted, 0);
 
 	rc = pcc_dataset_rule_init(&dataset->pccd_rule, cmd);
 	if (rc) {
@@ -835,12 +895,49 @@ pcc_dataset_del(struct pcc_super *super, char *pathname)
 }
 
 static void
-pcc_dataset_dump(struct pcc_dataset *dataset, struct seq_file *m)
+pcc_dataset_dump(struct pcc_super *super, struct pcc_dataset *dataset,
+		 struct seq_file *m)
 {
+	struct pcc_inode *pcci;
+	__u64 dirty = 0;
+	__u64 bytes;
+	__u64 time_ms;
+
 	seq_printf(m, "%s:\n", dataset->pccd_pathname);
 	seq_printf(m, "  rwid: %u\n", dataset->pccd_rwid);
 	seq_printf(m, "  flags: %x\n", dataset->pccd_flags);
 	seq_printf(m, "  autocache: %s\n", dataset->pccd_rule.pmr_conds_str);
+	if (dataset->pccd_ro_heat != 0) {
+		seq_printf(m, "  ro_heat: %u\n", dataset->pccd_ro_heat);
+		seq_printf(m, "  ro_budget: %llu\n", dataset->pccd_ro_budget);
+		spin_lock(&super->pccs_ro_lock);
+		seq_printf(m, "  ro_used: %llu\n", dataset->pccd_ro_used);
+		spin_unlock(&super->pccs_ro_lock);
+		seq_printf(m, "  ro_prefetched: %u\n",
+			   atomic_read(&dataset->pccd_ro_prefetched));
+		seq_printf(m, "  ro_evicted: %u\n",
+			   atomic_read(&dataset->pccd_ro_evicted));
+	}
+	if (dataset->pccd_wb_delay == 0)
+		return;
+
+	/* Data not yet written back is the size of the queued PCC copies */
+	spin_lock(&super->pccs_wb_lock);
+	list_for_each_entry(pcci, &super->pccs_wb_list, pcci_wb_linkage) {
+		if (pcci->pcci_wb_dataset == dataset)
+			dirty += i_size_read(pcci->pcci_path.dentry->d_inode);
+	}
+	spin_unlock(&super->pccs_wb_lock);
+
+	bytes = atomic64_read(&dataset->pccd_wb_bytes);
+	time_ms = atomic64_read(&dataset->pccd_wb_time);
+	seq_printf(m, "  wb_delay: %u\n", dataset->pccd_wb_delay);
+	seq_printf(m, "  wb_pending: %u\n",
+		   atomic_read(&dataset->pccd_wb_pending));
+	seq_printf(m, "  wb_dirty_bytes: %llu\n", dirty);
+	seq_printf(m, "  wb_flushed_bytes: %llu\n", bytes);
+	seq_printf(m, "  wb_flush_bw: %llu KiB/s\n",
+		   time_ms ? div64_u64(bytes * MSEC_PER_SEC, time_ms) >> 10 : 0);
 }
 
 int
@@ -850,7 +947,7 @@ pcc_super_dump(struct pcc_super *super, struct seq_file *m)
 
 	down_read(&super->pccs_rw_sem);
 	list_for_each_entry(dataset, &super->pccs_datasets, pccd_linkage) {
-		pcc_dataset_dump(dataset, m);
+		pcc_dataset_dump(super, dataset, m);
 	}
 	up_read(&super->pccs_rw_sem);
 	return 0;
@@ -869,8 +966,26 @@ static void pcc_remove_datasets(struct pcc_super *super)
 	up_write(&super->pccs_rw_sem);
 }
 
+/*
+ * Called at umount before the inodes are evicted, the scan holds a reference
+ * on the inode it is writing back. The scan only sends the restore requests,
+ * so this does not wait for the data to be copied.
+ */
+void pcc_super_wb_stop(struct pcc_super *super)
+{
+	spin_lock(&super->pccs_wb_lock);
+	super->pccs_wb_stopping = true;
+	spin_unlock(&super->pccs_wb_lock);
+
+	cancel_delayed_work_sync(&super->pccs_wb_work);
+}
+
 void pcc_super_fini(struct pcc_super *super)
 {
+	cancel_delayed_work_sync(&super->pccs_wb_work);
+	/* remove the RO-PCC copies of the inodes evicted at umount */
+	cancel_work_sync(&super->pccs_ro_work);
+	pcc_ro_work(&super->pccs_ro_work);
 	pcc_remove_datasets(super);
 	put_cred(super->pccs_cred);
 }
@@ -1009,16 +1124,134 @@ static void pcc_inode_init(struct pcc_inode *pcci, struct ll_inode_info *lli)
 	pcci->pcci_layout_gen = CL_LAYOUT_GEN_NONE;
 	atomic_set(&pcci->pcci_active_ios, 0);
 	init_waitqueue_head(&pcci->pcci_waitq);
+	pcci->pcci_wb_dataset = NULL;
+	INIT_LIST_HEAD(&pcci->pcci_wb_linkage);
+	pcci->pcci_wb_flushing = false;
+	pcci->pcci_ro_dataset = NULL;
+	INIT_LIST_HEAD(&pcci->pcci_ro_linkage);
+}
+
+static inline struct pcc_super *pcc_inode_super(struct pcc_inode *pcci)
+{
+	return &ll_i2sbi(ll_info2i(pcci->pcci_lli))->ll_pcc_super;
+}
+
+/*
+ * Queue a RW-PCC inode for the background write-back if its dataset has it
+ * enabled. The inode stays on the list until it is detached from PCC.
+ */
+static void pcc_inode_wb_add(struct pcc_inode *pcci,
+			     struct pcc_dataset *dataset)
+{
+	struct pcc_super *super = pcc_inode_super(pcci);
+	bool added = false;
+
+	if (pcci->pcci_type != LU_PCC_READWRITE || dataset->pccd_wb_delay == 0)
+		return;
+
+	spin_lock(&super->pccs_wb_lock);
+	if (pcci->pcci_wb_dataset == NULL) {
+		atomic_inc(&dataset->pccd_refcount);
+		atomic_inc(&dataset->pccd_wb_pending);
+		pcci->pcci_wb_dataset = dataset;
+		list_add_tail(&pcci->pcci_wb_linkage, &super->pccs_wb_list);
+		added = true;
+	}
+	pcci->pcci_wb_time = ktime_get_seconds();
+	if (super->pccs_wb_stopping)
+		added = false;
+	spin_unlock(&super->pccs_wb_lock);
+
+	if (added)
+		queue_delayed_work(system_long_wq, &super->pccs_wb_work,
+				   cfs_time_seconds(PCC_WB_SCAN_INTERVAL));
+}
+
+static void pcc_inode_wb_del(struct pcc_inode *pcci)
+{
+	struct pcc_super *super = pcc_inode_super(pcci);
+	struct pcc_dataset *dataset;
+
+	spin_lock(&super->pccs_wb_lock);
+	dataset = pcci->pcci_wb_dataset;
+	pcci->pcci_wb_dataset = NULL;
+	pcci->pcci_wb_flushing = false;
+	list_del_init(&pcci->pcci_wb_linkage);
+	spin_unlock(&super->pccs_wb_lock);
+
+	if (dataset != NULL) {
+		atomic_dec(&dataset->pccd_wb_pending);
+		pcc_dataset_put(dataset);
+	}
+}
+
+/*
+ * The layout of a file under write-back changed, the restore sent by
+ * pcc_wb_flush() is complete. Account the data copied to Lustre.
+ */
+static void pcc_inode_wb_done(struct pcc_inode *pcci)
+{
+	struct pcc_dataset *dataset = pcci->pcci_wb_dataset;
+
+	if (dataset == NULL || !pcci->pcci_wb_flushing)
+		return;
+
+	atomic64_add(i_size_read(pcci->pcci_path.dentry->d_inode),
+		     &dataset->pccd_wb_bytes);
+	atomic64_add(ktime_ms_delta(ktime_get(), pcci->pcci_wb_start),
+		     &dataset->pccd_wb_time);
+}
+
+/* Any IO or close on the PCC copy delays its write-back */
+static inline void pcc_inode_wb_touch(struct pcc_inode *pcci)
+{
+	if (pcci->pcci_wb_dataset != NULL)
+		pcci->pcci_wb_time = ktime_get_seconds();
+}
+
+/* Stop accounting a RO-PCC copy in its dataset, it may not be used anymore */
+static void pcc_inode_ro_del(struct pcc_inode *pcci)
+{
+	struct pcc_super *super = pcc_inode_super(pcci);
+	struct pcc_dataset *dataset = pcci->pcci_ro_dataset;
+
+	if (dataset == NULL)
+		return;
+
+	spin_lock(&super->pccs_ro_lock);
+	if (!list_empty(&pcci->pcci_ro_linkage)) {
+		list_del_init(&pcci->pcci_ro_linkage);
+		dataset->pccd_ro_used -= pcci->pcci_ro_size;
+	}
+	spin_unlock(&super->pccs_ro_lock);
 }
 
 static void pcc_inode_fini(struct pcc_inode *pcci)
 {
 	struct ll_inode_info *lli = pcci->pcci_lli;
+	struct pcc_super *super = pcc_inode_super(pcci);
 
-	path_put(&pcci->pcci_path);
+	pcc_inode_wb_del(pcci);
+	pcc_inode_ro_del(pcci);
+	lli->lli_pcc_inode = NULL;
 	pcci->pcci_type = LU_PCC_NONE;
+
+	if (pcci->pcci_ro_dataset != NULL) {
+		/*
+		 * The RO-PCC copy is useless without the Lustre inode, it is
+		 * removed by pcc_ro_work() as this may be called from inode
+		 * eviction.
+		 */
+		pcci->pcci_lli = NULL;
+		spin_lock(&super->pccs_ro_lock);
+		list_add_tail(&pcci->pcci_ro_linkage, &super->pccs_ro_free);
+		spin_unlock(&super->pccs_ro_lock);
+		queue_work(system_long_wq, &super->pccs_ro_work);
+		return;
+	}
+
+	path_put(&pcci->pcci_path);
 	OBD_SLAB_FREE_PTR(pcci, pcc_inode_slab);
-	lli->lli_pcc_inode = NULL;
 }
 
 static void pcc_inode_get(struct pcc_inode *pcci)
@@ -1165,6 +1398,8 @@ static void pcc_inode_attach_init(struct pcc_dataset *dataset,
 		lli->lli_pcc_state |= PCC_STATE_FL_IO_ATTACH;
 	if (dataset->pccd_flags & PCC_DATASET_STAT_ATTACH)
 		lli->lli_pcc_state |= PCC_STATE_FL_STAT_ATTACH;
+
+	pcc_inode_wb_add(pcci, dataset);
 }
 
 static inline void pcc_layout_gen_set(struct pcc_inode *pcci,
@@ -1252,6 +1487,7 @@ static int pcc_try_dataset_attach(struct inode *inode, __u32 gen,
 			 */
 			pcc_inode_get(pcci);
 			pcci->pcci_type = type;
+			pcc_inode_wb_add(pcci, dataset);
 		}
 		pcc_layout_gen_set(pcci, gen);
 		*cached = true;
@@ -1306,6 +1542,10 @@ static int pcc_try_auto_attach(struct inode *inode, bool *cached, bool is_open)
 	if (list_empty(&super->pccs_datasets))
 		RETURN(0);
 
+	/* The RO-PCC copy of a detached file is not removed yet */
+	if (lli->lli_pcc_inode && lli->lli_pcc_inode->pcci_ro_dataset)
+		RETURN(0);
+
 	/*
 	 * The file layout lock was cancelled. And this open does not
 	 * obtain valid layout lock from MDT (i.e. the file is being
@@ -1360,10 +1600,20 @@ int pcc_file_open(struct inode *inode, struct file *file)
 	if (lli->lli_pcc_state & PCC_STATE_FL_ATTACHING)
 		GOTO(out_unlock, rc = 0);
 
+	if (pcci && pcc_inode_has_layout(pcci) &&
+	    pcci->pcci_type == LU_PCC_READONLY &&
+	    !pcc_readonly_valid(inode, file, pcci)) {
+		__pcc_readonly_detach(pcci);
+		GOTO(out_unlock, rc = 0);
+	}
+
 	if (!pcci || !pcc_inode_has_layout(pcci)) {
 		if (lli->lli_pcc_state & PCC_STATE_FL_OPEN_ATTACH)
 			rc = pcc_try_auto_attach(inode, &cached, true);
 
+		if (rc == 0 && !cached)
+			pcc_readonly_prefetch_check(inode, file);
+
 		if (rc < 0 || !cached)
 			GOTO(out_unlock, rc);
 
@@ -1423,6 +1673,7 @@ void pcc_file_release(struct inode *inode, struct file *file)
 	dname = &path->dentry->d_name;
 	CDEBUG(D_CACHE, "releasing pcc file \"%.*s\"\n", dname->len,
 	       dname->name);
+	pcc_inode_wb_touch(pcci);
 	pcc_inode_put(pcci);
 	fput(pccf->pccf_file);
 	pccf->pccf_file = NULL;
@@ -1438,7 +1689,12 @@ static void pcc_io_init(struct inode *inode, enum pcc_io_type iot, bool *cached)
 
 	pcc_inode_lock(inode);
 	pcci = ll_i2pcci(inode);
-	if (pcci && pcc_inode_has_layout(pcci)) {
+	if (pcci && pcc_inode_has_layout(pcci) &&
+	    pcci->pcci_type == LU_PCC_READONLY &&
+	    (iot == PIT_GETATTR || iot == PIT_SETATTR)) {
+		/* Attributes of RO-PCC files are those of the Lustre file */
+		*cached = false;
+	} else if (pcci && pcc_inode_has_layout(pcci)) {
 		LASSERT(atomic_read(&pcci->pcci_refcount) > 0);
 		atomic_inc(&pcci->pcci_active_ios);
 		*cached = true;
@@ -1464,6 +1720,7 @@ static void pcc_io_fini(struct inode *inode)
 	struct pcc_inode *pcci = ll_i2pcci(inode);
 
 	LASSERT(pcci && atomic_read(&pcci->pcci_active_ios) > 0);
+	pcc_inode_wb_touch(pcci);
 	if (atomic_dec_and_test(&pcci->pcci_active_ios))
 		wake_up_all(&pcci->pcci_waitq);
 }
@@ -1583,6 +1840,7 @@ ssize_t pcc_file_write_iter(struct kiocb *iocb,
 	ENTRY;
 
 	if (pccf->pccf_file == NULL) {
+		pcc_readonly_invalidate(inode);
 		*cached = false;
 		RETURN(0);
 	}
@@ -1628,6 +1886,9 @@ int pcc_inode_setattr(struct inode *inode, struct iattr *attr,
 		RETURN(0);
 	}
 
+	if (attr->ia_valid & ATTR_SIZE)
+		pcc_readonly_invalidate(inode);
+
 	pcc_io_init(inode, PIT_SETATTR, cached);
 	if (!*cached)
 		RETURN(0);
@@ -1862,6 +2123,8 @@ int pcc_page_mkwrite(struct vm_area_struct *vma, struct vm_fault *vmf,
 	ENTRY;
 
 	if (!pcc_file || !pcc_vm_ops) {
+		if (!pcc_file)
+			pcc_readonly_invalidate(inode);
 		*cached = false;
 		RETURN(0);
 	}
@@ -1979,6 +2242,8 @@ static void __pcc_layout_invalidate(struct pcc_inode *pcci)
 	pcci->pcci_type = LU_PCC_NONE;
 	pcc_layout_gen_set(pcci, CL_LAYOUT_GEN_NONE);
 	pcc_layout_wait(pcci);
+	pcc_inode_wb_del(pcci);
+	pcc_inode_ro_del(pcci);
 }
 
 void pcc_layout_invalidate(struct inode *inode)
@@ -1989,8 +2254,11 @@ void pcc_layout_invalidate(struct inode *inode)
 
 	pcc_inode_lock(inode);
 	pcci = ll_i2pcci(inode);
-	if (pcci && pcc_inode_has_layout(pcci)) {
+	/* RO-PCC copies are checked against the data version at open */
+	if (pcci && pcc_inode_has_layout(pcci) &&
+	    pcci->pcci_type != LU_PCC_READONLY) {
 		LASSERT(atomic_read(&pcci->pcci_refcount) > 0);
+		pcc_inode_wb_done(pcci);
 		__pcc_layout_invalidate(pcci);
 
 		CDEBUG(D_CACHE, "Invalidate "DFID" layout gen %d\n",
@@ -2003,6 +2271,105 @@ void pcc_layout_invalidate(struct inode *inode)
 	EXIT;
 }
 
+/*
+ * Write back a RW-PCC file to Lustre. The file was released on attach, so
+ * it has no OST objects and its data can only be brought back as a whole by
+ * a HSM restore, done by the copytool from the PCC copy with large
+ * sequential I/Os. Only the restore request is sent here; the layout change
+ * at the end of the restore detaches the file from PCC, and later I/Os go
+ * to Lustre directly.
+ */
+static int pcc_wb_flush(struct inode *inode)
+{
+	const struct cred *old_cred;
+	int rc;
+
+	ENTRY;
+
+	old_cred = override_creds(pcc_super_cred(inode->i_sb));
+	rc = ll_layout_restore(inode, 0, OBD_OBJECT_EOF);
+	revert_creds(old_cred);
+
+	if (rc)
+		CDEBUG(D_CACHE, DFID" write-back failure: rc = %d\n",
+		       PFID(&ll_i2info(inode)->lli_fid), rc);
+	RETURN(rc);
+}
+
+static void pcc_wb_scan(struct work_struct *work)
+{
+	struct pcc_super *super = container_of(work, struct pcc_super,
+					       pccs_wb_work.work);
+	struct pcc_dataset *dataset;
+	struct pcc_inode *pcci;
+	struct inode *inode;
+	bool more;
+	int rc;
+
+	ENTRY;
+
+again:
+	inode = NULL;
+	spin_lock(&super->pccs_wb_lock);
+	if (super->pccs_wb_stopping) {
+		spin_unlock(&super->pccs_wb_lock);
+		RETURN_EXIT;
+	}
+
+	list_for_each_entry(pcci, &super->pccs_wb_list, pcci_wb_linkage) {
+		dataset = pcci->pcci_wb_dataset;
+		/*
+		 * Only write back files which are fully attached and which
+		 * nobody has open or used for wb_delay seconds. The restore
+		 * of a file under write-back is sent again if it is not
+		 * complete after wb_delay, the coordinator ignores it if the
+		 * first one is still running.
+		 */
+		if (!pcc_inode_has_layout(pcci) ||
+		    atomic_read(&pcci->pcci_refcount) > 1 ||
+		    atomic_read(&pcci->pcci_active_ios) > 0 ||
+		    ktime_get_seconds() < pcci->pcci_wb_time +
+					  dataset->pccd_wb_delay)
+			continue;
+
+		inode = igrab(ll_info2i(pcci->pcci_lli));
+		if (inode == NULL)
+			continue;
+
+		if (!pcci->pcci_wb_flushing) {
+			pcci->pcci_wb_flushing = true;
+			pcci->pcci_wb_start = ktime_get();
+		}
+		pcci->pcci_wb_time = ktime_get_seconds();
+		break;
+	}
+	more = !list_empty(&super->pccs_wb_list);
+	spin_unlock(&super->pccs_wb_lock);
+
+	if (inode != NULL) {
+		rc = pcc_wb_flush(inode);
+		if (rc) {
+			/* retry after wb_delay */
+			pcc_inode_lock(inode);
+			pcci = ll_i2pcci(inode);
+			if (pcci != NULL) {
+				spin_lock(&super->pccs_wb_lock);
+				pcci->pcci_wb_flushing = false;
+				spin_unlock(&super->pccs_wb_lock);
+			}
+			pcc_inode_unlock(inode);
+		}
+
+		iput(inode);
+		goto again;
+	}
+
+	if (more)
+		queue_delayed_work(system_long_wq, &super->pccs_wb_work,
+				   cfs_time_seconds(PCC_WB_SCAN_INTERVAL));
+	EXIT;
+}
+
 static int pcc_inode_remove(struct inode *inode, struct dentry *pcc_dentry)
 {
 	int rc;
@@ -2099,11 +2466,20 @@ out:
 	return dentry;
 }
 
+/*
+ * RO-PCC copies are kept in their own namespace under the dataset root. The
+ * FID path of RW-PCC is also the HSM archive path of the copytool, a RO-PCC
+ * copy there could overwrite or remove the archived data of the file.
+ */
+#define PCC_RO_DIR		".pcc_ro"
+
 static int __pcc_inode_create(struct pcc_dataset *dataset,
 			      struct lu_fid *fid,
-			      struct dentry **dentry)
+			      struct dentry **dentry,
+			      enum lu_pcc_type type)
 {
 	char *path;
+	struct dentry *root = dataset->pccd_path.dentry;
 	struct dentry *base;
 	struct dentry *child;
 	int rc = 0;
@@ -2112,9 +2488,17 @@ static int __pcc_inode_create(struct pcc_dataset *dataset,
 	if (path == NULL)
 		return -ENOMEM;
 
+	if (type == LU_PCC_READONLY) {
+		root = pcc_mkdir(root, PCC_RO_DIR, 0);
+		if (IS_ERR(root))
+			GOTO(out, rc = PTR_ERR(root));
+	}
+
 	pcc_fid2dataset_path(path, MAX_PCC_DATABASE_PATH, fid);
 
-	base = pcc_mkdir_p(dataset->pccd_path.dentry, path, 0);
+	base = pcc_mkdir_p(root, path, 0);
+	if (type == LU_PCC_READONLY)
+		dput(root);
 	if (IS_ERR(base)) {
 		rc = PTR_ERR(base);
 		GOTO(out, rc);
@@ -2162,7 +2546,7 @@ int pcc_inode_create(struct super_block *sb, struct pcc_dataset *dataset,
 	int rc;
 
 	old_cred = override_creds(pcc_super_cred(sb));
-	rc = __pcc_inode_create(dataset, fid, pcc_dentry);
+	rc = __pcc_inode_create(dataset, fid, pcc_dentry, LU_PCC_READWRITE);
 	revert_creds(old_cred);
 	return rc;
 }
@@ -2300,6 +2684,438 @@ out_free:
 	RETURN(rc);
 }
 
+/*
+ * RO-PCC: hot files which are mostly read are copied into a PCC backend by
+ * pcc_ro_work(), files are then read from the local copy. The copy is only
+ * valid for the data version of the Lustre file it was made from, which is
+ * checked at open: like NFS, RO-PCC provides close-to-open consistency for
+ * changes made by other clients, within PCC_RO_DV_MAX_AGE seconds. Any
+ * change made through this client detaches the file from RO-PCC first.
+ */
+static __u64 pcc_inode_heat(struct inode *inode, enum obd_heat_type type)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	__u64 heat;
+
+	spin_lock(&lli->lli_heat_lock);
+	heat = obd_heat_get(&lli->lli_heat_instances[type],
+			    ktime_get_real_seconds(),
+			    sbi->ll_heat_decay_weight,
+			    sbi->ll_heat_period_second);
+	spin_unlock(&lli->lli_heat_lock);
+
+	return heat;
+}
+
+/* Must be called with pcci->pcci_lock held */
+static void __pcc_readonly_detach(struct pcc_inode *pcci)
+{
+	CDEBUG(D_CACHE, "Detach "DFID" from RO-PCC\n",
+	       PFID(&pcci->pcci_lli->lli_fid));
+	__pcc_layout_invalidate(pcci);
+	pcc_inode_put(pcci);
+}
+
+/* Local changes through Lustre make the RO-PCC copy stale */
+static void pcc_readonly_invalidate(struct inode *inode)
+{
+	struct pcc_inode *pcci;
+
+	if (ll_i2pcci(inode) == NULL)
+		return;
+
+	pcc_inode_lock(inode);
+	pcci = ll_i2pcci(inode);
+	if (pcci && pcc_inode_has_layout(pcci) &&
+	    pcci->pcci_type == LU_PCC_READONLY)
+		__pcc_readonly_detach(pcci);
+	pcc_inode_unlock(inode);
+}
+
+/* Must be called with pcci->pcci_lock held */
+static bool pcc_readonly_valid(struct inode *inode, struct file *file,
+			       struct pcc_inode *pcci)
+{
+	__u64 dv;
+	int rc;
+
+	__u32 gen;
+
+	if (file->f_mode & FMODE_WRITE)
+		return false;
+
+	/* A new layout, e.g. after a mirror resync or a migration */
+	gen = ll_layout_version_get(ll_i2info(inode));
+	if (gen != CL_LAYOUT_GEN_NONE && gen != pcci->pcci_layout_gen) {
+		CDEBUG(D_CACHE, DFID" RO-PCC copy is stale: layout gen %u/%u\n",
+		       PFID(ll_inode2fid(inode)), gen, pcci->pcci_layout_gen);
+		return false;
+	}
+
+	/*
+	 * Hot files are opened many times a second, do not ask the OSTs for
+	 * the data version at each open.
+	 */
+	if (ktime_get_seconds() < pcci->pcci_ro_dv_time + PCC_RO_DV_MAX_AGE)
+		return true;
+
+	rc = ll_data_version(inode, &dv, LL_DV_RD_FLUSH);
+	if (rc || dv != pcci->pcci_ro_dv) {
+		CDEBUG(D_CACHE, DFID" RO-PCC copy is stale: rc = %d\n",
+		       PFID(ll_inode2fid(inode)), rc);
+		return false;
+	}
+	pcci->pcci_ro_dv_time = ktime_get_seconds();
+
+	return true;
+}
+
+static struct pcc_dataset *
+pcc_dataset_ro_get(struct pcc_super *super, struct pcc_matcher *matcher,
+		   __u64 heat)
+{
+	struct pcc_dataset *dataset;
+	struct pcc_dataset *selected = NULL;
+
+	down_read(&super->pccs_rw_sem);
+	list_for_each_entry(dataset, &super->pccs_datasets, pccd_linkage) {
+		if (!(dataset->pccd_flags & PCC_DATASET_ROPCC) ||
+		    dataset->pccd_ro_heat == 0 || heat < dataset->pccd_ro_heat)
+			continue;
+
+		if (pcc_cond_match(&dataset->pccd_rule, matcher)) {
+			atomic_inc(&dataset->pccd_refcount);
+			selected = dataset;
+			break;
+		}
+	}
+	up_read(&super->pccs_rw_sem);
+
+	return selected;
+}
+
+/*
+ * Called at open when the file is not cached in PCC, queue it to be
+ * prefetched into RO-PCC if it became hot enough.
+ * Must be called with pcci->pcci_lock held.
+ */
+static void pcc_readonly_prefetch_check(struct inode *inode,
+					struct file *file)
+{
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	struct pcc_super *super = &sbi->ll_pcc_super;
+	struct pcc_matcher matcher;
+	struct pcc_dataset *dataset;
+	struct pcc_ro_req *req;
+	__u64 heat;
+	bool queued = false;
+
+	if (list_empty(&super->pccs_datasets) ||
+	    !ll_sbi_has_file_heat(sbi) ||
+	    lli->lli_heat_flags & LU_HEAT_FLAG_OFF ||
+	    file->f_mode & FMODE_WRITE ||
+	    lli->lli_pcc_inode != NULL ||
+	    lli->lli_pcc_state & PCC_STATE_FL_RO_PREFETCH)
+		return;
+
+	heat = pcc_inode_heat(inode, OBD_HEAT_READSAMPLE);
+	if (heat == 0 || pcc_inode_heat(inode, OBD_HEAT_WRITESAMPLE) *
+			 PCC_RO_WRITE_RATIO > heat)
+		return;
+
+	matcher.pm_uid = from_kuid(&init_user_ns, inode->i_uid);
+	matcher.pm_gid = from_kgid(&init_user_ns, inode->i_gid);
+	matcher.pm_projid = lli->lli_projid;
+	matcher.pm_name = &file_dentry(file)->d_name;
+	dataset = pcc_dataset_ro_get(super, &matcher, heat);
+	if (dataset == NULL)
+		return;
+
+	OBD_ALLOC_PTR(req);
+	if (req == NULL) {
+		pcc_dataset_put(dataset);
+		return;
+	}
+
+	req->prr_path = file->f_path;
+	path_get(&req->prr_path);
+	req->prr_dataset = dataset;
+	req->prr_heat = heat;
+
+	spin_lock(&super->pccs_ro_lock);
+	if (super->pccs_ro_nr_reqs < PCC_RO_REQS_MAX) {
+		list_add_tail(&req->prr_linkage, &super->pccs_ro_reqs);
+		super->pccs_ro_nr_reqs++;
+		queued = true;
+	}
+	spin_unlock(&super->pccs_ro_lock);
+
+	if (!queued) {
+		path_put(&req->prr_path);
+		pcc_dataset_put(dataset);
+		OBD_FREE_PTR(req);
+		return;
+	}
+
+	CDEBUG(D_CACHE, "Prefetch "DFID" into RO-PCC, read heat %llu\n",
+	       PFID(&lli->lli_fid), heat);
+	lli->lli_pcc_state |= PCC_STATE_FL_RO_PREFETCH;
+	queue_work(system_long_wq, &super->pccs_ro_work);
+}
+
+/*
+ * Detach colder RO-PCC files until there is room for @size more bytes in
+ * the dataset. Files in use are never evicted.
+ */
+static int pcc_readonly_make_room(struct pcc_super *super,
+				  struct pcc_dataset *dataset,
+				  __u64 size, __u64 heat)
+{
+	struct pcc_inode *pcci;
+	struct pcc_inode *victim;
+	struct inode *inode;
+	__u64 victim_heat;
+	__u64 cur;
+
+	ENTRY;
+
+	if (dataset->pccd_ro_budget == 0)
+		RETURN(0);
+
+	if (size > dataset->pccd_ro_budget)
+		RETURN(-EFBIG);
+
+	while (1) {
+		victim = NULL;
+		victim_heat = heat;
+		inode = NULL;
+
+		spin_lock(&super->pccs_ro_lock);
+		if (dataset->pccd_ro_used + size <= dataset->pccd_ro_budget) {
+			spin_unlock(&super->pccs_ro_lock);
+			break;
+		}
+
+		list_for_each_entry(pcci, &dataset->pccd_ro_list,
+				    pcci_ro_linkage) {
+			if (atomic_read(&pcci->pcci_refcount) > 1)
+				continue;
+
+			cur = pcc_inode_heat(ll_info2i(pcci->pcci_lli),
+					     OBD_HEAT_READSAMPLE);
+			if (cur < victim_heat) {
+				victim = pcci;
+				victim_heat = cur;
+			}
+		}
+		if (victim != NULL)
+			inode = igrab(ll_info2i(victim->pcci_lli));
+		spin_unlock(&super->pccs_ro_lock);
+
+		if (inode == NULL)
+			RETURN(-ENOSPC);
+
+		pcc_readonly_invalidate(inode);
+		atomic_inc(&dataset->pccd_ro_evicted);
+		iput(inode);
+	}
+
+	RETURN(0);
+}
+
+static void pcc_readonly_prefetch(struct pcc_super *super,
+				  struct pcc_ro_req *req)
+{
+	struct pcc_dataset *dataset = req->prr_dataset;
+	struct inode *inode = req->prr_path.dentry->d_inode;
+	struct ll_inode_info *lli = ll_i2info(inode);
+	struct cl_layout clt = {
+		.cl_layout_gen = 0,
+		.cl_is_released = false,
+	};
+	const struct cred *old_cred;
+	struct pcc_inode *pcci;
+	struct dentry *dentry;
+	struct file *lu_filp;
+	struct file *pcc_filp;
+	struct path path;
+	__u64 dv, dv2;
+	__u64 size;
+	int rc;
+
+	ENTRY;
+
+	old_cred = override_creds(super->pccs_cred);
+#ifdef HAVE_DENTRY_OPEN_USE_PATH
+	lu_filp = dentry_open(&req->prr_path, O_RDONLY | O_LARGEFILE,
+			      current_cred());
+#else
+	lu_filp = dentry_open(req->prr_path.dentry, req->prr_path.mnt,
+			      O_RDONLY | O_LARGEFILE, current_cred());
+#endif
+	if (IS_ERR_OR_NULL(lu_filp))
+		GOTO(out_cred, rc = lu_filp == NULL ? -EINVAL :
+				    PTR_ERR(lu_filp));
+
+	rc = pcc_get_layout_info(inode, &clt);
+	if (rc)
+		GOTO(out_lu_filp, rc);
+
+	/* Released files are cached by RW-PCC, if anywhere */
+	if (clt.cl_is_released || lli->lli_open_fd_write_count > 0)
+		GOTO(out_lu_filp, rc = -EBUSY);
+
+	rc = ll_data_version(inode, &dv, LL_DV_RD_FLUSH);
+	if (rc)
+		GOTO(out_lu_filp, rc);
+
+	rc = ll_glimpse_size(inode);
+	if (rc)
+		GOTO(out_lu_filp, rc);
+
+	size = i_size_read(inode);
+	rc = pcc_readonly_make_room(super, dataset, size, req->prr_heat);
+	if (rc)
+		GOTO(out_lu_filp, rc);
+
+	rc = __pcc_inode_create(dataset, &lli->lli_fid, &dentry,
+				LU_PCC_READONLY);
+	if (rc)
+		GOTO(out_lu_filp, rc);
+
+	path.mnt = dataset->pccd_path.mnt;
+	path.dentry = dentry;
+#ifdef HAVE_DENTRY_OPEN_USE_PATH
+	pcc_filp = dentry_open(&path, O_TRUNC | O_WRONLY | O_LARGEFILE,
+			       current_cred());
+#else
+	pcc_filp = dentry_open(path.dentry, path.mnt,
+			       O_TRUNC | O_WRONLY | O_LARGEFILE,
+			       current_cred());
+#endif
+	if (IS_ERR_OR_NULL(pcc_filp))
+		GOTO(out_dentry, rc = pcc_filp == NULL ? -EINVAL :
+				      PTR_ERR(pcc_filp));
+
+	rc = pcc_copy_data(lu_filp, pcc_filp);
+	fput(pcc_filp);
+	if (rc)
+		GOTO(out_dentry, rc);
+
+	/* The file was changed during the copy */
+	rc = ll_data_version(inode, &dv2, LL_DV_RD_FLUSH);
+	if (rc == 0 && dv2 != dv)
+		rc = -ESTALE;
+	if (rc)
+		GOTO(out_dentry, rc);
+
+	pcc_inode_lock(inode);
+	if (lli->lli_pcc_inode != NULL || lli->lli_open_fd_write_count > 0)
+		GOTO(out_unlock, rc = -EBUSY);
+
+	OBD_SLAB_ALLOC_PTR_GFP(pcci, pcc_inode_slab, GFP_NOFS);
+	if (pcci == NULL)
+		GOTO(out_unlock, rc = -ENOMEM);
+
+	pcc_inode_init(pcci, lli);
+	pcc_inode_attach_init(dataset, pcci, dentry, LU_PCC_READONLY);
+	pcc_layout_gen_set(pcci, clt.cl_layout_gen);
+	atomic_inc(&dataset->pccd_refcount);
+	pcci->pcci_ro_dataset = dataset;
+	pcci->pcci_ro_dv = dv;
+	pcci->pcci_ro_dv_time = ktime_get_seconds();
+	pcci->pcci_ro_size = size;
+	spin_lock(&super->pccs_ro_lock);
+	list_add_tail(&pcci->pcci_ro_linkage, &dataset->pccd_ro_list);
+	dataset->pccd_ro_used += size;
+	spin_unlock(&super->pccs_ro_lock);
+	atomic_inc(&dataset->pccd_ro_prefetched);
+out_unlock:
+	pcc_inode_unlock(inode);
+out_dentry:
+	if (rc) {
+		(void) pcc_inode_remove(inode, dentry);
+		dput(dentry);
+	}
+out_lu_filp:
+	fput(lu_filp);
+out_cred:
+	revert_creds(old_cred);
+
+	CDEBUG(D_CACHE, "Prefetch "DFID" into RO-PCC: rc = %d\n",
+	       PFID(&lli->lli_fid), rc);
+
+	pcc_inode_lock(inode);
+	lli->lli_pcc_state &= ~PCC_STATE_FL_RO_PREFETCH;
+	pcc_inode_unlock(inode);
+	EXIT;
+}
+
+/* Remove the RO-PCC copy of an inode detached and released */
+static void pcc_readonly_remove(struct pcc_super *super,
+				struct pcc_inode *pcci)
+{
+	struct dentry *dentry = pcci->pcci_path.dentry;
+	struct dentry *parent;
+	const struct cred *old_cred;
+	int rc;
+
+	old_cred = override_creds(super->pccs_cred);
+	parent = dget_parent(dentry);
+	inode_lock(parent->d_inode);
+	rc = ll_vfs_unlink(parent->d_inode, dentry);
+	inode_unlock(parent->d_inode);
+	dput(parent);
+	revert_creds(old_cred);
+	if (rc)
+		CDEBUG(D_CACHE, "failed to unlink RO-PCC file %.*s: rc = %d\n",
+		       dentry->d_name.len, dentry->d_name.name, rc);
+
+	pcc_dataset_put(pcci->pcci_ro_dataset);
+	path_put(&pcci->pcci_path);
+	OBD_SLAB_FREE_PTR(pcci, pcc_inode_slab);
+}
+
+static void pcc_ro_work(struct work_struct *work)
+{
+	struct pcc_super *super = container_of(work, struct pcc_super,
+					       pccs_ro_work);
+	struct pcc_inode *pcci;
+	struct pcc_ro_req *req;
+
+	ENTRY;
+
+	/* Remove the stale copies first, they may use the budget */
+	spin_lock(&super->pccs_ro_lock);
+	while (!list_empty(&super->pccs_ro_free)) {
+		pcci = list_entry(super->pccs_ro_free.next,
+				  struct pcc_inode, pcci_ro_linkage);
+		list_del_init(&pcci->pcci_ro_linkage);
+		spin_unlock(&super->pccs_ro_lock);
+
+		pcc_readonly_remove(super, pcci);
+		spin_lock(&super->pccs_ro_lock);
+	}
+
+	while (!list_empty(&super->pccs_ro_reqs)) {
+		req = list_entry(super->pccs_ro_reqs.next,
+				 struct pcc_ro_req, prr_linkage);
+		list_del(&req->prr_linkage);
+		super->pccs_ro_nr_reqs--;
+		spin_unlock(&super->pccs_ro_lock);
+
+		pcc_readonly_prefetch(super, req);
+		path_put(&req->prr_path);
+		pcc_dataset_put(req->prr_dataset);
+		OBD_FREE_PTR(req);
+		spin_lock(&super->pccs_ro_lock);
+	}
+	spin_unlock(&super->pccs_ro_lock);
+	EXIT;
+}
+
 static int pcc_attach_allowed_check(struct inode *inode)
 {
 	struct ll_inode_info *lli = ll_i2info(inode);
@@ -2313,7 +3129,7 @@ static int pcc_attach_allowed_check(struct inode *inode)
 		GOTO(out_unlock, rc = -EBUSY);
 
 	pcci = ll_i2pcci(inode);
-	if (pcci && pcc_inode_has_layout(pcci))
+	if (pcci && (pcc_inode_has_layout(pcci) || pcci->pcci_ro_dataset))
 		GOTO(out_unlock, rc = -EEXIST);
 
 	lli->lli_pcc_state |= PCC_STATE_FL_ATTACHING;
@@ -2346,7 +3162,8 @@ int pcc_readwrite_attach(struct file *file, struct inode *inode,
 		RETURN(-ENOENT);
 
 	old_cred = override_creds(pcc_super_cred(inode->i_sb));
-	rc = __pcc_inode_create(dataset, &lli->lli_fid, &dentry);
+	rc = __pcc_inode_create(dataset, &lli->lli_fid, &dentry,
+				LU_PCC_READWRITE);
 	if (rc) {
 		revert_creds(old_cred);
 		GOTO(out_dataset_put, rc);
@@ -2525,6 +3342,8 @@ int pcc_ioctl_detach(struct inode *inode, __u32 opt)
 
 		__pcc_layout_invalidate(pcci);
 		pcc_inode_put(pcci);
+	} else if (pcci->pcci_type == LU_PCC_READONLY) {
+		__pcc_readonly_detach(pcci);
 	}
 
 out_unlock:
@@ -2582,6 +3401,10 @@ int pcc_ioctl_state(struct file *file, struct inode *inode,
 	state->pccs_type = pcci->pcci_type;
 	state->pccs_open_count = count;
 	state->pccs_flags = ll_i2info(inode)->lli_pcc_state;
+	if (pcci->pcci_wb_flushing)
+		state->pccs_flags |= PCC_STATE_FL_WB_FLUSHING;
+	else if (pcci->pcci_wb_dataset != NULL)
+		state->pccs_flags |= PCC_STATE_FL_WB_PENDING;
 	path = dentry_path_raw(pcci->pcci_path.dentry, buf, buf_len);
 	if (IS_ERR(path))
 		GOTO(out_unlock, rc = PTR_ERR(path));
@@ -36,6 +36,7 @@
 #include <linux/fs.h>
 #include <linux/seq_file.h>
 #include <linux/mm.h>
+#include <linux/workqueue.h>
 #include <uapi/linux/lustre/lustre_user.h>
 
 extern struct kmem_cache *pcc_inode_slab;
@@ -118,6 +119,31 @@ struct pcc_dataset {
 	struct path		pccd_path;	 /* Root path */
 	struct list_head	pccd_linkage;  /* Linked to pccs_datasets */
 	atomic_t		pccd_refcount; /* Reference count */
+	/*
+	 * Delay in seconds before an idle RW-PCC file is written back to
+	 * Lustre in background, 0 to keep it in PCC until detached.
+	 */
+	__u32			pccd_wb_delay;
+	/* Number of files waiting for or under write-back */
+	atomic_t		pccd_wb_pending;
+	/* Bytes written back to Lustre */
+	atomic64_t		pccd_wb_bytes;
+	/* Time spent writing back files, in ms */
+	atomic64_t		pccd_wb_time;
+	/*
+	 * Read heat from which a file is prefetched into RO-PCC in
+	 * background, 0 to disable the prefetch.
+	 */
+	__u32			pccd_ro_heat;
+	/* Space allowed for RO-PCC copies, in bytes, 0 for no limit */
+	__u64			pccd_ro_budget;
+	/* Space used by the attached RO-PCC copies, in bytes */
+	__u64			pccd_ro_used;
+	/* Attached RO-PCC inodes, linked by pcci_ro_linkage */
+	struct list_head	pccd_ro_list;
+	/* Number of files prefetched and evicted */
+	atomic_t		pccd_ro_prefetched;
+	atomic_t		pccd_ro_evicted;
 };
 
 struct pcc_super {
@@ -127,6 +153,23 @@ struct pcc_super {
 	struct list_head	 pccs_datasets;
 	/* creds of process who forced instantiation of super block */
 	const struct cred	*pccs_cred;
+	/* Protect pccs_wb_list */
+	spinlock_t		 pccs_wb_lock;
+	/* RW-PCC inodes to write back, linked by pcci_wb_linkage */
+	struct list_head	 pccs_wb_list;
+	/* Periodic scan of pccs_wb_list */
+	struct delayed_work	 pccs_wb_work;
+	/* Set at umount, no more write-back is started */
+	bool			 pccs_wb_stopping;
+	/* Protect pccs_ro_reqs, pccs_ro_free and the datasets RO lists */
+	spinlock_t		 pccs_ro_lock;
+	/* Hot files to prefetch into RO-PCC */
+	struct list_head	 pccs_ro_reqs;
+	unsigned int		 pccs_ro_nr_reqs;
+	/* Detached RO-PCC inodes whose copy is to be removed */
+	struct list_head	 pccs_ro_free;
+	/* Prefetch hot files and remove the detached copies */
+	struct work_struct	 pccs_ro_work;
 };
 
 struct pcc_inode {
@@ -151,6 +194,34 @@ struct pcc_inode {
 	atomic_t		 pcci_active_ios;
 	/* Waitq - wait for PCC I/O completion. */
 	wait_queue_head_t	 pcci_waitq;
+	/* Dataset with write-back enabled this inode is attached into */
+	struct pcc_dataset	*pcci_wb_dataset;
+	/* Linked to pccs_wb_list while waiting for write-back */
+	struct list_head	 pcci_wb_linkage;
+	/* Last IO or close on the PCC copy, in seconds */
+	time64_t		 pcci_wb_time;
+	/* Whether the write-back to Lustre is in progress */
+	bool			 pcci_wb_flushing;
+	/* When the write-back was started */
+	ktime_t			 pcci_wb_start;
+	/* Dataset holding the RO-PCC copy, until the copy is removed */
+	struct pcc_dataset	*pcci_ro_dataset;
+	/* Linked to pccd_ro_list while attached, then to pccs_ro_free */
+	struct list_head	 pcci_ro_linkage;
+	/* Data version of the Lustre file the RO-PCC copy was made from */
+	__u64			 pcci_ro_dv;
+	/* When pcci_ro_dv was last checked against the Lustre file */
+	time64_t		 pcci_ro_dv_time;
+	/* Size of the RO-PCC copy */
+	__u64			 pcci_ro_size;
+};
+
+/* Request to prefetch a hot file into RO-PCC */
+struct pcc_ro_req {
+	struct list_head	 prr_linkage;
+	struct path		 prr_path;
+	struct pcc_dataset	*prr_dataset;
+	__u64			 prr_heat;
 };
 
 struct pcc_file {
@@ -195,6 +266,9 @@ struct pcc_cmd {
 			struct list_head	 pccc_conds;
 			char			*pccc_conds_str;
 			enum pcc_dataset_flags	 pccc_flags;
+			__u32			 pccc_wb_delay;
+			__u32			 pccc_ro_heat;
+			__u64			 pccc_ro_budget;
 		} pccc_add;
 		struct pcc_cmd_del {
 			__u32			 pccc_pad;
@@ -209,6 +283,7 @@ struct pcc_create_attach {
 
 int pcc_super_init(struct pcc_super *super);
 void pcc_super_fini(struct pcc_super *super);
+void pcc_super_wb_stop(struct pcc_super *super);
 int pcc_cmd_handle(char *buffer, unsigned long count,
 		   struct pcc_super *super);
 int pcc_super_dump(struct pcc_super *super, struct seq_file *m);
@@ -370,6 +370,12 @@ sa_prep_data(struct inode *dir, struct inode *child, struct sa_entry *entry)
 	if (child == NULL)
 		op_data->op_fid2 = entry->se_fid;
 
+	/* get the data of small DoM files too, they are likely to be read
+	 * next, e.g. by a build or an interpreter loading modules */
+	if (ll_i2sbi(dir)->ll_flags & LL_SBI_SA_DOM &&
+	    (child == NULL || S_ISREG(child->i_mode)))
+		op_data->op_cli_flags |= CLI_DOM_PREFETCH;
+
 	minfo->mi_it.it_op = IT_GETATTR;
 	minfo->mi_dir = igrab(dir);
 	minfo->mi_cb = ll_statahead_interpret;
@@ -673,6 +679,11 @@ static void sa_instantiate(struct ll_statahead_info *sai,
 
 	entry->se_inode = child;
 
+	if (S_ISREG(child->i_mode) && ll_dom_finish_open(child, req, it) > 0) {
+		ll_file_set_flag(ll_i2info(child), LLIF_DOM_PREFETCHED);
+		atomic_inc(&ll_i2sbi(dir)->ll_sa_dom_total);
+	}
+
 	if (agl_should_run(sai, child))
 		ll_agl_add(sai, child, entry->se_index);
 
@@ -878,6 +889,22 @@ static void sa_statahead(struct dentry *parent, const char *name, int len,
 	EXIT;
 }
 
+/* Send the AGL glimpses the OSCs are holding to batch them. */
+static void ll_agl_flush(struct ll_sb_info *sbi)
+{
+	struct lu_env *env;
+	__u16 refcheck;
+
+	env = cl_env_get(&refcheck);
+	if (IS_ERR(env))
+		return;
+
+	obd_set_info_async(env, sbi->ll_dt_exp,
+			   sizeof(KEY_GLIMPSE_BATCH_FLUSH),
+			   KEY_GLIMPSE_BATCH_FLUSH, 0, NULL, NULL);
+	cl_env_put(env, &refcheck);
+}
+
 /* async glimpse (agl) thread main function */
 static int ll_agl_thread(void *arg)
 {
@@ -889,6 +916,7 @@ static int ll_agl_thread(void *arg)
 	struct ll_statahead_info *sai;
 	struct ptlrpc_thread *thread;
 	struct l_wait_info lwi = { 0 };
+	bool pending = false;
 	ENTRY;
 
 	sai = ll_sai_get(dir);
@@ -909,6 +937,12 @@ static int ll_agl_thread(void *arg)
 	wake_up(&thread->t_ctl_waitq);
 
 	while (1) {
+		/* Wait a bit for more entries before sending the glimpses
+		 * batched so far, statahead is usually slower than AGL. */
+		if (pending)
+			lwi = LWI_TIMEOUT(cfs_time_seconds(1) >> 7, NULL, NULL);
+		else
+			lwi = LWI_TIMEOUT(0, NULL, NULL);
 		l_wait_event(thread->t_ctl_waitq,
 			     !agl_list_empty(sai) ||
 			     !thread_is_running(thread),
@@ -924,12 +958,20 @@ static int ll_agl_thread(void *arg)
 			list_del_init(&clli->lli_agl_list);
 			spin_unlock(&plli->lli_agl_lock);
 			ll_agl_trigger(&clli->lli_vfs_inode, sai);
+			pending = true;
 			cond_resched();
 		} else {
 			spin_unlock(&plli->lli_agl_lock);
+			if (pending) {
+				ll_agl_flush(sbi);
+				pending = false;
+			}
 		}
 	}
 
+	if (pending)
+		ll_agl_flush(sbi);
+
 	spin_lock(&plli->lli_agl_lock);
 	sai->sai_agl_valid = 0;
 	while (!agl_list_empty(sai)) {
@@ -992,6 +1034,7 @@ static int ll_statahead_thread(void *arg)
 	struct l_wait_info lwi = { 0 };
 	struct page *page = NULL;
 	__u64 pos = 0;
+	bool agl_pending = false;
 	int rc = 0;
 	ENTRY;
 
@@ -1119,10 +1162,15 @@ static int ll_statahead_thread(void *arg)
 
 					ll_agl_trigger(&clli->lli_vfs_inode,
 							sai);
+					agl_pending = true;
 					cond_resched();
 					spin_lock(&lli->lli_agl_lock);
 				}
 				spin_unlock(&lli->lli_agl_lock);
+				if (agl_pending) {
+					ll_agl_flush(sbi);
+					agl_pending = false;
+				}
 			} while (sa_sent_full(sai) &&
 				 thread_is_running(sa_thread));
 
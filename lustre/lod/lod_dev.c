@@ -1723,6 +1723,7 @@ static int lod_init0(const struct lu_env *env, struct lod_device *lod,
 	dt_conf_get(env, &lod->lod_dt_dev, &ddp);
 	lod->lod_osd_max_easize = ddp.ddp_max_ea_size;
 	lod->lod_dom_max_stripesize = (1ULL << 20); /* 1Mb as default value */
+	lod->lod_qos_alias = 1;
 
 	/* setup obd to be used with old lov code */
 	rc = lod_pools_init(lod, cfg);
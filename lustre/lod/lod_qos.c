@@ -212,6 +212,10 @@ void lod_qos_statfs_update(const struct lu_env *env, struct lod_device *lod,
 	}
 	obd->obd_osfs_age = ktime_get_seconds();
 
+	/* refresh the weights used by lod_ost_alloc_alias() */
+	if (lod->lod_qos_alias && !ltd->ltd_is_mdt)
+		ltd_qos_alias_update(ltd);
+
 out:
 	up_write(&ltd->ltd_qos.lq_rw_sem);
 	EXIT;
@@ -1312,6 +1316,95 @@ out:
 	RETURN(rc);
 }
 
+/**
+ * Allocate a striping from the cached OST weights.
+ *
+ * Fast path of lod_ost_alloc_qos(): the OSTs are drawn from the alias table
+ * built by ltd_qos_alias_update() on statfs updates, so each stripe costs
+ * O(1) instead of a scan of all the OSTs, and the QoS lock is only taken for
+ * read, so creates don't serialize on it. The penalties of the OSTs used
+ * since the last table rebuild are not taken into account, the draw being
+ * random is enough to spread the objects between two rebuilds.
+ *
+ * Only the default pool is handled, and overstriping isn't supported.
+ *
+ * \param[in] env		execution environment for this thread
+ * \param[in] lo		LOD object
+ * \param[out] stripe		striping created
+ * \param[out] ost_indices	ost indices of striping created
+ * \param[in] stripe_count	number of stripes to allocate
+ * \param[in] th		transaction handle
+ * \param[in] comp_idx		index of ldo_comp_entries
+ *
+ * \retval 0		on success
+ * \retval -EAGAIN	no table, or not enough OSTs found, use the slow path
+ * \retval negative	errno on failure
+ */
+static int lod_ost_alloc_alias(const struct lu_env *env, struct lod_object *lo,
+			       struct dt_object **stripe, __u32 *ost_indices,
+			       __u32 stripe_count, struct thandle *th,
+			       int comp_idx)
+{
+	struct lod_layout_component *lod_comp = &lo->ldo_comp_entries[comp_idx];
+	struct lod_device *lod = lu2lod_dev(lo->ldo_obj.do_lu.lo_dev);
+	struct lu_qos *qos = &lod->lod_ost_descs.ltd_qos;
+	struct lu_qos_alias *lqa;
+	bool overstriped = false;
+	__u32 nfound = 0;
+	__u32 tries;
+	__u32 idx;
+	__u32 i;
+	int rc;
+
+	ENTRY;
+
+	rc = lod_qos_tgt_in_use_clear(env, stripe_count);
+	if (rc)
+		RETURN(rc);
+
+	down_read(&qos->lq_rw_sem);
+	lqa = qos->lq_alias;
+	if (lqa == NULL || lqa->lqa_count < stripe_count * 2 ||
+	    !ltd_qos_is_usable(&lod->lod_ost_descs))
+		GOTO(out, rc = -EAGAIN);
+
+	for (tries = 0; tries < stripe_count * 2 + 16 &&
+	     nfound < stripe_count; tries++) {
+		idx = lu_qos_alias_draw(lqa);
+		if (!cfs_bitmap_check(lod->lod_ost_bitmap, idx))
+			continue;
+
+		/* Fail Check before osc_precreate() is called
+		 * so we can only 'fail' single OSC.
+		 */
+		if (OBD_FAIL_CHECK(OBD_FAIL_MDS_OSC_PRECREATE) && idx == 0)
+			continue;
+
+		if (lod_comp_is_ost_used(env, lo, idx))
+			continue;
+
+		lod_check_and_reserve_ost(env, lo, lod_comp, idx, 1, &nfound,
+					  stripe, ost_indices, th,
+					  &overstriped);
+	}
+
+	if (nfound != stripe_count) {
+		QOS_DEBUG("%s: wanted %d objects, drew only %d\n",
+			  lod2obd(lod)->obd_name, stripe_count, nfound);
+		for (i = 0; i < nfound; i++) {
+			dt_object_put(env, stripe[i]);
+			stripe[i] = NULL;
+		}
+		GOTO(out, rc = -EAGAIN);
+	}
+	rc = 0;
+	EXIT;
+out:
+	up_read(&qos->lq_rw_sem);
+
+	return rc;
+}
+
 /**
  * Allocate a striping using an algorithm with weights.
  *
@@ -1390,6 +1483,12 @@ static int lod_ost_alloc_qos(const struct lu_env *env, struct lod_object *lo,
 	if (lod_comp->llc_pattern & LOV_PATTERN_OVERSTRIPING)
 		stripes_per_ost =
 			(lod_comp->llc_stripe_count - 1)/osts->op_count + 1;
+	else if (pool == NULL && lod->lod_qos_alias) {
+		rc = lod_ost_alloc_alias(env, lo, stripe, ost_indices,
+					 stripe_count, th, comp_idx);
+		if (rc != -EAGAIN)
+			GOTO(out_nolock, rc);
+	}
 
 	/* Do actual allocation, use write lock here. */
 	down_write(&lod->lod_ost_descs.ltd_qos.lq_rw_sem);
@@ -876,6 +876,53 @@ static ssize_t lmv_failout_store(struct kobject *kobj, struct attribute *attr,
 }
 LUSTRE_RW_ATTR(lmv_failout);
 
+/**
+ * Show whether OSTs are drawn from cached weights for QoS allocation.
+ */
+static ssize_t qos_alias_show(struct kobject *kobj, struct attribute *attr,
+			      char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct lod_device *lod = dt2lod_dev(dt);
+
+	return snprintf(buf, PAGE_SIZE, "%d\n", lod->lod_qos_alias ? 1 : 0);
+}
+
+/**
+ * Enable/disable QoS allocation from cached weights.
+ *
+ * When enabled, the OST weights are turned into an alias table on each statfs
+ * update, and QoS allocations outside of pools draw their OSTs from this table
+ * under a shared lock. Otherwise, the weights are recalculated for each
+ * allocation under an exclusive lock.
+ */
+static ssize_t qos_alias_store(struct kobject *kobj, struct attribute *attr,
+			       const char *buffer, size_t count)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct lod_device *lod = dt2lod_dev(dt);
+	struct lu_qos *qos = &lod->lod_ost_descs.ltd_qos;
+	bool val = 0;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc)
+		return rc;
+
+	down_write(&qos->lq_rw_sem);
+	lod->lod_qos_alias = val;
+	if (!val) {
+		lu_qos_alias_free(qos->lq_alias);
+		qos->lq_alias = NULL;
+	}
+	up_write(&qos->lq_rw_sem);
+
+	return count;
+}
+LUSTRE_RW_ATTR(qos_alias);
+
 static struct lprocfs_vars lprocfs_lod_obd_vars[] = {
 	{ NULL }
 };
@@ -909,6 +956,7 @@ static struct attribute *lod_attrs[] = {
 	&lustre_attr_qos_maxage.attr,
 	&lustre_attr_qos_prio_free.attr,
 	&lustre_attr_lod_qos_thresholdrr.attr,
+	&lustre_attr_qos_alias.attr,
 	&lustre_attr_mdt_stripecount.attr,
 	&lustre_attr_mdt_stripetype.attr,
 	&lustre_attr_mdt_activeobd.attr,
@@ -234,11 +234,12 @@ static int mdc_cached_mb_seq_show(struct seq_file *m, void *v)
 
 	seq_printf(m, "used_mb: %ld\n"
 		   "busy_cnt: %ld\n"
-		   "reclaim: %llu\n",
+		   "reclaim: %llu\n"
+		   "contended: %llu\n",
 		   (atomic_long_read(&cli->cl_lru_in_list) +
 		    atomic_long_read(&cli->cl_lru_busy)) >> shift,
 		    atomic_long_read(&cli->cl_lru_busy),
-		   cli->cl_lru_reclaim);
+		   cli->cl_lru_reclaim, osc_lru_contended(cli));
 
 	return 0;
 }
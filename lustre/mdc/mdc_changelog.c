@@ -86,31 +86,44 @@ struct chlg_reader_state {
 	wait_queue_head_t	    crs_waitq_prod;
 	/* Wait queue for the record copy threads */
 	wait_queue_head_t	    crs_waitq_cons;
-	/* Mutex protecting crs_rec_count and crs_rec_queue */
+	/* Mutex protecting crs_rec_count, crs_rec_queue and crs_filter */
 	struct mutex		    crs_lock;
-	/* Number of item in the list */
+	/* Number of records queued */
 	__u64			    crs_rec_count;
-	/* List of prefetched enqueued_record::enq_linkage_items */
+	/* List of chlg_rec_chunk holding the prefetched records */
 	struct list_head	    crs_rec_queue;
 	unsigned int		    crs_last_catidx;
 	unsigned int		    crs_last_idx;
 	bool			    crs_poll;
+	/* Records wanted by the reader */
+	struct changelog_filter	    crs_filter;
 };
 
-struct chlg_rec_entry {
+/*
+ * Prefetched records are packed into large chunks, rather than allocated one
+ * by one, and copied from there to userland.
+ */
+struct chlg_rec_chunk {
 	/* Link within the chlg_reader_state::crs_rec_queue list */
-	struct list_head	enq_linkage;
-	/* Data (enq_record) field length */
-	__u64			enq_length;
-	/* Copy of a changelog record (see struct llog_changelog_rec) */
-	struct changelog_rec	enq_record[];
+	struct list_head	crc_linkage;
+	/* Offset of the first record not yet delivered */
+	unsigned int		crc_start;
+	/* Offset following the last queued record */
+	unsigned int		crc_end;
+	/* Copies of changelog records (see struct llog_changelog_rec) */
+	char			crc_data[];
 };
 
 enum {
 	/* Number of records to prefetch locally. */
-	CDEV_CHLG_MAX_PREFETCH = 1024,
+	CDEV_CHLG_MAX_PREFETCH = 8192,
+	/* Size of a chlg_rec_chunk */
+	CDEV_CHLG_CHUNK_SIZE = 65536,
 };
 
+#define CHLG_CHUNK_DATA_SIZE \
+	(CDEV_CHLG_CHUNK_SIZE - offsetof(struct chlg_rec_chunk, crc_data))
+
 /**
  * Deregister a changelog character device whose refcount has reached zero.
  */
@@ -148,6 +161,29 @@ static inline void chlg_obd_put(struct chlg_registered_dev *dev,
 	class_decref(obd, "changelog", dev);
 }
 
+/**
+ * Check whether a record matches the filter set by the reader.
+ * Called with crs_lock held.
+ */
+static bool chlg_rec_wanted(struct chlg_reader_state *crs,
+			    struct changelog_rec *rec)
+{
+	struct changelog_filter *filter = &crs->crs_filter;
+
+	if (filter->cf_type_mask != 0 &&
+	    (rec->cr_type >= 64 ||
+	     !(filter->cf_type_mask & BIT_ULL(rec->cr_type))))
+		return false;
+
+	if (filter->cf_jobid[0] != '\0' &&
+	    (!(rec->cr_flags & CLF_JOBID) ||
+	     strncmp(changelog_rec_jobid(rec)->cr_jobid, filter->cf_jobid,
+		     sizeof(filter->cf_jobid)) != 0))
+		return false;
+
+	return true;
+}
+
 /**
  * ChangeLog catalog processing callback invoked on each record.
  * If the current record is eligible to userland delivery, push
@@ -166,7 +202,8 @@ static int chlg_read_cat_process_cb(const struct lu_env *env,
 {
 	struct llog_changelog_rec *rec;
 	struct chlg_reader_state *crs = data;
-	struct chlg_rec_entry *enq;
+	struct chlg_rec_chunk *chunk = NULL;
+	bool wanted;
 	size_t len;
 	int rc;
 	ENTRY;
@@ -199,6 +236,13 @@ static int chlg_read_cat_process_cb(const struct lu_env *env,
 	       PFID(&rec->cr.cr_tfid), PFID(&rec->cr.cr_pfid),
 	       rec->cr.cr_namelen, changelog_rec_name(&rec->cr));
 
+	/* Filtered out records are never queued */
+	mutex_lock(&crs->crs_lock);
+	wanted = chlg_rec_wanted(crs, &rec->cr);
+	mutex_unlock(&crs->crs_lock);
+	if (!wanted)
+		RETURN(0);
+
 	wait_event_interruptible(crs->crs_waitq_prod,
 				 crs->crs_rec_count < CDEV_CHLG_MAX_PREFETCH ||
 				 kthread_should_stop());
@@ -207,16 +251,24 @@ static int chlg_read_cat_process_cb(const struct lu_env *env,
 		RETURN(LLOG_PROC_BREAK);
 
 	len = changelog_rec_size(&rec->cr) + rec->cr.cr_namelen;
-	OBD_ALLOC(enq, sizeof(*enq) + len);
-	if (enq == NULL)
-		RETURN(-ENOMEM);
-
-	INIT_LIST_HEAD(&enq->enq_linkage);
-	enq->enq_length = len;
-	memcpy(enq->enq_record, &rec->cr, len);
 
 	mutex_lock(&crs->crs_lock);
-	list_add_tail(&enq->enq_linkage, &crs->crs_rec_queue);
+	if (!list_empty(&crs->crs_rec_queue))
+		chunk = list_last_entry(&crs->crs_rec_queue,
+					struct chlg_rec_chunk, crc_linkage);
+	if (chunk == NULL ||
+	    chunk->crc_end + cfs_size_round(len) > CHLG_CHUNK_DATA_SIZE) {
+		OBD_ALLOC_LARGE(chunk, CDEV_CHLG_CHUNK_SIZE);
+		if (chunk == NULL) {
+			mutex_unlock(&crs->crs_lock);
+			RETURN(-ENOMEM);
+		}
+		list_add_tail(&chunk->crc_linkage, &crs->crs_rec_queue);
+	}
+
+	/* keep records 8-byte aligned in the chunk */
+	memcpy(chunk->crc_data + chunk->crc_end, &rec->cr, len);
+	chunk->crc_end += cfs_size_round(len);
 	crs->crs_rec_count++;
 	mutex_unlock(&crs->crs_lock);
 
@@ -226,12 +278,38 @@ static int chlg_read_cat_process_cb(const struct lu_env *env,
 }
 
 /**
- * Remove record from the list it is attached to and free it.
+ * Return the first queued record, or NULL if there is none.
+ * Called with crs_lock held.
  */
-static void enq_record_delete(struct chlg_rec_entry *rec)
+static struct changelog_rec *chlg_rec_first(struct chlg_reader_state *crs,
+					    struct chlg_rec_chunk **chunkp)
 {
-	list_del(&rec->enq_linkage);
-	OBD_FREE(rec, sizeof(*rec) + rec->enq_length);
+	struct chlg_rec_chunk *chunk;
+
+	if (list_empty(&crs->crs_rec_queue))
+		return NULL;
+
+	chunk = list_first_entry(&crs->crs_rec_queue, struct chlg_rec_chunk,
+				 crc_linkage);
+	*chunkp = chunk;
+
+	return (struct changelog_rec *)(chunk->crc_data + chunk->crc_start);
+}
+
+/**
+ * Dequeue the first record of \a chunk, and free the chunk once it has been
+ * fully consumed. Called with crs_lock held.
+ */
+static void chlg_rec_consume(struct chlg_reader_state *crs,
+			     struct chlg_rec_chunk *chunk, size_t len)
+{
+	chunk->crc_start += cfs_size_round(len);
+	crs->crs_rec_count--;
+
+	if (chunk->crc_start >= chunk->crc_end) {
+		list_del(&chunk->crc_linkage);
+		OBD_FREE_LARGE(chunk, CDEV_CHLG_CHUNK_SIZE);
+	}
 }
 
 /**
@@ -340,13 +418,15 @@ static ssize_t chlg_read(struct file *file, char __user *buff, size_t count,
 			 loff_t *ppos)
 {
 	struct chlg_reader_state *crs = file->private_data;
-	struct chlg_rec_entry *rec;
-	struct chlg_rec_entry *tmp;
+	struct chlg_rec_chunk *chunk;
+	struct changelog_rec *rec;
 	size_t written_total = 0;
+	unsigned int consumed;
+	size_t len;
 	ssize_t rc;
-	LIST_HEAD(consumed);
 	ENTRY;
 
+again:
 	if (file->f_flags & O_NONBLOCK && crs->crs_rec_count == 0) {
 		if (crs->crs_err < 0)
 			RETURN(crs->crs_err);
@@ -359,35 +439,45 @@ static ssize_t chlg_read(struct file *file, char __user *buff, size_t count,
 	rc = wait_event_interruptible(crs->crs_waitq_cons,
 			crs->crs_rec_count > 0 || crs->crs_eof || crs->crs_err);
 
+	consumed = 0;
 	mutex_lock(&crs->crs_lock);
-	list_for_each_entry_safe(rec, tmp, &crs->crs_rec_queue, enq_linkage) {
-		if (written_total + rec->enq_length > count)
-			break;
+	while ((rec = chlg_rec_first(crs, &chunk)) != NULL) {
+		len = changelog_rec_size(rec) + rec->cr_namelen;
 
-		if (copy_to_user(buff, rec->enq_record, rec->enq_length)) {
-			rc = -EFAULT;
-			break;
-		}
+		/* records queued before the filter was set */
+		if (chlg_rec_wanted(crs, rec)) {
+			if (written_total + len > count)
+				break;
 
-		buff += rec->enq_length;
-		written_total += rec->enq_length;
+			if (copy_to_user(buff, rec, len)) {
+				rc = -EFAULT;
+				break;
+			}
 
-		crs->crs_rec_count--;
-		list_move_tail(&rec->enq_linkage, &consumed);
+			buff += len;
+			written_total += len;
+		}
 
-		crs->crs_start_offset = rec->enq_record->cr_index + 1;
+		crs->crs_start_offset = rec->cr_index + 1;
+		chlg_rec_consume(crs, chunk, len);
+		consumed++;
 	}
 	mutex_unlock(&crs->crs_lock);
 
-	if (written_total > 0) {
-		rc = written_total;
+	/* room was made in the queue, even if all records were filtered */
+	if (consumed > 0)
 		wake_up_all(&crs->crs_waitq_prod);
-	} else if (rc == 0) {
-		rc = crs->crs_err;
+
+	/* only filtered out records, 0 would look like EOF to the reader */
+	if (written_total == 0 && consumed > 0 && rc == 0) {
+		*ppos = crs->crs_start_offset;
+		goto again;
 	}
 
-	list_for_each_entry_safe(rec, tmp, &consumed, enq_linkage)
-		enq_record_delete(rec);
+	if (written_total > 0)
+		rc = written_total;
+	else if (rc == 0)
+		rc = crs->crs_err;
 
 	*ppos = crs->crs_start_offset;
 
@@ -403,8 +493,8 @@ static ssize_t chlg_read(struct file *file, char __user *buff, size_t count,
  */
 static int chlg_set_start_offset(struct chlg_reader_state *crs, __u64 offset)
 {
-	struct chlg_rec_entry *rec;
-	struct chlg_rec_entry *tmp;
+	struct chlg_rec_chunk *chunk;
+	struct changelog_rec *rec;
 
 	mutex_lock(&crs->crs_lock);
 	if (offset < crs->crs_start_offset) {
@@ -413,14 +503,12 @@ static int chlg_set_start_offset(struct chlg_reader_state *crs, __u64 offset)
 	}
 
 	crs->crs_start_offset = offset;
-	list_for_each_entry_safe(rec, tmp, &crs->crs_rec_queue, enq_linkage) {
-		struct changelog_rec *cr = rec->enq_record;
-
-		if (cr->cr_index >= crs->crs_start_offset)
+	while ((rec = chlg_rec_first(crs, &chunk)) != NULL) {
+		if (rec->cr_index >= crs->crs_start_offset)
 			break;
 
-		crs->crs_rec_count--;
-		enq_record_delete(rec);
+		chlg_rec_consume(crs, chunk,
+				 changelog_rec_size(rec) + rec->cr_namelen);
 	}
 
 	mutex_unlock(&crs->crs_lock);
@@ -603,15 +691,17 @@ err_crs:
 static int chlg_release(struct inode *inode, struct file *file)
 {
 	struct chlg_reader_state *crs = file->private_data;
-	struct chlg_rec_entry *rec;
-	struct chlg_rec_entry *tmp;
+	struct chlg_rec_chunk *chunk;
+	struct chlg_rec_chunk *tmp;
 	int rc = 0;
 
 	if (crs->crs_prod_task)
 		rc = kthread_stop(crs->crs_prod_task);
 
-	list_for_each_entry_safe(rec, tmp, &crs->crs_rec_queue, enq_linkage)
-		enq_record_delete(rec);
+	list_for_each_entry_safe(chunk, tmp, &crs->crs_rec_queue, crc_linkage) {
+		list_del(&chunk->crc_linkage);
+		OBD_FREE_LARGE(chunk, CDEV_CHLG_CHUNK_SIZE);
+	}
 
 	kref_put(&crs->crs_ced->ced_refs, chlg_dev_clear);
 	OBD_FREE_PTR(crs);
@@ -654,6 +744,22 @@ static long chlg_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		crs->crs_poll = !!arg;
 		rc = 0;
 		break;
+	case OBD_IOC_CHLG_FILTER: {
+		struct changelog_filter filter;
+
+		if (copy_from_user(&filter, (void __user *)arg,
+				   sizeof(filter))) {
+			rc = -EFAULT;
+			break;
+		}
+		filter.cf_jobid[sizeof(filter.cf_jobid) - 1] = '\0';
+
+		mutex_lock(&crs->crs_lock);
+		crs->crs_filter = filter;
+		mutex_unlock(&crs->crs_lock);
+		rc = 0;
+		break;
+	}
 	default:
 		rc = -EINVAL;
 		break;
@@ -516,11 +516,19 @@ mdc_intent_getattr_pack(struct obd_export *exp, struct lookup_intent *it,
 		    OBD_MD_DEFAULT_MEA;
 	struct ldlm_intent *lit;
 	__u32 easize;
+	__u32 inline_size = 0;
 	bool have_secctx = false;
 	int rc;
 
 	ENTRY;
 
+	/* ask for the data of Data-on-MDT files along with the attributes,
+	 * it is returned only if it fits in the reply buffer */
+	if (op_data->op_cli_flags & CLI_DOM_PREFETCH) {
+		valid |= OBD_MD_DOM_PREFETCH;
+		inline_size = obddev->u.cli.cl_dom_min_inline_repsize;
+	}
+
 	req = ptlrpc_request_alloc(class_exp2cliimp(exp),
 				   &RQF_LDLM_INTENT_GETATTR);
 	if (req == NULL)
@@ -580,6 +588,9 @@ mdc_intent_getattr_pack(struct obd_export *exp, struct lookup_intent *it,
 				     RCL_SERVER, 0);
 	}
 
+	req_capsule_set_size(&req->rq_pill, &RMF_NIOBUF_INLINE, RCL_SERVER,
+			     sizeof(struct niobuf_remote) + inline_size);
+
 	ptlrpc_request_set_replen(req);
 	RETURN(req);
 }
@@ -834,6 +834,11 @@ int mdd_changelog_write_rec(const struct lu_env *env,
  * \param handle - currently ignored since llogs start their own transaction;
  *		this will hopefully be fixed in llog rewrite
  * \retval 0 ok
+ *
+ * The record is appended right away rather than staged and flushed later
+ * with records of other transactions: it has to be committed with the
+ * metadata change it describes, and a later flush could not write under
+ * the handle and credits declared by this thread.
  */
 int mdd_changelog_store(const struct lu_env *env, struct mdd_device *mdd,
 			struct llog_changelog_rec *rec, struct thandle *th)
@@ -841,6 +846,7 @@ int mdd_changelog_store(const struct lu_env *env, struct mdd_device *mdd,
 	struct obd_device	*obd = mdd2obd_dev(mdd);
 	struct llog_ctxt	*ctxt;
 	struct thandle		*llog_th;
+	ktime_t			 kstart;
 	int			 rc;
 
 	rec->cr_hdr.lrh_len = llog_data_len(sizeof(*rec) +
@@ -860,7 +866,13 @@ int mdd_changelog_store(const struct lu_env *env, struct mdd_device *mdd,
 
 	OBD_FAIL_TIMEOUT(OBD_FAIL_MDS_CHANGELOG_REORDER, cfs_fail_val);
 	/* nested journal transaction */
+	kstart = ktime_get();
 	rc = llog_add(env, ctxt->loc_handle, &rec->cr_hdr, NULL, llog_th);
+	if (rc >= 0) {
+		lprocfs_counter_add(mdd->mdd_cl_stats, MDD_CL_STAT_APPEND,
+				    ktime_us_delta(ktime_get(), kstart));
+		mdd_env_info(env)->mti_cl_recs++;
+	}
 
 	/* time to recover some space ?? */
 	if (likely(!mdd->mdd_changelog_gc ||
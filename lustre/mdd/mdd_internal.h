@@ -108,6 +108,13 @@ struct mdd_changelog {
 						*/
 };
 
+/** ChangeLog append statistics, see mdd_changelog_store() */
+enum {
+	MDD_CL_STAT_APPEND = 0,		/* llog append latency */
+	MDD_CL_STAT_BATCH,		/* records per transaction */
+	MDD_CL_STAT_LAST,
+};
+
 static inline __u64 cl_time(void)
 {
 	struct timespec64 time;
@@ -140,6 +147,7 @@ struct mdd_device {
         struct dt_device_param           mdd_dt_conf;
         struct dt_object                *mdd_orphans; /* PENDING directory */
         struct mdd_changelog             mdd_cl;
+	struct lprocfs_stats		*mdd_cl_stats;
 	unsigned int			 mdd_changelog_gc;
 	time64_t			 mdd_changelog_max_idle_time;
 	unsigned long			 mdd_changelog_max_idle_indexes;
@@ -209,6 +217,8 @@ struct mdd_thread_info {
 	struct lfsck_req_local	  mti_lrl;
 	struct lu_seq_range	  mti_range;
 	union lmv_mds_md	  mti_lmv;
+	/* changelog records added in the current transaction */
+	unsigned int		  mti_cl_recs;
 };
 
 int mdd_la_get(const struct lu_env *env, struct mdd_object *obj,
@@ -726,10 +726,33 @@ int mdd_procfs_init(struct mdd_device *mdd, const char *name)
 		CERROR("Error %d setting up debugfs for %s\n",
 		       rc, name);
 		obd->obd_debugfs_entry = NULL;
+		GOTO(out_kobj, rc);
+	}
 
-		kobject_put(&mdd->mdd_kobj);
+	mdd->mdd_cl_stats = lprocfs_alloc_stats(MDD_CL_STAT_LAST, 0);
+	if (mdd->mdd_cl_stats == NULL)
+		GOTO(out_kobj, rc = -ENOMEM);
+
+	lprocfs_counter_init(mdd->mdd_cl_stats, MDD_CL_STAT_APPEND,
+			     LPROCFS_CNTR_AVGMINMAX | LPROCFS_CNTR_STDDEV,
+			     "append", "usecs");
+	lprocfs_counter_init(mdd->mdd_cl_stats, MDD_CL_STAT_BATCH,
+			     LPROCFS_CNTR_AVGMINMAX,
+			     "batch", "recs");
+	rc = ldebugfs_register_stats(obd->obd_debugfs_entry, "changelog_stats",
+				     mdd->mdd_cl_stats);
+	if (rc) {
+		CERROR("%s: cannot register changelog_stats: rc = %d\n",
+		       name, rc);
+		lprocfs_free_stats(&mdd->mdd_cl_stats);
+		GOTO(out_kobj, rc);
 	}
 
+	RETURN(0);
+
+out_kobj:
+	kobject_put(&mdd->mdd_kobj);
+	wait_for_completion(&mdd->mdd_kobj_unregister);
 	RETURN(rc);
 }
 
@@ -737,4 +760,5 @@ void mdd_procfs_fini(struct mdd_device *mdd)
 {
 	kobject_put(&mdd->mdd_kobj);
 	wait_for_completion(&mdd->mdd_kobj_unregister);
+	lprocfs_free_stats(&mdd->mdd_cl_stats);
 }
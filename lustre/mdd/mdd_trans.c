@@ -70,7 +70,9 @@ struct thandle *mdd_trans_create(const struct lu_env *env,
 int mdd_trans_start(const struct lu_env *env, struct mdd_device *mdd,
                     struct thandle *th)
 {
-        return mdd_child_ops(mdd)->dt_trans_start(env, mdd->mdd_child, th);
+	mdd_env_info(env)->mti_cl_recs = 0;
+
+	return mdd_child_ops(mdd)->dt_trans_start(env, mdd->mdd_child, th);
 }
 
 struct mdd_changelog_gc {
@@ -223,12 +225,20 @@ out:
 int mdd_trans_stop(const struct lu_env *env, struct mdd_device *mdd,
 		   int result, struct thandle *handle)
 {
+	struct mdd_thread_info *info = mdd_env_info(env);
 	int rc;
 
 	handle->th_result = result;
 	rc = mdd_child_ops(mdd)->dt_trans_stop(env, mdd->mdd_child, handle);
 	barrier_exit(mdd->mdd_bottom);
 
+	/* all the records of one transaction are committed together */
+	if (info->mti_cl_recs > 0) {
+		lprocfs_counter_add(mdd->mdd_cl_stats, MDD_CL_STAT_BATCH,
+				    info->mti_cl_recs);
+		info->mti_cl_recs = 0;
+	}
+
 	/* bottom half of changelog garbage-collection mechanism, started
 	 * from mdd_changelog_store(). This is required, as running a
 	 * kthead can't occur during a journal transaction is being filled
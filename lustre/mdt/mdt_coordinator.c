@@ -149,17 +149,19 @@ struct hsm_scan_data {
 	struct hsm_scan_request	*hsd_request;
 };
 
-static int mdt_cdt_waiting_cb(const struct lu_env *env,
-			      struct mdt_device *mdt,
-			      struct llog_handle *llh,
-			      struct llog_agent_req_rec *larr,
-			      struct hsm_scan_data *hsd)
+/*
+ * Add a waiting action to the requests to send, found either by a llog scan
+ * or in the index of waiting requests (see cdt_waiting_iterate()).
+ */
+static int mdt_cdt_waiting_add(struct mdt_device *mdt, u32 archive_id,
+			       u64 flags, struct hsm_action_item *new_hai,
+			       u32 cat_idx, u32 rec_idx, void *data)
 {
 	struct coordinator *cdt = &mdt->mdt_coordinator;
+	struct hsm_scan_data *hsd = data;
 	struct hsm_scan_request *request;
 	struct hsm_action_item *hai;
 	size_t hai_size;
-	u32 archive_id;
 	int i;
 
 	/* Are agents full? */
@@ -175,13 +177,12 @@ static int mdt_cdt_waiting_cb(const struct lu_env *env,
 		 * Restore requests are too important not to schedule at least
 		 * one, everytime we can.
 		 */
-		if (larr->arr_hai.hai_action != HSMA_RESTORE ||
+		if (new_hai->hai_action != HSMA_RESTORE ||
 		    hsd->hsd_one_restore)
 			RETURN(hsd->hsd_housekeeping ? 0 : LLOG_PROC_BREAK);
 	}
 
-	hai_size = cfs_size_round(larr->arr_hai.hai_len);
-	archive_id = larr->arr_archive_id;
+	hai_size = cfs_size_round(new_hai->hai_len);
 
 	/* Can we add this action to one of the existing HALs in hsd. */
 	request = NULL;
@@ -255,8 +256,8 @@ static int mdt_cdt_waiting_cb(const struct lu_env *env,
 
 		hal->hal_version = HAL_VERSION;
 		strlcpy(hal->hal_fsname, hsd->hsd_fsname, MTI_NAME_MAXLEN + 1);
-		hal->hal_archive_id = larr->arr_archive_id;
-		hal->hal_flags = larr->arr_flags;
+		hal->hal_archive_id = archive_id;
+		hal->hal_flags = flags;
 		hal->hal_count = 0;
 		request->hal_used_sz = hal_size(hal);
 		request->hal = hal;
@@ -283,7 +284,7 @@ static int mdt_cdt_waiting_cb(const struct lu_env *env,
 	for (i = 0; i < request->hal->hal_count; i++)
 		hai = hai_next(hai);
 
-	memcpy(hai, &larr->arr_hai, larr->arr_hai.hai_len);
+	memcpy(hai, new_hai, new_hai->hai_len);
 
 	request->hal_used_sz += hai_size;
 	request->hal->hal_count++;
@@ -297,14 +298,28 @@ static int mdt_cdt_waiting_cb(const struct lu_env *env,
 		hsd->hsd_one_restore = true;
 		/* Intentional fallthrough */
 	default:
-		cdt_agent_record_hash_add(cdt, hai->hai_cookie,
-					  llh->lgh_hdr->llh_cat_idx,
-					  larr->arr_hdr.lrh_index);
+		cdt_agent_record_hash_add(cdt, hai->hai_cookie, cat_idx,
+					  rec_idx);
 	}
 
 	RETURN(0);
 }
 
+static int mdt_cdt_waiting_cb(const struct lu_env *env,
+			      struct mdt_device *mdt,
+			      struct llog_handle *llh,
+			      struct llog_agent_req_rec *larr,
+			      struct hsm_scan_data *hsd)
+{
+	/* dispatched from the index of waiting requests */
+	if (mdt->mdt_coordinator.cdt_waiting_valid)
+		return 0;
+
+	return mdt_cdt_waiting_add(mdt, larr->arr_archive_id, larr->arr_flags,
+				   &larr->arr_hai, llh->lgh_hdr->llh_cat_idx,
+				   larr->arr_hdr.lrh_index, hsd);
+}
+
 static int mdt_cdt_started_cb(const struct lu_env *env,
 			      struct mdt_device *mdt,
 			      struct llog_handle *llh,
@@ -452,6 +467,10 @@ static void mdt_hsm_cdt_cleanup(struct mdt_device *mdt)
 	struct mdt_thread_info		*cdt_mti;
 
 	/* start cleaning */
+	down_write(&cdt->cdt_llog_lock);
+	cdt_waiting_invalidate(cdt);
+	up_write(&cdt->cdt_llog_lock);
+
 	down_write(&cdt->cdt_request_lock);
 	list_for_each_entry_safe(car, tmp1, &cdt->cdt_request_list,
 				 car_request_list) {
@@ -645,10 +664,26 @@ static int mdt_coordinator(void *data)
 		hsd.hsd_request_count = 0;
 		hsd.hsd_one_restore = false;
 
-		rc = cdt_llog_process(mti->mti_env, mdt, mdt_coordinator_cb,
-				      &hsd, 0, 0, WRITE);
-		if (rc < 0)
-			goto clean_cb_alloc;
+		/* index the waiting requests (again), so that looking for
+		 * new work doesn't need to scan the llog */
+		if (!cdt->cdt_waiting_valid && hsd.hsd_housekeeping)
+			cdt_waiting_rebuild(mti->mti_env, mdt);
+
+		if (hsd.hsd_housekeeping || !cdt->cdt_waiting_valid) {
+			rc = cdt_llog_process(mti->mti_env, mdt,
+					      mdt_coordinator_cb, &hsd, 0, 0,
+					      WRITE);
+			if (rc < 0)
+				goto clean_cb_alloc;
+		}
+
+		/* walk the index in llog order, like the scan above did */
+		if (cdt->cdt_waiting_valid) {
+			rc = cdt_waiting_iterate(mdt, mdt_cdt_waiting_add,
+						 &hsd);
+			if (rc < 0 && rc != -ENOENT)
+				goto clean_cb_alloc;
+		}
 
 		CDEBUG(D_HSM, "found %d requests to send\n",
 		       hsd.hsd_request_count);
@@ -896,6 +931,9 @@ static int hsm_restore_cb(const struct lu_env *env,
 		rc = llog_write(env, llh, hdr, hdr->lrh_index);
 		if (rc != 0)
 			GOTO(out, rc);
+		cdt_waiting_add(cdt, larr->arr_archive_id, larr->arr_flags,
+				hai, llh->lgh_hdr->llh_cat_idx,
+				hdr->lrh_index);
 	}
 
 	rc = cdt_restore_handle_add(mti, cdt, &hai->hai_fid, &hai->hai_extent);
@@ -971,6 +1009,8 @@ int mdt_hsm_cdt_init(struct mdt_device *mdt)
 	INIT_LIST_HEAD(&cdt->cdt_request_list);
 	INIT_LIST_HEAD(&cdt->cdt_agents);
 	INIT_LIST_HEAD(&cdt->cdt_restore_handle_list);
+	INIT_LIST_HEAD(&cdt->cdt_waiting_queues);
+	spin_lock_init(&cdt->cdt_dispatch_hist.oh_lock);
 
 	cdt->cdt_request_cookie_hash = cfs_hash_create("REQUEST_COOKIE_HASH",
 						       CFS_HASH_BITS_MIN,
@@ -996,9 +1036,21 @@ int mdt_hsm_cdt_init(struct mdt_device *mdt)
 	if (cdt->cdt_agent_record_hash == NULL)
 		GOTO(out_request_cookie_hash, rc = -ENOMEM);
 
+	cdt->cdt_waiting_hash = cfs_hash_create("WAITING_HASH",
+						CFS_HASH_BITS_MIN,
+						CFS_HASH_BITS_MAX,
+						CFS_HASH_BKT_BITS,
+						0 /* extra bytes */,
+						CFS_HASH_MIN_THETA,
+						CFS_HASH_MAX_THETA,
+						&cdt_waiting_hash_ops,
+						CFS_HASH_DEFAULT);
+	if (cdt->cdt_waiting_hash == NULL)
+		GOTO(out_agent_record_hash, rc = -ENOMEM);
+
 	rc = lu_env_init(&cdt->cdt_env, LCT_MD_THREAD);
 	if (rc < 0)
-		GOTO(out_agent_record_hash, rc);
+		GOTO(out_waiting_hash, rc);
 
 	/* for mdt_ucred(), lu_ucred stored in lu_ucred_key */
 	rc = lu_context_init(&cdt->cdt_session, LCT_SERVER_SESSION);
@@ -1032,6 +1084,9 @@ int mdt_hsm_cdt_init(struct mdt_device *mdt)
 
 out_env:
 	lu_env_fini(&cdt->cdt_env);
+out_waiting_hash:
+	cfs_hash_putref(cdt->cdt_waiting_hash);
+	cdt->cdt_waiting_hash = NULL;
 out_agent_record_hash:
 	cfs_hash_putref(cdt->cdt_agent_record_hash);
 	cdt->cdt_agent_record_hash = NULL;
@@ -1056,6 +1111,12 @@ int  mdt_hsm_cdt_fini(struct mdt_device *mdt)
 
 	lu_env_fini(&cdt->cdt_env);
 
+	down_write(&cdt->cdt_llog_lock);
+	cdt_waiting_invalidate(cdt);
+	up_write(&cdt->cdt_llog_lock);
+	cfs_hash_putref(cdt->cdt_waiting_hash);
+	cdt->cdt_waiting_hash = NULL;
+
 	cfs_hash_putref(cdt->cdt_agent_record_hash);
 	cdt->cdt_agent_record_hash = NULL;
 
@@ -1709,6 +1770,10 @@ static int mdt_cancel_all_cb(const struct lu_env *env,
 	hcad = data;
 	if (larr->arr_status == ARS_WAITING ||
 	    larr->arr_status == ARS_STARTED) {
+		if (larr->arr_status == ARS_WAITING)
+			cdt_waiting_del(&hcad->mdt->mdt_coordinator,
+					llh->lgh_hdr->llh_cat_idx,
+					hdr->lrh_index);
 		larr->arr_status = ARS_CANCELED;
 		larr->arr_req_change = ktime_get_real_seconds();
 		rc = llog_write(env, llh, hdr, hdr->lrh_index);
@@ -2504,6 +2569,16 @@ static ssize_t remove_count_show(struct kobject *kobj, struct attribute *attr,
 }
 LUSTRE_RO_ATTR(remove_count);
 
+static ssize_t waiting_count_show(struct kobject *kobj, struct attribute *attr,
+				  char *buf)
+{
+	struct coordinator *cdt = container_of(kobj, struct coordinator,
+					       cdt_hsm_kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", cdt->cdt_waiting_count);
+}
+LUSTRE_RO_ATTR(waiting_count);
+
 static struct lprocfs_vars lprocfs_mdt_hsm_vars[] = {
 	{ .name	=	"agents",
 	  .fops	=	&mdt_hsm_agent_fops			},
@@ -2520,6 +2595,8 @@ static struct lprocfs_vars lprocfs_mdt_hsm_vars[] = {
 	  .fops	=	&mdt_hsm_group_request_mask_fops,	},
 	{ .name	=	"other_request_mask",
 	  .fops	=	&mdt_hsm_other_request_mask_fops,	},
+	{ .name	=	"waiting",
+	  .fops	=	&mdt_hsm_waiting_fops,			},
 	{ 0 }
 };
 
@@ -2533,6 +2610,7 @@ static struct attribute *hsm_attrs[] = {
 	&lustre_attr_archive_count.attr,
 	&lustre_attr_restore_count.attr,
 	&lustre_attr_remove_count.attr,
+	&lustre_attr_waiting_count.attr,
 	NULL,
 };
 
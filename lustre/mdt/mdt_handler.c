@@ -4070,7 +4070,25 @@ out_shrink:
         rc2 = mdt_fix_reply(info);
         if (rc == 0)
                 rc = rc2;
-        return rc;
+
+	/*
+	 * Data-on-MDT prefetch - statahead of the client asks for the file
+	 * data too, return it in reply the same way as for open.
+	 */
+	if (rc == ELDLM_LOCK_REPLACED &&
+	    reqbody->mbo_valid & OBD_MD_DOM_PREFETCH &&
+	    info->mti_attr.ma_valid & MA_LOV &&
+	    info->mti_attr.ma_lmm != NULL &&
+	    mdt_lmm_dom_entry(info->mti_attr.ma_lmm) == LMM_DOM_ONLY) {
+		struct lustre_handle lh;
+
+		ldlm_lock2handle(*lockp, &lh);
+		rc2 = mdt_dom_read_on_open(info, info->mti_mdt, &lh);
+		if (rc2 < 0)
+			CDEBUG(D_INFO, "%s: no DoM data prefetch: rc = %d\n",
+			       mdt_obd_name(info->mti_mdt), rc2);
+	}
+	return rc;
 }
 
 static int mdt_intent_layout(enum ldlm_intent_flags it_opc,
@@ -5192,7 +5210,8 @@ TGT_MDT_HDL(HAS_KEY | HAS_BODY | HAS_REPLY | IS_MUTABLE,
 TGT_MDT_HDL(IS_MUTABLE,		MDS_RMFID,	mdt_rmfid),
 };
 
-static struct tgt_handler mdt_io_ops[] = {
+/* sized for the whole OST slice, it is indexed by the opcode */
+static struct tgt_handler mdt_io_ops[OST_LAST_OPC - OST_FIRST_OPC] = {
 TGT_OST_HDL_HP(HAS_BODY | HAS_REPLY, OST_BRW_READ, tgt_brw_read,
 							mdt_hp_brw),
 TGT_OST_HDL_HP(HAS_BODY | IS_MUTABLE,	 OST_BRW_WRITE,	tgt_brw_write,
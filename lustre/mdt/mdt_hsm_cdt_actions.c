@@ -166,6 +166,410 @@ void cdt_agent_record_hash_del(struct coordinator *cdt, u64 cookie)
 	cfs_hash_del_key(cdt->cdt_agent_record_hash, &cookie);
 }
 
+/*
+ * Index of the waiting requests.
+ *
+ * The waiting records of the agent llog are also kept in memory, queued per
+ * archive id in the order they were added, and hashed by their location in
+ * the llog so they can be removed when their status changes. This lets the
+ * coordinator find the requests to dispatch without scanning the llog.
+ *
+ * The index is protected by cdt_llog_lock, and is only changed by the code
+ * changing the llog, under the write lock. When it cannot be kept in sync
+ * (memory allocation failure, coordinator restart), it is dropped and marked
+ * invalid until the coordinator rebuilds it, see cdt_waiting_rebuild().
+ */
+struct cdt_waiting_queue {
+	struct list_head	 cwq_list;	/* cdt_waiting_queues */
+	struct list_head	 cwq_reqs;	/* cdt_waiting_req, FIFO */
+	/* next request to look at, used by cdt_waiting_iterate() */
+	struct cdt_waiting_req	*cwq_cursor;
+	u32			 cwq_archive_id;
+	unsigned int		 cwq_count;
+};
+
+struct cdt_waiting_req {
+	struct hlist_node	 cwr_hnode;
+	struct list_head	 cwr_list;	/* cwq_reqs */
+	struct cdt_waiting_queue *cwr_queue;
+	u64			 cwr_loc;	/* cat_idx << 32 | rec_idx */
+	u64			 cwr_flags;
+	/* must be last, hai_len bytes */
+	struct hsm_action_item	 cwr_hai;
+};
+
+static inline u64 cdt_waiting_loc(u32 cat_idx, u32 rec_idx)
+{
+	return ((u64)cat_idx << 32) | rec_idx;
+}
+
+static unsigned int
+cdt_waiting_hash(struct cfs_hash *hs, const void *key, unsigned int mask)
+{
+	return cfs_hash_djb2_hash(key, sizeof(u64), mask);
+}
+
+static void *cdt_waiting_object(struct hlist_node *hnode)
+{
+	return hlist_entry(hnode, struct cdt_waiting_req, cwr_hnode);
+}
+
+static void *cdt_waiting_key(struct hlist_node *hnode)
+{
+	struct cdt_waiting_req *cwr = cdt_waiting_object(hnode);
+
+	return &cwr->cwr_loc;
+}
+
+static int cdt_waiting_keycmp(const void *key, struct hlist_node *hnode)
+{
+	const u64 *loc2 = cdt_waiting_key(hnode);
+
+	return *(const u64 *)key == *loc2;
+}
+
+/* entries belong to the index, which is protected by cdt_llog_lock */
+static void cdt_waiting_get(struct cfs_hash *hs, struct hlist_node *hnode)
+{
+}
+
+static void cdt_waiting_put(struct cfs_hash *hs, struct hlist_node *hnode)
+{
+}
+
+struct cfs_hash_ops cdt_waiting_hash_ops = {
+	.hs_hash	= cdt_waiting_hash,
+	.hs_key		= cdt_waiting_key,
+	.hs_keycmp	= cdt_waiting_keycmp,
+	.hs_object	= cdt_waiting_object,
+	.hs_get		= cdt_waiting_get,
+	.hs_put_locked	= cdt_waiting_put,
+};
+
+static void cdt_waiting_free(struct cdt_waiting_req *cwr)
+{
+	OBD_FREE(cwr, offsetof(struct cdt_waiting_req, cwr_hai) +
+		 cwr->cwr_hai.hai_len);
+}
+
+/**
+ * Drop the index of waiting requests, until it is rebuilt.
+ *
+ * \param cdt [IN] coordinator, cdt_llog_lock held for write
+ */
+void cdt_waiting_invalidate(struct coordinator *cdt)
+{
+	struct cdt_waiting_queue *cwq;
+	struct cdt_waiting_queue *tmp;
+	struct cdt_waiting_req *cwr;
+	struct cdt_waiting_req *next;
+
+	if (cdt->cdt_waiting_valid)
+		CDEBUG(D_HSM, "dropping index of %u waiting requests\n",
+		       cdt->cdt_waiting_count);
+
+	cdt->cdt_waiting_valid = false;
+	list_for_each_entry_safe(cwq, tmp, &cdt->cdt_waiting_queues,
+				 cwq_list) {
+		list_for_each_entry_safe(cwr, next, &cwq->cwq_reqs, cwr_list) {
+			cfs_hash_del(cdt->cdt_waiting_hash, &cwr->cwr_loc,
+				     &cwr->cwr_hnode);
+			cdt_waiting_free(cwr);
+		}
+		list_del(&cwq->cwq_list);
+		OBD_FREE_PTR(cwq);
+	}
+	cdt->cdt_waiting_count = 0;
+}
+
+/**
+ * Add a waiting record to the index.
+ *
+ * \param cdt [IN] coordinator, cdt_llog_lock held for write
+ * \param archive_id [IN] archive id of the record
+ * \param flags [IN] flags of the record
+ * \param hai [IN] action item of the record
+ * \param cat_idx [IN] index of the plain llog in the catalog
+ * \param rec_idx [IN] index of the record in the plain llog
+ */
+void cdt_waiting_add(struct coordinator *cdt, u32 archive_id, u64 flags,
+		     const struct hsm_action_item *hai, u32 cat_idx,
+		     u32 rec_idx)
+{
+	struct cdt_waiting_queue *cwq;
+	struct cdt_waiting_req *cwr;
+	int rc;
+
+	if (!cdt->cdt_waiting_valid)
+		return;
+
+	/* location unknown, the record could not be removed */
+	if (cat_idx == 0)
+		GOTO(invalidate, rc = -ENOENT);
+
+	list_for_each_entry(cwq, &cdt->cdt_waiting_queues, cwq_list) {
+		if (cwq->cwq_archive_id == archive_id)
+			goto found;
+	}
+
+	OBD_ALLOC_PTR(cwq);
+	if (cwq == NULL)
+		GOTO(invalidate, rc = -ENOMEM);
+	INIT_LIST_HEAD(&cwq->cwq_reqs);
+	cwq->cwq_archive_id = archive_id;
+	list_add_tail(&cwq->cwq_list, &cdt->cdt_waiting_queues);
+found:
+	OBD_ALLOC(cwr, offsetof(struct cdt_waiting_req, cwr_hai) +
+		  hai->hai_len);
+	if (cwr == NULL)
+		GOTO(invalidate, rc = -ENOMEM);
+
+	cwr->cwr_queue = cwq;
+	cwr->cwr_loc = cdt_waiting_loc(cat_idx, rec_idx);
+	cwr->cwr_flags = flags;
+	memcpy(&cwr->cwr_hai, hai, hai->hai_len);
+
+	rc = cfs_hash_add_unique(cdt->cdt_waiting_hash, &cwr->cwr_loc,
+				 &cwr->cwr_hnode);
+	if (rc) {
+		/* already indexed */
+		cdt_waiting_free(cwr);
+		return;
+	}
+
+	list_add_tail(&cwr->cwr_list, &cwq->cwq_reqs);
+	cwq->cwq_count++;
+	cdt->cdt_waiting_count++;
+	return;
+
+invalidate:
+	CDEBUG(D_HSM, "cannot index request %#llx: rc = %d\n",
+	       hai->hai_cookie, rc);
+	cdt_waiting_invalidate(cdt);
+}
+
+/**
+ * Remove a record from the index, when it is no longer waiting.
+ *
+ * \param cdt [IN] coordinator, cdt_llog_lock held for write
+ * \param cat_idx [IN] index of the plain llog in the catalog
+ * \param rec_idx [IN] index of the record in the plain llog
+ */
+void cdt_waiting_del(struct coordinator *cdt, u32 cat_idx, u32 rec_idx)
+{
+	struct cdt_waiting_req *cwr;
+	u64 loc = cdt_waiting_loc(cat_idx, rec_idx);
+
+	if (!cdt->cdt_waiting_valid)
+		return;
+
+	cwr = cfs_hash_del_key(cdt->cdt_waiting_hash, &loc);
+	if (cwr == NULL)
+		return;
+
+	if (cwr->cwr_queue->cwq_cursor == cwr)
+		cwr->cwr_queue->cwq_cursor = NULL;
+	list_del(&cwr->cwr_list);
+	cwr->cwr_queue->cwq_count--;
+	cdt->cdt_waiting_count--;
+	cdt_waiting_free(cwr);
+}
+
+static int cdt_waiting_rebuild_cb(const struct lu_env *env,
+				  struct llog_handle *llh,
+				  struct llog_rec_hdr *hdr, void *data)
+{
+	struct llog_agent_req_rec *larr = (struct llog_agent_req_rec *)hdr;
+	struct coordinator *cdt = data;
+
+	if (larr->arr_status != ARS_WAITING)
+		return 0;
+
+	cdt_waiting_add(cdt, larr->arr_archive_id, larr->arr_flags,
+			&larr->arr_hai, llh->lgh_hdr->llh_cat_idx,
+			hdr->lrh_index);
+
+	return cdt->cdt_waiting_valid ? 0 : LLOG_PROC_BREAK;
+}
+
+/**
+ * Build the index of waiting requests from the agent llog.
+ *
+ * \param env [IN] environment
+ * \param mdt [IN] MDT device
+ * \retval 0 success, the index is valid
+ * \retval -ve failure
+ */
+int cdt_waiting_rebuild(const struct lu_env *env, struct mdt_device *mdt)
+{
+	struct obd_device *obd = mdt2obd_dev(mdt);
+	struct coordinator *cdt = &mdt->mdt_coordinator;
+	struct llog_ctxt *lctxt;
+	int rc;
+
+	ENTRY;
+
+	lctxt = llog_get_context(obd, LLOG_AGENT_ORIG_CTXT);
+	if (lctxt == NULL)
+		RETURN(-ENOENT);
+	if (lctxt->loc_handle == NULL)
+		GOTO(out, rc = -ENOENT);
+
+	down_write(&cdt->cdt_llog_lock);
+	cdt_waiting_invalidate(cdt);
+	cdt->cdt_waiting_valid = true;
+	rc = llog_cat_process(env, lctxt->loc_handle, cdt_waiting_rebuild_cb,
+			      cdt, 0, 0);
+	if (rc >= 0 && !cdt->cdt_waiting_valid)
+		rc = -ENOMEM;
+	if (rc < 0)
+		cdt_waiting_invalidate(cdt);
+	else
+		rc = 0;
+	CDEBUG(D_HSM, "%s: indexed %u waiting requests: rc = %d\n",
+	       mdt_obd_name(mdt), cdt->cdt_waiting_count, rc);
+	up_write(&cdt->cdt_llog_lock);
+	EXIT;
+out:
+	llog_ctxt_put(lctxt);
+
+	return rc;
+}
+
+/**
+ * Walk the waiting requests in the order they were added.
+ *
+ * Requests for archive ids no copytool serves are skipped. The walk stops
+ * when \a cb returns non-zero.
+ *
+ * \param mdt [IN] MDT device
+ * \param cb [IN] callback called for each request
+ * \param data [IN] callback data
+ * \retval 0 all the requests were walked
+ * \retval -ENOENT the index is not valid
+ * \retval other value returned by \a cb
+ */
+int cdt_waiting_iterate(struct mdt_device *mdt, cdt_waiting_cb_t cb,
+			void *data)
+{
+	struct coordinator *cdt = &mdt->mdt_coordinator;
+	struct cdt_waiting_queue *cwq;
+	struct cdt_waiting_queue *first;
+	struct cdt_waiting_req *cwr;
+	struct obd_uuid uuid;
+	int rc = 0;
+
+	ENTRY;
+
+	down_read(&cdt->cdt_llog_lock);
+	if (!cdt->cdt_waiting_valid)
+		GOTO(out, rc = -ENOENT);
+
+	list_for_each_entry(cwq, &cdt->cdt_waiting_queues, cwq_list) {
+		cwq->cwq_cursor = NULL;
+		if (list_empty(&cwq->cwq_reqs) ||
+		    mdt_hsm_find_best_agent(cdt, cwq->cwq_archive_id, &uuid))
+			continue;
+		cwq->cwq_cursor = list_first_entry(&cwq->cwq_reqs,
+						   struct cdt_waiting_req,
+						   cwr_list);
+	}
+
+	/* cookies grow with time, merge the queues in cookie order */
+	while (rc == 0) {
+		first = NULL;
+		list_for_each_entry(cwq, &cdt->cdt_waiting_queues, cwq_list) {
+			if (cwq->cwq_cursor == NULL)
+				continue;
+			if (first == NULL ||
+			    cwq->cwq_cursor->cwr_hai.hai_cookie <
+			    first->cwq_cursor->cwr_hai.hai_cookie)
+				first = cwq;
+		}
+		if (first == NULL)
+			break;
+
+		cwr = first->cwq_cursor;
+		if (list_is_last(&cwr->cwr_list, &first->cwq_reqs))
+			first->cwq_cursor = NULL;
+		else
+			first->cwq_cursor = list_next_entry(cwr, cwr_list);
+
+		rc = cb(mdt, first->cwq_archive_id, cwr->cwr_flags,
+			&cwr->cwr_hai, cwr->cwr_loc >> 32,
+			cwr->cwr_loc & 0xffffffff, data);
+	}
+	EXIT;
+out:
+	up_read(&cdt->cdt_llog_lock);
+
+	return rc;
+}
+
+static int mdt_hsm_waiting_seq_show(struct seq_file *m, void *v)
+{
+	struct mdt_device *mdt = m->private;
+	struct coordinator *cdt = &mdt->mdt_coordinator;
+	struct obd_histogram *hist = &cdt->cdt_dispatch_hist;
+	struct cdt_waiting_queue *cwq;
+	unsigned long tot, t, cum = 0;
+	int i;
+
+	down_read(&cdt->cdt_llog_lock);
+	seq_printf(m, "index: %s\n", cdt->cdt_waiting_valid ?
+		   "valid" : "invalid");
+	seq_printf(m, "waiting: %u\n", cdt->cdt_waiting_count);
+	list_for_each_entry(cwq, &cdt->cdt_waiting_queues, cwq_list) {
+		if (cwq->cwq_count == 0)
+			continue;
+		seq_printf(m, "- archive_id: %u\n  waiting: %u\n",
+			   cwq->cwq_archive_id, cwq->cwq_count);
+	}
+	up_read(&cdt->cdt_llog_lock);
+
+	/* time between the creation and the start of a request */
+	tot = lprocfs_oh_sum(hist);
+	seq_printf(m, "dispatch_latency:\n");
+	for (i = 0; i < OBD_HIST_MAX && cum < tot; i++) {
+		t = hist->oh_buckets[i];
+		cum += t;
+		if (t == 0)
+			continue;
+		seq_printf(m, "  %lus: { samples: %lu, pct: %u, cum_pct: %u }\n",
+			   1UL << i, t, pct(t, tot),
+			   pct(cum, tot));
+	}
+
+	return 0;
+}
+
+static ssize_t mdt_hsm_waiting_seq_write(struct file *file,
+					 const char __user *buf,
+					 size_t len, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct mdt_device *mdt = m->private;
+
+	lprocfs_oh_clear(&mdt->mdt_coordinator.cdt_dispatch_hist);
+
+	return len;
+}
+
+static int mdt_hsm_waiting_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, mdt_hsm_waiting_seq_show, inode->i_private);
+}
+
+/* Queue depth and dispatch latency of the waiting requests */
+const struct file_operations mdt_hsm_waiting_fops = {
+	.owner		= THIS_MODULE,
+	.open		= mdt_hsm_waiting_open,
+	.read		= seq_read,
+	.write		= mdt_hsm_waiting_seq_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 void dump_llog_agent_req_rec(const char *prefix,
 			     const struct llog_agent_req_rec *larr)
 {
@@ -246,6 +650,29 @@ int cdt_llog_process(const struct lu_env *env, struct mdt_device *mdt,
 	RETURN(rc);
 }
 
+/*
+ * Find the index in the catalog of the plain llog a record was just added
+ * to, as seen by llog_cat_process() callbacks in llh_cat_idx.
+ * Returns 0 if it is unknown.
+ */
+static u32 cdt_llog_cat_idx(struct llog_handle *cathandle,
+			    const struct llog_cookie *cookie)
+{
+	struct llog_handle *llh;
+	u32 cat_idx = 0;
+
+	down_read(&cathandle->lgh_lock);
+	llh = cathandle->u.chd.chd_current_log;
+	if (llh != NULL && llh->lgh_hdr != NULL &&
+	    ostid_id(&llh->lgh_id.lgl_oi) == ostid_id(&cookie->lgc_lgl.lgl_oi) &&
+	    ostid_seq(&llh->lgh_id.lgl_oi) ==
+	    ostid_seq(&cookie->lgc_lgl.lgl_oi))
+		cat_idx = llh->lgh_hdr->llh_cat_idx;
+	up_read(&cathandle->lgh_lock);
+
+	return cat_idx;
+}
+
 /**
  * add an entry in agent llog
  * \param env [IN] environment
@@ -263,6 +690,7 @@ int mdt_agent_record_add(const struct lu_env *env, struct mdt_device *mdt,
 	struct coordinator		*cdt = &mdt->mdt_coordinator;
 	struct llog_ctxt		*lctxt = NULL;
 	struct llog_agent_req_rec	*larr;
+	struct llog_cookie		 cookie = { .lgc_index = 0 };
 	int				 rc;
 	int				 sz;
 	ENTRY;
@@ -294,9 +722,13 @@ int mdt_agent_record_add(const struct lu_env *env, struct mdt_device *mdt,
 	else
 		larr->arr_hai.hai_cookie = cdt->cdt_last_cookie++;
 
-	rc = llog_cat_add(env, lctxt->loc_handle, &larr->arr_hdr, NULL);
+	rc = llog_cat_add(env, lctxt->loc_handle, &larr->arr_hdr, &cookie);
 	if (rc > 0)
 		rc = 0;
+	if (rc == 0)
+		cdt_waiting_add(cdt, archive_id, flags, &larr->arr_hai,
+				cdt_llog_cat_idx(lctxt->loc_handle, &cookie),
+				cookie.lgc_index);
 
 	up_write(&cdt->cdt_llog_lock);
 	llog_ctxt_put(lctxt);
@@ -370,6 +802,20 @@ static int mdt_agent_record_update_cb(const struct lu_env *env,
 			    update->status == ARS_CANCELED)
 				RETURN(0);
 
+			if (larr->arr_status == ARS_WAITING &&
+			    update->status != ARS_WAITING) {
+				struct coordinator *cdt =
+					&ducb->mdt->mdt_coordinator;
+
+				cdt_waiting_del(cdt, llh->lgh_hdr->llh_cat_idx,
+						hdr->lrh_index);
+				if (update->status == ARS_STARTED)
+					lprocfs_oh_tally_log2(
+						&cdt->cdt_dispatch_hist,
+						ducb->change_time -
+						larr->arr_req_create);
+			}
+
 			larr->arr_status = update->status;
 			larr->arr_req_change = ducb->change_time;
 			rc = llog_write(env, llh, hdr, hdr->lrh_index);
@@ -186,6 +186,15 @@ struct coordinator {
 	bool			 cdt_remove_archive_on_last_unlink;
 
 	bool			 cdt_wakeup_coordinator;
+
+	/* Index of the waiting requests, protected by cdt_llog_lock,
+	 * see cdt_waiting_add() */
+	struct cfs_hash		*cdt_waiting_hash;
+	struct list_head	 cdt_waiting_queues;
+	unsigned int		 cdt_waiting_count;
+	bool			 cdt_waiting_valid;
+	/* seconds between the creation and the start of requests */
+	struct obd_histogram	 cdt_dispatch_hist;
 };
 
 /* mdt state flag bits */
@@ -1018,6 +1027,19 @@ void cdt_agent_record_hash_add(struct coordinator *cdt, u64 cookie, u32 cat_idt,
 void cdt_agent_record_hash_lookup(struct coordinator *cdt, u64 cookie,
 				  u32 *cat_idt, u32 *rec_idx);
 void cdt_agent_record_hash_del(struct coordinator *cdt, u64 cookie);
+extern const struct file_operations mdt_hsm_waiting_fops;
+extern struct cfs_hash_ops cdt_waiting_hash_ops;
+typedef int (*cdt_waiting_cb_t)(struct mdt_device *mdt, u32 archive_id,
+				u64 flags, struct hsm_action_item *hai,
+				u32 cat_idx, u32 rec_idx, void *data);
+void cdt_waiting_invalidate(struct coordinator *cdt);
+void cdt_waiting_add(struct coordinator *cdt, u32 archive_id, u64 flags,
+		     const struct hsm_action_item *hai, u32 cat_idx,
+		     u32 rec_idx);
+void cdt_waiting_del(struct coordinator *cdt, u32 cat_idx, u32 rec_idx);
+int cdt_waiting_rebuild(const struct lu_env *env, struct mdt_device *mdt);
+int cdt_waiting_iterate(struct mdt_device *mdt, cdt_waiting_cb_t cb,
+			void *data);
 
 /* mdt/mdt_hsm_cdt_agent.c */
 extern const struct file_operations mdt_hsm_agent_fops;
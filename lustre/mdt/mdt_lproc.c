@@ -897,6 +897,8 @@ static ssize_t dom_read_open_show(struct kobject *kobj,
  *
  * If enabled then Data-on-MDT file data may be read during open and
  * returned back in reply. It works only with mo_dom_lock enabled.
+ * The data of small files is also returned with getattr intents sent
+ * by client statahead, if the client asks for it.
  *
  * \param[in] file	proc file
  * \param[in] buffer	string which represents policy
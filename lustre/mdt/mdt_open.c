@@ -2372,7 +2372,8 @@ int mdt_mfd_close(struct mdt_thread_info *info, struct mdt_file_data *mfd)
 	}
 
 	if (S_ISREG(lu_object_attr(&o->mot_obj)) &&
-	    ma->ma_attr.la_valid & (LA_LSIZE | LA_LBLOCKS)) {
+	    ma->ma_attr.la_valid & (LA_LSIZE | LA_LBLOCKS) &&
+	    !OBD_FAIL_CHECK(OBD_FAIL_LFSCK_LOST_LSOM)) {
 		int rc2;
 
 		rc2 = mdt_lsom_update(info, o, false);
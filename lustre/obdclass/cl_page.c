@@ -47,6 +47,33 @@
 
 static void cl_page_delete0(const struct lu_env *env, struct cl_page *pg);
 
+/* Slices are laid out after struct cl_page, at the offsets set up by
+ * cl_object_page_init() for each layer, see cl_page_slice_add(). */
+#define cl_page_slice_get(page, i)					\
+	((struct cl_page_slice *)((char *)(page) + sizeof(struct cl_page) + \
+				  (page)->cp_layer_offset[i]))
+
+#define cl_page_slice_for_each(page, slice, i)				\
+	for (i = 0; i < (page)->cp_layer_count &&			\
+		    ((slice) = cl_page_slice_get(page, i)) != NULL; i++)
+
+#define cl_page_slice_for_each_reverse(page, slice, i)			\
+	for (i = (page)->cp_layer_count - 1;				\
+	     i >= 0 && ((slice) = cl_page_slice_get(page, i)) != NULL; i--)
+
+/*
+ * The cl_pages of all the objects of one type have the same size, set by the
+ * layers of that type, e.g. vvp, lov and osc for files. A slab cache is
+ * created for each size the first time a page of that size is needed.
+ */
+#define CL_PAGE_KMEM_MAX	16
+
+static DEFINE_MUTEX(cl_page_kmem_mutex);
+static struct kmem_cache *cl_page_kmem_array[CL_PAGE_KMEM_MAX];
+static unsigned short cl_page_kmem_size_array[CL_PAGE_KMEM_MAX];
+/* kmem_cache_create() keeps a pointer to the name on older kernels */
+static char cl_page_kmem_name_array[CL_PAGE_KMEM_MAX][32];
+
 #ifdef LIBCFS_DEBUG
 # define PASSERT(env, page, expr)                                       \
   do {                                                                    \
@@ -133,9 +160,10 @@ cl_page_at_trusted(const struct cl_page *page,
                    const struct lu_device_type *dtype)
 {
 	const struct cl_page_slice *slice;
+	int i;
 	ENTRY;
 
-	list_for_each_entry(slice, &page->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each(page, slice, i) {
 		if (slice->cpl_obj->co_lu.lo_dev->ld_type == dtype)
 			RETURN(slice);
 	}
@@ -146,28 +174,30 @@ static void cl_page_free(const struct lu_env *env, struct cl_page *page,
 			 struct pagevec *pvec)
 {
 	struct cl_object *obj  = page->cp_obj;
-	int pagesize = cl_object_header(obj)->coh_page_bufsize;
+	unsigned short bufsize = cl_object_header(obj)->coh_page_bufsize;
+	struct cl_page_slice *slice;
+	int i;
 
 	PASSERT(env, page, list_empty(&page->cp_batch));
 	PASSERT(env, page, page->cp_owner == NULL);
 	PASSERT(env, page, page->cp_state == CPS_FREEING);
 
 	ENTRY;
-	while (!list_empty(&page->cp_layers)) {
-		struct cl_page_slice *slice;
-
-		slice = list_entry(page->cp_layers.next,
-				   struct cl_page_slice, cpl_linkage);
-		list_del_init(page->cp_layers.next);
+	cl_page_slice_for_each(page, slice, i) {
 		if (unlikely(slice->cpl_ops->cpo_fini != NULL))
 			slice->cpl_ops->cpo_fini(env, slice, pvec);
 	}
+	page->cp_layer_count = 0;
 	cs_page_dec(obj, CS_total);
 	cs_pagestate_dec(obj, page->cp_state);
 	lu_object_ref_del_at(&obj->co_lu, &page->cp_obj_ref, "cl_page", page);
 	cl_object_put(env, obj);
 	lu_ref_fini(&page->cp_reference);
-	OBD_FREE(page, pagesize);
+	if (page->cp_kmem_index >= 0)
+		OBD_SLAB_FREE(page, cl_page_kmem_array[page->cp_kmem_index],
+			      bufsize);
+	else
+		OBD_FREE(page, bufsize);
 	EXIT;
 }
 
@@ -182,6 +212,84 @@ static inline void cl_page_state_set_trust(struct cl_page *page,
         *(enum cl_page_state *)&page->cp_state = state;
 }
 
+/**
+ * Allocates the memory of a cl_page and of its slices, from the slab cache
+ * for the pages of that size.
+ *
+ * The caches are looked up without a lock, there is one per layer stack in
+ * use, i.e. 2 or 3. Falls back to kmalloc if there are too many of them.
+ */
+static struct cl_page *cl_page_kmem_alloc(struct cl_object *o)
+{
+	struct cl_page *page = NULL;
+	unsigned short bufsize = cl_object_header(o)->coh_page_bufsize;
+	int i;
+
+	for (i = 0; i < CL_PAGE_KMEM_MAX; i++) {
+		unsigned short size;
+
+		size = smp_load_acquire(&cl_page_kmem_size_array[i]);
+		if (size == bufsize)
+			goto alloc;
+		if (size == 0)
+			break;
+	}
+	if (i == CL_PAGE_KMEM_MAX)
+		goto fallback;
+
+	mutex_lock(&cl_page_kmem_mutex);
+	for (i = 0; i < CL_PAGE_KMEM_MAX; i++) {
+		if (cl_page_kmem_size_array[i] == bufsize ||
+		    cl_page_kmem_size_array[i] == 0)
+			break;
+	}
+	if (i < CL_PAGE_KMEM_MAX && cl_page_kmem_size_array[i] == 0) {
+		snprintf(cl_page_kmem_name_array[i],
+			 sizeof(cl_page_kmem_name_array[i]),
+			 "cl_page_kmem-%u", bufsize);
+		cl_page_kmem_array[i] =
+			kmem_cache_create(cl_page_kmem_name_array[i], bufsize,
+					  0, 0, NULL);
+		if (cl_page_kmem_array[i] != NULL)
+			smp_store_release(&cl_page_kmem_size_array[i],
+					  bufsize);
+		else
+			i = CL_PAGE_KMEM_MAX;
+	}
+	mutex_unlock(&cl_page_kmem_mutex);
+	if (i == CL_PAGE_KMEM_MAX)
+		goto fallback;
+
+alloc:
+	OBD_SLAB_ALLOC_GFP(page, cl_page_kmem_array[i], bufsize, GFP_NOFS);
+	if (page != NULL)
+		page->cp_kmem_index = i;
+	return page;
+
+fallback:
+	OBD_ALLOC_GFP(page, bufsize, GFP_NOFS);
+	if (page != NULL)
+		page->cp_kmem_index = -1;
+	return page;
+}
+
+/**
+ * Destroys the slab caches of the cl_pages, called at module unload once all
+ * the pages are freed.
+ */
+void cl_page_kmem_fini(void)
+{
+	int i;
+
+	for (i = 0; i < CL_PAGE_KMEM_MAX; i++) {
+		if (cl_page_kmem_size_array[i] == 0)
+			break;
+		kmem_cache_destroy(cl_page_kmem_array[i]);
+		cl_page_kmem_array[i] = NULL;
+		cl_page_kmem_size_array[i] = 0;
+	}
+}
+
 struct cl_page *cl_page_alloc(const struct lu_env *env,
 		struct cl_object *o, pgoff_t ind, struct page *vmpage,
 		enum cl_page_type type)
@@ -190,8 +298,7 @@ struct cl_page *cl_page_alloc(const struct lu_env *env,
 	struct lu_object_header *head;
 
 	ENTRY;
-	OBD_ALLOC_GFP(page, cl_object_header(o)->coh_page_bufsize,
-			GFP_NOFS);
+	page = cl_page_kmem_alloc(o);
 	if (page != NULL) {
 		int result = 0;
 		atomic_set(&page->cp_ref, 1);
@@ -202,7 +309,6 @@ struct cl_page *cl_page_alloc(const struct lu_env *env,
 		page->cp_vmpage = vmpage;
 		cl_page_state_set_trust(page, CPS_CACHED);
 		page->cp_type = type;
-		INIT_LIST_HEAD(&page->cp_layers);
 		INIT_LIST_HEAD(&page->cp_batch);
 		lu_ref_init(&page->cp_reference);
 		head = o->co_lu.lo_header;
@@ -473,6 +579,7 @@ void cl_page_disown0(const struct lu_env *env,
                      struct cl_io *io, struct cl_page *pg)
 {
 	const struct cl_page_slice *slice;
+	int i;
         enum cl_page_state state;
 
         ENTRY;
@@ -488,7 +595,7 @@ void cl_page_disown0(const struct lu_env *env,
          * uppermost layer (llite), responsible for VFS/VM interaction runs
          * last and can release locks safely.
          */
-	list_for_each_entry_reverse(slice, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each_reverse(pg, slice, i) {
 		if (slice->cpl_ops->cpo_disown != NULL)
 			(*slice->cpl_ops->cpo_disown)(env, slice, io);
 	}
@@ -533,6 +640,7 @@ static int cl_page_own0(const struct lu_env *env, struct cl_io *io,
 {
 	int result = 0;
 	const struct cl_page_slice *slice;
+	int i;
 
         PINVRNT(env, pg, !cl_page_is_owned(pg, io));
 
@@ -544,7 +652,7 @@ static int cl_page_own0(const struct lu_env *env, struct cl_io *io,
 		goto out;
 	}
 
-	list_for_each_entry(slice, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each(pg, slice, i) {
 		if (slice->cpl_ops->cpo_own)
 			result = (*slice->cpl_ops->cpo_own)(env, slice,
 							    io, nonblock);
@@ -611,13 +719,14 @@ void cl_page_assume(const struct lu_env *env,
                     struct cl_io *io, struct cl_page *pg)
 {
 	const struct cl_page_slice *slice;
+	int i;
 
 	PINVRNT(env, pg, cl_object_same(pg->cp_obj, io->ci_obj));
 
 	ENTRY;
 	io = cl_io_top(io);
 
-	list_for_each_entry(slice, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each(pg, slice, i) {
 		if (slice->cpl_ops->cpo_assume != NULL)
 			(*slice->cpl_ops->cpo_assume)(env, slice, io);
 	}
@@ -645,6 +754,7 @@ void cl_page_unassume(const struct lu_env *env,
                       struct cl_io *io, struct cl_page *pg)
 {
 	const struct cl_page_slice *slice;
+	int i;
 
         PINVRNT(env, pg, cl_page_is_owned(pg, io));
         PINVRNT(env, pg, cl_page_invariant(pg));
@@ -654,7 +764,7 @@ void cl_page_unassume(const struct lu_env *env,
         cl_page_owner_clear(pg);
         cl_page_state_set(env, pg, CPS_CACHED);
 
-	list_for_each_entry_reverse(slice, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each_reverse(pg, slice, i) {
 		if (slice->cpl_ops->cpo_unassume != NULL)
 			(*slice->cpl_ops->cpo_unassume)(env, slice, io);
 	}
@@ -701,11 +811,12 @@ void cl_page_discard(const struct lu_env *env,
                      struct cl_io *io, struct cl_page *pg)
 {
 	const struct cl_page_slice *slice;
+	int i;
 
 	PINVRNT(env, pg, cl_page_is_owned(pg, io));
 	PINVRNT(env, pg, cl_page_invariant(pg));
 
-	list_for_each_entry(slice, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each(pg, slice, i) {
 		if (slice->cpl_ops->cpo_discard != NULL)
 			(*slice->cpl_ops->cpo_discard)(env, slice, io);
 	}
@@ -720,6 +831,7 @@ EXPORT_SYMBOL(cl_page_discard);
 static void cl_page_delete0(const struct lu_env *env, struct cl_page *pg)
 {
 	const struct cl_page_slice *slice;
+	int i;
 
         ENTRY;
 
@@ -731,7 +843,7 @@ static void cl_page_delete0(const struct lu_env *env, struct cl_page *pg)
         cl_page_owner_clear(pg);
         cl_page_state_set0(env, pg, CPS_FREEING);
 
-	list_for_each_entry_reverse(slice, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each_reverse(pg, slice, i) {
 		if (slice->cpl_ops->cpo_delete != NULL)
 			(*slice->cpl_ops->cpo_delete)(env, slice);
 	}
@@ -784,10 +896,11 @@ EXPORT_SYMBOL(cl_page_delete);
 void cl_page_export(const struct lu_env *env, struct cl_page *pg, int uptodate)
 {
 	const struct cl_page_slice *slice;
+	int i;
 
         PINVRNT(env, pg, cl_page_invariant(pg));
 
-	list_for_each_entry(slice, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each(pg, slice, i) {
 		if (slice->cpl_ops->cpo_export != NULL)
 			(*slice->cpl_ops->cpo_export)(env, slice, uptodate);
 	}
@@ -804,8 +917,7 @@ int cl_page_is_vmlocked(const struct lu_env *env, const struct cl_page *pg)
 	int result;
 
         ENTRY;
-        slice = container_of(pg->cp_layers.next,
-                             const struct cl_page_slice, cpl_linkage);
+	slice = cl_page_slice_get(pg, 0);
         PASSERT(env, pg, slice->cpl_ops->cpo_is_vmlocked != NULL);
         /*
          * Call ->cpo_is_vmlocked() directly instead of going through
@@ -822,10 +934,11 @@ void cl_page_touch(const struct lu_env *env, const struct cl_page *pg,
 		  size_t to)
 {
 	const struct cl_page_slice *slice;
+	int i;
 
 	ENTRY;
 
-	list_for_each_entry(slice, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each(pg, slice, i) {
 		if (slice->cpl_ops->cpo_page_touch != NULL)
 			(*slice->cpl_ops->cpo_page_touch)(env, slice, to);
 	}
@@ -863,6 +976,7 @@ int cl_page_prep(const struct lu_env *env, struct cl_io *io,
                  struct cl_page *pg, enum cl_req_type crt)
 {
 	const struct cl_page_slice *slice;
+	int i;
 	int result = 0;
 
         PINVRNT(env, pg, cl_page_is_owned(pg, io));
@@ -877,7 +991,7 @@ int cl_page_prep(const struct lu_env *env, struct cl_io *io,
 	if (crt >= CRT_NR)
 		return -EINVAL;
 
-	list_for_each_entry(slice, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each(pg, slice, i) {
 		if (slice->cpl_ops->cpo_own)
 			result = (*slice->cpl_ops->io[crt].cpo_prep)(env,
 								     slice,
@@ -917,6 +1031,7 @@ void cl_page_completion(const struct lu_env *env,
                         struct cl_page *pg, enum cl_req_type crt, int ioret)
 {
 	const struct cl_page_slice *slice;
+	int i;
         struct cl_sync_io *anchor = pg->cp_sync_io;
 
         PASSERT(env, pg, crt < CRT_NR);
@@ -928,7 +1043,7 @@ void cl_page_completion(const struct lu_env *env,
 	if (crt >= CRT_NR)
 		return;
 
-	list_for_each_entry_reverse(slice, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each_reverse(pg, slice, i) {
 		if (slice->cpl_ops->io[crt].cpo_completion != NULL)
 			(*slice->cpl_ops->io[crt].cpo_completion)(env, slice,
 								  ioret);
@@ -956,6 +1071,7 @@ int cl_page_make_ready(const struct lu_env *env, struct cl_page *pg,
                        enum cl_req_type crt)
 {
 	const struct cl_page_slice *sli;
+	int i;
 	int result = 0;
 
         PINVRNT(env, pg, crt < CRT_NR);
@@ -964,7 +1080,7 @@ int cl_page_make_ready(const struct lu_env *env, struct cl_page *pg,
 	if (crt >= CRT_NR)
 		RETURN(-EINVAL);
 
-	list_for_each_entry(sli, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each(pg, sli, i) {
 		if (sli->cpl_ops->io[crt].cpo_make_ready != NULL)
 			result = (*sli->cpl_ops->io[crt].cpo_make_ready)(env,
 									 sli);
@@ -994,6 +1110,7 @@ int cl_page_flush(const struct lu_env *env, struct cl_io *io,
 		  struct cl_page *pg)
 {
 	const struct cl_page_slice *slice;
+	int i;
 	int result = 0;
 
 	PINVRNT(env, pg, cl_page_is_owned(pg, io));
@@ -1001,7 +1118,7 @@ int cl_page_flush(const struct lu_env *env, struct cl_io *io,
 
 	ENTRY;
 
-	list_for_each_entry(slice, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each(pg, slice, i) {
 		if (slice->cpl_ops->cpo_flush != NULL)
 			result = (*slice->cpl_ops->cpo_flush)(env, slice, io);
 		if (result != 0)
@@ -1024,11 +1141,12 @@ void cl_page_clip(const struct lu_env *env, struct cl_page *pg,
                   int from, int to)
 {
 	const struct cl_page_slice *slice;
+	int i;
 
         PINVRNT(env, pg, cl_page_invariant(pg));
 
         CL_PAGE_HEADER(D_TRACE, env, pg, "%d %d\n", from, to);
-	list_for_each_entry(slice, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each(pg, slice, i) {
 		if (slice->cpl_ops->cpo_clip != NULL)
 			(*slice->cpl_ops->cpo_clip)(env, slice, from, to);
 	}
@@ -1056,10 +1174,11 @@ void cl_page_print(const struct lu_env *env, void *cookie,
                    lu_printer_t printer, const struct cl_page *pg)
 {
 	const struct cl_page_slice *slice;
+	int i;
 	int result = 0;
 
 	cl_page_header_print(env, cookie, printer, pg);
-	list_for_each_entry(slice, &pg->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each(pg, slice, i) {
 		if (slice->cpl_ops->cpo_print != NULL)
 			result = (*slice->cpl_ops->cpo_print)(env, slice,
 							     cookie, printer);
@@ -1076,9 +1195,10 @@ EXPORT_SYMBOL(cl_page_print);
 int cl_page_cancel(const struct lu_env *env, struct cl_page *page)
 {
 	const struct cl_page_slice *slice;
+	int i;
 	int			    result = 0;
 
-	list_for_each_entry(slice, &page->cp_layers, cpl_linkage) {
+	cl_page_slice_for_each(page, slice, i) {
 		if (slice->cpl_ops->cpo_cancel != NULL)
 			result = (*slice->cpl_ops->cpo_cancel)(env, slice);
 		if (result != 0)
@@ -1119,7 +1239,7 @@ EXPORT_SYMBOL(cl_page_size);
  *
  * This is called by cl_object_operations::coo_page_init() methods to add a
  * per-layer state to the page. New state is added at the end of
- * cl_page::cp_layers list, that is, it is at the bottom of the stack.
+ * cl_page::cp_layer_offset, that is, it is at the bottom of the stack.
  *
  * \see cl_lock_slice_add(), cl_req_slice_add(), cl_io_slice_add()
  */
@@ -1127,8 +1247,13 @@ void cl_page_slice_add(struct cl_page *page, struct cl_page_slice *slice,
 		       struct cl_object *obj, pgoff_t index,
 		       const struct cl_page_operations *ops)
 {
+	unsigned int offset = (char *)slice -
+			      ((char *)page + sizeof(*page));
+
 	ENTRY;
-	list_add_tail(&slice->cpl_linkage, &page->cp_layers);
+	LASSERT(page->cp_layer_count < CP_MAX_LAYER);
+	LASSERT(offset < (1 << sizeof(page->cp_layer_offset[0]) * 8));
+	page->cp_layer_offset[page->cp_layer_count++] = offset;
 	slice->cpl_obj  = obj;
 	slice->cpl_index = index;
 	slice->cpl_ops  = ops;
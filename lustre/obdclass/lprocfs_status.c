@@ -790,6 +790,15 @@ static const char *obd_connect_names[] = {
 	NULL
 };
 
+/* flags2 allocated down from the highest bit, see lustre_idl.h */
+static const struct {
+	__u64		 ocn_flag;
+	const char	*ocn_name;
+} obd_connect_names2_high[] = {
+	{ OBD_CONNECT2_BATCH_BL_AST,	"batch_bl_ast" },
+	{ OBD_CONNECT2_BATCH_GLIMPSE,	"batch_glimpse" },
+};
+
 void obd_connect_seq_flags2str(struct seq_file *m, __u64 flags, __u64 flags2,
 			       const char *sep)
 {
@@ -822,9 +831,19 @@ void obd_connect_seq_flags2str(struct seq_file *m, __u64 flags, __u64 flags2,
 		}
 	}
 
-	if (flags2 & ~(mask - 1)) {
+	flags2 &= ~(mask - 1);
+	for (i = 0; i < ARRAY_SIZE(obd_connect_names2_high); i++) {
+		if (flags2 & obd_connect_names2_high[i].ocn_flag) {
+			seq_printf(m, "%s%s", first ? "" : sep,
+				   obd_connect_names2_high[i].ocn_name);
+			flags2 &= ~obd_connect_names2_high[i].ocn_flag;
+			first = false;
+		}
+	}
+
+	if (flags2) {
 		seq_printf(m, "%sunknown2_%#llx",
-			   first ? "" : sep, flags2 & ~(mask - 1));
+			   first ? "" : sep, flags2);
 		first = false;
 	}
 }
@@ -856,10 +875,20 @@ int obd_connect_flags2str(char *page, int count, __u64 flags, __u64 flags2,
 					ret ? sep : "", obd_connect_names[i]);
 	}
 
-	if (flags2 & ~(mask - 1))
+	flags2 &= ~(mask - 1);
+	for (i = 0; i < ARRAY_SIZE(obd_connect_names2_high); i++) {
+		if (flags2 & obd_connect_names2_high[i].ocn_flag) {
+			ret += snprintf(page + ret, count - ret, "%s%s",
+					ret ? sep : "",
+					obd_connect_names2_high[i].ocn_name);
+			flags2 &= ~obd_connect_names2_high[i].ocn_flag;
+		}
+	}
+
+	if (flags2)
 		ret += snprintf(page + ret, count - ret,
 				"%sunknown2_%#llx",
-				ret ? sep : "", flags2 & ~(mask - 1));
+				ret ? sep : "", flags2);
 
 	return ret;
 }
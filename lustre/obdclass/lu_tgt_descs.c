@@ -298,6 +298,8 @@ void lu_tgt_descs_fini(struct lu_tgt_descs *ltd)
 {
 	int i;
 
+	lu_qos_alias_free(ltd->ltd_qos.lq_alias);
+	ltd->ltd_qos.lq_alias = NULL;
 	CFS_FREE_BITMAP(ltd->ltd_tgt_bitmap);
 	for (i = 0; i < TGT_PTRS; i++) {
 		if (ltd->ltd_tgt_idx[i])
@@ -684,3 +686,194 @@ int ltd_qos_update(struct lu_tgt_descs *ltd, struct lu_tgt_desc *tgt,
 	RETURN(0);
 }
 EXPORT_SYMBOL(ltd_qos_update);
+
+/**
+ * Build an alias table for weighted random selection.
+ *
+ * Vose's variant of Walker's alias method: every slot of the table holds a
+ * target, the probability to keep it and another target (its alias) to use
+ * otherwise. Slots whose target is under the average weight are filled up
+ * by targets over the average. A target is then drawn in constant time with
+ * a probability proportional to its weight, see lu_qos_alias_draw(). If all
+ * the weights are 0, the targets are drawn uniformly.
+ *
+ * \param[in] tgts	target indices
+ * \param[in] weights	target weights
+ * \param[in] count	number of targets
+ *
+ * \retval		alias table, to be freed with lu_qos_alias_free()
+ * \retval		ERR_PTR(negative errno) on error
+ */
+struct lu_qos_alias *lu_qos_alias_build(const __u32 *tgts,
+					const __u64 *weights, __u32 count)
+{
+	struct lu_qos_alias_slot *slots;
+	struct lu_qos_alias *lqa;
+	__u64 max = 0, total = 0;
+	__u32 nsmall = 0, nlarge = 0;
+	__u32 *work;
+	__u64 *prob;
+	__u32 i, s, l;
+	int shift = 0;
+
+	if (count == 0)
+		return ERR_PTR(-EINVAL);
+
+	OBD_ALLOC_LARGE(prob, sizeof(*prob) * count);
+	OBD_ALLOC_LARGE(work, sizeof(*work) * count);
+	if (prob == NULL || work == NULL)
+		GOTO(out, lqa = ERR_PTR(-ENOMEM));
+
+	OBD_ALLOC_LARGE(lqa, offsetof(struct lu_qos_alias, lqa_slots[count]));
+	if (lqa == NULL)
+		GOTO(out, lqa = ERR_PTR(-ENOMEM));
+	lqa->lqa_count = count;
+	slots = lqa->lqa_slots;
+
+	/* keep weight * count * LU_QOS_ALIAS_ONE in 64 bits */
+	for (i = 0; i < count; i++)
+		max = max(max, weights[i]);
+	while ((max >> shift) >= (1ULL << 24))
+		shift++;
+	for (i = 0; i < count; i++)
+		total += weights[i] >> shift;
+
+	/* small targets are stacked from the start of work[], large ones
+	 * from the end */
+	for (i = 0; i < count; i++) {
+		slots[i].las_tgt = tgts[i];
+		slots[i].las_alias = i;
+		if (total == 0)
+			prob[i] = LU_QOS_ALIAS_ONE;
+		else
+			prob[i] = div64_u64((weights[i] >> shift) * count *
+					    LU_QOS_ALIAS_ONE, total);
+		if (prob[i] < LU_QOS_ALIAS_ONE)
+			work[nsmall++] = i;
+		else
+			work[count - ++nlarge] = i;
+	}
+
+	while (nsmall > 0 && nlarge > 0) {
+		s = work[--nsmall];
+		l = work[count - nlarge];
+		slots[s].las_prob = prob[s];
+		slots[s].las_alias = l;
+		prob[l] -= LU_QOS_ALIAS_ONE - prob[s];
+		if (prob[l] < LU_QOS_ALIAS_ONE) {
+			nlarge--;
+			work[nsmall++] = l;
+		}
+	}
+	/* what is left is (up to rounding) exactly average */
+	while (nsmall > 0)
+		slots[work[--nsmall]].las_prob = LU_QOS_ALIAS_ONE;
+	while (nlarge > 0)
+		slots[work[count - nlarge--]].las_prob = LU_QOS_ALIAS_ONE;
+
+out:
+	if (work != NULL)
+		OBD_FREE_LARGE(work, sizeof(*work) * count);
+	if (prob != NULL)
+		OBD_FREE_LARGE(prob, sizeof(*prob) * count);
+	return lqa;
+}
+EXPORT_SYMBOL(lu_qos_alias_build);
+
+void lu_qos_alias_free(struct lu_qos_alias *lqa)
+{
+	if (lqa == NULL)
+		return;
+
+	OBD_FREE_LARGE(lqa, offsetof(struct lu_qos_alias,
+				     lqa_slots[lqa->lqa_count]));
+}
+EXPORT_SYMBOL(lu_qos_alias_free);
+
+/**
+ * Draw a target from an alias table.
+ *
+ * \param[in] lqa	alias table built by lu_qos_alias_build()
+ *
+ * \retval		index of the drawn target
+ */
+__u32 lu_qos_alias_draw(const struct lu_qos_alias *lqa)
+{
+	const struct lu_qos_alias_slot *slot;
+
+	slot = &lqa->lqa_slots[prandom_u32_max(lqa->lqa_count)];
+	if (prandom_u32_max(LU_QOS_ALIAS_ONE) < slot->las_prob)
+		return slot->las_tgt;
+
+	return lqa->lqa_slots[slot->las_alias].las_tgt;
+}
+EXPORT_SYMBOL(lu_qos_alias_draw);
+
+/**
+ * Rebuild the alias table of the usable targets.
+ *
+ * The table is built from the target weights (see lu_tgt_qos_weight_calc())
+ * when the penalties are recalculated, so that the allocation path can draw
+ * targets under a shared lock without walking the whole target list for each
+ * stripe. The penalties added by ltd_qos_update() for each allocation are not
+ * reflected until the next rebuild, which happens on the next statfs update.
+ * If QoS allocation is not possible (targets are balanced, or not enough
+ * usable targets), the table is dropped.
+ *
+ * The caller must hold lq_rw_sem for write.
+ *
+ * \param[in] ltd	lu_tgt_descs
+ *
+ * \retval 0		on success
+ * \retval negative	negated errno on error
+ */
+int ltd_qos_alias_update(struct lu_tgt_descs *ltd)
+{
+	struct lu_qos *qos = &ltd->ltd_qos;
+	struct lu_tgt_desc *tgt;
+	struct lu_qos_alias *lqa = NULL;
+	__u64 *weights = NULL;
+	__u32 *tgts = NULL;
+	__u32 count = 0;
+	int rc;
+
+	ENTRY;
+
+	rc = ltd_qos_penalties_calc(ltd);
+	if (rc)
+		GOTO(out, rc = 0);
+
+	OBD_ALLOC_LARGE(tgts, sizeof(*tgts) * ltd->ltd_tgtnr);
+	OBD_ALLOC_LARGE(weights, sizeof(*weights) * ltd->ltd_tgtnr);
+	if (tgts == NULL || weights == NULL)
+		GOTO(out, rc = -ENOMEM);
+
+	ltd_foreach_tgt(ltd, tgt) {
+		if (!tgt->ltd_active || count >= ltd->ltd_tgtnr)
+			continue;
+
+		lu_tgt_qos_weight_calc(tgt);
+		tgts[count] = tgt->ltd_index;
+		weights[count] = tgt->ltd_qos.ltq_weight;
+		count++;
+	}
+
+	if (count > 0) {
+		lqa = lu_qos_alias_build(tgts, weights, count);
+		if (IS_ERR(lqa)) {
+			rc = PTR_ERR(lqa);
+			lqa = NULL;
+		}
+	}
+	EXIT;
+out:
+	if (weights != NULL)
+		OBD_FREE_LARGE(weights, sizeof(*weights) * ltd->ltd_tgtnr);
+	if (tgts != NULL)
+		OBD_FREE_LARGE(tgts, sizeof(*tgts) * ltd->ltd_tgtnr);
+	lu_qos_alias_free(qos->lq_alias);
+	qos->lq_alias = lqa;
+
+	return rc;
+}
+EXPORT_SYMBOL(ltd_qos_alias_update);
@@ -218,7 +218,8 @@ static inline struct obd_device *emd2obd_dev(struct echo_md_device *d)
 
 static int cl_echo_object_put(struct echo_object *eco);
 static int cl_echo_object_brw(struct echo_object *eco, int rw, u64 offset,
-			      struct page **pages, int npages, int async);
+			      struct page **pages, int npages, int async,
+			      bool noio);
 
 struct echo_thread_info {
 	struct echo_object_conf eti_conf;
@@ -1329,8 +1330,13 @@ static void echo_commit_callback(const struct lu_env *env, struct cl_io *io,
 	}
 }
 
+/*
+ * With \a noio, the cl_pages are set up and freed without any I/O, to measure
+ * the overhead of the client page cache for each page.
+ */
 static int cl_echo_object_brw(struct echo_object *eco, int rw, u64 offset,
-			      struct page **pages, int npages, int async)
+			      struct page **pages, int npages, int async,
+			      bool noio)
 {
 	struct lu_env           *env;
 	struct echo_thread_info *info;
@@ -1400,7 +1406,7 @@ static int cl_echo_object_brw(struct echo_object *eco, int rw, u64 offset,
 		offset += page_size;
 	}
 
-	if (rc == 0) {
+	if (rc == 0 && !noio) {
 		enum cl_req_type typ = rw == READ ? CRT_READ : CRT_WRITE;
 
 		async = async && (typ == CRT_WRITE);
@@ -2538,7 +2544,7 @@ echo_client_page_debug_check(struct page *page, u64 id, u64 offset, u64 count)
 
 static int echo_client_kbrw(struct echo_device *ed, int rw, struct obdo *oa,
 			    struct echo_object *eco, u64 offset,
-			    u64 count, int async)
+			    u64 count, int async, bool noio)
 {
 	size_t npages;
 	struct brw_page *pga;
@@ -2554,7 +2560,7 @@ static int echo_client_kbrw(struct echo_device *ed, int rw, struct obdo *oa,
 	ENTRY;
 	verify = (ostid_id(&oa->o_oi) != ECHO_PERSISTENT_OBJID &&
 		  (oa->o_valid & OBD_MD_FLFLAGS) != 0 &&
-		  (oa->o_flags & OBD_FL_DEBUG_CHECK) != 0);
+		  (oa->o_flags & OBD_FL_DEBUG_CHECK) != 0 && !noio);
 
 	gfp_mask = ((ostid_id(&oa->o_oi) & 2) == 0) ? GFP_KERNEL : GFP_HIGHUSER;
 
@@ -2603,7 +2609,7 @@ static int echo_client_kbrw(struct echo_device *ed, int rw, struct obdo *oa,
 
 	/* brw mode can only be used at client */
 	LASSERT(ed->ed_next != NULL);
-	rc = cl_echo_object_brw(eco, rw, offset, pages, npages, async);
+	rc = cl_echo_object_brw(eco, rw, offset, pages, npages, async, noio);
 
  out:
 	if (rc != 0 || rw != OBD_BRW_READ)
@@ -2762,7 +2768,8 @@ static int echo_client_brw_ioctl(const struct lu_env *env, int rw,
 		/* fall through */
 	case 2:
 		rc = echo_client_kbrw(ed, rw, oa, eco, data->ioc_offset,
-				      data->ioc_count, async);
+				      data->ioc_count, async,
+				      data->ioc_u32_1 & OBD_BRW_IOC_NOIO);
 		break;
 	case 3:
 		rc = echo_client_prep_commit(env, ec->ec_exp, rw, oa, eco,
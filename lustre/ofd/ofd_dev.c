@@ -2093,6 +2093,74 @@ out_unlock:
 	RETURN(rc);
 }
 
+/**
+ * OFD request handler for OST_BATCH_GLIMPSE RPC.
+ *
+ * Grant PR locks on many objects at once and return their LVB. This is
+ * used by the client to prefetch sizes for AGL: the lock is cached by the
+ * client, which can stat() the file then without any RPC, as after an AGL
+ * glimpse enqueue. A lock which would conflict with other ones is not
+ * granted and -EAGAIN is returned for that object, a regular glimpse is
+ * needed then.
+ *
+ * \param[in] tsi	target session environment for this request
+ *
+ * \retval		0 if successful
+ * \retval		negative errno on error
+ */
+static int ofd_batch_glimpse_hdl(struct tgt_session_info *tsi)
+{
+	struct obd_export *exp = tsi->tsi_exp;
+	const struct lu_env *env = tsi->tsi_env;
+	struct ofd_thread_info *info;
+	struct ost_glimpse_rec *reqrec;
+	struct ost_glimpse_rec *reprec;
+	int lvb_len;
+	int size;
+	int count;
+	int i;
+	int rc;
+	ENTRY;
+
+	reqrec = req_capsule_client_get(tsi->tsi_pill, &RMF_OST_GLIMPSE_REC);
+	if (reqrec == NULL)
+		RETURN(err_serious(-EPROTO));
+
+	size = req_capsule_get_size(tsi->tsi_pill, &RMF_OST_GLIMPSE_REC,
+				    RCL_CLIENT);
+	count = size / sizeof(*reqrec);
+	if (count == 0)
+		RETURN(err_serious(-EPROTO));
+
+	req_capsule_set_size(tsi->tsi_pill, &RMF_OST_GLIMPSE_REC, RCL_SERVER,
+			     size);
+	rc = req_capsule_server_pack(tsi->tsi_pill);
+	if (rc)
+		RETURN(err_serious(rc));
+
+	reprec = req_capsule_server_get(tsi->tsi_pill, &RMF_OST_GLIMPSE_REC);
+	info = ofd_info_init(env, exp);
+
+	for (i = 0; i < count; i++, reqrec++, reprec++) {
+		memset(reprec, 0, sizeof(*reprec));
+		reprec->ogr_oi = reqrec->ogr_oi;
+
+		if (!lustre_handle_is_used(&reqrec->ogr_handle)) {
+			reprec->ogr_rc = -EPROTO;
+			continue;
+		}
+
+		ostid_build_res_name(&reqrec->ogr_oi, &info->fti_resid);
+		lvb_len = sizeof(reprec->ogr_lvb);
+		reprec->ogr_rc = tgt_enqueue_nowait(tsi, &info->fti_resid,
+						    &reqrec->ogr_handle,
+						    &reprec->ogr_handle,
+						    &reprec->ogr_lvb, &lvb_len);
+	}
+
+	RETURN(0);
+}
+
 /**
  * OFD request handler for OST_LADVISE RPC.
  *
@@ -2731,6 +2799,8 @@ TGT_OST_HDL_HP(HAS_BODY | HAS_REPLY | IS_MUTABLE,
 TGT_OST_HDL(HAS_BODY | HAS_REPLY,	OST_SYNC,	ofd_sync_hdl),
 TGT_OST_HDL(HAS_REPLY,	OST_QUOTACTL,	ofd_quotactl),
 TGT_OST_HDL(HAS_BODY | HAS_REPLY, OST_LADVISE,	ofd_ladvise_hdl),
+TGT_OST_HDL(0,				OST_BATCH_GLIMPSE,
+						ofd_batch_glimpse_hdl),
 };
 
 static struct tgt_opc_slice ofd_common_slice[] = {
@@ -196,11 +196,12 @@ static int osc_cached_mb_seq_show(struct seq_file *m, void *v)
 
 	seq_printf(m, "used_mb: %ld\n"
 		   "busy_cnt: %ld\n"
-		   "reclaim: %llu\n",
+		   "reclaim: %llu\n"
+		   "contended: %llu\n",
 		   (atomic_long_read(&cli->cl_lru_in_list) +
 		    atomic_long_read(&cli->cl_lru_busy)) >> shift,
 		    atomic_long_read(&cli->cl_lru_busy),
-		   cli->cl_lru_reclaim);
+		   cli->cl_lru_reclaim, osc_lru_contended(cli));
 
 	return 0;
 }
@@ -592,6 +593,39 @@ static ssize_t destroys_in_flight_show(struct kobject *kobj,
 }
 LUSTRE_RO_ATTR(destroys_in_flight);
 
+static ssize_t glimpse_batch_max_show(struct kobject *kobj,
+				      struct attribute *attr,
+				      char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+
+	return sprintf(buf, "%u\n", obd->u.cli.cl_glimpse_batch_max);
+}
+
+static ssize_t glimpse_batch_max_store(struct kobject *kobj,
+				       struct attribute *attr,
+				       const char *buffer,
+				       size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > OSC_GLIMPSE_BATCH_MAX)
+		return -ERANGE;
+
+	obd->u.cli.cl_glimpse_batch_max = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(glimpse_batch_max);
+
 LPROC_SEQ_FOPS_RW_TYPE(osc, obd_max_pages_per_rpc);
 
 LUSTRE_RW_ATTR(short_io_bytes);
@@ -957,6 +991,7 @@ static struct attribute *osc_attrs[] = {
 	&lustre_attr_cur_dirty_bytes.attr,
 	&lustre_attr_cur_lost_grant_bytes.attr,
 	&lustre_attr_destroys_in_flight.attr,
+	&lustre_attr_glimpse_batch_max.attr,
 	&lustre_attr_grant_shrink_interval.attr,
 	&lustre_attr_lockless_truncate.attr,
 	&lustre_attr_max_dirty_mb.attr,
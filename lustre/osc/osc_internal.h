@@ -83,6 +83,14 @@ int osc_ladvise_base(struct obd_export *exp, struct obdo *oa,
 		     struct ladvise_hdr *ladvise_hdr,
 		     obd_enqueue_update_f upcall, void *cookie,
 		     struct ptlrpc_request_set *rqset);
+
+/* largest # of objects whose LVB fit in one OST_BATCH_GLIMPSE reply */
+#define OSC_GLIMPSE_BATCH_MAX	((OST_MAXREPSIZE - 512) / \
+				 sizeof(struct ost_glimpse_rec))
+
+bool osc_glimpse_batch_add(const struct lu_env *env, struct osc_object *osc,
+			   struct ldlm_enqueue_info *einfo);
+void osc_glimpse_batch_flush(const struct lu_env *env, struct client_obd *cli);
 int osc_process_config_base(struct obd_device *obd, struct lustre_cfg *cfg);
 int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 		  struct list_head *ext_list, int cmd);
@@ -993,6 +993,13 @@ static int osc_lock_enqueue(const struct lu_env *env,
 	if (oscl->ols_glimpse || oscl->ols_speculative) {
 		/* Speculative and glimpse locks do not have an anchor */
 		LASSERT(equi(oscl->ols_speculative, anchor == NULL));
+
+		/* Get the AGL lock along with the locks of other objects
+		 * by OST_BATCH_GLIMPSE. */
+		if (oscl->ols_glimpse && oscl->ols_speculative &&
+		    osc_glimpse_batch_add(env, osc, &oscl->ols_einfo))
+			RETURN(0);
+
 		async = true;
 		GOTO(enqueue_base, 0);
 	}
@@ -90,6 +90,8 @@ int osc_object_init(const struct lu_env *env, struct lu_object *obj,
 	atomic_set(&osc->oo_nr_ios, 0);
 	init_waitqueue_head(&osc->oo_io_waitq);
 
+	INIT_LIST_HEAD(&osc->oo_glimpse_item);
+
 	LASSERT(osc->oo_obj_ops != NULL);
 
 	cl_object_page_init(lu2cl(obj), sizeof(struct osc_page));
@@ -116,6 +118,7 @@ void osc_object_free(const struct lu_env *env, struct lu_object *obj)
 	LASSERT(atomic_read(&osc->oo_nr_writes) == 0);
 	LASSERT(list_empty(&osc->oo_ol_list));
 	LASSERT(atomic_read(&osc->oo_nr_ios) == 0);
+	LASSERT(list_empty(&osc->oo_glimpse_item));
 
 	lu_object_fini(obj);
 	OBD_SLAB_FREE_PTR(osc, osc_object_kmem);
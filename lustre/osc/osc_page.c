@@ -282,6 +282,7 @@ int osc_page_init(const struct lu_env *env, struct cl_object *obj,
 	opg->ops_to   = PAGE_SIZE;
 
 	INIT_LIST_HEAD(&opg->ops_lru);
+	opg->ops_lru_cpt = -1;
 
 	result = osc_prep_async_page(osc, opg, page->cp_vmpage,
 				     cl_offset(obj, index));
@@ -360,6 +361,145 @@ void osc_page_submit(const struct lu_env *env, struct osc_page *opg,
 
 static DECLARE_WAIT_QUEUE_HEAD(osc_lru_waitq);
 
+/* RPCs worth of pages staged on a per-CPT LRU before they are migrated */
+#define OSC_LRU_BATCH_RPCS	8
+
+/*
+ * Pages are added to the LRU of the CPU partition of the I/O thread, and
+ * moved to client_obd::cl_lru_list once there are that many of them, or
+ * when the LRU is shrunk. Pages on the per-CPT lists are the most recently
+ * used ones, so they are appended to the tail of cl_lru_list.
+ *
+ * Pages are added one extent at a time, which is often a full RPC, so the
+ * threshold is several RPCs deep for the per-CPT lists to batch anything.
+ * All the per-CPT lists together stay below a quarter of the cache.
+ */
+static inline long osc_lru_batch(struct client_obd *cli)
+{
+	long batch = OSC_LRU_BATCH_RPCS * cli->cl_max_pages_per_rpc;
+	long limit = cli->cl_cache->ccc_lru_max /
+		     (4 * cfs_cpt_number(cfs_cpt_table));
+
+	return max(min(batch, limit), 1L);
+}
+
+/* Take an LRU lock, and count how often it is contended */
+static inline void osc_lru_lock(spinlock_t *lock, __u64 *contended)
+{
+	if (!spin_trylock(lock)) {
+		spin_lock(lock);
+		(*contended)++;
+	}
+}
+
+int osc_lru_cpts_init(struct client_obd *cli)
+{
+	struct osc_lru_cpt *olc;
+	int i;
+
+	cli->cl_lru_cpts = cfs_percpt_alloc(cfs_cpt_table, sizeof(*olc));
+	if (cli->cl_lru_cpts == NULL)
+		return -ENOMEM;
+
+	cfs_percpt_for_each(olc, i, cli->cl_lru_cpts) {
+		spin_lock_init(&olc->olc_lock);
+		INIT_LIST_HEAD(&olc->olc_list);
+	}
+
+	return 0;
+}
+
+void osc_lru_cpts_fini(struct client_obd *cli)
+{
+	if (cli->cl_lru_cpts == NULL)
+		return;
+
+	cfs_percpt_free(cli->cl_lru_cpts);
+	cli->cl_lru_cpts = NULL;
+}
+
+__u64 osc_lru_contended(struct client_obd *cli)
+{
+	struct osc_lru_cpt *olc;
+	__u64 contended = cli->cl_lru_contended;
+	int i;
+
+	if (cli->cl_lru_cpts != NULL) {
+		cfs_percpt_for_each(olc, i, cli->cl_lru_cpts)
+			contended += olc->olc_contended;
+	}
+
+	return contended;
+}
+EXPORT_SYMBOL(osc_lru_contended);
+
+/* Move the pages of a per-CPT list to cl_lru_list, with olc_lock held */
+static void osc_lru_migrate(struct client_obd *cli, struct osc_lru_cpt *olc)
+{
+	struct osc_page *opg;
+
+	osc_lru_lock(&cli->cl_lru_list_lock, &cli->cl_lru_contended);
+	list_for_each_entry(opg, &olc->olc_list, ops_lru)
+		opg->ops_lru_cpt = -1;
+	list_splice_tail_init(&olc->olc_list, &cli->cl_lru_list);
+	olc->olc_count = 0;
+	spin_unlock(&cli->cl_lru_list_lock);
+}
+
+/* Move the pages of all the per-CPT lists to cl_lru_list, before shrinking */
+static void osc_lru_migrate_all(struct client_obd *cli)
+{
+	struct osc_lru_cpt *olc;
+	int i;
+
+	cfs_percpt_for_each(olc, i, cli->cl_lru_cpts) {
+		if (list_empty(&olc->olc_list))
+			continue;
+
+		osc_lru_lock(&olc->olc_lock, &olc->olc_contended);
+		if (!list_empty(&olc->olc_list))
+			osc_lru_migrate(cli, olc);
+		spin_unlock(&olc->olc_lock);
+	}
+}
+
+/**
+ * Lock the LRU list the page is on, or was last on. The page may be moved
+ * to cl_lru_list until the lock of its list is taken, see osc_lru_migrate().
+ *
+ * \retval the CPU partition of that list, -1 for cl_lru_list
+ */
+static int osc_lru_page_lock(struct client_obd *cli, struct osc_page *opg)
+{
+	struct osc_lru_cpt *olc;
+	int cpt;
+
+	while (1) {
+		cpt = READ_ONCE(opg->ops_lru_cpt);
+		if (cpt < 0) {
+			osc_lru_lock(&cli->cl_lru_list_lock,
+				     &cli->cl_lru_contended);
+			if (likely(opg->ops_lru_cpt == cpt))
+				return cpt;
+			spin_unlock(&cli->cl_lru_list_lock);
+		} else {
+			olc = cli->cl_lru_cpts[cpt];
+			osc_lru_lock(&olc->olc_lock, &olc->olc_contended);
+			if (likely(opg->ops_lru_cpt == cpt))
+				return cpt;
+			spin_unlock(&olc->olc_lock);
+		}
+	}
+}
+
+static void osc_lru_page_unlock(struct client_obd *cli, int cpt)
+{
+	if (cpt < 0)
+		spin_unlock(&cli->cl_lru_list_lock);
+	else
+		spin_unlock(&cli->cl_lru_cpts[cpt]->olc_lock);
+}
+
 /**
  * LRU pages are freed in batch mode. OSC should at least free this
  * number of pages to avoid running out of LRU slots.
@@ -441,10 +581,15 @@ int lru_queue_work(const struct lu_env *env, void *data)
 
 void osc_lru_add_batch(struct client_obd *cli, struct list_head *plist)
 {
-	struct list_head lru = LIST_HEAD_INIT(lru);
+	struct osc_lru_cpt *olc;
 	struct osc_async_page *oap;
 	long npages = 0;
+	int cpt;
+
+	cpt = cfs_cpt_current(cfs_cpt_table, 1);
+	olc = cli->cl_lru_cpts[cpt];
 
+	osc_lru_lock(&olc->olc_lock, &olc->olc_contended);
 	list_for_each_entry(oap, plist, oap_pending_item) {
 		struct osc_page *opg = oap2osc_page(oap);
 
@@ -453,26 +598,33 @@ void osc_lru_add_batch(struct client_obd *cli, struct list_head *plist)
 
 		++npages;
 		LASSERT(list_empty(&opg->ops_lru));
-		list_add(&opg->ops_lru, &lru);
+		opg->ops_lru_cpt = cpt;
+		list_add_tail(&opg->ops_lru, &olc->olc_list);
 	}
 
 	if (npages > 0) {
-		spin_lock(&cli->cl_lru_list_lock);
-		list_splice_tail(&lru, &cli->cl_lru_list);
+		olc->olc_count += npages;
 		atomic_long_sub(npages, &cli->cl_lru_busy);
 		atomic_long_add(npages, &cli->cl_lru_in_list);
-		cli->cl_lru_last_used = ktime_get_real_seconds();
-		spin_unlock(&cli->cl_lru_list_lock);
+		if (olc->olc_count >= osc_lru_batch(cli))
+			osc_lru_migrate(cli, olc);
+	}
+	spin_unlock(&olc->olc_lock);
 
+	if (npages > 0) {
+		cli->cl_lru_last_used = ktime_get_real_seconds();
 		if (waitqueue_active(&osc_lru_waitq))
 			(void)ptlrpcd_queue_work(cli->cl_lru_work);
 	}
 }
 
+/* Called with the lock of the list the page is on */
 static void __osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 {
 	LASSERT(atomic_long_read(&cli->cl_lru_in_list) > 0);
 	list_del_init(&opg->ops_lru);
+	if (opg->ops_lru_cpt >= 0)
+		cli->cl_lru_cpts[opg->ops_lru_cpt]->olc_count--;
 	atomic_long_dec(&cli->cl_lru_in_list);
 }
 
@@ -483,14 +635,15 @@ static void __osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 static void osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 {
 	if (opg->ops_in_lru) {
-		spin_lock(&cli->cl_lru_list_lock);
+		int cpt = osc_lru_page_lock(cli, opg);
+
 		if (!list_empty(&opg->ops_lru)) {
 			__osc_lru_del(cli, opg);
 		} else {
 			LASSERT(atomic_long_read(&cli->cl_lru_busy) > 0);
 			atomic_long_dec(&cli->cl_lru_busy);
 		}
-		spin_unlock(&cli->cl_lru_list_lock);
+		osc_lru_page_unlock(cli, cpt);
 
 		atomic_long_inc(cli->cl_lru_left);
 		/* this is a great place to release more LRU pages if
@@ -514,14 +667,16 @@ static void osc_lru_use(struct client_obd *cli, struct osc_page *opg)
 	/* If page is being transferred for the first time,
 	 * ops_lru should be empty */
 	if (opg->ops_in_lru) {
+		int cpt;
+
 		if (list_empty(&opg->ops_lru))
 			return;
-		spin_lock(&cli->cl_lru_list_lock);
+		cpt = osc_lru_page_lock(cli, opg);
 		if (!list_empty(&opg->ops_lru)) {
 			__osc_lru_del(cli, opg);
 			atomic_long_inc(&cli->cl_lru_busy);
 		}
-		spin_unlock(&cli->cl_lru_list_lock);
+		osc_lru_page_unlock(cli, cpt);
 	}
 }
 
@@ -605,7 +760,10 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 	pvec = (struct cl_page **)osc_env_info(env)->oti_pvec;
 	io = osc_env_thread_io(env);
 
-	spin_lock(&cli->cl_lru_list_lock);
+	/* the pages on the per-CPT lists can be shrunk as well */
+	osc_lru_migrate_all(cli);
+
+	osc_lru_lock(&cli->cl_lru_list_lock, &cli->cl_lru_contended);
 	if (force)
 		cli->cl_lru_reclaim++;
 	maxscan = min(target << 1, atomic_long_read(&cli->cl_lru_in_list));
@@ -648,7 +806,8 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 			io->ci_ignore_layout = 1;
 			rc = cl_io_init(env, io, CIT_MISC, clobj);
 
-			spin_lock(&cli->cl_lru_list_lock);
+			osc_lru_lock(&cli->cl_lru_list_lock,
+				     &cli->cl_lru_contended);
 
 			if (rc != 0)
 				break;
@@ -683,7 +842,8 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 			discard_pagevec(env, io, pvec, index);
 			index = 0;
 
-			spin_lock(&cli->cl_lru_list_lock);
+			osc_lru_lock(&cli->cl_lru_list_lock,
+				     &cli->cl_lru_contended);
 		}
 
 		if (++count >= target)
@@ -719,6 +879,7 @@ static long osc_lru_reclaim(struct client_obd *cli, unsigned long npages)
 	struct cl_client_cache *cache = cli->cl_cache;
 	int max_scans;
 	__u16 refcheck;
+	bool reclaimed = false;
 	long rc = 0;
 	ENTRY;
 
@@ -747,7 +908,9 @@ static long osc_lru_reclaim(struct client_obd *cli, unsigned long npages)
 		atomic_long_read(&cli->cl_lru_busy), npages);
 
 	/* Reclaim LRU slots from other client_obd as it can't free enough
-	 * from its own. This should rarely happen. */
+	 * from its own. This should rarely happen. Once enough slots are
+	 * freed, the other OSCs over their share are shrunk by their own
+	 * LRU work in parallel, rather than one by one by this thread. */
 	spin_lock(&cache->ccc_lru_lock);
 	LASSERT(!list_empty(&cache->ccc_lru));
 
@@ -765,16 +928,22 @@ static long osc_lru_reclaim(struct client_obd *cli, unsigned long npages)
 			atomic_long_read(&cli->cl_lru_busy));
 
 		list_move_tail(&cli->cl_lru_osc, &cache->ccc_lru);
-		if (osc_cache_too_much(cli) > 0) {
-			spin_unlock(&cache->ccc_lru_lock);
+		if (osc_cache_too_much(cli) <= 0)
+			continue;
 
-			rc = osc_lru_shrink(env, cli, npages, true);
-			spin_lock(&cache->ccc_lru_lock);
-			if (rc >= npages)
-				break;
-			if (rc > 0)
-				npages -= rc;
+		if (reclaimed) {
+			(void)ptlrpcd_queue_work(cli->cl_lru_work);
+			continue;
 		}
+
+		spin_unlock(&cache->ccc_lru_lock);
+
+		rc = osc_lru_shrink(env, cli, npages, true);
+		spin_lock(&cache->ccc_lru_lock);
+		if (rc >= npages)
+			reclaimed = true;
+		else if (rc > 0)
+			npages -= rc;
 	}
 	spin_unlock(&cache->ccc_lru_lock);
 
@@ -80,6 +80,11 @@ struct osc_ladvise_args {
 	void			*la_cookie;
 };
 
+struct osc_glimpse_batch_args {
+	/* objects glimpsed, in the order of the records */
+	struct list_head	 gba_list;
+};
+
 static void osc_release_ppga(struct brw_page **ppga, size_t count);
 static int brw_interpret(const struct lu_env *env, struct ptlrpc_request *req,
 			 void *data, int rc);
@@ -2690,6 +2695,238 @@ int osc_match_base(const struct lu_env *env, struct obd_export *exp,
 	RETURN(rc);
 }
 
+/**
+ * Finish the lock requested for \a osc by OST_BATCH_GLIMPSE, with the record
+ * returned by the OST or an error. The granted lock is cached like the one
+ * of an AGL glimpse enqueue, see osc_lock_upcall_speculative().
+ */
+static void osc_glimpse_batch_fini(const struct lu_env *env,
+				   struct osc_object *osc,
+				   struct ost_glimpse_rec *rec, int rc)
+{
+	struct lustre_handle *lockh = &osc->oo_glimpse_lockh;
+	struct ldlm_lock *dlmlock;
+
+	if (rc == 0)
+		rc = rec->ogr_rc;
+	rc = ldlm_cli_enqueue_batch_fini(osc_export(osc), lockh, LCK_PR,
+					 rc == 0 ? &rec->ogr_handle : NULL,
+					 rc == 0 ? &rec->ogr_lvb : NULL,
+					 rc == 0 ? sizeof(rec->ogr_lvb) : 0, rc);
+	if (rc == 0) {
+		dlmlock = ldlm_handle2lock(lockh);
+		LASSERT(dlmlock != NULL);
+
+		lock_res_and_lock(dlmlock);
+		LASSERT(ldlm_is_granted(dlmlock));
+		osc_lock_lvb_update(env, osc, dlmlock, NULL);
+		unlock_res_and_lock(dlmlock);
+		LDLM_LOCK_PUT(dlmlock);
+
+		ldlm_lock_decref(lockh, LCK_PR);
+	}
+	lockh->cookie = 0;
+}
+
+static int osc_glimpse_batch_interpret(const struct lu_env *env,
+				       struct ptlrpc_request *req,
+				       void *args, int rc)
+{
+	struct osc_glimpse_batch_args *gba = args;
+	struct client_obd *cli = &req->rq_import->imp_obd->u.cli;
+	struct ost_glimpse_rec *rec = NULL;
+	struct osc_object *osc;
+	struct osc_object *tmp;
+	unsigned int count = 0;
+	ENTRY;
+
+	if (rc == 0) {
+		rec = req_capsule_server_get(&req->rq_pill,
+					     &RMF_OST_GLIMPSE_REC);
+		if (rec != NULL)
+			count = req_capsule_get_size(&req->rq_pill,
+						     &RMF_OST_GLIMPSE_REC,
+						     RCL_SERVER) / sizeof(*rec);
+	}
+
+	list_for_each_entry_safe(osc, tmp, &gba->gba_list, oo_glimpse_item) {
+		if (count > 0 &&
+		    memcmp(&rec->ogr_oi, &osc->oo_oinfo->loi_oi,
+			   sizeof(rec->ogr_oi)) == 0)
+			osc_glimpse_batch_fini(env, osc, rec, 0);
+		else
+			osc_glimpse_batch_fini(env, osc, NULL,
+					       rc ? rc : -EPROTO);
+		if (count > 0) {
+			rec++;
+			count--;
+		}
+
+		spin_lock(&cli->cl_glimpse_batch_lock);
+		list_del_init(&osc->oo_glimpse_item);
+		spin_unlock(&cli->cl_glimpse_batch_lock);
+		cl_object_put(env, osc2cl(osc));
+	}
+
+	RETURN(0);
+}
+
+static int osc_glimpse_batch_send(struct client_obd *cli,
+				  struct list_head *list, unsigned int count)
+{
+	struct osc_glimpse_batch_args *gba;
+	struct ptlrpc_request *req;
+	struct ost_glimpse_rec *rec;
+	struct osc_object *osc;
+	int size = count * sizeof(*rec);
+	int rc;
+	ENTRY;
+
+	req = ptlrpc_request_alloc(cli->cl_import, &RQF_OST_BATCH_GLIMPSE);
+	if (req == NULL)
+		RETURN(-ENOMEM);
+
+	req_capsule_set_size(&req->rq_pill, &RMF_OST_GLIMPSE_REC, RCL_CLIENT,
+			     size);
+	rc = ptlrpc_request_pack(req, LUSTRE_OST_VERSION, OST_BATCH_GLIMPSE);
+	if (rc) {
+		ptlrpc_request_free(req);
+		RETURN(rc);
+	}
+	ptlrpc_at_set_req_timeout(req);
+	/* AGL is only a hint, don't wait for recovery nor resend */
+	req->rq_no_delay = req->rq_no_resend = 1;
+
+	rec = req_capsule_client_get(&req->rq_pill, &RMF_OST_GLIMPSE_REC);
+	list_for_each_entry(osc, list, oo_glimpse_item) {
+		memset(rec, 0, sizeof(*rec));
+		rec->ogr_oi = osc->oo_oinfo->loi_oi;
+		rec->ogr_handle = osc->oo_glimpse_lockh;
+		rec++;
+	}
+
+	req_capsule_set_size(&req->rq_pill, &RMF_OST_GLIMPSE_REC, RCL_SERVER,
+			     size);
+	ptlrpc_request_set_replen(req);
+
+	req->rq_interpret_reply = osc_glimpse_batch_interpret;
+	gba = ptlrpc_req_async_args(gba, req);
+	INIT_LIST_HEAD(&gba->gba_list);
+	list_splice_init(list, &gba->gba_list);
+
+	ptlrpcd_add_req(req);
+	RETURN(0);
+}
+
+/**
+ * Send all the glimpses queued by osc_glimpse_batch_add(), by RPCs of at
+ * most client_obd::cl_glimpse_batch_max objects. Glimpses which cannot be
+ * sent are dropped, like AGL errors are ignored by osc_lock_enqueue().
+ */
+void osc_glimpse_batch_flush(const struct lu_env *env, struct client_obd *cli)
+{
+	struct osc_object *osc;
+	struct osc_object *tmp;
+	unsigned int max;
+	unsigned int count;
+	LIST_HEAD(list);
+	int rc;
+
+	while (1) {
+		spin_lock(&cli->cl_glimpse_batch_lock);
+		max = cli->cl_glimpse_batch_max ?: OSC_GLIMPSE_BATCH_DEFAULT;
+		for (count = 0; count < max &&
+		     !list_empty(&cli->cl_glimpse_batch_list); count++)
+			list_move_tail(cli->cl_glimpse_batch_list.next, &list);
+		cli->cl_glimpse_batch_count -= count;
+		spin_unlock(&cli->cl_glimpse_batch_lock);
+
+		if (count == 0)
+			break;
+
+		rc = osc_glimpse_batch_send(cli, &list, count);
+		if (rc == 0)
+			continue;
+
+		CDEBUG(D_DLMTRACE, "%s: drop %u batched glimpses: rc = %d\n",
+		       cli_name(cli), count, rc);
+		list_for_each_entry_safe(osc, tmp, &list, oo_glimpse_item) {
+			osc_glimpse_batch_fini(env, osc, NULL, rc);
+			spin_lock(&cli->cl_glimpse_batch_lock);
+			list_del_init(&osc->oo_glimpse_item);
+			spin_unlock(&cli->cl_glimpse_batch_lock);
+			cl_object_put(env, osc2cl(osc));
+		}
+	}
+}
+
+/**
+ * Queue a speculative glimpse of \a osc to be sent with others in one
+ * OST_BATCH_GLIMPSE RPC, instead of one glimpse enqueue per object.
+ *
+ * The PR lock of \a einfo on the whole object is created now, and is
+ * granted by the OST along with the locks of the other objects.
+ *
+ * \retval true	if the glimpse was queued
+ * \retval false	if a regular glimpse enqueue should be done
+ */
+bool osc_glimpse_batch_add(const struct lu_env *env, struct osc_object *osc,
+			   struct ldlm_enqueue_info *einfo)
+{
+	struct osc_thread_info *info = osc_env_info(env);
+	struct obd_export *exp = osc_export(osc);
+	struct client_obd *cli = &exp->exp_obd->u.cli;
+	struct ldlm_enqueue_info batch_einfo = *einfo;
+	struct lustre_handle lockh;
+	bool queued = false;
+	bool full;
+
+	if (!exp_connect_batch_glimpse(exp) || cli->cl_glimpse_batch_max == 0)
+		return false;
+
+	/* a cached lock gives the size without any RPC */
+	ostid_build_res_name(&osc->oo_oinfo->loi_oi, &info->oti_resname);
+	info->oti_policy.l_extent.start = 0;
+	info->oti_policy.l_extent.end = OBD_OBJECT_EOF;
+	if (ldlm_lock_match(exp->exp_obd->obd_namespace,
+			    LDLM_FL_BLOCK_GRANTED | LDLM_FL_LVB_READY |
+			    LDLM_FL_TEST_LOCK, &info->oti_resname,
+			    LDLM_EXTENT, &info->oti_policy, LCK_PR | LCK_PW,
+			    &lockh, 0))
+		return false;
+
+	/* see osc_lock_enqueue(), there is no osc_lock for AGL */
+	batch_einfo.ei_mode = LCK_PR;
+	batch_einfo.ei_cbdata = NULL;
+	if (ldlm_cli_enqueue_batch(exp, &batch_einfo, &info->oti_resname,
+				   &info->oti_policy, sizeof(struct ost_lvb),
+				   LVB_T_OST, &lockh))
+		return false;
+
+	spin_lock(&cli->cl_glimpse_batch_lock);
+	if (list_empty(&osc->oo_glimpse_item)) {
+		/* released when the reply is received */
+		cl_object_get(osc2cl(osc));
+		osc->oo_glimpse_lockh = lockh;
+		list_add_tail(&osc->oo_glimpse_item,
+			      &cli->cl_glimpse_batch_list);
+		cli->cl_glimpse_batch_count++;
+		queued = true;
+	}
+	full = cli->cl_glimpse_batch_count >= cli->cl_glimpse_batch_max;
+	spin_unlock(&cli->cl_glimpse_batch_lock);
+
+	/* the object is already queued by another thread */
+	if (!queued)
+		ldlm_cli_enqueue_batch_fini(exp, &lockh, LCK_PR, NULL, NULL, 0,
+					    -EALREADY);
+
+	if (full)
+		osc_glimpse_batch_flush(env, cli);
+
+	return true;
+}
+
 static int osc_statfs_interpret(const struct lu_env *env,
 				struct ptlrpc_request *req, void *args, int rc)
 {
@@ -2911,6 +3148,11 @@ int osc_set_info_async(const struct lu_env *env, struct obd_export *exp,
                 RETURN(0);
         }
 
+	if (KEY_IS(KEY_GLIMPSE_BATCH_FLUSH)) {
+		osc_glimpse_batch_flush(env, &obd->u.cli);
+		RETURN(0);
+	}
+
 	if (KEY_IS(KEY_CACHE_LRU_SHRINK)) {
 		struct client_obd *cli = &obd->u.cli;
 		long nr = atomic_long_read(&cli->cl_lru_in_list) >> 1;
@@ -3207,6 +3449,10 @@ int osc_setup_common(struct obd_device *obd, struct lustre_cfg *lcfg)
 		GOTO(out_ptlrpcd_work, rc = PTR_ERR(handler));
 	cli->cl_lru_work = handler;
 
+	rc = osc_lru_cpts_init(cli);
+	if (rc)
+		GOTO(out_ptlrpcd_work, rc);
+
 	rc = osc_quota_setup(obd);
 	if (rc)
 		GOTO(out_ptlrpcd_work, rc);
@@ -3225,6 +3471,7 @@ out_ptlrpcd_work:
 		ptlrpcd_destroy_work(cli->cl_lru_work);
 		cli->cl_lru_work = NULL;
 	}
+	osc_lru_cpts_fini(cli);
 	client_obd_cleanup(obd);
 out_ptlrpcd:
 	ptlrpcd_decref();
@@ -3341,6 +3588,7 @@ int osc_cleanup_common(struct obd_device *obd)
 	/* free memory of osc quota cache */
 	osc_quota_cleanup(obd);
 
+	osc_lru_cpts_fini(cli);
 	rc = client_obd_cleanup(obd);
 
 	ptlrpcd_decref();
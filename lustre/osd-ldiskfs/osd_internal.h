@@ -320,6 +320,11 @@ struct osd_device {
 	 * exceeds the osd_device::od_full_scrub_threshold_rate,
 	 * then trigger OI scrub to scan the whole device. */
 	__u64			 od_full_scrub_threshold_rate;
+	/* How many threads verify the OI mappings during the OI scrub
+	 * that is not driven by the LFSCK, the OI scrub included. */
+	unsigned int		 od_scrub_threads;
+	/* How many groups of inode table the OI scrub reads ahead. */
+	unsigned int		 od_scrub_ra_groups;
 
 	/* a list of orphaned agent inodes, protected with od_osfs_lock */
 	struct list_head	 od_orphan_list;
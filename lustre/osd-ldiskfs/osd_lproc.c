@@ -528,6 +528,84 @@ static ssize_t full_scrub_threshold_rate_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(full_scrub_threshold_rate);
 
+static ssize_t scrub_threads_show(struct kobject *kobj, struct attribute *attr,
+				  char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *dev = osd_dt_dev(dt);
+
+	LASSERT(dev);
+	if (unlikely(!dev->od_mnt))
+		return -EINPROGRESS;
+
+	return sprintf(buf, "%u\n", dev->od_scrub_threads);
+}
+
+static ssize_t scrub_threads_store(struct kobject *kobj,
+				   struct attribute *attr,
+				   const char *buffer, size_t count)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *dev = osd_dt_dev(dt);
+	unsigned int val;
+	int rc;
+
+	LASSERT(dev);
+	if (unlikely(!dev->od_mnt))
+		return -EINPROGRESS;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val < 1 || val > OSD_SCRUB_THREADS_MAX)
+		return -EINVAL;
+
+	/* Take effect when the OI scrub is started next time. */
+	dev->od_scrub_threads = val;
+	return count;
+}
+LUSTRE_RW_ATTR(scrub_threads);
+
+static ssize_t scrub_readahead_show(struct kobject *kobj,
+				    struct attribute *attr, char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *dev = osd_dt_dev(dt);
+
+	LASSERT(dev);
+	if (unlikely(!dev->od_mnt))
+		return -EINPROGRESS;
+
+	return sprintf(buf, "%u (groups)\n", dev->od_scrub_ra_groups);
+}
+
+static ssize_t scrub_readahead_store(struct kobject *kobj,
+				     struct attribute *attr,
+				     const char *buffer, size_t count)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osd_device *dev = osd_dt_dev(dt);
+	unsigned int val;
+	int rc;
+
+	LASSERT(dev);
+	if (unlikely(!dev->od_mnt))
+		return -EINPROGRESS;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	dev->od_scrub_ra_groups = val;
+	return count;
+}
+LUSTRE_RW_ATTR(scrub_readahead);
+
 static int ldiskfs_osd_oi_scrub_seq_show(struct seq_file *m, void *data)
 {
 	struct osd_device *dev = osd_dt_dev((struct dt_device *)m->private);
@@ -709,6 +787,8 @@ static struct attribute *ldiskfs_attrs[] = {
 	&lustre_attr_pdo.attr,
 	&lustre_attr_full_scrub_ratio.attr,
 	&lustre_attr_full_scrub_threshold_rate.attr,
+	&lustre_attr_scrub_threads.attr,
+	&lustre_attr_scrub_readahead.attr,
 	NULL,
 };
 
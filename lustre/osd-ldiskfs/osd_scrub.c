@@ -878,6 +878,321 @@ osd_scrub_wakeup(struct lustre_scrub *scrub, struct osd_otable_it *it)
 	return !scrub->os_waiting;
 }
 
+/* parallel OI mappings verification */
+
+/**
+ * Verify the OI mapping for \a oic without holding os_rwsem.
+ *
+ * Most of the OI mappings are consistent, the workers only look them up
+ * and count them. The others are handed back to the OI scrub thread that
+ * repairs them via osd_scrub_check_update() as before.
+ *
+ * \retval	true if the OI mapping is consistent
+ * \retval	false if it needs to be handled by osd_scrub_check_update()
+ */
+static bool osd_scrub_verify(struct osd_thread_info *info,
+			     struct osd_device *dev,
+			     struct osd_idmap_cache *oic, int val)
+{
+	struct lustre_scrub *scrub = &dev->od_scrub.os_scrub;
+	struct osd_inode_id *lid2 = &info->oti_id;
+	int rc;
+
+	if (oic->oic_lid.oii_ino >= scrub->os_file.sf_pos_latest_start) {
+		rc = osd_oi_lookup(info, dev, &oic->oic_fid, lid2,
+			val == SCRUB_NEXT_OSTOBJ ? OI_KNOWN_ON_OST : 0);
+		if (rc != 0 || !osd_id_eq(&oic->oic_lid, lid2))
+			return false;
+	}
+
+	down_write(&scrub->os_rwsem);
+	scrub->os_new_checked++;
+	up_write(&scrub->os_rwsem);
+
+	return true;
+}
+
+static int osd_scrub_worker(void *args)
+{
+	struct osd_device *dev = args;
+	struct osd_scrub *oscrub = &dev->od_scrub;
+	struct lustre_scrub *scrub = &oscrub->os_scrub;
+	struct ptlrpc_thread *thread = &scrub->os_thread;
+	struct osd_scrub_req *req = NULL;
+	struct l_wait_info lwi = { 0 };
+	struct lu_env env;
+	bool consistent;
+	bool wakeup;
+	int rc;
+
+	rc = lu_env_init(&env, LCT_LOCAL | LCT_DT_THREAD);
+	if (rc != 0) {
+		CDEBUG(D_LFSCK, "%s: OI scrub worker fail to init env: "
+		       "rc = %d\n", osd_scrub2name(scrub), rc);
+		GOTO(noenv, rc);
+	}
+
+	while (1) {
+		if (req == NULL) {
+			OBD_ALLOC_PTR(req);
+			if (req == NULL)
+				GOTO(out, rc = -ENOMEM);
+		}
+
+		l_wait_event(thread->t_ctl_waitq,
+			     oscrub->os_req_count > 0 || oscrub->os_workers_stop,
+			     &lwi);
+
+		spin_lock(&oscrub->os_req_lock);
+		if (oscrub->os_req_count == 0) {
+			spin_unlock(&oscrub->os_req_lock);
+			if (oscrub->os_workers_stop)
+				break;
+			continue;
+		}
+
+		/* The OI scrub thread may wait for the room to queue more. */
+		wakeup = oscrub->os_req_count == OSD_SCRUB_REQ_QUEUE_SIZE;
+		*req = oscrub->os_reqs[oscrub->os_req_head];
+		oscrub->os_req_head = (oscrub->os_req_head + 1) &
+				      OSD_SCRUB_REQ_QUEUE_MASK;
+		oscrub->os_req_count--;
+		oscrub->os_req_inflight++;
+		spin_unlock(&oscrub->os_req_lock);
+		if (wakeup)
+			wake_up_all(&thread->t_ctl_waitq);
+
+		consistent = osd_scrub_verify(osd_oti_get(&env), dev,
+					      &req->osr_oic, req->osr_val);
+
+		spin_lock(&oscrub->os_req_lock);
+		if (!consistent) {
+			list_add_tail(&req->osr_list, &oscrub->os_req_repair);
+			req = NULL;
+		}
+		oscrub->os_req_inflight--;
+		/* The OI scrub thread may wait for all to be verified. */
+		wakeup = oscrub->os_req_count == 0 &&
+			 oscrub->os_req_inflight == 0;
+		spin_unlock(&oscrub->os_req_lock);
+		if (wakeup)
+			wake_up_all(&thread->t_ctl_waitq);
+	}
+
+	GOTO(out, rc = 0);
+
+out:
+	if (req != NULL)
+		OBD_FREE_PTR(req);
+	lu_env_fini(&env);
+
+noenv:
+	/* The OI scrub thread takes os_req_lock after the last worker
+	 * exits, so the wakeup is done before it goes ahead. */
+	spin_lock(&oscrub->os_req_lock);
+	atomic_dec(&oscrub->os_workers_running);
+	wake_up_all(&thread->t_ctl_waitq);
+	spin_unlock(&oscrub->os_req_lock);
+
+	return rc;
+}
+
+/**
+ * Hand the OI mapping check for \a oic over to the workers.
+ *
+ * Only the objects found by the inode table iteration during the full
+ * OI scrub that is not driven by the otable-based iteration are handed
+ * over, with the FID that only needs the OI mapping to be looked up.
+ * The OI mappings for the objects before os_pos_current may be still in
+ * verifying, the LFSCK should not see such objects.
+ *
+ * \retval	true if the workers will check the OI mapping
+ */
+static bool osd_scrub_dispatch(struct osd_device *dev,
+			       struct osd_idmap_cache *oic, int val)
+{
+	struct osd_scrub *oscrub = &dev->od_scrub;
+	struct lustre_scrub *scrub = &oscrub->os_scrub;
+	struct ptlrpc_thread *thread = &scrub->os_thread;
+	struct osd_scrub_req *req;
+	struct l_wait_info lwi = { 0 };
+	bool wakeup;
+
+	if (oscrub->os_reqs == NULL || scrub->os_in_prior ||
+	    scrub->os_partial_scan || dev->od_otable_it != NULL ||
+	    (val != 0 && val != SCRUB_NEXT_OSTOBJ) ||
+	    fid_is_igif(&oic->oic_fid))
+		return false;
+
+	l_wait_event(thread->t_ctl_waitq,
+		     oscrub->os_req_count < OSD_SCRUB_REQ_QUEUE_SIZE ||
+		     atomic_read(&oscrub->os_workers_running) == 0,
+		     &lwi);
+
+	spin_lock(&oscrub->os_req_lock);
+	if (unlikely(atomic_read(&oscrub->os_workers_running) == 0)) {
+		spin_unlock(&oscrub->os_req_lock);
+		return false;
+	}
+
+	req = &oscrub->os_reqs[(oscrub->os_req_head + oscrub->os_req_count) &
+			       OSD_SCRUB_REQ_QUEUE_MASK];
+	req->osr_oic = *oic;
+	req->osr_val = val;
+	/* Some worker may be idle. */
+	wakeup = oscrub->os_req_count < oscrub->os_workers;
+	oscrub->os_req_count++;
+	spin_unlock(&oscrub->os_req_lock);
+	if (wakeup)
+		wake_up_all(&thread->t_ctl_waitq);
+
+	return true;
+}
+
+/**
+ * Repair the OI mappings that the workers found inconsistent.
+ *
+ * With \a drain, wait for the workers to verify all the queued OI
+ * mappings firstly, so that all the objects before os_pos_current have
+ * been processed when it is recorded as the checkpoint position.
+ *
+ * It is called by the OI scrub thread when no prior item is in handling.
+ */
+static int osd_scrub_repair(struct osd_thread_info *info,
+			    struct osd_device *dev, bool drain)
+{
+	struct osd_scrub *oscrub = &dev->od_scrub;
+	struct ptlrpc_thread *thread = &oscrub->os_scrub.os_thread;
+	struct osd_scrub_req *req;
+	struct l_wait_info lwi = { 0 };
+	int rc = 0;
+	int rc1;
+
+	if (drain) {
+		l_wait_event(thread->t_ctl_waitq,
+			     (oscrub->os_req_count == 0 &&
+			      oscrub->os_req_inflight == 0) ||
+			     atomic_read(&oscrub->os_workers_running) == 0,
+			     &lwi);
+
+		/* All the workers have exited, check the left ones. */
+		spin_lock(&oscrub->os_req_lock);
+		while (oscrub->os_req_count > 0) {
+			req = &oscrub->os_reqs[oscrub->os_req_head];
+			oscrub->os_req_head = (oscrub->os_req_head + 1) &
+					      OSD_SCRUB_REQ_QUEUE_MASK;
+			oscrub->os_req_count--;
+			spin_unlock(&oscrub->os_req_lock);
+
+			rc1 = osd_scrub_check_update(info, dev, &req->osr_oic,
+						     req->osr_val);
+			if (rc1 != 0 && rc == 0)
+				rc = rc1;
+			spin_lock(&oscrub->os_req_lock);
+		}
+		spin_unlock(&oscrub->os_req_lock);
+	}
+
+	spin_lock(&oscrub->os_req_lock);
+	while (!list_empty(&oscrub->os_req_repair)) {
+		req = list_entry(oscrub->os_req_repair.next,
+				 struct osd_scrub_req, osr_list);
+		list_del(&req->osr_list);
+		spin_unlock(&oscrub->os_req_lock);
+
+		rc1 = osd_scrub_check_update(info, dev, &req->osr_oic,
+					     req->osr_val);
+		OBD_FREE_PTR(req);
+		if (rc1 != 0 && rc == 0)
+			rc = rc1;
+		spin_lock(&oscrub->os_req_lock);
+	}
+	spin_unlock(&oscrub->os_req_lock);
+
+	return rc;
+}
+
+static void osd_scrub_start_workers(struct osd_device *dev)
+{
+	struct osd_scrub *oscrub = &dev->od_scrub;
+	struct task_struct *task;
+	unsigned int threads = dev->od_scrub_threads;
+	int i;
+
+	if (threads <= 1)
+		return;
+
+	if (threads > OSD_SCRUB_THREADS_MAX)
+		threads = OSD_SCRUB_THREADS_MAX;
+
+	OBD_ALLOC_LARGE(oscrub->os_reqs, sizeof(struct osd_scrub_req) *
+					 OSD_SCRUB_REQ_QUEUE_SIZE);
+	if (oscrub->os_reqs == NULL)
+		return;
+
+	oscrub->os_req_head = 0;
+	oscrub->os_req_count = 0;
+	oscrub->os_req_inflight = 0;
+	oscrub->os_workers = 0;
+	oscrub->os_workers_stop = 0;
+	for (i = 1; i < threads; i++) {
+		atomic_inc(&oscrub->os_workers_running);
+		task = kthread_run(osd_scrub_worker, dev, "OI_scrub_%02d", i);
+		if (IS_ERR(task)) {
+			atomic_dec(&oscrub->os_workers_running);
+			CDEBUG(D_LFSCK, "%s: cannot start OI scrub worker %d: "
+			       "rc = %ld\n", osd_scrub2name(&oscrub->os_scrub),
+			       i, PTR_ERR(task));
+			break;
+		}
+
+		oscrub->os_workers++;
+	}
+
+	if (oscrub->os_workers == 0) {
+		OBD_FREE_LARGE(oscrub->os_reqs, sizeof(struct osd_scrub_req) *
+						OSD_SCRUB_REQ_QUEUE_SIZE);
+		oscrub->os_reqs = NULL;
+	}
+
+	CDEBUG(D_LFSCK, "%s: OI scrub started %d workers\n",
+	       osd_scrub2name(&oscrub->os_scrub), oscrub->os_workers);
+}
+
+static void osd_scrub_stop_workers(struct osd_device *dev)
+{
+	struct osd_scrub *oscrub = &dev->od_scrub;
+	struct ptlrpc_thread *thread = &oscrub->os_scrub.os_thread;
+	struct osd_scrub_req *req;
+	struct l_wait_info lwi = { 0 };
+
+	if (oscrub->os_reqs == NULL)
+		return;
+
+	spin_lock(&oscrub->os_req_lock);
+	oscrub->os_workers_stop = 1;
+	spin_unlock(&oscrub->os_req_lock);
+	wake_up_all(&thread->t_ctl_waitq);
+	l_wait_event(thread->t_ctl_waitq,
+		     atomic_read(&oscrub->os_workers_running) == 0,
+		     &lwi);
+
+	/* Only non-empty if the OI scrub crashed. */
+	spin_lock(&oscrub->os_req_lock);
+	while (!list_empty(&oscrub->os_req_repair)) {
+		req = list_entry(oscrub->os_req_repair.next,
+				 struct osd_scrub_req, osr_list);
+		list_del(&req->osr_list);
+		OBD_FREE_PTR(req);
+	}
+	oscrub->os_req_count = 0;
+	spin_unlock(&oscrub->os_req_lock);
+
+	OBD_FREE_LARGE(oscrub->os_reqs, sizeof(struct osd_scrub_req) *
+					OSD_SCRUB_REQ_QUEUE_SIZE);
+	oscrub->os_reqs = NULL;
+}
+
 static int osd_scrub_exec(struct osd_thread_info *info, struct osd_device *dev,
 			  struct osd_iit_param *param,
 			  struct osd_idmap_cache *oic, bool *noslot, int rc)
@@ -888,6 +1203,8 @@ static int osd_scrub_exec(struct osd_thread_info *info, struct osd_device *dev,
 	struct ptlrpc_thread *thread = &scrub->os_thread;
 	struct osd_otable_it *it = dev->od_otable_it;
 	struct osd_otable_cache *ooc = it ? &it->ooi_cache : NULL;
+	bool checkpoint = true;
+	int rc1;
 
 	switch (rc) {
 	case SCRUB_NEXT_NOSCRUB:
@@ -900,18 +1217,34 @@ static int osd_scrub_exec(struct osd_thread_info *info, struct osd_device *dev,
 		goto wait;
 	}
 
-	rc = osd_scrub_check_update(info, dev, oic, rc);
-	if (rc != 0) {
-		scrub->os_in_prior = 0;
-		return rc;
+	if (!osd_scrub_dispatch(dev, oic, rc)) {
+		rc = osd_scrub_check_update(info, dev, oic, rc);
+		if (rc != 0) {
+			scrub->os_in_prior = 0;
+			return rc;
+		}
 	}
 
-	rc = scrub_checkpoint(info->oti_env, scrub);
-	if (rc) {
-		CDEBUG(D_LFSCK, "%s: fail to checkpoint, pos = %llu: "
-		       "rc = %d\n", osd_scrub2name(scrub),
-		       scrub->os_pos_current, rc);
-		/* Continue, as long as the scrub itself can go ahead. */
+	if (dev->od_scrub.os_reqs != NULL) {
+		/* Not checkpoint until the prior item has been handled. */
+		checkpoint = !scrub->os_in_prior &&
+			ktime_get_seconds() >= scrub->os_time_next_checkpoint;
+		if (!scrub->os_in_prior) {
+			rc = osd_scrub_repair(info, dev, checkpoint);
+			if (rc != 0)
+				return rc;
+		}
+	}
+
+	if (checkpoint) {
+		rc = scrub_checkpoint(info->oti_env, scrub);
+		if (rc) {
+			CDEBUG(D_LFSCK, "%s: fail to checkpoint, pos = %llu: "
+			       "rc = %d\n", osd_scrub2name(scrub),
+			       scrub->os_pos_current, rc);
+			/* Continue, as long as the scrub itself can go
+			 * ahead. */
+		}
 	}
 
 	if (scrub->os_in_prior) {
@@ -920,6 +1253,15 @@ static int osd_scrub_exec(struct osd_thread_info *info, struct osd_device *dev,
 	}
 
 wait:
+	/* The otable-based iteration may go up to os_pos_current as soon as
+	 * the OI scrub moves on, so the OI mappings queued for the workers
+	 * before it was attached must have been verified by then. */
+	if (it != NULL && dev->od_scrub.os_reqs != NULL) {
+		rc1 = osd_scrub_repair(info, dev, true);
+		if (rc1 != 0)
+			return rc1;
+	}
+
 	if (it != NULL && it->ooi_waiting && ooc != NULL &&
 	    ooc->ooc_pos_preload < scrub->os_pos_current) {
 		spin_lock(&scrub->os_lock);
@@ -1031,6 +1373,60 @@ static void osd_scrub_join(const struct lu_env *env, struct osd_device *dev,
 	EXIT;
 }
 
+static inline ldiskfs_fsblk_t
+osd_scrub_itable_block(struct super_block *sb, struct ldiskfs_group_desc *desc)
+{
+	ldiskfs_fsblk_t blk = le32_to_cpu(desc->bg_inode_table_lo);
+
+	if (LDISKFS_DESC_SIZE(sb) >= LDISKFS_MIN_DESC_SIZE_64BIT)
+		blk |= (ldiskfs_fsblk_t)le32_to_cpu(desc->bg_inode_table_hi)
+			<< 32;
+	return blk;
+}
+
+/**
+ * Read ahead the used part of the inode tables for the groups after the
+ * current one asynchronously, then the inodes will be in cache when the
+ * OI scrub reaches them, instead of being read by osd_iget() one by one.
+ */
+static void osd_scrub_readahead(struct osd_device *dev,
+				struct osd_iit_param *param)
+{
+	struct super_block *sb = param->sb;
+	struct ldiskfs_group_desc *desc;
+	ldiskfs_group_t last;
+	ldiskfs_fsblk_t blk;
+	__u32 used;
+	__u32 nr;
+	__u32 i;
+
+	if (dev->od_scrub_ra_groups == 0)
+		return;
+
+	last = param->bg + dev->od_scrub_ra_groups;
+	if (last >= LDISKFS_SB(sb)->s_groups_count)
+		last = LDISKFS_SB(sb)->s_groups_count - 1;
+
+	if (param->ra_bg <= param->bg)
+		param->ra_bg = param->bg + 1;
+
+	for (; param->ra_bg <= last; param->ra_bg++) {
+		desc = ldiskfs_get_group_desc(sb, param->ra_bg, NULL);
+		if (!desc)
+			break;
+
+		if (desc->bg_flags & cpu_to_le16(LDISKFS_BG_INODE_UNINIT))
+			continue;
+
+		used = LDISKFS_INODES_PER_GROUP(sb) -
+		       ldiskfs_itable_unused_count(sb, desc);
+		nr = DIV_ROUND_UP(used, LDISKFS_INODES_PER_BLOCK(sb));
+		blk = osd_scrub_itable_block(sb, desc);
+		for (i = 0; i < nr; i++)
+			sb_breadahead(sb, blk + i);
+	}
+}
+
 static int osd_inode_iteration(struct osd_thread_info *info,
 			       struct osd_device *dev, __u32 max, bool preload)
 {
@@ -1168,6 +1564,9 @@ full:
 		struct ldiskfs_group_desc *desc;
 		bool next_group = false;
 
+		if (!preload)
+			osd_scrub_readahead(dev, param);
+
 		desc = ldiskfs_get_group_desc(param->sb, param->bg, NULL);
 		if (!desc)
 			RETURN(-EIO);
@@ -1305,6 +1704,7 @@ static int osd_scrub_main(void *args)
 	       osd_scrub2name(scrub), scrub->os_start_flags,
 	       scrub->os_pos_current);
 
+	osd_scrub_start_workers(dev);
 	rc = osd_inode_iteration(osd_oti_get(&env), dev, ~0U, false);
 	if (unlikely(rc == SCRUB_IT_CRASH)) {
 		spin_lock(&scrub->os_lock);
@@ -1313,6 +1713,16 @@ static int osd_scrub_main(void *args)
 		GOTO(out, rc = -EINVAL);
 	}
 
+	if (dev->od_scrub.os_reqs != NULL) {
+		int rc1;
+
+		/* Finish the OI mappings queued for the workers, then the
+		 * position recorded by osd_scrub_post() is still valid. */
+		rc1 = osd_scrub_repair(osd_oti_get(&env), dev, true);
+		if (rc1 != 0 && rc >= 0)
+			rc = rc1;
+	}
+
 	GOTO(post, rc);
 
 post:
@@ -1321,6 +1731,7 @@ post:
 	       osd_scrub2name(scrub), scrub->os_pos_current, rc);
 
 out:
+	osd_scrub_stop_workers(dev);
 	while (!list_empty(&scrub->os_inconsistent_items)) {
 		struct osd_inconsistent_item *oii;
 
@@ -2596,6 +3007,9 @@ int osd_scrub_setup(const struct lu_env *env, struct osd_device *dev)
 	init_rwsem(&scrub->os_rwsem);
 	spin_lock_init(&scrub->os_lock);
 	INIT_LIST_HEAD(&scrub->os_inconsistent_items);
+	spin_lock_init(&dev->od_scrub.os_req_lock);
+	INIT_LIST_HEAD(&dev->od_scrub.os_req_repair);
+	atomic_set(&dev->od_scrub.os_workers_running, 0);
 	scrub->os_name = osd_name(dev);
 
 	push_ctxt(&saved, ctxt);
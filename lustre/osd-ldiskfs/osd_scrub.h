@@ -46,11 +46,28 @@ struct osd_iit_param {
 	struct super_block *sb;
 	struct buffer_head *bitmap;
 	ldiskfs_group_t bg;
+	/* The first group whose inode table has not been read ahead. */
+	ldiskfs_group_t ra_bg;
 	__u32 gbase;
 	__u32 offset;
 	__u32 start;
 };
 
+/* How many groups of inode table the OI scrub reads ahead by default. */
+#define OSD_SCRUB_RA_GROUPS_DEFAULT	4
+/* The max # of threads verifying OI mappings, the OI scrub included. */
+#define OSD_SCRUB_THREADS_MAX		16
+/* The size of the queue of OI mappings to be verified by the workers. */
+#define OSD_SCRUB_REQ_QUEUE_SIZE	256
+#define OSD_SCRUB_REQ_QUEUE_MASK	(OSD_SCRUB_REQ_QUEUE_SIZE - 1)
+
+struct osd_scrub_req {
+	/* Link into osd_scrub::os_req_repair. */
+	struct list_head	osr_list;
+	struct osd_idmap_cache	osr_oic;
+	int			osr_val;
+};
+
 struct osd_scrub {
 	struct lustre_scrub	os_scrub;
 	struct lvfs_run_ctxt    os_ctxt;
@@ -69,6 +86,22 @@ struct osd_scrub {
 
 	__u64			os_bad_oimap_count;
 	time64_t		os_bad_oimap_time;
+
+	/* The OI mappings to be verified by the workers, a ring buffer of
+	 * OSD_SCRUB_REQ_QUEUE_SIZE items, protected by os_req_lock. */
+	struct osd_scrub_req   *os_reqs;
+	spinlock_t		os_req_lock;
+	unsigned int		os_req_head;
+	unsigned int		os_req_count;
+	/* # of OI mappings being verified by the workers. */
+	unsigned int		os_req_inflight;
+	/* The OI mappings found inconsistent by the workers, to be repaired
+	 * by the OI scrub thread itself. */
+	struct list_head	os_req_repair;
+	/* # of the started workers. */
+	int			os_workers;
+	atomic_t		os_workers_running;
+	unsigned int		os_workers_stop:1;
 };
 
 #endif /* _OSD_SCRUB_H */
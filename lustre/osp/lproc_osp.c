@@ -294,6 +294,90 @@ static ssize_t max_rpcs_in_progress_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(max_rpcs_in_progress);
 
+/**
+ * Show maximum number of objects destroyed by a single RPC
+ *
+ * \param[in] m		seq_file handle
+ * \param[in] data	unused
+ * \retval		0 on success
+ * \retval		negative number on error
+ */
+static ssize_t sync_destroy_batch_show(struct kobject *kobj,
+				       struct attribute *attr,
+				       char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osp_device *osp = dt2osp_dev(dt);
+
+	return sprintf(buf, "%u\n", osp->opd_sync_max_batch);
+}
+
+/**
+ * Change maximum number of objects destroyed by a single RPC
+ *
+ * 1 disables merging of the destroys of consecutive objects.
+ *
+ * \param[in] file	proc file
+ * \param[in] buffer	string which represents maximum number
+ * \param[in] count	\a buffer length
+ * \param[in] off	unused for single entry
+ * \retval		\a count on success
+ * \retval		negative number on error
+ */
+static ssize_t sync_destroy_batch_store(struct kobject *kobj,
+					struct attribute *attr,
+					const char *buffer,
+					size_t count)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osp_device *osp = dt2osp_dev(dt);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val == 0 || val > OSP_SYNC_DESTROY_BATCH_MAX)
+		return -ERANGE;
+
+	osp->opd_sync_max_batch = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(sync_destroy_batch);
+
+/**
+ * Show number of llog records cancelled per second
+ *
+ * The rate is updated by the sync thread once a second at most, when it
+ * cancels records. If it didn't for a while, the rate is computed here.
+ *
+ * \param[in] m		seq_file handle
+ * \param[in] data	unused
+ * \retval		0 on success
+ * \retval		negative number on error
+ */
+static ssize_t sync_drain_rate_show(struct kobject *kobj,
+				    struct attribute *attr,
+				    char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osp_device *osp = dt2osp_dev(dt);
+	s64 elapsed = ktime_ms_delta(ktime_get(), osp->opd_sync_drain_time);
+	__u64 rate = osp->opd_sync_drain_rate;
+
+	if (elapsed >= 2 * MSEC_PER_SEC)
+		rate = div64_u64(osp->opd_sync_drain_count * MSEC_PER_SEC,
+				 elapsed);
+
+	return sprintf(buf, "%llu\n", rate);
+}
+LUSTRE_RO_ATTR(sync_drain_rate);
+
 /**
  * Show number of objects to precreate next time
  *
@@ -432,6 +516,89 @@ static ssize_t max_create_count_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(max_create_count);
 
+/**
+ * Show the moving average of objects created per second
+ *
+ * \param[in] m		seq_file handle
+ * \param[in] data	unused for single entry
+ * \retval		0 on success
+ * \retval		negative number on error
+ */
+static ssize_t create_rate_show(struct kobject *kobj, struct attribute *attr,
+				char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osp_device *osp = dt2osp_dev(dt);
+
+	if (!osp->opd_pre)
+		return -EINVAL;
+
+	return sprintf(buf, "%u\n", osp_precreate_rate(osp));
+}
+LUSTRE_RO_ATTR(create_rate);
+
+/**
+ * Show how long (in ms) the precreated objects should last
+ *
+ * \param[in] m		seq_file handle
+ * \param[in] data	unused for single entry
+ * \retval		0 on success
+ * \retval		negative number on error
+ */
+static ssize_t create_horizon_ms_show(struct kobject *kobj,
+				      struct attribute *attr,
+				      char *buf)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osp_device *osp = dt2osp_dev(dt);
+
+	if (!osp->opd_pre)
+		return -EINVAL;
+
+	return sprintf(buf, "%u\n", osp->opd_pre_horizon_ms);
+}
+
+/**
+ * Change how long (in ms) the precreated objects should last
+ *
+ * At the current create rate, see create_rate. 0 means the pool is sized
+ * by create_count only.
+ *
+ * \param[in] file	proc file
+ * \param[in] buffer	string which represents the time in ms
+ * \param[in] count	\a buffer length
+ * \param[in] off	unused for single entry
+ * \retval		\a count on success
+ * \retval		negative number on error
+ */
+static ssize_t create_horizon_ms_store(struct kobject *kobj,
+				       struct attribute *attr,
+				       const char *buffer, size_t count)
+{
+	struct dt_device *dt = container_of(kobj, struct dt_device,
+					    dd_kobj);
+	struct osp_device *osp = dt2osp_dev(dt);
+	unsigned int val;
+	int rc;
+
+	if (!osp->opd_pre)
+		return -EINVAL;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > 60 * MSEC_PER_SEC)
+		return -ERANGE;
+
+	osp->opd_pre_horizon_ms = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(create_horizon_ms);
+
 /**
  * Show last id to assign in creation
  *
@@ -858,6 +1025,73 @@ osp_reserved_mb_high_seq_write(struct file *file, const char __user *buffer,
 }
 LDEBUGFS_SEQ_FOPS(osp_reserved_mb_high);
 
+/**
+ * Show the histogram of the time spent waiting for a precreated object
+ *
+ * \param[in] m		seq_file handle
+ * \param[in] data	unused for single entry
+ * \retval		0 on success
+ * \retval		negative number on error
+ */
+static int osp_create_wait_hist_seq_show(struct seq_file *m, void *data)
+{
+	struct obd_device	*dev = m->private;
+	struct osp_device	*osp = lu2osp_dev(dev->obd_lu_dev);
+	struct obd_histogram	*hist;
+	struct timespec64	 now;
+	unsigned long		 tot, cum = 0;
+	int			 i;
+
+	if (osp == NULL || osp->opd_pre == NULL)
+		return -EINVAL;
+
+	hist = &osp->opd_pre_wait_hist;
+	ktime_get_real_ts64(&now);
+	seq_printf(m, "snapshot_time:         %lld.%09lu (secs.nsecs)\n",
+		   (s64)now.tv_sec, now.tv_nsec);
+	seq_printf(m, "create rate:           %u objs/s\n",
+		   osp_precreate_rate(osp));
+	seq_printf(m, "\nwait (usec)           creates   %% cum %%\n");
+
+	tot = lprocfs_oh_sum(hist);
+	for (i = 0; i < OBD_HIST_MAX && cum < tot; i++) {
+		unsigned long c = hist->oh_buckets[i];
+
+		cum += c;
+		seq_printf(m, "%lu:\t\t%10lu %3u %3u\n", 1UL << i, c,
+			   pct(c, tot), pct(cum, tot));
+	}
+
+	return 0;
+}
+
+/**
+ * Clear the histogram of the time spent waiting for a precreated object
+ *
+ * \param[in] file	proc file
+ * \param[in] buffer	unused because any input will do
+ * \param[in] count	\a buffer length
+ * \param[in] off	unused for single entry
+ * \retval		\a count on success
+ * \retval		negative number on error
+ */
+static ssize_t
+osp_create_wait_hist_seq_write(struct file *file, const char __user *buffer,
+			       size_t count, loff_t *off)
+{
+	struct seq_file		*m = file->private_data;
+	struct obd_device	*dev = m->private;
+	struct osp_device	*osp = lu2osp_dev(dev->obd_lu_dev);
+
+	if (osp == NULL || osp->opd_pre == NULL)
+		return -EINVAL;
+
+	lprocfs_oh_clear(&osp->opd_pre_wait_hist);
+
+	return count;
+}
+LDEBUGFS_SEQ_FOPS(osp_create_wait_hist);
+
 /**
  * Show low watermark (in megabytes). If available free space at OST is less
  * than low watermark, object allocation for OST is disabled.
@@ -951,6 +1185,8 @@ static struct lprocfs_vars lprocfs_osp_obd_vars[] = {
 	  .fops =	&osp_reserved_mb_high_fops	},
 	{ .name =	"reserved_mb_low",
 	  .fops =	&osp_reserved_mb_low_fops	},
+	{ .name =	"create_wait_hist",
+	  .fops =	&osp_create_wait_hist_fops	},
 	{ NULL }
 };
 
@@ -987,10 +1223,14 @@ static struct attribute *osp_obd_attrs[] = {
 	&lustre_attr_sync_in_flight.attr,
 	&lustre_attr_sync_in_progress.attr,
 	&lustre_attr_sync_changes.attr,
+	&lustre_attr_sync_destroy_batch.attr,
+	&lustre_attr_sync_drain_rate.attr,
 	&lustre_attr_force_sync.attr,
 	&lustre_attr_old_sync_processed.attr,
 	&lustre_attr_create_count.attr,
 	&lustre_attr_max_create_count.attr,
+	&lustre_attr_create_rate.attr,
+	&lustre_attr_create_horizon_ms.attr,
 	NULL,
 };
 
@@ -86,6 +86,15 @@ struct osp_precreate {
 	int				 osp_pre_create_slow;
 	/* cleaning up orphans or recreating missing objects */
 	int				 osp_pre_recovering;
+	/* objects consumed per second, moving average */
+	unsigned int			 osp_pre_rate;
+	/* objects consumed since osp_pre_rate_time */
+	unsigned int			 osp_pre_rate_count;
+	ktime_t				 osp_pre_rate_time;
+	/* how long (ms) the pool should last at the current rate */
+	unsigned int			 osp_pre_horizon_ms;
+	/* time spent waiting for an object in osp_precreate_reserve() */
+	struct obd_histogram		 osp_pre_wait_hist;
 };
 
 struct osp_update_request_sub {
@@ -151,6 +160,10 @@ struct osp_rpc_lock {
 	unsigned int		rpcl_fakes;
 };
 
+/* objects destroyed by a single OST_DESTROY from the sync thread */
+#define OSP_SYNC_DESTROY_BATCH		32
+#define OSP_SYNC_DESTROY_BATCH_MAX	1024
+
 struct osp_device {
 	struct dt_device		 opd_dt_dev;
 	/* corresponded OST index */
@@ -244,6 +257,17 @@ struct osp_device {
 	/* last generated id */
 	ktime_t				 opd_sync_next_commit_cb;
 	atomic_t			 opd_commits_registered;
+	/* destroy RPC still open to the next objects, not sent yet */
+	struct ptlrpc_request		*opd_sync_batch_req;
+	/* object the destroy RPC above can be extended with */
+	struct lu_fid			 opd_sync_batch_next;
+	/* max number of objects destroyed by a single RPC */
+	int				 opd_sync_max_batch;
+	/* records cancelled since opd_sync_drain_time */
+	__u64				 opd_sync_drain_count;
+	ktime_t				 opd_sync_drain_time;
+	/* records cancelled per second over the last interval */
+	__u64				 opd_sync_drain_rate;
 
 	/*
 	 * statfs related fields: OSP maintains it on its own
@@ -286,6 +310,11 @@ struct osp_device {
 #define opd_pre_max_create_count	opd_pre->osp_pre_max_create_count
 #define opd_pre_create_slow		opd_pre->osp_pre_create_slow
 #define opd_pre_recovering		opd_pre->osp_pre_recovering
+#define opd_pre_rate			opd_pre->osp_pre_rate
+#define opd_pre_rate_count		opd_pre->osp_pre_rate_count
+#define opd_pre_rate_time		opd_pre->osp_pre_rate_time
+#define opd_pre_horizon_ms		opd_pre->osp_pre_horizon_ms
+#define opd_pre_wait_hist		opd_pre->osp_pre_wait_hist
 
 extern struct kmem_cache *osp_object_kmem;
 
@@ -866,6 +895,7 @@ extern const struct dt_index_operations osp_md_index_ops;
 /* osp_precreate.c */
 int osp_init_precreate(struct osp_device *d);
 int osp_precreate_reserve(const struct lu_env *env, struct osp_device *d);
+unsigned int osp_precreate_rate(struct osp_device *d);
 __u64 osp_precreate_get_id(struct osp_device *d);
 int osp_precreate_get_fid(const struct lu_env *env, struct osp_device *d,
 			  struct lu_fid *fid);
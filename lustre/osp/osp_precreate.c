@@ -46,6 +46,13 @@
 
 #include "osp_internal.h"
 
+/* default time the precreated pool should last at the current create rate */
+#define OSP_PRE_HORIZON_MS		1000
+/* shortest interval the create rate is sampled over */
+#define OSP_PRE_RATE_INTERVAL_MS	100
+/* the create rate is halved for each such period without creates */
+#define OSP_PRE_RATE_IDLE_MS		(8 * OSP_PRE_RATE_INTERVAL_MS)
+
 /*
  * there are two specific states to take care about:
  *
@@ -318,6 +325,84 @@ static inline int osp_objs_precreated(const struct lu_env *env,
 			    &osp->opd_pre_used_fid);
 }
 
+/**
+ * Current estimate of the create rate
+ *
+ * The average kept by osp_precreate_rate_update() is only updated when
+ * objects are taken from the pool, so it is halved here for each
+ * OSP_PRE_RATE_IDLE_MS since the last update, the same way the conflict
+ * rate of LDLM resources ages. The stored value isn't changed, so this
+ * needs no locking.
+ *
+ * \param[in] d		OSP device
+ *
+ * \retval		objects per second
+ */
+unsigned int osp_precreate_rate(struct osp_device *d)
+{
+	s64 shift = div_s64(ktime_ms_delta(ktime_get(), d->opd_pre_rate_time),
+			    OSP_PRE_RATE_IDLE_MS);
+	unsigned int rate = d->opd_pre_rate;
+
+	if (shift <= 0)
+		return rate;
+
+	return shift < 32 ? rate >> shift : 0;
+}
+
+/**
+ * Number of precreated objects needed for the next opd_pre_horizon_ms
+ *
+ * The create rate is estimated by osp_precreate_rate_update().
+ *
+ * \param[in] d		OSP device
+ *
+ * \retval		number of objects
+ */
+static inline int osp_precreate_want(struct osp_device *d)
+{
+	__u64 want;
+
+	want = div_u64((__u64)osp_precreate_rate(d) * d->opd_pre_horizon_ms,
+		       MSEC_PER_SEC);
+
+	return min_t(__u64, want, d->opd_pre_max_create_count / 2);
+}
+
+/**
+ * Update the estimate of the create rate
+ *
+ * The rate is sampled over intervals of OSP_PRE_RATE_INTERVAL_MS at least,
+ * and folded into an exponential moving average. After an idle period the
+ * average is aged by osp_precreate_rate() instead, so a new burst isn't
+ * diluted by the idle time. Must be called with opd_pre_lock held.
+ *
+ * \param[in] d		OSP device
+ * \param[in] nr	number of objects just taken from the pool
+ */
+static void osp_precreate_rate_update(struct osp_device *d, int nr)
+{
+	ktime_t now = ktime_get();
+	s64 elapsed = ktime_ms_delta(now, d->opd_pre_rate_time);
+	unsigned int rate;
+
+	if (elapsed >= OSP_PRE_RATE_IDLE_MS) {
+		d->opd_pre_rate = osp_precreate_rate(d);
+		d->opd_pre_rate_count = nr;
+		d->opd_pre_rate_time = now;
+		return;
+	}
+
+	d->opd_pre_rate_count += nr;
+	if (elapsed < OSP_PRE_RATE_INTERVAL_MS)
+		return;
+
+	rate = div64_u64((__u64)d->opd_pre_rate_count * MSEC_PER_SEC, elapsed);
+	d->opd_pre_rate = (3 * d->opd_pre_rate + rate) / 4;
+	d->opd_pre_rate_count = 0;
+	d->opd_pre_rate_time = now;
+}
+
 /**
  * Check pool of precreated objects is nearly empty
  *
@@ -325,7 +410,9 @@ static inline int osp_objs_precreated(const struct lu_env *env,
  * because then there will be a long period of OSP being unavailable for the
  * new creations due to lenghty precreate RPC. Instead we ask for another
  * precreation ahead and hopefully have it ready before the current pool is
- * empty. Notice this function relies on an external locking.
+ * empty: when less than half of the last precreate is left, or less than
+ * the objects needed at the current create rate for opd_pre_horizon_ms.
+ * Notice this function relies on an external locking.
  *
  * \param[in] env	LU environment provided by the caller
  * \param[in] d		OSP device
@@ -336,10 +423,11 @@ static inline int osp_precreate_near_empty_nolock(const struct lu_env *env,
 						  struct osp_device *d)
 {
 	int window = osp_objs_precreated(env, d);
+	int low = max(d->opd_pre_create_count / 2, osp_precreate_want(d));
 
 	/* don't consider new precreation till OST is healty and
 	 * has free space */
-	return ((window - d->opd_pre_reserved < d->opd_pre_create_count / 2) &&
+	return ((window - d->opd_pre_reserved < low) &&
 		(d->opd_pre_status == 0));
 }
 
@@ -647,7 +735,10 @@ static int osp_precreate_send(const struct lu_env *env, struct osp_device *d)
 	spin_lock(&d->opd_pre_lock);
 	if (d->opd_pre_create_count > d->opd_pre_max_create_count / 2)
 		d->opd_pre_create_count = d->opd_pre_max_create_count / 2;
+	/* precreate enough for the horizon, unless the OST is slow */
 	grow = d->opd_pre_create_count;
+	if (!d->opd_pre_create_slow)
+		grow = max(grow, osp_precreate_want(d));
 	spin_unlock(&d->opd_pre_lock);
 
 	body = req_capsule_client_get(&req->rq_pill, &RMF_OST_BODY);
@@ -1441,6 +1532,7 @@ static int osp_precreate_timeout_condition(void *data)
 int osp_precreate_reserve(const struct lu_env *env, struct osp_device *d)
 {
 	time64_t expire = ktime_get_seconds() + obd_timeout;
+	ktime_t start = ktime_get();
 	struct l_wait_info lwi;
 	int precreated, rc, synced = 0;
 
@@ -1532,6 +1624,9 @@ int osp_precreate_reserve(const struct lu_env *env, struct osp_device *d)
 			     osp_precreate_ready_condition(env, d), &lwi);
 	}
 
+	lprocfs_oh_tally_log2(&d->opd_pre_wait_hist,
+			      ktime_us_delta(ktime_get(), start));
+
 	RETURN(rc);
 }
 
@@ -1587,6 +1682,7 @@ int osp_precreate_get_fid(const struct lu_env *env, struct osp_device *d,
 	d->opd_pre_used_fid.f_oid++;
 	memcpy(fid, &d->opd_pre_used_fid, sizeof(*fid));
 	d->opd_pre_reserved--;
+	osp_precreate_rate_update(d, 1);
 	/*
 	 * last_used_id must be changed along with getting new id otherwise
 	 * we might miscalculate gap causing object loss or leak
@@ -1743,6 +1839,9 @@ int osp_init_precreate(struct osp_device *d)
 	d->opd_pre_max_create_count = OST_MAX_PRECREATE;
 	d->opd_reserved_mb_high = 0;
 	d->opd_reserved_mb_low = 0;
+	d->opd_pre_rate_time = ktime_get();
+	d->opd_pre_horizon_ms = OSP_PRE_HORIZON_MS;
+	spin_lock_init(&d->opd_pre_wait_hist.oh_lock);
 
 	RETURN(0);
 }
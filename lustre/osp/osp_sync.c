@@ -40,6 +40,7 @@
 #define DEBUG_SUBSYSTEM S_MDS
 
 #include <linux/kthread.h>
+#include <linux/sort.h>
 #include <lustre_log.h>
 #include <lustre_update.h>
 #include "osp_internal.h"
@@ -75,6 +76,13 @@
  *
  * opd_sync_rpcs_in_flight is a number of RPC in flight.
  * we control this with OSP_MAX_RPCS_IN_FLIGHT
+ *
+ * unlink records for consecutive objects of the same sequence (which is
+ * what a big "rm -r" produces on every OST) are merged into a single
+ * OST_DESTROY covering the range of objects, see osp_sync_batch_add().
+ * such a request is counted once in the counters above and carries the
+ * cookies of all its records, which are cancelled together once the
+ * request is committed.
  */
 
 /* XXX: do math to learn reasonable threshold
@@ -86,18 +94,33 @@
 
 #define OSP_JOB_MAGIC		0x26112005
 
+/* cookies of the records merged into a destroy RPC, but the first one */
+struct osp_job_batch {
+	int			ojb_size;
+	int			ojb_count;
+	struct llog_cookie	ojb_cookies[0];
+};
+
 struct osp_job_req_args {
 	/** bytes reserved for ptlrpc_replay_req() */
 	struct ptlrpc_replay_async_args	jra_raa;
 	struct list_head		jra_committed_link;
 	struct list_head		jra_in_flight_link;
 	struct llog_cookie		jra_lcookie;
+	struct osp_job_batch		*jra_batch;
 	__u32				jra_magic;
 };
 
 static int osp_sync_add_commit_cb(const struct lu_env *env,
 				  struct osp_device *d, struct thandle *th);
 
+static inline void osp_sync_batch_free(struct osp_job_req_args *jra)
+{
+	OBD_FREE_LARGE(jra->jra_batch, offsetof(struct osp_job_batch,
+				ojb_cookies[jra->jra_batch->ojb_size]));
+	jra->jra_batch = NULL;
+}
+
 static inline int osp_sync_running(struct osp_device *d)
 {
 	return !!(d->opd_sync_thread.t_flags & SVC_RUNNING);
@@ -183,6 +206,17 @@ static inline int osp_sync_in_flight_conflict(struct osp_device *d,
 			conflict = 1;
 			break;
 		}
+
+		/* destroy of a range of objects, possibly still held open
+		 * by osp_sync_batch_add() */
+		if (body->oa.o_valid & OBD_MD_FLOBJCOUNT &&
+		    ostid_seq(&ostid) == ostid_seq(&body->oa.o_oi) &&
+		    ostid_id(&ostid) > ostid_id(&body->oa.o_oi) &&
+		    ostid_id(&ostid) < ostid_id(&body->oa.o_oi) +
+				       body->oa.o_misc) {
+			conflict = 1;
+			break;
+		}
 	}
 	spin_unlock(&d->opd_sync_lock);
 
@@ -571,12 +605,19 @@ static int osp_sync_interpret(const struct lu_env *env,
 	       atomic_read(&req->rq_refcount),
 	       rc, (unsigned) req->rq_transno);
 
-	if (rc == -ENOENT) {
+	if (rc == -ENOENT && req->rq_transno != 0) {
+		/*
+		 * some objects of a destroyed range didn't exist anymore,
+		 * the others were destroyed: the records are cancelled
+		 * once the request is committed, as for a plain success.
+		 * This is so for any range, batched or from a single
+		 * record, the commit callback queues the request then.
+		 */
+	} else if (rc == -ENOENT) {
 		/*
 		 * we tried to destroy object or update attributes,
 		 * but object doesn't exist anymore - cancell llog record
 		 */
-		LASSERT(req->rq_transno == 0);
 		LASSERT(list_empty(&jra->jra_committed_link));
 
 		ptlrpc_request_addref(req);
@@ -591,8 +632,11 @@ static int osp_sync_interpret(const struct lu_env *env,
 		struct obd_import *imp = req->rq_import;
 		/*
 		 * error happened, we'll try to repeat on next boot ?
+		 * if a part of a destroyed range was done, the records
+		 * are cancelled on commit, the rest is left to LFSCK
 		 */
 		LASSERTF(req->rq_transno == 0 || rc == -EIO ||
+			 jra->jra_batch != NULL ||
 			 req->rq_import_generation < imp->imp_generation,
 			 "transno %llu, rc %d, gen: req %d, imp %d\n",
 			 req->rq_transno, rc, req->rq_import_generation,
@@ -603,6 +647,8 @@ static int osp_sync_interpret(const struct lu_env *env,
 			 * will be called at some point */
 			LASSERT(atomic_read(&d->opd_sync_rpcs_in_progress) > 0);
 			atomic_dec(&d->opd_sync_rpcs_in_progress);
+			if (jra->jra_batch != NULL)
+				osp_sync_batch_free(jra);
 		}
 
 		wake_up(&d->opd_sync_waitq);
@@ -632,6 +678,64 @@ static int osp_sync_interpret(const struct lu_env *env,
 	return 0;
 }
 
+/**
+ * Initialize the callback data of a new request.
+ *
+ * \param[in] llh	llog handle where the record is stored
+ * \param[in] h		llog record
+ * \param[in] req	request
+ */
+static void osp_sync_init_job_args(struct llog_handle *llh,
+				   struct llog_rec_hdr *h,
+				   struct ptlrpc_request *req)
+{
+	struct osp_job_req_args *jra;
+
+	jra = ptlrpc_req_async_args(jra, req);
+	jra->jra_magic = OSP_JOB_MAGIC;
+	jra->jra_lcookie.lgc_lgl = llh->lgh_id;
+	jra->jra_lcookie.lgc_subsys = LLOG_MDS_OST_ORIG_CTXT;
+	jra->jra_lcookie.lgc_index = h->lrh_index;
+	jra->jra_batch = NULL;
+	INIT_LIST_HEAD(&jra->jra_committed_link);
+}
+
+/**
+ * Put the request on the in-flight list.
+ *
+ * A destroy request held open for the next objects is put there as well,
+ * so that osp_sync_in_flight_conflict() sees the objects it covers.
+ *
+ * \param[in] d		OSP device
+ * \param[in] req	request
+ */
+static void osp_sync_in_flight_add(struct osp_device *d,
+				   struct ptlrpc_request *req)
+{
+	struct osp_job_req_args *jra;
+
+	LASSERT(atomic_read(&d->opd_sync_rpcs_in_flight) <=
+		d->opd_sync_max_rpcs_in_flight);
+
+	jra = ptlrpc_req_async_args(jra, req);
+	spin_lock(&d->opd_sync_lock);
+	list_add_tail(&jra->jra_in_flight_link, &d->opd_sync_in_flight_list);
+	spin_unlock(&d->opd_sync_lock);
+}
+
+/**
+ * Put the request on the in-flight list and hand it to ptlrpcd.
+ *
+ * \param[in] d		OSP device
+ * \param[in] req	request
+ */
+static void osp_sync_send_rpc(struct osp_device *d,
+			      struct ptlrpc_request *req)
+{
+	osp_sync_in_flight_add(d, req);
+	ptlrpcd_add_req(req);
+}
+
 /*
  ** Add request to ptlrpc queue.
  *
@@ -647,22 +751,89 @@ static void osp_sync_send_new_rpc(struct osp_device *d,
 				  struct llog_rec_hdr *h,
 				  struct ptlrpc_request *req)
 {
+	osp_sync_init_job_args(llh, h, req);
+	osp_sync_send_rpc(d, req);
+}
+
+/**
+ * Send the destroy request being batched, if any.
+ *
+ * \param[in] d		OSP device
+ */
+static void osp_sync_batch_flush(struct osp_device *d)
+{
+	struct ptlrpc_request *req = d->opd_sync_batch_req;
+
+	if (req == NULL)
+		return;
+
+	d->opd_sync_batch_req = NULL;
+	/* already on the in-flight list */
+	ptlrpcd_add_req(req);
+}
+
+/**
+ * Try to merge an unlink record into the destroy request being batched.
+ *
+ * OST_DESTROY can destroy a range of objects starting from o_oi, as many as
+ * o_misc says. If the record is for the object following the last one of the
+ * range, the range is extended and the cookie of the record is remembered to
+ * be cancelled along with the cookie of the request.
+ *
+ * \param[in] d		OSP device
+ * \param[in] llh	llog handle where the record is stored
+ * \param[in] h		llog record
+ *
+ * \retval true		the record is merged
+ * \retval false	the record needs its own request
+ */
+static bool osp_sync_batch_add(struct osp_device *d, struct llog_handle *llh,
+			       struct llog_rec_hdr *h)
+{
+	struct llog_unlink64_rec *rec = (struct llog_unlink64_rec *)h;
+	struct ptlrpc_request *req = d->opd_sync_batch_req;
 	struct osp_job_req_args *jra;
+	struct osp_job_batch *batch;
+	struct llog_cookie *cookie;
+	struct ost_body *body;
 
-	LASSERT(atomic_read(&d->opd_sync_rpcs_in_flight) <=
-		d->opd_sync_max_rpcs_in_flight);
+	if (req == NULL || h->lrh_type != MDS_UNLINK64_REC ||
+	    !lu_fid_eq(&rec->lur_fid, &d->opd_sync_batch_next))
+		return false;
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_OST_BODY);
+	if (body->oa.o_misc + rec->lur_count > d->opd_sync_max_batch ||
+	    (__u64)rec->lur_fid.f_oid + rec->lur_count >
+	    LUSTRE_DATA_SEQ_MAX_WIDTH)
+		return false;
 
 	jra = ptlrpc_req_async_args(jra, req);
-	jra->jra_magic = OSP_JOB_MAGIC;
-	jra->jra_lcookie.lgc_lgl = llh->lgh_id;
-	jra->jra_lcookie.lgc_subsys = LLOG_MDS_OST_ORIG_CTXT;
-	jra->jra_lcookie.lgc_index = h->lrh_index;
-	INIT_LIST_HEAD(&jra->jra_committed_link);
+	batch = jra->jra_batch;
+	if (batch == NULL) {
+		int size = d->opd_sync_max_batch;
+
+		OBD_ALLOC_LARGE(batch, offsetof(struct osp_job_batch,
+					  ojb_cookies[size]));
+		if (batch == NULL)
+			return false;
+		batch->ojb_size = size;
+		jra->jra_batch = batch;
+	}
+	if (batch->ojb_count >= batch->ojb_size)
+		return false;
+
+	cookie = &batch->ojb_cookies[batch->ojb_count++];
+	cookie->lgc_lgl = llh->lgh_id;
+	cookie->lgc_subsys = LLOG_MDS_OST_ORIG_CTXT;
+	cookie->lgc_index = h->lrh_index;
+
+	/* the request is on the in-flight list already */
 	spin_lock(&d->opd_sync_lock);
-	list_add_tail(&jra->jra_in_flight_link, &d->opd_sync_in_flight_list);
+	body->oa.o_misc += rec->lur_count;
 	spin_unlock(&d->opd_sync_lock);
+	d->opd_sync_batch_next.f_oid += rec->lur_count;
 
-	ptlrpcd_add_req(req);
+	return true;
 }
 
 
@@ -874,7 +1045,19 @@ static int osp_sync_new_unlink64_job(struct osp_device *d,
 	body->oa.o_misc = rec->lur_count;
 	body->oa.o_valid = OBD_MD_FLGROUP | OBD_MD_FLID |
 			   OBD_MD_FLOBJCOUNT;
-	osp_sync_send_new_rpc(d, llh, h, req);
+
+	osp_sync_init_job_args(llh, h, req);
+	if (d->opd_sync_max_batch > 1 && fid_is_norm(&rec->lur_fid) &&
+	    rec->lur_count < d->opd_sync_max_batch) {
+		/* keep it open for the destroy of the next objects */
+		LASSERT(d->opd_sync_batch_req == NULL);
+		d->opd_sync_batch_req = req;
+		d->opd_sync_batch_next = rec->lur_fid;
+		d->opd_sync_batch_next.f_oid += rec->lur_count;
+		osp_sync_in_flight_add(d, req);
+	} else {
+		osp_sync_send_rpc(d, req);
+	}
 	RETURN(0);
 }
 
@@ -936,6 +1119,10 @@ static void osp_sync_process_record(const struct lu_env *env,
 	 * and fire after next commit callback
 	 */
 
+	if (osp_sync_batch_add(d, llh, rec))
+		goto done;
+	osp_sync_batch_flush(d);
+
 	/* notice we increment counters before sending RPC, to be consistent
 	 * in RPC interpret callback which may happen very quickly */
 	atomic_inc(&d->opd_sync_rpcs_in_flight);
@@ -960,6 +1147,7 @@ static void osp_sync_process_record(const struct lu_env *env,
 		break;
 	}
 
+done:
 	/* For all kinds of records, not matter successful or not,
 	 * we should decrease changes and bump last_processed_id.
 	 */
@@ -995,6 +1183,89 @@ static void osp_sync_process_record(const struct lu_env *env,
 	RETURN_EXIT;
 }
 
+static int osp_sync_cookie_cmp(const void *a, const void *b)
+{
+	const struct llog_cookie *ca = a;
+	const struct llog_cookie *cb = b;
+	int rc;
+
+	rc = memcmp(&ca->lgc_lgl, &cb->lgc_lgl, sizeof(ca->lgc_lgl));
+	if (rc != 0)
+		return rc;
+
+	return ca->lgc_index < cb->lgc_index ? -1 :
+	       ca->lgc_index > cb->lgc_index;
+}
+
+/**
+ * Cancel llog records, one llog_cat_cancel_arr_rec() call per plain llog.
+ *
+ * \param[in] env	LU environment provided by the caller
+ * \param[in] d		OSP device
+ * \param[in] llh	catalog handle
+ * \param[in] cookies	cookies of the records, sorted in place
+ * \param[in] count	number of cookies
+ */
+static void osp_sync_cancel_cookies(const struct lu_env *env,
+				    struct osp_device *d,
+				    struct llog_handle *llh,
+				    struct llog_cookie *cookies, int count)
+{
+	struct obd_device	*obd = d->opd_obd;
+	int			*arr;
+	int			 rc, i, j, k;
+
+	sort(cookies, count, sizeof(*cookies), osp_sync_cookie_cmp, NULL);
+
+	OBD_ALLOC_LARGE(arr, sizeof(int) * count);
+	for (i = 0; i < count; i = j) {
+		for (j = i + 1; j < count; j++)
+			if (memcmp(&cookies[j].lgc_lgl, &cookies[i].lgc_lgl,
+				   sizeof(cookies[i].lgc_lgl)) != 0)
+				break;
+
+		if (arr == NULL) {
+			llog_cat_cancel_records(env, llh, j - i, &cookies[i]);
+			continue;
+		}
+
+		for (k = i; k < j; k++)
+			arr[k - i] = cookies[k].lgc_index;
+		rc = llog_cat_cancel_arr_rec(env, llh, &cookies[i].lgc_lgl,
+					     j - i, arr);
+		if (rc)
+			CERROR("%s: can't cancel %d records rc: %d\n",
+			       obd->obd_name, j - i, rc);
+		else
+			CDEBUG(D_OTHER, "%s: massive records cancel id "DFID
+			       " num %d\n", obd->obd_name,
+			       PFID(&cookies[i].lgc_lgl.lgl_oi.oi_fid), j - i);
+	}
+	if (arr != NULL)
+		OBD_FREE_LARGE(arr, sizeof(int) * count);
+}
+
+/**
+ * Update the rate at which llog records are cancelled.
+ *
+ * The rate is computed over intervals of at least a second.
+ *
+ * \param[in] d		OSP device
+ */
+static void osp_sync_drain_update(struct osp_device *d)
+{
+	ktime_t now = ktime_get();
+	s64 elapsed = ktime_ms_delta(now, d->opd_sync_drain_time);
+
+	if (elapsed < MSEC_PER_SEC)
+		return;
+
+	d->opd_sync_drain_rate = div64_u64(d->opd_sync_drain_count *
+					   MSEC_PER_SEC, elapsed);
+	d->opd_sync_drain_count = 0;
+	d->opd_sync_drain_time = now;
+}
+
 /**
  * Cancel llog records for the committed changes.
  *
@@ -1014,10 +1285,10 @@ static void osp_sync_process_committed(const struct lu_env *env,
 	struct ptlrpc_request	*req;
 	struct llog_ctxt	*ctxt;
 	struct llog_handle	*llh;
-	int			*arr;
-	struct list_head	 list, *le;
-	struct llog_logid	 lgid;
-	int			 rc, i, count = 0, done = 0;
+	struct llog_cookie	*cookies;
+	struct list_head	 list;
+	struct osp_job_req_args	*jra;
+	int			 rc, i = 0, count = 0, done = 0;
 
 	ENTRY;
 
@@ -1036,8 +1307,6 @@ static void osp_sync_process_committed(const struct lu_env *env,
 
 	/*
 	 * now cancel them all
-	 * XXX: can we improve this using some batching?
-	 *      with batch RPC that'll happen automatically?
 	 * XXX: can we store ctxt in lod_device and save few cycles ?
 	 */
 	ctxt = llog_get_context(obd, LLOG_MDS_OST_ORIG_CTXT);
@@ -1052,15 +1321,17 @@ static void osp_sync_process_committed(const struct lu_env *env,
 	INIT_LIST_HEAD(&d->opd_sync_committed_there);
 	spin_unlock(&d->opd_sync_lock);
 
-	list_for_each(le, &list)
+	list_for_each_entry(jra, &list, jra_committed_link) {
 		count++;
-	if (count > 2)
-		OBD_ALLOC_WAIT(arr, sizeof(int) * count);
+		if (jra->jra_batch != NULL)
+			count += jra->jra_batch->ojb_count;
+	}
+	if (count > 1)
+		OBD_ALLOC_LARGE(cookies, sizeof(*cookies) * count);
 	else
-		arr = NULL;
-	i = 0;
+		cookies = NULL;
 	while (!list_empty(&list)) {
-		struct osp_job_req_args	*jra;
+		struct osp_job_batch *batch;
 
 		jra = list_entry(list.next, struct osp_job_req_args,
 				 jra_committed_link);
@@ -1072,43 +1343,46 @@ static void osp_sync_process_committed(const struct lu_env *env,
 		body = req_capsule_client_get(&req->rq_pill,
 					      &RMF_OST_BODY);
 		LASSERT(body);
+		batch = jra->jra_batch;
 		/* import can be closing, thus all commit cb's are
 		 * called we can check committness directly */
 		if (req->rq_import_generation == imp->imp_generation) {
-			if (arr && (!i ||
-				    !memcmp(&jra->jra_lcookie.lgc_lgl, &lgid,
-					   sizeof(lgid)))) {
-				if (unlikely(!i))
-					lgid = jra->jra_lcookie.lgc_lgl;
-
-				arr[i++] = jra->jra_lcookie.lgc_index;
+			if (cookies != NULL) {
+				cookies[i++] = jra->jra_lcookie;
+				if (batch != NULL) {
+					memcpy(&cookies[i], batch->ojb_cookies,
+					       sizeof(*cookies) *
+					       batch->ojb_count);
+					i += batch->ojb_count;
+				}
 			} else {
 				rc = llog_cat_cancel_records(env, llh, 1,
 							     &jra->jra_lcookie);
 				if (rc)
 					CERROR("%s: can't cancel record: %d\n",
 					       obd->obd_name, rc);
+				if (batch != NULL)
+					llog_cat_cancel_records(env, llh,
+							batch->ojb_count,
+							batch->ojb_cookies);
 			}
+			d->opd_sync_drain_count += 1 +
+				(batch != NULL ? batch->ojb_count : 0);
 		} else {
 			DEBUG_REQ(D_OTHER, req, "imp_committed = %llu",
 				  imp->imp_peer_committed_transno);
 		}
+		if (batch != NULL)
+			osp_sync_batch_free(jra);
 		ptlrpc_req_finished(req);
 		done++;
 	}
-	if (arr && i > 0) {
-		rc = llog_cat_cancel_arr_rec(env, llh, &lgid, i, arr);
-
-		if (rc)
-			CERROR("%s: can't cancel %d records rc: %d\n",
-			       obd->obd_name, i, rc);
-		else
-			CDEBUG(D_OTHER, "%s: massive records cancel id "DFID\
-			       " num %d\n", obd->obd_name,
-			       PFID(&lgid.lgl_oi.oi_fid), i);
+	if (cookies != NULL) {
+		if (i > 0)
+			osp_sync_cancel_cookies(env, d, llh, cookies, i);
+		OBD_FREE_LARGE(cookies, sizeof(*cookies) * count);
 	}
-	if (arr)
-		OBD_FREE(arr, sizeof(int) * count);
+	osp_sync_drain_update(d);
 
 	llog_ctxt_put(ctxt);
 
@@ -1156,6 +1430,7 @@ static int osp_sync_process_queues(const struct lu_env *env,
 
 		if (!osp_sync_running(d)) {
 			CDEBUG(D_HA, "stop llog processing\n");
+			osp_sync_batch_flush(d);
 			return LLOG_PROC_BREAK;
 		}
 
@@ -1177,8 +1452,14 @@ static int osp_sync_process_queues(const struct lu_env *env,
 			osp_sync_process_record(env, d, llh, rec);
 			llh = NULL;
 			rec = NULL;
+			/* keep the destroy batch open for the next record */
+			continue;
 		}
 
+		/* the thread is going to sleep, nothing more to merge */
+		if (list_empty(&d->opd_sync_committed_there))
+			osp_sync_batch_flush(d);
+
 		l_wait_event(d->opd_sync_waitq,
 			     !osp_sync_running(d) ||
 			     osp_sync_can_process_new(d, rec) ||
@@ -1288,6 +1569,8 @@ next:
 	} while (rc == 0 && (wrapped ||
 			     d->opd_sync_last_catalog_idx == LLOG_CAT_FIRST));
 
+	osp_sync_batch_flush(d);
+
 	if (rc < 0) {
 		if (rc == -EINPROGRESS) {
 			/* can't access the llog now - OI scrub is trying to fix
@@ -1519,6 +1802,8 @@ int osp_sync_init(const struct lu_env *env, struct osp_device *d)
 
 	d->opd_sync_max_rpcs_in_flight = OSP_MAX_RPCS_IN_FLIGHT;
 	d->opd_sync_max_rpcs_in_progress = OSP_MAX_RPCS_IN_PROGRESS;
+	d->opd_sync_max_batch = OSP_SYNC_DESTROY_BATCH;
+	d->opd_sync_drain_time = ktime_get();
 	spin_lock_init(&d->opd_sync_lock);
 	init_waitqueue_head(&d->opd_sync_waitq);
 	init_waitqueue_head(&d->opd_sync_barrier_waitq);
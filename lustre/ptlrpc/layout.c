@@ -411,6 +411,12 @@ static const struct req_msg_field *ldlm_cp_callback_client[] = {
         &RMF_DLM_LVB
 };
 
+/* handles of the locks the client no longer has */
+static const struct req_msg_field *ldlm_bl_callback_batch_server[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_DLM_REQ
+};
+
 static const struct req_msg_field *ldlm_gl_callback_desc_client[] = {
 	&RMF_PTLRPC_BODY,
 	&RMF_DLM_REQ,
@@ -481,7 +487,8 @@ static const struct req_msg_field *ldlm_intent_getattr_server[] = {
 	&RMF_ACL,
 	&RMF_CAPA1,
 	&RMF_FILE_SECCTX,
-	&RMF_DEFAULT_MDT_MD
+	&RMF_DEFAULT_MDT_MD,
+	&RMF_NIOBUF_INLINE
 };
 
 static const struct req_msg_field *ldlm_intent_create_client[] = {
@@ -692,6 +699,11 @@ static const struct req_msg_field *ost_ladvise[] = {
 	&RMF_OST_LADVISE,
 };
 
+static const struct req_msg_field *ost_batch_glimpse[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_OST_GLIMPSE_REC,
+};
+
 static const struct req_msg_field *ost_get_fiemap_server[] = {
         &RMF_PTLRPC_BODY,
         &RMF_FIEMAP_VAL
@@ -820,6 +832,7 @@ static struct req_format *req_formats[] = {
 	&RQF_OST_SET_INFO_LAST_FID,
 	&RQF_OST_GET_INFO_FIEMAP,
 	&RQF_OST_LADVISE,
+	&RQF_OST_BATCH_GLIMPSE,
 	&RQF_LDLM_ENQUEUE,
 	&RQF_LDLM_ENQUEUE_LVB,
 	&RQF_LDLM_CONVERT,
@@ -827,6 +840,7 @@ static struct req_format *req_formats[] = {
 	&RQF_LDLM_CALLBACK,
 	&RQF_LDLM_CP_CALLBACK,
 	&RQF_LDLM_BL_CALLBACK,
+	&RQF_LDLM_BL_CALLBACK_BATCH,
 	&RQF_LDLM_GL_CALLBACK,
 	&RQF_LDLM_GL_CALLBACK_DESC,
 	&RQF_LDLM_INTENT,
@@ -1285,6 +1299,12 @@ struct req_msg_field RMF_OST_LADVISE =
 		    lustre_swab_ladvise, NULL);
 EXPORT_SYMBOL(RMF_OST_LADVISE);
 
+struct req_msg_field RMF_OST_GLIMPSE_REC =
+	DEFINE_MSGF("ost_glimpse_rec", RMF_F_STRUCT_ARRAY,
+		    sizeof(struct ost_glimpse_rec),
+		    lustre_swab_ost_glimpse_rec, NULL);
+EXPORT_SYMBOL(RMF_OST_GLIMPSE_REC);
+
 struct req_msg_field RMF_OUT_UPDATE_HEADER = DEFINE_MSGF("out_update_header", 0,
 				-1, lustre_swab_out_update_header, NULL);
 EXPORT_SYMBOL(RMF_OUT_UPDATE_HEADER);
@@ -1547,6 +1567,11 @@ struct req_format RQF_LDLM_BL_CALLBACK =
         DEFINE_REQ_FMT0("LDLM_BL_CALLBACK", ldlm_enqueue_client, empty);
 EXPORT_SYMBOL(RQF_LDLM_BL_CALLBACK);
 
+struct req_format RQF_LDLM_BL_CALLBACK_BATCH =
+	DEFINE_REQ_FMT0("LDLM_BL_CALLBACK_BATCH", ldlm_enqueue_client,
+			ldlm_bl_callback_batch_server);
+EXPORT_SYMBOL(RQF_LDLM_BL_CALLBACK_BATCH);
+
 struct req_format RQF_LDLM_GL_CALLBACK =
         DEFINE_REQ_FMT0("LDLM_GL_CALLBACK", ldlm_enqueue_client,
                         ldlm_gl_callback_server);
@@ -1758,6 +1783,11 @@ struct req_format RQF_OST_LADVISE =
 	DEFINE_REQ_FMT0("OST_LADVISE", ost_ladvise, ost_body_only);
 EXPORT_SYMBOL(RQF_OST_LADVISE);
 
+struct req_format RQF_OST_BATCH_GLIMPSE =
+	DEFINE_REQ_FMT0("OST_BATCH_GLIMPSE", ost_batch_glimpse,
+			ost_batch_glimpse);
+EXPORT_SYMBOL(RQF_OST_BATCH_GLIMPSE);
+
 /* Convenience macro */
 #define FMT_FIELD(fmt, i, j) (fmt)->rf_fields[(i)].d[(j)]
 
@@ -66,6 +66,16 @@ static struct ll_rpc_opcode {
         { OST_QUOTACTL,     "ost_quotactl" },
         { OST_QUOTA_ADJUST_QUNIT, "ost_quota_adjust_qunit" },
 	{ OST_LADVISE,      "ost_ladvise" },
+	{ 22,                NULL },
+	{ 23,                NULL },
+	{ 24,                NULL },
+	{ 25,                NULL },
+	{ 26,                NULL },
+	{ 27,                NULL },
+	{ 28,                NULL },
+	{ 29,                NULL },
+	{ 30,                NULL },
+	{ OST_BATCH_GLIMPSE, "ost_batch_glimpse" },
         { MDS_GETATTR,      "mds_getattr" },
         { MDS_GETATTR_NAME, "mds_getattr_lock" },
         { MDS_CLOSE,        "mds_close" },
@@ -77,6 +77,14 @@
 #define NRS_POL_NAME_ORR	"orr"
 #define NRS_POL_NAME_TRR	"trr"
 
+static int orr_calendar_queue;
+module_param(orr_calendar_queue, int, 0644);
+MODULE_PARM_DESC(orr_calendar_queue,
+		 "Sort ORR/TRR requests with a calendar queue instead of a binary heap");
+
+/** # of rounds covered by one year of the ORR/TRR calendar queue */
+#define NRS_ORR_CALQ_ROUNDS	64
+
 /**
  * Checks if the RPC type of \a nrq is currently handled by an ORR/TRR policy
  *
@@ -508,30 +516,26 @@ static struct cfs_hash_ops nrs_trr_hash_ops = {
 #define NRS_ORR_QUANTUM_DFLT	256
 
 /**
- * Binary heap predicate.
+ * Request ordering predicate.
  *
  * Uses
  * ptlrpc_nrs_request::nr_u::orr::or_round,
  * ptlrpc_nrs_request::nr_u::orr::or_sequence, and
  * ptlrpc_nrs_request::nr_u::orr::or_range to compare two binheap nodes and
  * produce a binary predicate that indicates their relative priority, so that
- * the binary heap can perform the necessary sorting operations.
+ * the binary heap or the calendar queue can perform the necessary sorting
+ * operations.
  *
- * \param[in] e1 the first binheap node to compare
- * \param[in] e2 the second binheap node to compare
+ * \param[in] nrq1 the first request to compare
+ * \param[in] nrq2 the second request to compare
  *
- * \retval 0 e1 > e2
- * \retval 1 e1 < e2
+ * \retval 0 nrq1 > nrq2
+ * \retval 1 nrq1 < nrq2
  */
 static int
-orr_req_compare(struct cfs_binheap_node *e1, struct cfs_binheap_node *e2)
+orr_nrq_compare(struct ptlrpc_nrs_request *nrq1,
+		struct ptlrpc_nrs_request *nrq2)
 {
-	struct ptlrpc_nrs_request *nrq1;
-	struct ptlrpc_nrs_request *nrq2;
-
-	nrq1 = container_of(e1, struct ptlrpc_nrs_request, nr_node);
-	nrq2 = container_of(e2, struct ptlrpc_nrs_request, nr_node);
-
 	/**
 	 * Requests have been scheduled against a different scheduling round.
 	 */
@@ -576,6 +580,24 @@ orr_req_compare(struct cfs_binheap_node *e1, struct cfs_binheap_node *e2)
 	}
 }
 
+/**
+ * Binary heap predicate.
+ *
+ * \param[in] e1 the first binheap node to compare
+ * \param[in] e2 the second binheap node to compare
+ *
+ * \retval 0 e1 > e2
+ * \retval 1 e1 < e2
+ */
+static int
+orr_req_compare(struct cfs_binheap_node *e1, struct cfs_binheap_node *e2)
+{
+	return orr_nrq_compare(container_of(e1, struct ptlrpc_nrs_request,
+					    nr_node),
+			       container_of(e2, struct ptlrpc_nrs_request,
+					    nr_node));
+}
+
 /**
  * ORR binary heap operations
  */
@@ -585,6 +607,75 @@ static struct cfs_binheap_ops nrs_orr_heap_ops = {
 	.hop_compare	= orr_req_compare,
 };
 
+/**
+ * Calendar queue predicate; the calendar queue keys requests by round number,
+ * so this only needs to order requests of the same round.
+ *
+ * \param[in] e1 the first calendar queue node to compare
+ * \param[in] e2 the second calendar queue node to compare
+ *
+ * \retval 0 e1 > e2
+ * \retval 1 e1 < e2
+ */
+static int
+orr_req_calq_compare(struct cfs_calq_node *e1, struct cfs_calq_node *e2)
+{
+	return orr_nrq_compare(container_of(e1, struct ptlrpc_nrs_request,
+					    nr_u.orr.or_cqnode),
+			       container_of(e2, struct ptlrpc_nrs_request,
+					    nr_u.orr.or_cqnode));
+}
+
+/**
+ * ORR calendar queue operations
+ */
+static struct cfs_calq_ops nrs_orr_calq_ops = {
+	.cqo_compare	= orr_req_calq_compare,
+};
+
+/*
+ * Queued requests are sorted either in a binary heap or in a calendar queue;
+ * the helpers below hide which one is in use.
+ */
+static int nrs_orr_queue_insert(struct nrs_orr_data *orrd,
+				struct ptlrpc_nrs_request *nrq)
+{
+	if (orrd->od_calq == NULL)
+		return cfs_binheap_insert(orrd->od_binheap, &nrq->nr_node);
+
+	nrq->nr_u.orr.or_cqnode.cqn_key = nrq->nr_u.orr.or_round;
+	cfs_calq_insert(orrd->od_calq, &nrq->nr_u.orr.or_cqnode);
+	return 0;
+}
+
+static void nrs_orr_queue_remove(struct nrs_orr_data *orrd,
+				 struct ptlrpc_nrs_request *nrq)
+{
+	if (orrd->od_calq == NULL)
+		cfs_binheap_remove(orrd->od_binheap, &nrq->nr_node);
+	else
+		cfs_calq_remove(orrd->od_calq, &nrq->nr_u.orr.or_cqnode);
+}
+
+static struct ptlrpc_nrs_request *nrs_orr_queue_first(struct nrs_orr_data *orrd)
+{
+	struct cfs_binheap_node *node;
+	struct cfs_calq_node *cqnode;
+
+	if (orrd->od_calq == NULL) {
+		node = cfs_binheap_root(orrd->od_binheap);
+		if (node == NULL)
+			return NULL;
+		return container_of(node, struct ptlrpc_nrs_request, nr_node);
+	}
+
+	cqnode = cfs_calq_first(orrd->od_calq);
+	if (cqnode == NULL)
+		return NULL;
+	return container_of(cqnode, struct ptlrpc_nrs_request,
+			    nr_u.orr.or_cqnode);
+}
+
 /**
  * Prints a warning message if an ORR/TRR policy is started on a service with
  * more than one CPT.  Not printed on the console for now, since we don't
@@ -630,14 +721,28 @@ static int nrs_orr_start(struct ptlrpc_nrs_policy *policy, char *arg)
 		RETURN(-ENOMEM);
 
 	/*
-	 * Binary heap instance for sorted incoming requests.
+	 * Binary heap or calendar queue instance for sorted incoming requests.
+	 * Rounds are consecutive integers, so the calendar queue has a fixed
+	 * day width of one round.
 	 */
-	orrd->od_binheap = cfs_binheap_create(&nrs_orr_heap_ops,
-					      CBH_FLAG_ATOMIC_GROW, 4096, NULL,
-					      nrs_pol2cptab(policy),
-					      nrs_pol2cptid(policy));
-	if (orrd->od_binheap == NULL)
-		GOTO(out_orrd, rc = -ENOMEM);
+	if (orr_calendar_queue) {
+		orrd->od_calq = cfs_calq_create(&nrs_orr_calq_ops,
+						CFS_CALQ_FLAG_ATOMIC_GROW |
+						CFS_CALQ_FLAG_FIXED,
+						NRS_ORR_CALQ_ROUNDS, 1, NULL,
+						nrs_pol2cptab(policy),
+						nrs_pol2cptid(policy));
+		if (orrd->od_calq == NULL)
+			GOTO(out_orrd, rc = -ENOMEM);
+	} else {
+		orrd->od_binheap = cfs_binheap_create(&nrs_orr_heap_ops,
+						      CBH_FLAG_ATOMIC_GROW,
+						      4096, NULL,
+						      nrs_pol2cptab(policy),
+						      nrs_pol2cptid(policy));
+		if (orrd->od_binheap == NULL)
+			GOTO(out_orrd, rc = -ENOMEM);
+	}
 
 	nrs_orr_genobjname(policy, orrd->od_objname);
 
@@ -695,7 +800,10 @@ static int nrs_orr_start(struct ptlrpc_nrs_policy *policy, char *arg)
 out_cache:
 	kmem_cache_destroy(orrd->od_cache);
 out_binheap:
-	cfs_binheap_destroy(orrd->od_binheap);
+	if (orrd->od_calq != NULL)
+		cfs_calq_destroy(orrd->od_calq);
+	else
+		cfs_binheap_destroy(orrd->od_binheap);
 out_orrd:
 	OBD_FREE_PTR(orrd);
 
@@ -717,12 +825,17 @@ static void nrs_orr_stop(struct ptlrpc_nrs_policy *policy)
 	ENTRY;
 
 	LASSERT(orrd != NULL);
-	LASSERT(orrd->od_binheap != NULL);
+	LASSERT(orrd->od_binheap != NULL || orrd->od_calq != NULL);
 	LASSERT(orrd->od_obj_hash != NULL);
 	LASSERT(orrd->od_cache != NULL);
-	LASSERT(cfs_binheap_is_empty(orrd->od_binheap));
 
-	cfs_binheap_destroy(orrd->od_binheap);
+	if (orrd->od_calq != NULL) {
+		LASSERT(cfs_calq_is_empty(orrd->od_calq));
+		cfs_calq_destroy(orrd->od_calq);
+	} else {
+		LASSERT(cfs_binheap_is_empty(orrd->od_binheap));
+		cfs_binheap_destroy(orrd->od_binheap);
+	}
 	cfs_hash_putref(orrd->od_obj_hash);
 	kmem_cache_destroy(orrd->od_cache);
 
@@ -943,21 +1056,18 @@ struct ptlrpc_nrs_request *nrs_orr_req_get(struct ptlrpc_nrs_policy *policy,
 					   bool peek, bool force)
 {
 	struct nrs_orr_data	  *orrd = policy->pol_private;
-	struct cfs_binheap_node	  *node = cfs_binheap_root(orrd->od_binheap);
-	struct ptlrpc_nrs_request *nrq;
-
-	nrq = unlikely(node == NULL) ? NULL :
-	      container_of(node, struct ptlrpc_nrs_request, nr_node);
+	struct ptlrpc_nrs_request *nrq = nrs_orr_queue_first(orrd);
 
 	if (likely(!peek && nrq != NULL)) {
 		struct nrs_orr_object *orro;
+		struct ptlrpc_nrs_request *next;
 
 		orro = container_of(nrs_request_resource(nrq),
 				    struct nrs_orr_object, oo_res);
 
 		LASSERT(nrq->nr_u.orr.or_round <= orro->oo_round);
 
-		cfs_binheap_remove(orrd->od_binheap, &nrq->nr_node);
+		nrs_orr_queue_remove(orrd, nrq);
 		orro->oo_active--;
 
 		if (strncmp(policy->pol_desc->pd_name, NRS_POL_NAME_ORR,
@@ -977,17 +1087,12 @@ struct ptlrpc_nrs_request *nrs_orr_req_get(struct ptlrpc_nrs_policy *policy,
 			       nrq->nr_u.orr.or_round);
 
 		/** Peek at the next request to be served */
-		node = cfs_binheap_root(orrd->od_binheap);
+		next = nrs_orr_queue_first(orrd);
 
 		/** No more requests */
-		if (unlikely(node == NULL)) {
+		if (unlikely(next == NULL)) {
 			orrd->od_round++;
 		} else {
-			struct ptlrpc_nrs_request *next;
-
-			next = container_of(node, struct ptlrpc_nrs_request,
-					    nr_node);
-
 			if (orrd->od_round < next->nr_u.orr.or_round)
 				orrd->od_round = next->nr_u.orr.or_round;
 		}
@@ -1077,7 +1182,7 @@ static int nrs_orr_req_add(struct ptlrpc_nrs_policy *policy,
 	nrq->nr_u.orr.or_round = orro->oo_round;
 	nrq->nr_u.orr.or_sequence = orro->oo_sequence;
 
-	rc = cfs_binheap_insert(orrd->od_binheap, &nrq->nr_node);
+	rc = nrs_orr_queue_insert(orrd, nrq);
 	if (rc == 0) {
 		orro->oo_active++;
 		if (--orro->oo_quantum == 0)
@@ -1107,9 +1212,9 @@ static void nrs_orr_req_del(struct ptlrpc_nrs_policy *policy,
 
 	LASSERT(nrq->nr_u.orr.or_round <= orro->oo_round);
 
-	is_root = &nrq->nr_node == cfs_binheap_root(orrd->od_binheap);
+	is_root = nrq == nrs_orr_queue_first(orrd);
 
-	cfs_binheap_remove(orrd->od_binheap, &nrq->nr_node);
+	nrs_orr_queue_remove(orrd, nrq);
 	orro->oo_active--;
 
 	/**
@@ -1118,15 +1223,12 @@ static void nrs_orr_req_del(struct ptlrpc_nrs_policy *policy,
 	 */
 	if (unlikely(is_root)) {
 		/** Peek at the next request to be served */
-		struct cfs_binheap_node *node = cfs_binheap_root(orrd->od_binheap);
+		nrq = nrs_orr_queue_first(orrd);
 
 		/** No more requests */
-		if (unlikely(node == NULL)) {
+		if (unlikely(nrq == NULL)) {
 			orrd->od_round++;
 		} else {
-			nrq = container_of(node, struct ptlrpc_nrs_request,
-					   nr_node);
-
 			if (orrd->od_round < nrq->nr_u.orr.or_round)
 				orrd->od_round = nrq->nr_u.orr.or_round;
 		}
@@ -67,6 +67,14 @@ static int tbf_depth = 3;
 module_param(tbf_depth, int, 0644);
 MODULE_PARM_DESC(tbf_depth, "How many tokens that a client can save up");
 
+static int tbf_calendar_queue;
+module_param(tbf_calendar_queue, int, 0644);
+MODULE_PARM_DESC(tbf_calendar_queue,
+		 "Schedule TBF queues with a calendar queue instead of a binary heap");
+
+/** Initial width of a calendar queue day, in nanoseconds */
+#define NRS_TBF_CALQ_WIDTH	(100 * NSEC_PER_USEC)
+
 static enum hrtimer_restart nrs_tbf_timer_cb(struct hrtimer *timer)
 {
 	struct nrs_tbf_head *head = container_of(timer, struct nrs_tbf_head,
@@ -124,6 +132,129 @@ nrs_tbf_cli_rule_put(struct nrs_tbf_client *cli)
 	cli->tc_rule = NULL;
 }
 
+/**
+ * Binary heap predicate.
+ *
+ * \param[in] e1 the first binheap node to compare
+ * \param[in] e2 the second binheap node to compare
+ *
+ * \retval 0 e1 > e2
+ * \retval 1 e1 < e2
+ */
+static int
+tbf_cli_compare(struct cfs_binheap_node *e1, struct cfs_binheap_node *e2)
+{
+	struct nrs_tbf_client *cli1;
+	struct nrs_tbf_client *cli2;
+
+	cli1 = container_of(e1, struct nrs_tbf_client, tc_node);
+	cli2 = container_of(e2, struct nrs_tbf_client, tc_node);
+
+	if (cli1->tc_deadline < cli2->tc_deadline)
+		return 1;
+	else if (cli1->tc_deadline > cli2->tc_deadline)
+		return 0;
+
+	if (cli1->tc_check_time < cli2->tc_check_time)
+		return 1;
+	else if (cli1->tc_check_time > cli2->tc_check_time)
+		return 0;
+
+	/* Maybe need more comparasion, e.g. request number in the rules */
+	return 1;
+}
+
+/**
+ * TBF binary heap operations
+ */
+static struct cfs_binheap_ops nrs_tbf_heap_ops = {
+	.hop_enter	= NULL,
+	.hop_exit	= NULL,
+	.hop_compare	= tbf_cli_compare,
+};
+
+/**
+ * Calendar queue predicate, ordering clients with the same deadline.
+ *
+ * \param[in] e1 the first calendar queue node to compare
+ * \param[in] e2 the second calendar queue node to compare
+ *
+ * \retval 0 e1 > e2
+ * \retval 1 e1 < e2
+ */
+static int
+tbf_cli_calq_compare(struct cfs_calq_node *e1, struct cfs_calq_node *e2)
+{
+	struct nrs_tbf_client *cli1;
+	struct nrs_tbf_client *cli2;
+
+	cli1 = container_of(e1, struct nrs_tbf_client, tc_cqnode);
+	cli2 = container_of(e2, struct nrs_tbf_client, tc_cqnode);
+
+	return tbf_cli_compare(&cli1->tc_node, &cli2->tc_node);
+}
+
+/**
+ * TBF calendar queue operations
+ */
+static struct cfs_calq_ops nrs_tbf_calq_ops = {
+	.cqo_compare	= tbf_cli_calq_compare,
+};
+
+/*
+ * The queues of clients are sorted by deadline either in a binary heap or in
+ * a calendar queue; the helpers below hide which one is in use.
+ */
+static int
+nrs_tbf_queue_insert(struct nrs_tbf_head *head, struct nrs_tbf_client *cli)
+{
+	if (head->th_calq == NULL)
+		return cfs_binheap_insert(head->th_binheap, &cli->tc_node);
+
+	cli->tc_cqnode.cqn_key = cli->tc_deadline;
+	cfs_calq_insert(head->th_calq, &cli->tc_cqnode);
+	return 0;
+}
+
+static void
+nrs_tbf_queue_remove(struct nrs_tbf_head *head, struct nrs_tbf_client *cli)
+{
+	if (head->th_calq == NULL)
+		cfs_binheap_remove(head->th_binheap, &cli->tc_node);
+	else
+		cfs_calq_remove(head->th_calq, &cli->tc_cqnode);
+}
+
+static void
+nrs_tbf_queue_relocate(struct nrs_tbf_head *head, struct nrs_tbf_client *cli)
+{
+	if (head->th_calq == NULL) {
+		cfs_binheap_relocate(head->th_binheap, &cli->tc_node);
+	} else {
+		cli->tc_cqnode.cqn_key = cli->tc_deadline;
+		cfs_calq_relocate(head->th_calq, &cli->tc_cqnode);
+	}
+}
+
+static struct nrs_tbf_client *
+nrs_tbf_queue_first(struct nrs_tbf_head *head)
+{
+	struct cfs_binheap_node *node;
+	struct cfs_calq_node *cqnode;
+
+	if (head->th_calq == NULL) {
+		node = cfs_binheap_root(head->th_binheap);
+		if (node == NULL)
+			return NULL;
+		return container_of(node, struct nrs_tbf_client, tc_node);
+	}
+
+	cqnode = cfs_calq_first(head->th_calq);
+	if (cqnode == NULL)
+		return NULL;
+	return container_of(cqnode, struct nrs_tbf_client, tc_cqnode);
+}
+
 static void
 nrs_tbf_cli_reset_value(struct nrs_tbf_head *head,
 			struct nrs_tbf_client *cli)
@@ -140,8 +271,7 @@ nrs_tbf_cli_reset_value(struct nrs_tbf_head *head,
 	cli->tc_rule_generation = rule->tr_generation;
 
 	if (cli->tc_in_heap)
-		cfs_binheap_relocate(head->th_binheap,
-				     &cli->tc_node);
+		nrs_tbf_queue_relocate(head, cli);
 }
 
 static void
@@ -505,47 +635,6 @@ nrs_tbf_command(struct ptlrpc_nrs_policy *policy,
 	}
 }
 
-/**
- * Binary heap predicate.
- *
- * \param[in] e1 the first binheap node to compare
- * \param[in] e2 the second binheap node to compare
- *
- * \retval 0 e1 > e2
- * \retval 1 e1 < e2
- */
-static int
-tbf_cli_compare(struct cfs_binheap_node *e1, struct cfs_binheap_node *e2)
-{
-	struct nrs_tbf_client *cli1;
-	struct nrs_tbf_client *cli2;
-
-	cli1 = container_of(e1, struct nrs_tbf_client, tc_node);
-	cli2 = container_of(e2, struct nrs_tbf_client, tc_node);
-
-	if (cli1->tc_deadline < cli2->tc_deadline)
-		return 1;
-	else if (cli1->tc_deadline > cli2->tc_deadline)
-		return 0;
-
-	if (cli1->tc_check_time < cli2->tc_check_time)
-		return 1;
-	else if (cli1->tc_check_time > cli2->tc_check_time)
-		return 0;
-
-	/* Maybe need more comparasion, e.g. request number in the rules */
-	return 1;
-}
-
-/**
- * TBF binary heap operations
- */
-static struct cfs_binheap_ops nrs_tbf_heap_ops = {
-	.hop_enter	= NULL,
-	.hop_exit	= NULL,
-	.hop_compare	= tbf_cli_compare,
-};
-
 static unsigned nrs_tbf_jobid_hop_hash(struct cfs_hash *hs, const void *key,
 				  unsigned mask)
 {
@@ -1433,6 +1522,8 @@ static struct req_format *req_fmt(__u32 opcode)
 		return &RQF_OST_SYNC;
 	case OST_LADVISE:
 		return &RQF_OST_LADVISE;
+	case OST_BATCH_GLIMPSE:
+		return &RQF_OST_BATCH_GLIMPSE;
 	case MDS_GETATTR:
 		return &RQF_MDS_GETATTR;
 	case MDS_GETATTR_NAME:
@@ -2794,12 +2885,24 @@ static int nrs_tbf_start(struct ptlrpc_nrs_policy *policy, char *arg)
 	head->th_ops = ops;
 	head->th_type_flag = type;
 
-	head->th_binheap = cfs_binheap_create(&nrs_tbf_heap_ops,
-					      CBH_FLAG_ATOMIC_GROW, 4096, NULL,
-					      nrs_pol2cptab(policy),
-					      nrs_pol2cptid(policy));
-	if (head->th_binheap == NULL)
-		GOTO(out_free_head, rc = -ENOMEM);
+	if (tbf_calendar_queue) {
+		head->th_calq = cfs_calq_create(&nrs_tbf_calq_ops,
+						CFS_CALQ_FLAG_ATOMIC_GROW,
+						CFS_CALQ_MIN_BUCKETS,
+						NRS_TBF_CALQ_WIDTH, NULL,
+						nrs_pol2cptab(policy),
+						nrs_pol2cptid(policy));
+		if (head->th_calq == NULL)
+			GOTO(out_free_head, rc = -ENOMEM);
+	} else {
+		head->th_binheap = cfs_binheap_create(&nrs_tbf_heap_ops,
+						      CBH_FLAG_ATOMIC_GROW,
+						      4096, NULL,
+						      nrs_pol2cptab(policy),
+						      nrs_pol2cptid(policy));
+		if (head->th_binheap == NULL)
+			GOTO(out_free_head, rc = -ENOMEM);
+	}
 
 	atomic_set(&head->th_rule_sequence, 0);
 	spin_lock_init(&head->th_rule_lock);
@@ -2813,7 +2916,10 @@ static int nrs_tbf_start(struct ptlrpc_nrs_policy *policy, char *arg)
 	policy->pol_private = head;
 	return 0;
 out_free_heap:
-	cfs_binheap_destroy(head->th_binheap);
+	if (head->th_calq != NULL)
+		cfs_calq_destroy(head->th_calq);
+	else
+		cfs_binheap_destroy(head->th_binheap);
 out_free_head:
 	OBD_FREE_PTR(head);
 out:
@@ -2845,9 +2951,14 @@ static void nrs_tbf_stop(struct ptlrpc_nrs_policy *policy)
 		nrs_tbf_rule_put(rule);
 	}
 	LASSERT(list_empty(&head->th_list));
-	LASSERT(head->th_binheap != NULL);
-	LASSERT(cfs_binheap_is_empty(head->th_binheap));
-	cfs_binheap_destroy(head->th_binheap);
+	if (head->th_calq != NULL) {
+		LASSERT(cfs_calq_is_empty(head->th_calq));
+		cfs_calq_destroy(head->th_calq);
+	} else {
+		LASSERT(head->th_binheap != NULL);
+		LASSERT(cfs_binheap_is_empty(head->th_binheap));
+		cfs_binheap_destroy(head->th_binheap);
+	}
 	OBD_FREE_PTR(head);
 	nrs->nrs_throttling = 0;
 	wake_up(&policy->pol_nrs->nrs_svcpt->scp_waitq);
@@ -3052,18 +3163,16 @@ struct ptlrpc_nrs_request *nrs_tbf_req_get(struct ptlrpc_nrs_policy *policy,
 	struct nrs_tbf_head	  *head = policy->pol_private;
 	struct ptlrpc_nrs_request *nrq = NULL;
 	struct nrs_tbf_client     *cli;
-	struct cfs_binheap_node	  *node;
 
 	assert_spin_locked(&policy->pol_nrs->nrs_svcpt->scp_req_lock);
 
 	if (!peek && policy->pol_nrs->nrs_throttling)
 		return NULL;
 
-	node = cfs_binheap_root(head->th_binheap);
-	if (unlikely(node == NULL))
+	cli = nrs_tbf_queue_first(head);
+	if (unlikely(cli == NULL))
 		return NULL;
 
-	cli = container_of(node, struct nrs_tbf_client, tc_node);
 	LASSERT(cli->tc_in_heap);
 	if (peek) {
 		nrq = list_entry(cli->tc_list.next,
@@ -3109,14 +3218,12 @@ struct ptlrpc_nrs_request *nrs_tbf_req_get(struct ptlrpc_nrs_policy *policy,
 			cli->tc_check_time = now;
 			list_del_init(&nrq->nr_u.tbf.tr_list);
 			if (list_empty(&cli->tc_list)) {
-				cfs_binheap_remove(head->th_binheap,
-						   &cli->tc_node);
+				nrs_tbf_queue_remove(head, cli);
 				cli->tc_in_heap = false;
 			} else {
 				if (!(rule->tr_flags & NTRS_REALTIME))
 					cli->tc_deadline = now + cli->tc_nsecs;
-				cfs_binheap_relocate(head->th_binheap,
-						     &cli->tc_node);
+				nrs_tbf_queue_relocate(head, cli);
 			}
 			CDEBUG(D_RPCTRACE,
 			       "TBF dequeues: class@%p rate %llu gen %llu "
@@ -3131,9 +3238,8 @@ struct ptlrpc_nrs_request *nrs_tbf_req_get(struct ptlrpc_nrs_policy *policy,
 			if (rule->tr_flags & NTRS_REALTIME) {
 				cli->tc_deadline = deadline;
 				cli->tc_nsecs_resid = old_resid;
-				cfs_binheap_relocate(head->th_binheap,
-						     &cli->tc_node);
-				if (node != cfs_binheap_root(head->th_binheap))
+				nrs_tbf_queue_relocate(head, cli);
+				if (cli != nrs_tbf_queue_first(head))
 					return nrs_tbf_req_get(policy,
 							       peek, force);
 			}
@@ -3173,7 +3279,7 @@ static int nrs_tbf_req_add(struct ptlrpc_nrs_policy *policy,
 	if (list_empty(&cli->tc_list)) {
 		LASSERT(!cli->tc_in_heap);
 		cli->tc_deadline = cli->tc_check_time + cli->tc_nsecs;
-		rc = cfs_binheap_insert(head->th_binheap, &cli->tc_node);
+		rc = nrs_tbf_queue_insert(head, cli);
 		if (rc == 0) {
 			cli->tc_in_heap = true;
 			nrq->nr_u.tbf.tr_sequence = head->th_sequence++;
@@ -3234,12 +3340,10 @@ static void nrs_tbf_req_del(struct ptlrpc_nrs_policy *policy,
 	LASSERT(!list_empty(&nrq->nr_u.tbf.tr_list));
 	list_del_init(&nrq->nr_u.tbf.tr_list);
 	if (list_empty(&cli->tc_list)) {
-		cfs_binheap_remove(head->th_binheap,
-				   &cli->tc_node);
+		nrs_tbf_queue_remove(head, cli);
 		cli->tc_in_heap = false;
 	} else {
-		cfs_binheap_relocate(head->th_binheap,
-				     &cli->tc_node);
+		nrs_tbf_queue_relocate(head, cli);
 	}
 }
 
@@ -1908,6 +1908,15 @@ void lustre_swab_ost_lvb(struct ost_lvb *lvb)
 }
 EXPORT_SYMBOL(lustre_swab_ost_lvb);
 
+void lustre_swab_ost_glimpse_rec(struct ost_glimpse_rec *ogr)
+{
+	lustre_swab_ost_id(&ogr->ogr_oi);
+	__swab32s(&ogr->ogr_rc);
+	__swab32s(&ogr->ogr_padding);
+	lustre_swab_ost_lvb(&ogr->ogr_lvb);
+}
+EXPORT_SYMBOL(lustre_swab_ost_glimpse_rec);
+
 void lustre_swab_lquota_lvb(struct lquota_lvb *lvb)
 {
 	__swab64s(&lvb->lvb_flags);
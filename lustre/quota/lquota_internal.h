@@ -147,6 +147,22 @@ struct lquota_slv_entry {
 
 	/* when latest edquot set */
 	time64_t		lse_edquot_time;
+
+	/* estimated consumption rate, in inodes or kbytes per second */
+	__u64			lse_rate;
+
+	/* space consumed since lse_rate_time, not yet folded in lse_rate */
+	__u64			lse_rate_space;
+
+	/* when lse_rate was last updated */
+	time64_t		lse_rate_time;
+
+	/* # operations which had to wait for the master to grant space */
+	__u64			lse_wait_count;
+
+	/* total and longest time spent waiting for space, in usecs */
+	__u64			lse_wait_total;
+	__u64			lse_wait_max;
 };
 
 /* In-memory entry for each enforced quota id
@@ -228,6 +244,12 @@ struct lquota_site {
 #define lqe_acq_rc		u.se.lse_acq_rc
 #define lqe_acq_time		u.se.lse_acq_time
 #define lqe_edquot_time		u.se.lse_edquot_time
+#define lqe_rate		u.se.lse_rate
+#define lqe_rate_space		u.se.lse_rate_space
+#define lqe_rate_time		u.se.lse_rate_time
+#define lqe_wait_count		u.se.lse_wait_count
+#define lqe_wait_total		u.se.lse_wait_total
+#define lqe_wait_max		u.se.lse_wait_max
 
 #define LQUOTA_BUMP_VER 0x1
 #define LQUOTA_SET_VER  0x2
@@ -263,9 +263,12 @@ static bool qsd_calc_adjust(struct lquota_entry *lqe, struct quota_body *qbody)
 		qbody->qb_flags = QUOTA_DQACQ_FL_REPORT;
 	}
 
-	/* 3. Time to pre-acquire? */
+	/* 3. Time to pre-acquire? Owning qtune of spare space is the minimum,
+	 * IDs consuming space quickly should own enough to cover the prefetch
+	 * window */
 	if (!lqe->lqe_edquot && !lqe->lqe_nopreacq && usage > 0 &&
-	    lqe->lqe_qunit != 0 && granted < usage + lqe->lqe_qtune) {
+	    lqe->lqe_qunit != 0 &&
+	    granted < usage + max(lqe->lqe_qtune, qsd_prefetch_space(lqe))) {
 		/* To pre-acquire quota space, we report how much spare quota
 		 * space the slave currently owns, then the master will grant us
 		 * back how much we can pretend given the current state of
@@ -504,9 +507,10 @@ static inline bool qsd_calc_acquire(struct lquota_entry *lqe,
 		granted = lqe->lqe_usage;
 	}
 
-	/* acquire as much as needed, but not more */
+	/* acquire as much as needed, plus what this ID is expected to consume
+	 * shortly, so that no pre-acquire request has to follow */
 	if (usage > granted) {
-		qbody->qb_count  = usage - granted;
+		qbody->qb_count  = usage - granted + qsd_prefetch_space(lqe);
 		qbody->qb_flags |= QUOTA_DQACQ_FL_ACQ;
 	}
 
@@ -622,12 +626,13 @@ static int qsd_acquire_remote(const struct lu_env *env,
  * \param lqe   - is the qid entry to be processed
  * \param space - is the amount of quota required for the operation
  * \param ret   - is the return code (-EDQUOT, -EINPROGRESS, ...)
+ * \param waited - set to true if local quota space was not enough
  *
  * \retval true  - exit from l_wait_event and real return value in \a ret
  * \retval false - continue waiting
  */
 static bool qsd_acquire(const struct lu_env *env, struct lquota_entry *lqe,
-			long long space, int *ret)
+			long long space, int *ret, bool *waited)
 {
 	int rc = 0, count;
 	ENTRY;
@@ -651,6 +656,7 @@ static bool qsd_acquire(const struct lu_env *env, struct lquota_entry *lqe,
 			/* rc == 0, Wouhou! enough local quota space
 			 * rc < 0, something bad happened */
 			 break;
+		*waited = true;
 
 		/* if we have gotten some quota and stil wait more quota,
 		 * it's better to give QMT some time to reclaim from clients */
@@ -663,13 +669,46 @@ static bool qsd_acquire(const struct lu_env *env, struct lquota_entry *lqe,
 		rc = qsd_acquire_remote(env, lqe);
 	}
 
-	if (rc == -EBUSY)
+	if (rc == -EBUSY) {
 		/* already a request in flight, continue waiting */
+		*waited = true;
 		RETURN(false);
+	}
 	*ret = rc;
 	RETURN(true); /* exit from l_wait_event */
 }
 
+/**
+ * Account \a space consumed by an operation in the consumption rate estimate
+ * of \a lqe. Space is summed up over one second, then folded into a moving
+ * average weighting the last second by 1/4.
+ * Called with the lqe write lock held.
+ */
+static void qsd_update_rate(struct lquota_entry *lqe, __u64 space)
+{
+	time64_t	now = ktime_get_seconds();
+	time64_t	elapsed = now - lqe->lqe_rate_time;
+	__u64		sample;
+
+	if (lqe->lqe_rate_time == 0 || elapsed > QSD_WB_INTERVAL) {
+		/* first operation, or idle for long: start over */
+		lqe->lqe_rate = 0;
+		lqe->lqe_rate_space = space;
+		lqe->lqe_rate_time = now;
+		return;
+	}
+
+	if (elapsed == 0) {
+		lqe->lqe_rate_space += space;
+		return;
+	}
+
+	sample = div_u64(lqe->lqe_rate_space, elapsed);
+	lqe->lqe_rate = (lqe->lqe_rate * 3 + sample) >> 2;
+	lqe->lqe_rate_space = space;
+	lqe->lqe_rate_time = now;
+}
+
 /**
  * Quota enforcement handler. If local quota can satisfy this operation,
  * return success, otherwise, acquire more quota from master.
@@ -695,6 +734,8 @@ static int qsd_op_begin0(const struct lu_env *env, struct qsd_qtype_info *qqi,
 {
 	struct lquota_entry *lqe;
 	struct l_wait_info lwi;
+	ktime_t start;
+	bool waited = false;
 	int qtype_flag = 0;
 	int rc, ret = -EINPROGRESS;
 	ENTRY;
@@ -733,14 +774,29 @@ static int qsd_op_begin0(const struct lu_env *env, struct qsd_qtype_info *qqi,
 
 	lqe_write_lock(lqe);
 	lqe->lqe_waiting_write += space;
+	qsd_update_rate(lqe, space);
 	lqe_write_unlock(lqe);
 
 	/* acquire quota space for the operation, cap overall wait time to
 	 * prevent a service thread from being stuck for too long */
 	lwi = LWI_TIMEOUT(cfs_time_seconds(qsd_wait_timeout(qqi->qqi_qsd)),
 			  NULL, NULL);
-	rc = l_wait_event(lqe->lqe_waiters, qsd_acquire(env, lqe, space, &ret),
-			  &lwi);
+	start = ktime_get();
+	rc = l_wait_event(lqe->lqe_waiters,
+			  qsd_acquire(env, lqe, space, &ret, &waited), &lwi);
+
+	if (waited) {
+		/* account time spent waiting for the master */
+		__u64 wait = ktime_us_delta(ktime_get(), start);
+
+		lqe_write_lock(lqe);
+		lqe->lqe_wait_count++;
+		lqe->lqe_wait_total += wait;
+		if (wait > lqe->lqe_wait_max)
+			lqe->lqe_wait_max = wait;
+		lqe_write_unlock(lqe);
+		LQUOTA_DEBUG(lqe, "waited %llu usecs for quota space", wait);
+	}
 
 	if (rc == 0 && ret == 0) {
 		qid->lqi_space += space;
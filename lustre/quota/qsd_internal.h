@@ -104,6 +104,11 @@ struct qsd_instance {
 	 * enforced here (via procfs) */
 	int			 qsd_timeout;
 
+	/* how many seconds of consumption, at the rate estimated for each ID,
+	 * should be acquired ahead of time from the master. 0 disables
+	 * rate-based prefetch */
+	int			 qsd_prefetch_window;
+
 	unsigned long		qsd_is_md:1,    /* managing quota for mdt */
 				qsd_started:1,  /* instance is now started */
 				qsd_prepared:1, /* qsd_prepare() successfully
@@ -329,6 +334,24 @@ static inline void qsd_set_edquot(struct lquota_entry *lqe, bool edquot)
 
 #define QSD_WB_INTERVAL	60 /* 60 seconds */
 
+#define QSD_PREFETCH_WINDOW	1 /* 1 second */
+
+/* helper function returning how much quota space should be owned on top of
+ * current usage in order to absorb the next qsd_prefetch_window seconds of
+ * consumption for this ID without asking the master. This is capped to qunit,
+ * which is the most the master is willing to leave on a single slave */
+static inline __u64 qsd_prefetch_space(struct lquota_entry *lqe)
+{
+	struct qsd_instance	*qsd = lqe2qqi(lqe)->qqi_qsd;
+
+	if (qsd->qsd_prefetch_window <= 0 || lqe->lqe_edquot ||
+	    lqe->lqe_nopreacq)
+		return 0;
+
+	return min_t(__u64, lqe->lqe_rate * qsd->qsd_prefetch_window,
+		     lqe->lqe_qunit);
+}
+
 /* helper function calculating how long a service thread should be waiting for
  * quota space */
 static inline int qsd_wait_timeout(struct qsd_instance *qsd)
@@ -264,6 +264,119 @@ qsd_timeout_seq_write(struct file *file, const char __user *buffer,
 }
 LPROC_SEQ_FOPS(qsd_timeout);
 
+static int qsd_prefetch_window_seq_show(struct seq_file *m, void *data)
+{
+	struct qsd_instance *qsd = m->private;
+	LASSERT(qsd != NULL);
+
+	seq_printf(m, "%d\n", qsd->qsd_prefetch_window);
+	return 0;
+}
+
+static ssize_t
+qsd_prefetch_window_seq_write(struct file *file, const char __user *buffer,
+			      size_t count, loff_t *off)
+{
+	struct qsd_instance *qsd = ((struct seq_file *)file->private_data)->private;
+	int window;
+	int rc;
+
+	LASSERT(qsd != NULL);
+	rc = kstrtoint_from_user(buffer, count, 0, &window);
+	if (rc)
+		return rc;
+
+	if (window < 0 || window > QSD_WB_INTERVAL)
+		return -EINVAL;
+
+	qsd->qsd_prefetch_window = window;
+	return count;
+}
+LPROC_SEQ_FOPS(qsd_prefetch_window);
+
+struct qsd_acquire_stats_data {
+	struct seq_file	*qasd_seq;
+	int		 qasd_qtype;
+	bool		 qasd_clear;
+};
+
+static int qsd_acquire_stats_cb(struct cfs_hash *hs, struct cfs_hash_bd *bd,
+				struct hlist_node *hnode, void *data)
+{
+	struct qsd_acquire_stats_data	*d = data;
+	struct lquota_entry		*lqe;
+
+	lqe = hlist_entry(hnode, struct lquota_entry, lqe_hash);
+
+	if (d->qasd_clear) {
+		lqe_write_lock(lqe);
+		lqe->lqe_wait_count = 0;
+		lqe->lqe_wait_total = 0;
+		lqe->lqe_wait_max = 0;
+		lqe_write_unlock(lqe);
+		return 0;
+	}
+
+	lqe_read_lock(lqe);
+	if (lqe->lqe_wait_count != 0 || lqe->lqe_rate != 0)
+		seq_printf(d->qasd_seq, "- %-3s %-10llu rate: %-10llu "
+			   "waits: %-10llu wait_total_us: %-12llu "
+			   "wait_max_us: %llu\n",
+			   qtype_name(d->qasd_qtype), lqe->lqe_id.qid_uid,
+			   lqe->lqe_rate, lqe->lqe_wait_count,
+			   lqe->lqe_wait_total, lqe->lqe_wait_max);
+	lqe_read_unlock(lqe);
+	return 0;
+}
+
+static void qsd_acquire_stats_iterate(struct qsd_instance *qsd,
+				      struct qsd_acquire_stats_data *d)
+{
+	int qtype;
+
+	read_lock(&qsd->qsd_lock);
+	if (!qsd->qsd_prepared) {
+		read_unlock(&qsd->qsd_lock);
+		return;
+	}
+	read_unlock(&qsd->qsd_lock);
+
+	for (qtype = USRQUOTA; qtype < LL_MAXQUOTAS; qtype++) {
+		struct qsd_qtype_info *qqi = qsd->qsd_type_array[qtype];
+
+		if (qqi == NULL || qqi->qqi_site == NULL)
+			continue;
+		d->qasd_qtype = qtype;
+		cfs_hash_for_each(qqi->qqi_site->lqs_hash,
+				  qsd_acquire_stats_cb, d);
+	}
+}
+
+/* per-ID consumption rate and time spent by service threads waiting for the
+ * master to grant quota space; writing anything resets the wait counters */
+static int qsd_acquire_stats_seq_show(struct seq_file *m, void *data)
+{
+	struct qsd_instance		*qsd = m->private;
+	struct qsd_acquire_stats_data	 d = { .qasd_seq = m };
+
+	LASSERT(qsd != NULL);
+	qsd_acquire_stats_iterate(qsd, &d);
+	return 0;
+}
+
+static ssize_t
+qsd_acquire_stats_seq_write(struct file *file, const char __user *buffer,
+			    size_t count, loff_t *off)
+{
+	struct qsd_instance *qsd = ((struct seq_file *)file->private_data)->private;
+	struct qsd_acquire_stats_data d = { .qasd_clear = true };
+
+	LASSERT(qsd != NULL);
+	qsd_acquire_stats_iterate(qsd, &d);
+	return count;
+}
+LPROC_SEQ_FOPS(qsd_acquire_stats);
+
 static struct lprocfs_vars lprocfs_quota_qsd_vars[] = {
 	{ .name	=	"info",
 	  .fops	=	&qsd_state_fops		},
@@ -273,6 +386,10 @@ static struct lprocfs_vars lprocfs_quota_qsd_vars[] = {
 	  .fops	=	&qsd_force_reint_fops	},
 	{ .name	=	"timeout",
 	  .fops	=	&qsd_timeout_fops	},
+	{ .name	=	"prefetch_window",
+	  .fops	=	&qsd_prefetch_window_fops	},
+	{ .name	=	"acquire_stats",
+	  .fops	=	&qsd_acquire_stats_fops	},
 	{ NULL }
 };
 
@@ -670,6 +787,7 @@ struct qsd_instance *qsd_init(const struct lu_env *env, char *svname,
 	qsd->qsd_prepared = false;
 	qsd->qsd_started = false;
 	qsd->qsd_is_md = is_md;
+	qsd->qsd_prefetch_window = QSD_PREFETCH_WINDOW;
 
 	/* copy service name */
 	if (strlcpy(qsd->qsd_svname, svname, sizeof(qsd->qsd_svname))
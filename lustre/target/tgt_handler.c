@@ -1370,6 +1370,21 @@ int tgt_enqueue(struct tgt_session_info *tsi)
 }
 EXPORT_SYMBOL(tgt_enqueue);
 
+/**
+ * Grant a PR lock on a whole object for a request batching lock requests,
+ * see ldlm_handle_enqueue_nowait().
+ */
+int tgt_enqueue_nowait(struct tgt_session_info *tsi,
+		       const struct ldlm_res_id *res_id,
+		       const struct lustre_handle *remote,
+		       struct lustre_handle *lockh, void *lvb, int *lvb_len)
+{
+	return ldlm_handle_enqueue_nowait(tsi->tsi_exp->exp_obd->obd_namespace,
+					  tsi->tsi_exp, res_id, remote,
+					  &tgt_dlm_cbs, lockh, lvb, lvb_len);
+}
+EXPORT_SYMBOL(tgt_enqueue_nowait);
+
 int tgt_convert(struct tgt_session_info *tsi)
 {
 	struct ptlrpc_request *req = tgt_ses_req(tsi);
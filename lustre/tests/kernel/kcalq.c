@@ -0,0 +1,240 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+
+/* Compare the binary heap and the calendar queue used by the NRS
+ * policies. Both are run through the same "hold" workload: the queue
+ * is filled with n elements, then the smallest element is
+ * repeatedly dequeued and requeued with a later key, the way TBF
+ * moves a client deadline forward. This is done for 10^3 elements,
+ * then 10 times more up to max_nodes, and the average cost of one
+ * dequeue/enqueue pair is printed for each structure. The order in
+ * which both structures return the keys is also checked.  */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/vmalloc.h>
+#include <linux/ktime.h>
+#include <libcfs/libcfs.h>
+
+/* Random ID passed by userspace, and printed in messages, used to
+ * separate different runs of that module. */
+static int run_id;
+module_param(run_id, int, 0644);
+MODULE_PARM_DESC(run_id, "run ID");
+
+/* Largest number of queued elements to test with. */
+static unsigned int max_nodes = 1000000;
+module_param(max_nodes, uint, 0644);
+MODULE_PARM_DESC(max_nodes, "largest number of queued elements");
+
+/* Number of dequeue/enqueue pairs timed for each queue size. */
+static unsigned int nops = 1000000;
+module_param(nops, uint, 0644);
+MODULE_PARM_DESC(nops, "number of dequeue/enqueue pairs per run");
+
+#define PREFIX "lustre_kcalq_%u:"
+
+/* Keys are spread like TBF deadlines, in nanoseconds. */
+#define KCALQ_KEY_SPREAD	(10 * NSEC_PER_MSEC)
+
+struct kcalq_elem {
+	struct cfs_binheap_node	ke_hnode;
+	struct cfs_calq_node	ke_cqnode;
+	__u64			ke_key;
+};
+
+static int kcalq_heap_compare(struct cfs_binheap_node *a,
+			      struct cfs_binheap_node *b)
+{
+	return container_of(a, struct kcalq_elem, ke_hnode)->ke_key <
+	       container_of(b, struct kcalq_elem, ke_hnode)->ke_key;
+}
+
+static struct cfs_binheap_ops kcalq_heap_ops = {
+	.hop_compare	= kcalq_heap_compare,
+};
+
+static struct cfs_calq_ops kcalq_calq_ops = {
+	.cqo_compare	= NULL,
+};
+
+/* Small LCG, so that both runs see exactly the same keys. */
+static inline __u64 kcalq_rand(__u64 *seed)
+{
+	*seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+	return *seed >> 33;
+}
+
+static void kcalq_fill(struct kcalq_elem *elems, unsigned int n)
+{
+	__u64 seed = run_id;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		elems[i].ke_key = kcalq_rand(&seed) % KCALQ_KEY_SPREAD;
+}
+
+/* Returns the time taken in ns, and the sum of the dequeued keys,
+ * weighted by their position, in \a check. */
+static s64 kcalq_run_heap(struct kcalq_elem *elems, unsigned int n,
+			  __u64 *check)
+{
+	struct cfs_binheap *h;
+	struct cfs_binheap_node *node;
+	struct kcalq_elem *e;
+	__u64 seed = run_id + 1;
+	ktime_t start;
+	unsigned int i;
+
+	h = cfs_binheap_create(&kcalq_heap_ops, 0, n, NULL, NULL, 0);
+	if (h == NULL)
+		return -ENOMEM;
+
+	kcalq_fill(elems, n);
+	for (i = 0; i < n; i++)
+		if (cfs_binheap_insert(h, &elems[i].ke_hnode) != 0)
+			break;
+
+	*check = 0;
+	start = ktime_get();
+	for (i = 0; i < nops; i++) {
+		node = cfs_binheap_remove_root(h);
+		e = container_of(node, struct kcalq_elem, ke_hnode);
+		*check += e->ke_key * (i + 1);
+		e->ke_key += kcalq_rand(&seed) % KCALQ_KEY_SPREAD;
+		cfs_binheap_insert(h, &e->ke_hnode);
+	}
+	start = ktime_sub(ktime_get(), start);
+
+	while (cfs_binheap_remove_root(h) != NULL)
+		;
+	cfs_binheap_destroy(h);
+
+	return ktime_to_ns(start);
+}
+
+static s64 kcalq_run_calq(struct kcalq_elem *elems, unsigned int n,
+			  __u64 *check)
+{
+	struct cfs_calq *q;
+	struct cfs_calq_node *node;
+	struct kcalq_elem *e;
+	__u64 seed = run_id + 1;
+	ktime_t start;
+	unsigned int i;
+
+	q = cfs_calq_create(&kcalq_calq_ops, 0, CFS_CALQ_MIN_BUCKETS,
+			    KCALQ_KEY_SPREAD / n + 1, NULL, NULL, 0);
+	if (q == NULL)
+		return -ENOMEM;
+
+	kcalq_fill(elems, n);
+	for (i = 0; i < n; i++) {
+		elems[i].ke_cqnode.cqn_key = elems[i].ke_key;
+		cfs_calq_insert(q, &elems[i].ke_cqnode);
+	}
+
+	*check = 0;
+	start = ktime_get();
+	for (i = 0; i < nops; i++) {
+		node = cfs_calq_remove_first(q);
+		e = container_of(node, struct kcalq_elem, ke_cqnode);
+		*check += e->ke_key * (i + 1);
+		e->ke_key += kcalq_rand(&seed) % KCALQ_KEY_SPREAD;
+		e->ke_cqnode.cqn_key = e->ke_key;
+		cfs_calq_insert(q, &e->ke_cqnode);
+	}
+	start = ktime_sub(ktime_get(), start);
+
+	while (cfs_calq_remove_first(q) != NULL)
+		;
+	cfs_calq_destroy(q);
+
+	return ktime_to_ns(start);
+}
+
+static int __init kcalq_init(void)
+{
+	struct kcalq_elem *elems;
+	unsigned int n;
+	__u64 check_heap;
+	__u64 check_calq;
+	s64 t_heap;
+	s64 t_calq;
+	bool ok = true;
+
+	if (max_nodes < 1000 || nops == 0) {
+		pr_err(PREFIX " invalid parameters\n", run_id);
+		goto out;
+	}
+
+	elems = vmalloc(sizeof(*elems) * max_nodes);
+	if (elems == NULL) {
+		pr_err(PREFIX " cannot allocate %u elements\n", run_id,
+		       max_nodes);
+		goto out;
+	}
+
+	for (n = 1000; n <= max_nodes; n *= 10) {
+		t_heap = kcalq_run_heap(elems, n, &check_heap);
+		t_calq = kcalq_run_calq(elems, n, &check_calq);
+		if (t_heap < 0 || t_calq < 0) {
+			pr_err(PREFIX " %u elements: out of memory\n",
+			       run_id, n);
+			ok = false;
+			break;
+		}
+
+		pr_err(PREFIX " %u elements: binheap %llu ns/op, calq %llu ns/op\n",
+		       run_id, n, div_u64(t_heap, nops), div_u64(t_calq, nops));
+		if (check_heap != check_calq) {
+			pr_err(PREFIX " %u elements: dequeue order differs\n",
+			       run_id, n);
+			ok = false;
+		}
+
+		if (n > max_nodes / 10)
+			break;
+	}
+
+	vfree(elems);
+
+	/* below message is checked in sanity.sh test_423 */
+	if (ok)
+		pr_err(PREFIX " binheap and calq orders are identical\n",
+		       run_id);
+out:
+	/* Don't load. */
+	return -EINVAL;
+}
+
+static void __exit kcalq_exit(void)
+{
+}
+
+MODULE_AUTHOR("OpenSFS, Inc. <http://www.lustre.org/>");
+MODULE_DESCRIPTION("Lustre binary heap vs calendar queue benchmark");
+MODULE_VERSION(LUSTRE_VERSION_STRING);
+MODULE_LICENSE("GPL");
+
+module_init(kcalq_init);
+module_exit(kcalq_exit);
@@ -0,0 +1,226 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+
+/* Compare the two ways LOD picks an OST with a probability
+ * proportional to its weight: a scan of the cumulative weights, as
+ * done by lod_ost_alloc_qos(), and a draw from the alias table built
+ * by lu_qos_alias_build(). A storm of ncreates single stripe creates
+ * is replayed against synthetic sets of 16 OSTs, then 4 times more up
+ * to max_osts, where one OST in 8 is almost full and the others have
+ * random free space. The average cost of one pick is printed for
+ * both, and the OSTs drawn from the alias table are checked to follow
+ * the weights. */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/vmalloc.h>
+#include <linux/ktime.h>
+#include <libcfs/libcfs.h>
+#include <lu_object.h>
+
+/* Random ID passed by userspace, and printed in messages, used to
+ * separate different runs of that module. */
+static int run_id;
+module_param(run_id, int, 0644);
+MODULE_PARM_DESC(run_id, "run ID");
+
+/* Largest number of OSTs to test with. */
+static unsigned int max_osts = 4096;
+module_param(max_osts, uint, 0644);
+MODULE_PARM_DESC(max_osts, "largest number of OSTs");
+
+/* Number of creates replayed for each OST set. */
+static unsigned int ncreates = 1000000;
+module_param(ncreates, uint, 0644);
+MODULE_PARM_DESC(ncreates, "number of creates per run");
+
+#define PREFIX "lustre_kqos_%u:"
+
+/* Small LCG, so that each run sees the same OST set. */
+static inline __u64 kqos_rand(__u64 *seed)
+{
+	*seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+	return *seed >> 33;
+}
+
+/* Weights are in bytes, like ltq_weight. */
+static void kqos_fill(__u32 *tgts, __u64 *weights, unsigned int n)
+{
+	__u64 seed = run_id;
+	unsigned int i;
+
+	for (i = 0; i < n; i++) {
+		tgts[i] = i;
+		if (i % 8 == 7)
+			weights[i] = 1ULL << 20;
+		else
+			weights[i] = (kqos_rand(&seed) % 1024 + 1) << 30;
+	}
+}
+
+static s64 kqos_run_scan(const __u64 *weights, unsigned int n)
+{
+	__u64 total = 0;
+	__u64 rand, cur;
+	ktime_t start;
+	unsigned int i, j;
+	unsigned int sum = 0;
+
+	for (j = 0; j < n; j++)
+		total += weights[j];
+
+	start = ktime_get();
+	for (i = 0; i < ncreates; i++) {
+		rand = lu_prandom_u64_max(total);
+		cur = 0;
+		for (j = 0; j < n; j++) {
+			cur += weights[j];
+			if (cur >= rand)
+				break;
+		}
+		sum += j;
+	}
+	start = ktime_sub(ktime_get(), start);
+
+	/* keep the loop from being optimized out */
+	if (sum == 0 && n > 1)
+		pr_err(PREFIX " scan always picked the first OST\n", run_id);
+
+	return ktime_to_ns(start);
+}
+
+/* Returns the time taken in ns, and the number of times each OST was
+ * drawn in \a hits. */
+static s64 kqos_run_alias(const struct lu_qos_alias *lqa, __u32 *hits,
+			  unsigned int n)
+{
+	ktime_t start;
+	unsigned int i;
+
+	memset(hits, 0, sizeof(*hits) * n);
+	start = ktime_get();
+	for (i = 0; i < ncreates; i++)
+		hits[lu_qos_alias_draw(lqa)]++;
+	start = ktime_sub(ktime_get(), start);
+
+	return ktime_to_ns(start);
+}
+
+/* The sum of |hits - expected| over all OSTs grows like
+ * sqrt(n * ncreates), accept 5 times its expected value. */
+static bool kqos_check(const __u64 *weights, const __u32 *hits,
+		       unsigned int n)
+{
+	__u64 total = 0;
+	__u64 expected;
+	__u64 dev = 0;
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		total += weights[i] >> 20;
+
+	for (i = 0; i < n; i++) {
+		expected = div64_u64((weights[i] >> 20) * ncreates, total);
+		dev += hits[i] > expected ? hits[i] - expected :
+					    expected - hits[i];
+	}
+
+	return dev * dev <= 16ULL * n * ncreates;
+}
+
+static int __init kqos_init(void)
+{
+	struct lu_qos_alias *lqa;
+	__u64 *weights = NULL;
+	__u32 *tgts = NULL;
+	__u32 *hits = NULL;
+	unsigned int n;
+	s64 t_scan;
+	s64 t_alias;
+	bool ok = true;
+
+	if (max_osts < 16 || ncreates == 0) {
+		pr_err(PREFIX " invalid parameters\n", run_id);
+		goto out;
+	}
+
+	weights = vmalloc(sizeof(*weights) * max_osts);
+	tgts = vmalloc(sizeof(*tgts) * max_osts);
+	hits = vmalloc(sizeof(*hits) * max_osts);
+	if (weights == NULL || tgts == NULL || hits == NULL) {
+		pr_err(PREFIX " cannot allocate %u OSTs\n", run_id, max_osts);
+		goto out_free;
+	}
+
+	for (n = 16; n <= max_osts; n *= 4) {
+		kqos_fill(tgts, weights, n);
+		lqa = lu_qos_alias_build(tgts, weights, n);
+		if (IS_ERR(lqa)) {
+			pr_err(PREFIX " %u OSTs: cannot build table: rc = %ld\n",
+			       run_id, n, PTR_ERR(lqa));
+			ok = false;
+			break;
+		}
+
+		t_scan = kqos_run_scan(weights, n);
+		t_alias = kqos_run_alias(lqa, hits, n);
+		lu_qos_alias_free(lqa);
+
+		pr_err(PREFIX " %u OSTs: scan %llu ns/create, alias %llu ns/create\n",
+		       run_id, n, div_u64(t_scan, ncreates),
+		       div_u64(t_alias, ncreates));
+		if (!kqos_check(weights, hits, n)) {
+			pr_err(PREFIX " %u OSTs: draws don't follow weights\n",
+			       run_id, n);
+			ok = false;
+		}
+
+		if (n > max_osts / 4)
+			break;
+	}
+
+	/* below message is checked in sanity.sh test_424 */
+	if (ok)
+		pr_err(PREFIX " alias draws follow OST weights\n", run_id);
+out_free:
+	if (hits != NULL)
+		vfree(hits);
+	if (tgts != NULL)
+		vfree(tgts);
+	if (weights != NULL)
+		vfree(weights);
+out:
+	/* Don't load. */
+	return -EINVAL;
+}
+
+static void __exit kqos_exit(void)
+{
+}
+
+MODULE_AUTHOR("OpenSFS, Inc. <http://www.lustre.org/>");
+MODULE_DESCRIPTION("Lustre QoS weighted allocation benchmark");
+MODULE_VERSION(LUSTRE_VERSION_STRING);
+MODULE_LICENSE("GPL");
+
+module_init(kqos_init);
+module_exit(kqos_exit);
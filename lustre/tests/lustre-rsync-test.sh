@@ -685,6 +685,39 @@ test_9() {
 }
 run_test 9 "Replicate recursive directory removal"
 
+test_10() {
+	init_src
+	init_changelog
+
+	local i
+
+	for i in $(seq 8); do
+		mkdir $DIR/$tdir/d$i
+		createmany -o $DIR/$tdir/d$i/f 100 > /dev/null ||
+			error "createmany in d$i failed"
+		dd if=/dev/urandom of=$DIR/$tdir/d$i/data bs=1M count=2 \
+			2>/dev/null || error "dd in d$i failed"
+		echo append >> $DIR/$tdir/d$i/f0
+		mv $DIR/$tdir/d$i/f1 $DIR/$tdir/d$i/g1
+		unlinkmany $DIR/$tdir/d$i/f 50 50 > /dev/null ||
+			error "unlinkmany in d$i failed"
+	done
+	mv $DIR/$tdir/d1 $DIR/$tdir/d0
+	rm -rf $DIR/$tdir/d2
+
+	local LRSYNC_LOG=$(generate_logname "lrsync_log")
+	$LRSYNC -s $DIR -t $TGT -t $TGT2 -m $MDT0 -u $CL_USER -l $LREPL_LOG \
+		-D $LRSYNC_LOG --threads 4
+
+	check_diff ${DIR}/$tdir $TGT/$tdir
+	check_diff ${DIR}/$tdir $TGT2/$tdir
+
+	fini_changelog
+	cleanup_src_tgt
+	return 0
+}
+run_test 10 "Replicate with several replay threads"
+
 cd $ORIG_PWD
 complete $SECONDS
 check_and_cleanup_lustre
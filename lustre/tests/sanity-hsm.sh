@@ -1430,6 +1430,35 @@ test_12q() {
 }
 run_test 12q "file attributes are refreshed after restore"
 
+test_12r() {
+	# copy the data with several threads, in small chunks
+	copytool setup --threads 4 --chunk-size 64k
+
+	mkdir -p $DIR/$tdir
+	local f=$DIR/$tdir/$tfile
+
+	# sparse file, with data not aligned on chunks and a trailing hole
+	dd if=/dev/urandom of=$f bs=1k count=1000 seek=10 conv=notrunc ||
+		error "write $f failed"
+	dd if=/dev/urandom of=$f bs=1M count=3 seek=5 conv=notrunc ||
+		error "write $f failed"
+	$TRUNCATE $f $((16 * 1024 * 1024)) || error "truncate $f failed"
+
+	local fid=$(path2fid $f)
+	local sum=$(md5sum $f | awk '{print $1}')
+
+	$LFS hsm_archive $f || error "archive of $f failed"
+	wait_request_state $fid ARCHIVE SUCCEED
+	$LFS hsm_release $f || error "release of $f failed"
+
+	local sum2=$(md5sum $f | awk '{print $1}')
+
+	[[ $sum == $sum2 ]] || error "md5sum mismatch after restore"
+	[[ $(stat -c %s $f) == $((16 * 1024 * 1024)) ]] ||
+		error "wrong size after restore: $(stat -c %s $f)"
+}
+run_test 12r "Archive/restore a sparse file with several copy threads"
+
 test_13() {
 	local -i i j k=0
 	for i in {1..10}; do
@@ -4456,6 +4485,55 @@ test_254b()
 }
 run_test 254b "Request counters are correctly incremented and decremented"
 
+test_254c()
+{
+	[ $MDS1_VERSION -lt $(version_code 2.12.58) ] &&
+		skip "need MDS version at least 2.12.58"
+
+	local request_count=16
+	local count
+	local i
+
+	for ((i = 0; i < $request_count; i++)); do
+		create_small_file "$DIR/$tdir/$tfile-$i"
+	done
+
+	# No copytool, the requests stay in the waiting index
+	kill_copytools
+	wait_copytools || error "copytools failed to stop"
+
+	stack_trap \
+		"set_hsm_param loop_period $(get_hsm_param loop_period)" EXIT
+	set_hsm_param loop_period 1
+	# Force a housekeeping run which builds the index
+	cdt_restart
+	sleep 2
+
+	for ((i = 0; i < $request_count; i++)); do
+		$LFS hsm_archive --archive 2 "$DIR/$tdir/$tfile-$i"
+	done
+
+	get_hsm_param waiting
+	get_hsm_param waiting | grep -q "index: valid" ||
+		error "waiting requests are not indexed"
+	count=$(get_hsm_param waiting_count)
+	[ "$count" -eq "$request_count" ] ||
+		error "Expected '$request_count' (!= '$count') waiting requests"
+
+	copytool setup --archive-id 2
+	for ((i = 0; i < $request_count; i++)); do
+		wait_request_state "$(path2fid "$DIR/$tdir/$tfile-$i")" \
+			ARCHIVE SUCCEED
+	done
+
+	count=$(get_hsm_param waiting_count)
+	[ "$count" -eq 0 ] ||
+		error "Expected 0 (!= '$count') waiting requests"
+	get_hsm_param waiting | grep -q "dispatch_latency" ||
+		error "no dispatch latency reported"
+}
+run_test 254c "Waiting requests are indexed by the coordinator"
+
 test_255()
 {
 	[ $MDS1_VERSION -lt $(version_code 2.12.0) ] &&
@@ -5761,6 +5761,114 @@ test_39()
 }
 run_test 39 "LFSCK does not break foreign dir and reverse is also true"
 
+test_40() {
+	echo "#####"
+	echo "Layout LFSCK with several assistant threads on the MDT should"
+	echo "repair all the inconsistent OST-object owners as the single"
+	echo "assistant does."
+	echo "#####"
+
+	local param=/sys/module/lfsck/parameters/lfsck_assistant_threads
+	local saved=$(do_facet $SINGLEMDS cat $param 2>/dev/null)
+
+	[ -n "$saved" ] || skip "MDS does not support parallel LFSCK assistant"
+
+	check_mount_and_prep
+	$LFS setstripe -c 1 -i 0 $DIR/$tdir
+	createmany -o $DIR/$tdir/f 64 || error "(0) Fail to create files"
+	cancel_lru_locks osc
+
+	echo "Inject failure stub to skip OST-object owner changing"
+	#define OBD_FAIL_LFSCK_BAD_OWNER	0x1613
+	do_facet $SINGLEMDS $LCTL set_param fail_loc=0x1613
+	for ((i = 0; i < 64; i++)); do
+		chown 1.1 $DIR/$tdir/f$i || error "(1) Fail to chown f$i"
+	done
+	do_facet $SINGLEMDS $LCTL set_param fail_loc=0
+
+	do_facet $SINGLEMDS "echo 4 > $param"
+	stack_trap "do_facet $SINGLEMDS 'echo $saved > $param'" EXIT
+
+	echo "Trigger layout LFSCK with 4 assistant threads"
+	$START_LAYOUT -r || error "(2) Fail to start LFSCK for layout!"
+
+	wait_update_facet $SINGLEMDS "$LCTL get_param -n \
+		mdd.${MDT_DEV}.lfsck_layout |
+		awk '/^status/ { print \\\$2 }'" "completed" 32 || {
+		$SHOW_LAYOUT
+		error "(3) unexpected status"
+	}
+
+	local repaired=$($SHOW_LAYOUT |
+			 awk '/^repaired_inconsistent_owner/ { print $2 }')
+	[ $repaired -eq 64 ] ||
+		error "(4) Fail to repair inconsistent owner: $repaired"
+}
+run_test 40 "Parallel layout LFSCK assistant threads"
+
+test_41() {
+	[ $MDS1_VERSION -lt $(version_code 2.12.58) ] &&
+		skip "MDS does not refresh LSOM during layout LFSCK"
+
+	echo "#####"
+	echo "The files lost their LSOM at close time. The layout LFSCK"
+	echo "should rebuild the lazy SOM from the OST-objects, and leave"
+	echo "it alone when it is up to date."
+	echo "#####"
+
+	check_mount_and_prep
+	$LFS setstripe -c -1 -S 1M $DIR/$tdir
+
+	echo "Inject failure stub to skip the LSOM update on close"
+	#define OBD_FAIL_LFSCK_LOST_LSOM	0x1632
+	do_facet $SINGLEMDS $LCTL set_param fail_loc=0x1632
+	for ((i = 0; i < 32; i++)); do
+		dd if=/dev/zero of=$DIR/$tdir/f$i bs=4k count=$((i * 97 + 1)) \
+			2>/dev/null || error "(1) Fail to write f$i"
+	done
+	do_facet $SINGLEMDS $LCTL set_param fail_loc=0
+	cancel_lru_locks osc
+
+	echo "Trigger layout LFSCK to refresh the LSOM"
+	$START_LAYOUT -r || error "(2) Fail to start LFSCK for layout!"
+
+	wait_update_facet $SINGLEMDS "$LCTL get_param -n \
+		mdd.${MDT_DEV}.lfsck_layout |
+		awk '/^status/ { print \\\$2 }'" "completed" 32 || {
+		$SHOW_LAYOUT
+		error "(3) unexpected status"
+	}
+
+	local refreshed=$($SHOW_LAYOUT |
+			  awk '/^som_refreshed/ { print $2 }')
+	[ $refreshed -ge 32 ] ||
+		error "(4) Fail to refresh LSOM: $refreshed"
+
+	for ((i = 0; i < 32; i++)); do
+		local size=$($LFS getsom -s $DIR/$tdir/f$i)
+		local expect=$(stat -c %s $DIR/$tdir/f$i)
+
+		[ "$size" == "$expect" ] ||
+			error "(5) f$i expected LSOM size $expect, got $size"
+	done
+
+	echo "Trigger layout LFSCK again, all LSOM are up to date"
+	$START_LAYOUT -r || error "(6) Fail to start LFSCK for layout!"
+
+	wait_update_facet $SINGLEMDS "$LCTL get_param -n \
+		mdd.${MDT_DEV}.lfsck_layout |
+		awk '/^status/ { print \\\$2 }'" "completed" 32 || {
+		$SHOW_LAYOUT
+		error "(7) unexpected status"
+	}
+
+	local coverage=$($SHOW_LAYOUT |
+			 awk '/^som_coverage/ { print $2 }')
+	[ "$coverage" == "100%" ] ||
+		error "(8) Unexpected LSOM coverage: $coverage"
+}
+run_test 41 "Layout LFSCK refreshes stale LSOM"
+
 # restore MDS/OST size
 MDSSIZE=${SAVED_MDSSIZE}
 OSTSIZE=${SAVED_OSTSIZE}
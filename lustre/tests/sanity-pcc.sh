@@ -1373,6 +1373,98 @@ test_17() {
 }
 run_test 17 "Test auto attach for layout refresh"
 
+test_18() {
+	local loopfile="$TMP/$tfile"
+	local mntpt="/mnt/pcc.$tdir"
+	local hsm_root="$mntpt/$tdir"
+	local file=$DIR/$tfile
+	local delay=10
+
+	setup_loopdev $SINGLEAGT $loopfile $mntpt 50
+	copytool setup -m "$MOUNT" -a "$HSM_ARCHIVE_NUMBER"
+	setup_pcc_mapping $SINGLEAGT \
+		"projid={100}\ rwid=$HSM_ARCHIVE_NUMBER\ wb_delay=$delay"
+
+	do_facet $SINGLEAGT $LCTL pcc list $MOUNT |
+		grep -q "wb_delay: $delay" ||
+		error "wb_delay $delay not set on the PCC backend"
+
+	do_facet $SINGLEAGT "echo -n writeback_data > $file"
+	do_facet $SINGLEAGT $LFS pcc attach -i $HSM_ARCHIVE_NUMBER $file ||
+		error "PCC attach $file failed"
+	check_lpcc_state $file "readwrite"
+	do_facet $SINGLEAGT $LFS pcc state $file | grep -q "write-back" ||
+		error "$file should be queued for write-back"
+
+	# Writes to the PCC copy postpone the write-back: the file is idle
+	# for less than $delay seconds after the second write, but it would
+	# be idle for more than $delay seconds after the attach.
+	sleep $((delay / 2 + 1))
+	do_facet $SINGLEAGT "echo -n writeback_data2 > $file"
+	sleep $((delay / 2 + 1))
+	check_lpcc_state $file "readwrite"
+	do_facet $SINGLEAGT $LFS pcc state $file |
+		grep -q "write-back: pending" ||
+		error "$file write-back not postponed by the write"
+
+	wait_request_state $(path2fid $file) RESTORE SUCCEED
+	check_lpcc_state $file "none"
+	# HSM exists archived status, the PCC copy is kept as archive
+	check_hsm_flags $file "0x00000009"
+	check_file_data $SINGLEAGT $file "writeback_data2"
+
+	do_facet $SINGLEAGT $LCTL pcc list $MOUNT |
+		grep -q "wb_flushed_bytes: 0$" &&
+		error "flushed bytes not accounted"
+	return 0
+}
+run_test 18 "Idle RW-PCC files are written back to Lustre in background"
+
+test_19() {
+	local loopfile="$TMP/$tfile"
+	local mntpt="/mnt/pcc.$tdir"
+	local hsm_root="$mntpt/$tdir"
+	local file=$DIR/$tdir/$tfile.ref
+	local heat_sav
+
+	heat_sav=$(do_facet $SINGLEAGT $LCTL get_param -n llite.*.file_heat |
+		   head -n 1)
+	[ -z "$heat_sav" ] && skip "no file heat support"
+
+	setup_loopdev $SINGLEAGT $loopfile $mntpt 50
+	setup_pcc_mapping $SINGLEAGT \
+		"fname={*.ref}\ ropcc=1\ ro_heat=4\ ro_budget=10"
+	do_facet $SINGLEAGT $LCTL set_param -n llite.*.file_heat=1
+	stack_trap "do_facet $SINGLEAGT $LCTL set_param -n \
+		llite.*.file_heat=$heat_sav" EXIT
+
+	mkdir -p $DIR/$tdir || error "mkdir $DIR/$tdir failed"
+	do_facet $SINGLEAGT "echo -n ro_data > $file"
+	for i in $(seq 10); do
+		do_facet $SINGLEAGT cat $file > /dev/null ||
+			error "cat $file failed"
+	done
+
+	# The hot file is prefetched in background
+	wait_update_facet $SINGLEAGT \
+		"$LFS pcc state $file | grep -o 'type: [a-z]*'" \
+		"type: readonly" 30 ||
+		error "$file was not prefetched into RO-PCC"
+	# RO copies are not at the FID path used for the HSM archive
+	do_facet $SINGLEAGT $LFS pcc state $file |
+		grep -q "PCC file: .*/.pcc_ro/" ||
+		error "RO-PCC copy of $file not under .pcc_ro"
+	check_file_data $SINGLEAGT $file "ro_data"
+	do_facet $SINGLEAGT $LCTL pcc list $MOUNT | grep "ro_used: 7" ||
+		error "RO-PCC space used not accounted"
+
+	# A write through Lustre detaches the file
+	do_facet $SINGLEAGT "echo -n ro_data2 > $file"
+	check_lpcc_state $file "none"
+	check_file_data $SINGLEAGT $file "ro_data2"
+}
+run_test 19 "Hot read-mostly files are prefetched into RO-PCC"
+
 complete $SECONDS
 check_and_cleanup_lustre
 exit_status
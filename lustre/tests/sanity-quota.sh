@@ -3471,6 +3471,46 @@ test_65() {
 }
 run_test 65 "Check lfs quota result"
 
+test_66() {
+	local LIMIT=20 # 20M
+	local TESTFILE="$DIR/$tdir/$tfile-0"
+	local uid=$(id -u $TSTUSR)
+	local param=osd-*.$FSNAME-OST0000.quota_slave
+
+	setup_quota_test || error "setup quota failed with $?"
+	trap cleanup_quota_test EXIT
+
+	set_ost_qtype $QTYPE || error "enable ost quota failed"
+	$LFS setquota -u $TSTUSR -b 0 -B ${LIMIT}M -i 0 -I 0 $DIR ||
+		error "set user quota failed"
+
+	local window=$(do_facet ost1 $LCTL get_param -n $param.prefetch_window)
+	stack_trap "do_facet ost1 $LCTL set_param \
+		$param.prefetch_window=$window" EXIT
+	do_facet ost1 $LCTL set_param $param.prefetch_window=-1 &&
+		error "negative prefetch window accepted"
+	do_facet ost1 $LCTL set_param $param.prefetch_window=2 ||
+		error "failed to set prefetch window"
+	do_facet ost1 $LCTL set_param $param.acquire_stats=clear
+
+	$LFS setstripe $TESTFILE -c 1 -i 0 || error "setstripe $TESTFILE failed"
+	chown $TSTUSR.$TSTUSR $TESTFILE || error "chown $TESTFILE failed"
+
+	$RUNAS $DD of=$TESTFILE count=$((LIMIT / 2)) oflag=sync ||
+		quota_error u $TSTUSR "user write failure, but expect success"
+
+	local stats=$(do_facet ost1 $LCTL get_param -n $param.acquire_stats)
+	echo "$stats"
+	echo "$stats" | grep -q "^- usr $uid " ||
+		error "no acquire stats for user $TSTUSR"
+
+	rm -f $TESTFILE
+	wait_delete_completed || error "wait_delete_completed failed"
+	resetquota -u $TSTUSR
+	cleanup_quota_test
+}
+run_test 66 "quota slave reports per-ID consumption rate and waits"
+
 quota_fini()
 {
 	do_nodes $(comma_list $(nodes_list)) "lctl set_param debug=-quota"
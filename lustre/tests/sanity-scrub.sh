@@ -1273,6 +1273,41 @@ test_16() {
 }
 run_test 16 "Initial OI scrub can rebuild crashed index objects"
 
+test_17() {
+	[ $(facet_fstype $SINGLEMDS) != "ldiskfs" ] &&
+		skip "ldiskfs special test"
+
+	formatall > /dev/null
+	setupall > /dev/null
+
+	scrub_prep 20 1
+	echo "starting MDTs with OI scrub disabled"
+	scrub_start_mds 2 "$MOUNT_OPTS_NOSCRUB"
+	scrub_check_status 3 init
+	scrub_check_flags 4 recreated,inconsistent
+
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local facets=$(get_facets MDS)
+
+	save_lustre_params $facets "osd-*.*.scrub_threads" > $p
+	save_lustre_params $facets "osd-*.*.scrub_readahead" >> $p
+	do_nodes $(comma_list $(mdts_nodes)) $LCTL set_param -n \
+		osd-*.*.scrub_threads=4 osd-*.*.scrub_readahead=8 ||
+		{ rm -f $p; skip "MDS does not support parallel OI scrub"; }
+	stack_trap "restore_lustre_params < $p; rm -f $p" EXIT
+
+	scrub_start 5
+	scrub_check_status 6 completed
+	scrub_check_flags 7 ""
+	scrub_check_repaired 8 20 0
+
+	scrub_start 9
+	scrub_check_status 10 completed
+	scrub_check_flags 11 ""
+	scrub_check_repaired 12 0 0
+}
+run_test 17 "OI scrub with several threads"
+
 # restore MDS/OST size
 MDSSIZE=${SAVED_MDSSIZE}
 OSTSIZE=${SAVED_OSTSIZE}
@@ -2963,6 +2963,40 @@ test_27N() {
 }
 run_test 27N "lctl pool_list on separate MGS gives correct pool name"
 
+test_27O() {
+	remote_mds_nodsh && skip "remote MDS with nodsh"
+	do_facet mds1 $LCTL list_param osp.*OST0000*.create_rate ||
+		skip "MDS doesn't estimate the create rate"
+
+	local osp=$FSNAME-OST0000-osc-MDT0000
+	local rate
+	local idle
+	local waits
+
+	do_facet mds1 $LCTL set_param osp.$osp.create_wait_hist=clear
+	test_mkdir -i 0 -c 1 $DIR/$tdir
+	$LFS setstripe -c 1 -i 0 $DIR/$tdir
+	createmany -o $DIR/$tdir/f- 2000 || error "createmany failed"
+
+	rate=$(do_facet mds1 $LCTL get_param -n osp.$osp.create_rate)
+	echo "create rate: $rate objs/s"
+	(( rate > 0 )) || error "create rate not estimated"
+
+	do_facet mds1 $LCTL get_param osp.$osp.create_wait_hist
+	waits=$(do_facet mds1 $LCTL get_param -n osp.$osp.create_wait_hist |
+		awk '/^[0-9]/ { sum += $2 } END { print sum + 0 }')
+	(( waits >= 2000 )) || error "only $waits reservations accounted"
+
+	# the estimate is halved for each idle period of 800ms
+	sleep 5
+	idle=$(do_facet mds1 $LCTL get_param -n osp.$osp.create_rate)
+	echo "create rate after 5s idle: $idle objs/s"
+	(( idle < rate || rate == 0 )) || error "create rate doesn't decay"
+
+	unlinkmany $DIR/$tdir/f- 2000 || error "unlinkmany failed"
+}
+run_test 27O "precreate follows the create rate"
+
 # createtest also checks that device nodes are created and
 # then visible correctly (#2091)
 test_28() { # bug 2091
@@ -6997,6 +7031,31 @@ test_56ca() {
 }
 run_test 56ca "check lfs find --mirror-count|-N and --mirror-state"
 
+test_56cb() {
+	local dir=$DIR/$tdir
+	local serial
+	local parallel
+	local opts
+
+	setup_56 $dir 10 10 "-c 1"
+	test_mkdir $dir/dir1/subdir
+	$LFS setstripe -c $OSTCOUNT $dir/dir1/subdir/striped ||
+		error "setstripe $dir/dir1/subdir/striped failed"
+
+	for opts in "" "-type f" "-type d" "-maxdepth 1" "-name file1" \
+		    "-stripe-count 1" "! -stripe-count 1" "-ost 0" \
+		    "-size -1M -type f"; do
+		serial=$($LFS find $dir $opts | sort)
+		parallel=$($LFS find $dir --threads 4 $opts | sort)
+		[ "$serial" == "$parallel" ] || {
+			echo "serial: $serial"
+			echo "parallel: $parallel"
+			error "'lfs find $opts' differs with --threads 4"
+		}
+	done
+}
+run_test 56cb "lfs find --threads finds the same files"
+
 test_57a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 	# note test will not do anything if MDS is not local
@@ -7342,6 +7401,49 @@ test_60h() {
 }
 run_test 60h "striped directory with missing stripes can be accessed"
 
+test_60i() {
+	$LCTL get_param -n debug_deferred > /dev/null 2>&1 ||
+		skip "no deferred debug message formatting"
+
+	local saved_debug=$($LCTL get_param -n debug)
+	local saved_deferred=$($LCTL get_param -n debug_deferred)
+	local log=$TMP/$tfile.log
+	local deferred
+	local text
+	local mode
+
+	stack_trap "$LCTL set_param -n debug='$saved_debug' \
+		debug_deferred=$saved_deferred; rm -f $log" EXIT
+
+	touch $DIR/$tfile || error "touch $DIR/$tfile failed"
+	$LCTL set_param -n debug=+trace
+	# the same getattr is logged with both formatting paths, keep the
+	# "(file:line:func()) message" part of its llite ENTRY/EXIT records,
+	# pointers returned by EXIT differ between runs
+	for mode in 0 1; do
+		$LCTL set_param -n debug_deferred=$mode
+		cancel_lru_locks mdc
+		$LCTL clear
+		stat $DIR/$tfile > /dev/null || error "stat $DIR/$tfile failed"
+		$LCTL dk $log > /dev/null
+		grep -E ":ll_[a-z_]*\(\)\) Process (entered|leaving)" $log |
+			sed -E -e 's/^[^(]*\(//' -e 's/[0-9a-f]{8,}/N/g' |
+			sort -u > $log.$mode
+	done
+	text=$(cat $log.0)
+	deferred=$(cat $log.1)
+	rm -f $log.0 $log.1
+
+	[ -n "$deferred" ] || error "no deferred ENTRY/EXIT records"
+	# arguments must be expanded, not left as conversion specifiers
+	! grep -q "%" <<< "$deferred" ||
+		error "deferred records not expanded: $(grep % <<< "$deferred")"
+	[ "$deferred" == "$text" ] ||
+		error "deferred records differ: $(diff <(echo "$text") \
+		      <(echo "$deferred"))"
+}
+run_test 60i "debug messages with deferred formatting are decoded"
+
 test_61a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 
@@ -11076,6 +11178,63 @@ test_123b () { # statahead(bug 15027)
 }
 run_test 123b "not panic with network error in statahead enqueue (bug 15027)"
 
+test_123c() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run"
+	[[ $($LCTL get_param osc.*.import) =~ connect_flags.*batch_glimpse ]] ||
+		skip "server does not support OST_BATCH_GLIMPSE"
+
+	local batch_max=$($LCTL get_param -n osc.*.glimpse_batch_max |
+			  head -n 1)
+	local nfiles=200
+	local glimpses
+	local batches
+	local unbatched
+	local i
+
+	test_mkdir $DIR/$tdir
+	$LFS setstripe -c 1 -i 0 $DIR/$tdir
+	createmany -o $DIR/$tdir/$tfile- $nfiles || error "createmany failed"
+	for ((i = 0; i < nfiles; i++)); do
+		$TRUNCATE $DIR/$tdir/$tfile-$i $((i * 1000 + 1)) ||
+			error "truncate $tfile-$i failed"
+	done
+
+	cancel_lru_locks mdc
+	cancel_lru_locks osc
+	$LCTL set_param -n osc.*.stats=clear
+
+	ls -l $DIR/$tdir > $TMP/$tfile.ls || error "ls $DIR/$tdir failed"
+	$LCTL get_param -n llite.*.statahead_stats
+	glimpses=$(calc_stats osc.*.stats ldlm_glimpse_enqueue)
+	batches=$(calc_stats osc.*.stats ost_batch_glimpse)
+	(( batches > 0 )) || error "AGL glimpses were not batched"
+
+	for ((i = 0; i < nfiles; i++)); do
+		(( $(awk "/ $tfile-$i\$/ { print \$5 }" $TMP/$tfile.ls) ==
+		   i * 1000 + 1 )) || error "$tfile-$i: wrong size"
+	done
+	rm -f $TMP/$tfile.ls
+
+	# the same without batching
+	stack_trap "$LCTL set_param osc.*.glimpse_batch_max=$batch_max" EXIT
+	$LCTL set_param osc.*.glimpse_batch_max=0
+	cancel_lru_locks mdc
+	cancel_lru_locks osc
+	$LCTL set_param -n osc.*.stats=clear
+
+	ls -l $DIR/$tdir > /dev/null || error "ls $DIR/$tdir failed"
+	unbatched=$(calc_stats osc.*.stats ldlm_glimpse_enqueue)
+	echo "batched: $glimpses glimpses, $batches batches," \
+		"not batched: $unbatched glimpses"
+
+	# stat() should use the locks granted by the batched glimpses
+	(( glimpses < nfiles / 2 )) ||
+		error "$glimpses glimpses sent for $nfiles files"
+	(( glimpses + batches < unbatched )) ||
+		error "$((glimpses + batches)) RPCs, $unbatched without batching"
+}
+run_test 123c "AGL glimpses are batched by OST_BATCH_GLIMPSE"
+
 test_124a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 	$LCTL get_param -n mdc.*.connect_flags | grep -q lru_resize ||
@@ -14199,6 +14358,75 @@ test_160k() {
 }
 run_test 160k "Verify that changelog records are not lost"
 
+test_160l() {
+	remote_mds_nodsh && skip "remote MDS with nodsh"
+	[ $MDS1_VERSION -lt $(version_code 2.12.58) ] &&
+		skip "Need MDS version at least 2.12.58"
+
+	local mdt=$(facet_svc $SINGLEMDS)
+	local param="mdd.$mdt.changelog_stats"
+	local before
+	local after
+
+	changelog_register || error "changelog_register failed"
+
+	do_facet $SINGLEMDS $LCTL set_param -n $param=clear
+	before=$(do_facet $SINGLEMDS $LCTL get_param -n $param |
+		 awk '/^append/ { print $2 }')
+	before=${before:-0}
+
+	test_mkdir -c1 $DIR/$tdir
+	createmany -o $DIR/$tdir/f 100 || error "createmany failed"
+
+	do_facet $SINGLEMDS $LCTL get_param $param
+	after=$(do_facet $SINGLEMDS $LCTL get_param -n $param |
+		awk '/^append/ { print $2 }')
+	(( after - before >= 101 )) ||
+		error "expected at least 101 appends, got $((after - before))"
+	do_facet $SINGLEMDS $LCTL get_param -n $param | grep -q "^batch" ||
+		error "no batch statistics"
+
+	rm -rf $DIR/$tdir
+	changelog_deregister
+}
+run_test 160l "changelog append statistics"
+
+test_160m() {
+	remote_mds_nodsh && skip "remote MDS with nodsh"
+	[ $MDS1_VERSION -lt $(version_code 2.12.58) ] &&
+		skip "Need MDS version at least 2.12.58"
+
+	local mdt=$(facet_svc $SINGLEMDS)
+	local nr
+
+	changelog_register || error "changelog_register failed"
+
+	test_mkdir -c1 -i0 $DIR/$tdir
+	test_mkdir -c1 -i0 $DIR/$tdir/d1
+	test_mkdir -c1 -i0 $DIR/$tdir/d2
+	createmany -o $DIR/$tdir/f 10 || error "createmany failed"
+	rm -f $DIR/$tdir/f0 || error "rm f0 failed"
+
+	$LFS changelog --type MKDIR,UNLNK $mdt
+	nr=$($LFS changelog --type MKDIR,UNLNK $mdt | wc -l)
+	(( nr == 4 )) || error "expected 4 MKDIR/UNLNK records, got $nr"
+	$LFS changelog --type MKDIR,UNLNK $mdt |
+		grep -qv "MKDIR\|UNLNK" && error "unwanted records returned"
+
+	nr=$($LFS changelog --type CREAT $mdt | wc -l)
+	(( nr == 10 )) || error "expected 10 CREAT records, got $nr"
+
+	nr=$($LFS changelog --jobid nosuchjob.0 $mdt | wc -l)
+	(( nr == 0 )) || error "expected no record for unknown jobid, got $nr"
+
+	$LFS changelog --type NOSUCHTYPE $mdt &&
+		error "bad record type should be rejected"
+
+	rm -rf $DIR/$tdir
+	changelog_deregister
+}
+run_test 160m "changelog reader filtering by type and jobid"
+
 test_161a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 
@@ -14645,6 +14873,7 @@ obdecho_test() {
         local OBD=$1
         local node=$2
 	local pages=${3:-64}
+	local batch=$4
         local rc=0
         local id
 
@@ -14667,7 +14896,7 @@ obdecho_test() {
 	[ $rc -eq 0 ] && { do_facet $node "$LCTL --device ec getattr $id" ||
 			   rc=4; }
 	[ $rc -eq 0 ] && { do_facet $node "$LCTL --device ec "		       \
-			   "test_brw $count w v $pages $id" || rc=4; }
+			   "test_brw $count w v $pages $id $batch" || rc=4; }
 	[ $rc -eq 0 ] && { do_facet $node "$LCTL --device ec destroy $id 1" ||
 			   rc=4; }
 	[ $rc -eq 0 ] || [ $rc -gt 2 ] &&
@@ -14753,6 +14982,38 @@ test_180c() { # LU-2598
 }
 run_test 180c "test huge bulk I/O size on obdfilter, don't LASSERT"
 
+test_180d() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run"
+
+	if ! module_loaded obdecho; then
+		load_module obdecho/obdecho &&
+			stack_trap "rmmod obdecho" EXIT ||
+			error "unable to load obdecho on client"
+	fi
+
+	local osc=$($LCTL dl | grep -v mdt | awk '$3 == "osc" {print $4; exit}')
+	local host=$($LCTL get_param -n osc.$osc.import |
+		     awk '/current_connection:/ { print $2 }' )
+	local target=$($LCTL get_param -n osc.$osc.import |
+		       awk '/target:/ { print $2 }' )
+	local log=$TMP/$tfile.log
+
+	target=${target%_UUID}
+	[ -n "$target" ] || error "there is no osc.$osc.import target"
+
+	setup_obdecho_osc $host $target &&
+		stack_trap "cleanup_obdecho_osc $target" EXIT ||
+		{ error "obdecho setup failed with $?"; return; }
+
+	# set up and free the client pages only, without any I/O
+	obdecho_test ${target}_osc client 1024 c | tee $log
+	[ ${PIPESTATUS[0]} -eq 0 ] ||
+		error "obdecho_test failed on ${target}_osc"
+	grep -q "ns per page" $log || error "no per page overhead reported"
+	rm -f $log
+}
+run_test 180d "time client page setup with obdecho"
+
 test_181() { # bug 22177
 	test_mkdir $DIR/$tdir
 	# create enough files to index the directory
@@ -17164,6 +17425,39 @@ test_239b() { #LU-5297
 }
 run_test 239b "process osp sync record with ENOMEM error correctly"
 
+test_239c() {
+	remote_mds_nodsh && skip "remote MDS with nodsh"
+	remote_ost_nodsh && skip "remote OST with nodsh"
+	do_facet mds1 $LCTL list_param osp.*.sync_destroy_batch ||
+		skip "MDS doesn't merge object destroys"
+
+	local nfiles=64
+	local destroys
+
+	test_mkdir -i 0 -c 1 $DIR/$tdir
+	$LFS setstripe -c 1 -i 0 $DIR/$tdir
+	createmany -o $DIR/$tdir/f- $nfiles || error "createmany failed"
+	sync
+	wait_delete_completed
+
+	do_facet ost1 $LCTL set_param obdfilter.*.stats=clear
+	# unlink in creation order, the objects are consecutive on OST0000
+	unlinkmany $DIR/$tdir/f- $nfiles || error "unlinkmany failed"
+	wait_delete_completed
+
+	destroys=$(do_facet ost1 $LCTL get_param -n \
+		   obdfilter.$FSNAME-OST0000.stats |
+		   awk '/^destroy/ { print $2 }')
+	echo "$nfiles objects destroyed with ${destroys:-0} RPCs"
+	[[ -n "$destroys" ]] || error "no destroy on OST0000"
+	(( destroys < nfiles / 2 )) ||
+		error "$destroys destroy RPCs for $nfiles objects"
+
+	do_facet mds1 $LCTL get_param osp.$FSNAME-OST0000*.sync_drain_rate ||
+		error "cannot read sync_drain_rate"
+}
+run_test 239c "destroys of consecutive objects are merged"
+
 test_240() {
 	[ $MDSCOUNT -lt 2 ] && skip_env "needs >= 2 MDTs"
 	remote_mds_nodsh && skip "remote MDS with nodsh"
@@ -18013,6 +18307,41 @@ test_255c() {
 }
 run_test 255c "suite of ladvise lockahead tests"
 
+test_255d() {
+	[ $OST1_VERSION -lt $(version_code 2.10.50) ] &&
+		skip "lustre < 2.10.50 does not support lockahead"
+
+	local stride=$((1024 * 1024))
+	local size=4096
+	local cmd="O"
+	local prefetch
+	local hits
+	local i
+
+	test_mkdir -p $DIR/$tdir
+	$LFS setstripe -i 0 -c 1 $DIR/$tdir
+
+	for ((i = 0; i < 16; i++)); do
+		cmd+="z$((i * stride))w$size"
+	done
+
+	$LCTL set_param -n llite.*.stats=clear
+	cancel_lru_locks osc
+	$MULTIOP $DIR/$tdir/$tfile ${cmd}c || error "strided writes failed"
+
+	prefetch=$($LCTL get_param -n llite.*.stats |
+		   awk '/^lockahead_prefetch/ { print $2 }')
+	hits=$($LCTL get_param -n llite.*.stats |
+	       awk '/^lockahead_hit/ { print $2 }')
+	echo "locks requested ahead: $prefetch, hits: $hits"
+	(( ${prefetch:-0} > 0 )) || error "no lock requested ahead"
+	(( ${hits:-0} > 0 )) || error "no write hit a lock requested ahead"
+
+	(( $(stat -c %s $DIR/$tdir/$tfile) == 15 * stride + size )) ||
+		error "wrong file size"
+}
+run_test 255d "lockahead prefetch for strided writes"
+
 test_256() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 	remote_mds_nodsh && skip "remote MDS with nodsh"
@@ -18743,6 +19072,53 @@ test_271g() {
 }
 run_test 271g "Discard DoM data vs client flush race"
 
+test_271h() {
+	[ $MDS1_VERSION -lt $(version_code 2.12.60) ] &&
+		skip "Need MDS version at least 2.12.60"
+	$LCTL get_param -n llite.*.statahead_dom > /dev/null 2>&1 ||
+		skip "client does not support DoM statahead prefetch"
+
+	local nfiles=100
+	local mdtidx
+	local before
+	local after
+	local num
+
+	mkdir -p $DIR/$tdir
+	$LFS setstripe -E 1024K -L mdt $DIR/$tdir
+	mdtidx=$($LFS getstripe --mdt-index $DIR/$tdir)
+
+	for ((i = 0; i < nfiles; i++)); do
+		echo "DoM data of file $i" > $DIR/$tdir/f$i ||
+			error "write $DIR/$tdir/f$i failed"
+	done
+	cancel_lru_locks mdc
+
+	before=$($LCTL get_param -n llite.*.statahead_stats |
+		 awk '/dom prefetch total:/ { print $4 }')
+	# statahead gets the data along with the attributes
+	ls -l $DIR/$tdir > /dev/null || error "ls -l $DIR/$tdir failed"
+	$LCTL get_param -n llite.*.statahead_stats
+	after=$($LCTL get_param -n llite.*.statahead_stats |
+		awk '/dom prefetch total:/ { print $4 }')
+	(( after > before )) || error "no DoM data prefetched by statahead"
+
+	before=$($LCTL get_param -n llite.*.statahead_stats |
+		 awk '/dom prefetch hit:/ { print $4 }')
+	$LCTL set_param -n mdc.*.stats=clear
+	for ((i = 0; i < nfiles; i++)); do
+		[[ "$(cat $DIR/$tdir/f$i)" == "DoM data of file $i" ]] ||
+			error "$DIR/$tdir/f$i data mismatch"
+	done
+	num=$(get_mdc_stats $mdtidx ost_read)
+	[ -z $num ] || error "$num READ RPC occured"
+
+	after=$($LCTL get_param -n llite.*.statahead_stats |
+		awk '/dom prefetch hit:/ { print $4 }')
+	(( after > before )) || error "no read served from prefetched data"
+}
+run_test 271h "DoM: statahead prefetches data of small files"
+
 test_272a() {
 	[ $MDS1_VERSION -lt $(version_code 2.11.50) ] &&
 		skip "Need MDS version at least 2.11.50"
@@ -21498,6 +21874,116 @@ test_422() {
 }
 run_test 422 "kill a process with RPC in progress"
 
+test_423() {
+	local module=$LUSTRE/tests/kernel/kcalq.ko
+
+	[ -f $module ] || skip_env "$module not found"
+
+	local run_id=$RANDOM
+
+	# The module is designed to not be inserted, see test_410.
+	insmod $module run_id=$run_id max_nodes=100000 nops=100000 \
+	    &> /dev/null
+
+	dmesg | grep "lustre_kcalq_$run_id:"
+	dmesg | grep -q \
+	    "lustre_kcalq_$run_id: binheap and calq orders are identical" ||
+	    error "calendar queue order differs from binary heap"
+}
+run_test 423 "calendar queue sorts like the binary heap"
+
+test_424() {
+	local module=$LUSTRE/tests/kernel/kqos.ko
+
+	[ -f $module ] || skip_env "$module not found"
+
+	local run_id=$RANDOM
+
+	# The module is designed to not be inserted, see test_410.
+	insmod $module run_id=$run_id max_osts=1024 ncreates=100000 \
+	    &> /dev/null
+
+	dmesg | grep "lustre_kqos_$run_id:"
+	dmesg | grep -q \
+	    "lustre_kqos_$run_id: alias draws follow OST weights" ||
+	    error "alias table draws don't follow OST weights"
+}
+run_test 424 "QoS alias table draws OSTs by weight"
+
+test_425() {
+	[ $OSTCOUNT -lt 4 ] && skip_env "needs >= 4 OSTs"
+	remote_mds_nodsh && skip "remote MDS with nodsh"
+
+	local qos_alias=$(do_facet mds1 $LCTL get_param -n \
+			  lod.$FSNAME-MDT0000-mdtlov.qos_alias)
+	local maxage=$(do_facet mds1 $LCTL get_param -n \
+		       lod.$FSNAME-MDT0000-mdtlov.qos_maxage | sed 's/[^0-9]//g')
+	local alias
+
+	[ -n "$qos_alias" ] || skip "MDS does not support qos_alias"
+	stack_trap "do_facet mds1 $LCTL set_param \
+		lod.$FSNAME-MDT0000-mdtlov.qos_alias=$qos_alias" EXIT
+
+	# always use QoS allocation, even if OSTs are balanced
+	local old_rr=$(do_facet mds1 $LCTL get_param -n \
+		       lod.$FSNAME-MDT0000-mdtlov.qos_threshold_rr)
+
+	do_facet mds1 $LCTL set_param \
+		lod.$FSNAME-MDT0000-mdtlov.qos_threshold_rr=0
+	stack_trap "do_facet mds1 $LCTL set_param \
+		lod.$FSNAME-MDT0000-mdtlov.qos_threshold_rr=$old_rr" EXIT
+
+	test_mkdir $DIR/$tdir
+	for alias in 0 1; do
+		do_facet mds1 $LCTL set_param \
+			lod.$FSNAME-MDT0000-mdtlov.qos_alias=$alias
+		# let the table be rebuilt by a statfs update
+		sleep $((maxage * 2 + 1))
+		createmany -o $DIR/$tdir/f$alias- 200 ||
+			error "create with qos_alias=$alias failed"
+		$LFS getstripe -i $DIR/$tdir/f$alias-* | sort | uniq -c
+		(( $($LFS getstripe -i $DIR/$tdir/f$alias-* | sort -u |
+		     wc -l) > 1 )) ||
+			error "qos_alias=$alias: all files on the same OST"
+	done
+}
+run_test 425 "QoS allocation with and without the alias table"
+
+test_426() {
+	local osc=$($LCTL dl | awk '/-osc-[^M]/ { print $4; exit }')
+	local nthreads=4
+	local pids=""
+	local used
+
+	$LCTL get_param -n osc.$osc.osc_cached_mb | grep -q "^contended:" ||
+		skip "client does not have per-CPT LRU lists"
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile ||
+		error "setstripe $DIR/$tfile failed"
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=$((nthreads * 16)) ||
+		error "dd $DIR/$tfile failed"
+	cancel_lru_locks osc
+
+	# readers add pages to the LRU lists of several CPU partitions
+	for ((i = 0; i < nthreads; i++)); do
+		dd if=$DIR/$tfile of=/dev/null bs=1M count=16 skip=$((i * 16)) &
+		pids="$pids $!"
+	done
+	wait $pids || error "parallel read of $DIR/$tfile failed"
+
+	$LCTL get_param osc.$osc.osc_cached_mb
+	used=$($LCTL get_param -n osc.$osc.osc_cached_mb |
+	       awk '/^used_mb/ { print $2 }')
+	(( used > 0 )) || error "no page cached after read"
+
+	# pages not yet moved to the main LRU list must be shrunk too
+	$LCTL set_param osc.$osc.osc_cached_mb=0
+	used=$($LCTL get_param -n osc.$osc.osc_cached_mb |
+	       awk '/^used_mb/ { print $2 }')
+	(( used == 0 )) || error "$used MB still cached after shrink"
+}
+run_test 426 "per-CPT LRU lists are shrunk with osc_cached_mb"
+
 prep_801() {
 	[[ $(lustre_version_code mds1) -lt $(version_code 2.9.55) ]] ||
 	[[ $OST1_VERSION -lt $(version_code 2.9.55) ]] &&
@@ -896,6 +896,83 @@ test_32b() { # bug 11270
 }
 run_test 32b "lockless i/o"
 
+test_32c() {
+	remote_ost_nodsh && skip "remote OST with nodsh" && return
+
+	local facets=$(get_facets OST)
+	local p="$TMP/$TESTSUITE-$TESTNAME.parameters"
+	local ns="ldlm.namespaces.filter-*"
+	local managed
+
+	save_lustre_params client "osc.*.contention_seconds" > $p
+	save_lustre_params $facets "$ns.contended_rate" >> $p
+	save_lustre_params $facets "$ns.contention_seconds" >> $p
+	clear_stats $OSC.*.${OSC}_stats
+
+	$LFS setstripe -c 1 -i 0 $DIR1/$tfile || error "setstripe failed"
+	do_facet ost1 "lctl set_param -n $ns.contended_rate=4 \
+		$ns.contention_seconds=1"
+	lctl set_param -n $OSC.*.contention_seconds=0
+	for i in {1..10}; do
+		dd if=/dev/zero of=$DIR1/$tfile bs=4k count=1 conv=notrunc > \
+			/dev/null 2>&1
+		dd if=/dev/zero of=$DIR2/$tfile bs=4k count=1 conv=notrunc > \
+			/dev/null 2>&1
+	done
+	do_facet ost1 "lctl get_param -n $ns.contended_resources"
+	managed=$(do_facet ost1 "lctl get_param -n $ns.contended_resources" |
+		  grep -c "mode: managed")
+	[ $managed -ne 0 ] || error "contended resource is not managed"
+	[ $(calc_stats $OSC.*.${OSC}_stats lockless_write_bytes) -ne 0 ] ||
+		error "lockless i/o was not triggered"
+
+	# the conflict rate is halved every second without conflicts
+	wait_update_facet ost1 "lctl get_param -n $ns.contended_resources |
+		grep -c 'mode: managed'" 0 10 ||
+		error "resource is still managed without contention"
+
+	rm -f $DIR1/$tfile
+	restore_lustre_params <$p
+	rm -f $p
+}
+run_test 32c "server managed mode for contended resources"
+
+test_32d() {
+	remote_ost_nodsh && skip "remote OST with nodsh" && return
+	$LCTL get_param -n osc.*OST0000*.import | grep -q batch_bl_ast ||
+		skip "OST does not support batched blocking ASTs"
+
+	local ns="ldlm.namespaces.filter-*"
+	local nlocks=16
+	local batched
+	local i
+
+	$LFS setstripe -c 1 -i 0 $DIR1/$tfile || error "setstripe failed"
+	cancel_lru_locks osc
+	# lockahead locks are not expanded, client 1 gets one lock per extent
+	for ((i = 0; i < nlocks; i++)); do
+		$LFS ladvise -a lockahead -m WRITE -s $((i * 1048576)) \
+			-e $((i * 1048576 + 4095)) $DIR1/$tfile ||
+			error "lockahead $i failed"
+	done
+	$LCTL get_param -n ldlm.namespaces.*OST0000*osc*.lock_count
+
+	do_facet ost1 "$LCTL set_param -n $ns.bl_ast_stats=clear"
+	# the append lock conflicts with all of them
+	echo foo >> $DIR2/$tfile || error "append failed"
+
+	do_facet ost1 "$LCTL get_param -n $ns.bl_ast_stats"
+	batched=$(do_facet ost1 "$LCTL get_param -n $ns.bl_ast_stats" |
+		  awk '/^locks per bl AST/ { on = 1; next }
+		       /^$/ || /^bl AST/ { on = 0 }
+		       on && $1 + 0 > 1 && $2 > 0 { n += $2 }
+		       END { print n + 0 }')
+	(( batched > 0 )) || error "no blocking AST sent for several locks"
+
+	rm -f $DIR1/$tfile
+}
+run_test 32d "blocking ASTs batched per client"
+
 print_jbd_stat () {
     local dev
     local mdts=$(get_facets MDS)
@@ -496,7 +496,8 @@ command_t cmdlist[] = {
 	 "usage: test_setattr <num> [verbose [[t]objid]]"},
 	{"test_brw", jt_obd_test_brw, 0,
 	 "do <num> bulk read/writes (<npages> per I/O, on OST object <objid>)\n"
-	 "usage: test_brw [t]<num> [write [verbose [npages [[t]objid]]]]"},
+	 "with batch 'c', only set up the client pages to time them\n"
+	 "usage: test_brw [t]<num> [write [verbose [npages [[t]objid [batch]]]]]"},
 	{"getobjversion", jt_get_obj_version, 0,
 	 "get the version of an object on servers\n"
 	 "usage: getobjversion <fid>\n"
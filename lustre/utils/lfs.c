@@ -463,6 +463,7 @@ command_t cmdlist[] = {
 	 "     [[!] --stripe-count|-c [+-]<stripes>]\n"
 	 "     [[!] --stripe-index|-i <index,...>]\n"
 	 "     [[!] --stripe-size|-S [+-]N[kMGT]] [[!] --type|-t <filetype>]\n"
+	 "     [--threads=N]\n"
 	 "     [[!] --gid|-g|--group|-G <gid>|<gname>]\n"
 	 "     [[!] --uid|-u|--user|-U <uid>|<uname>] [[!] --pool <pool>]\n"
 	 "     [[!] --projid <projid>]\n"
@@ -557,7 +558,8 @@ command_t cmdlist[] = {
          "usage: flushctx [-k] [mountpoint...]"},
         {"changelog", lfs_changelog, 0,
          "Show the metadata changes on an MDT."
-         "\nusage: changelog <mdtname> [startrec [endrec]]"},
+	 "\nusage: changelog [--jobid JOBID] [--type TYPE[,...]] <mdtname> "
+	 "[startrec [endrec]]"},
         {"changelog_clear", lfs_changelog_clear, 0,
          "Indicate that old changelog records up to <endrec> are no longer of "
          "interest to consumer <id>, allowing the system to free up space.\n"
@@ -2976,6 +2978,7 @@ enum {
 	LFS_MIRROR_INDEX_OPT,
 	LFS_LAYOUT_FOREIGN_OPT,
 	LFS_MODE_OPT,
+	LFS_FIND_THREADS_OPT,
 };
 
 /* functions */
@@ -4168,6 +4171,8 @@ static int lfs_find(int argc, char **argv)
 	{ .val = 'S',	.name = "stripe_size",	.has_arg = required_argument },
 	{ .val = 't',	.name = "type",		.has_arg = required_argument },
 	{ .val = 'T',	.name = "mdt-count",	.has_arg = required_argument },
+	{ .val = LFS_FIND_THREADS_OPT,
+			.name = "threads",	.has_arg = required_argument },
 	{ .val = 'u',	.name = "uid",		.has_arg = required_argument },
 	{ .val = 'U',	.name = "user",		.has_arg = required_argument },
 	{ .val = 'z',	.name = "extension-size",
@@ -4608,6 +4613,17 @@ err_free:
 			param.fp_exclude_projid = !!neg_opt;
 			param.fp_check_projid = 1;
 			break;
+		case LFS_FIND_THREADS_OPT:
+			param.fp_threads = strtoul(optarg, &endptr, 0);
+			if (*endptr != '\0' || param.fp_threads == 0 ||
+			    param.fp_threads > 1024) {
+				fprintf(stderr,
+					"error: bad thread count '%s'\n",
+					optarg);
+				ret = -1;
+				goto err;
+			}
+			break;
 		case 's':
 			if (optarg[0] == '+') {
 				param.fp_size_sign = -1;
@@ -7391,16 +7407,39 @@ static int lfs_flushctx(int argc, char **argv)
         return rc;
 }
 
+/* Convert a comma-separated list of changelog record types into a mask */
+static int lfs_changelog_str2mask(char *list, __u64 *mask)
+{
+	char *name;
+	int type;
+
+	*mask = 0;
+	while ((name = strsep(&list, ",")) != NULL) {
+		for (type = 0; type < CL_LAST; type++)
+			if (strcasecmp(name, changelog_type2str(type)) == 0)
+				break;
+		if (type == CL_LAST)
+			return -EINVAL;
+		*mask |= 1ULL << type;
+	}
+
+	return 0;
+}
+
 static int lfs_changelog(int argc, char **argv)
 {
 	void *changelog_priv;
 	struct changelog_rec *rec;
 	long long startrec = 0, endrec = 0;
 	char *mdd;
+	char *jobid = NULL;
+	__u64 type_mask = 0;
 	struct option long_opts[] = {
 		{ .val = 'f', .name = "follow", .has_arg = no_argument },
+		{ .val = 'j', .name = "jobid", .has_arg = required_argument },
+		{ .val = 't', .name = "type", .has_arg = required_argument },
 		{ .name = NULL } };
-	char short_opts[] = "f";
+	char short_opts[] = "fj:t:";
 	int rc, follow = 0;
 
 	while ((rc = getopt_long(argc, argv, short_opts,
@@ -7409,6 +7448,17 @@ static int lfs_changelog(int argc, char **argv)
                 case 'f':
                         follow++;
                         break;
+		case 'j':
+			jobid = optarg;
+			break;
+		case 't':
+			if (lfs_changelog_str2mask(optarg, &type_mask) < 0) {
+				fprintf(stderr,
+					"%s changelog: bad record type in '%s'\n",
+					progname, optarg);
+				return CMD_HELP;
+			}
+			break;
                 default:
 			fprintf(stderr,
 				"%s changelog: unrecognized option '%s'\n",
@@ -7452,18 +7502,26 @@ static int lfs_changelog(int argc, char **argv)
 		return rc;
 	}
 
-	while ((rc = llapi_changelog_recv(changelog_priv, &rec)) == 0) {
+	if (jobid != NULL || type_mask != 0) {
+		rc = llapi_changelog_set_filter(changelog_priv, type_mask,
+						jobid);
+		if (rc < 0) {
+			fprintf(stderr,
+				"%s changelog: cannot set filter: %s\n",
+				progname, strerror(errno = -rc));
+			llapi_changelog_fini(&changelog_priv);
+			return rc;
+		}
+	}
+
+	while ((rc = llapi_changelog_recv_next(changelog_priv, &rec)) == 0) {
 		time_t secs;
 		struct tm ts;
 
-		if (endrec && rec->cr_index > endrec) {
-			llapi_changelog_free(&rec);
+		if (endrec && rec->cr_index > endrec)
 			break;
-		}
-		if (rec->cr_index < startrec) {
-			llapi_changelog_free(&rec);
+		if (rec->cr_index < startrec)
 			continue;
-		}
 
 		secs = rec->cr_time >> 30;
 		gmtime_r(&secs, &ts);
@@ -7554,8 +7612,6 @@ static int lfs_changelog(int argc, char **argv)
 				       changelog_rec_sname(rec));
 		}
 		printf("\n");
-
-		llapi_changelog_free(&rec);
 	}
 
 	llapi_changelog_fini(&changelog_priv);
@@ -10961,6 +11017,10 @@ static int lfs_pcc_state(int argc, char **argv)
 		printf(", PCC file: %s", state.pccs_path);
 		printf(", user number: %u", state.pccs_open_count);
 		printf(", flags: %x", state.pccs_flags);
+		if (state.pccs_flags & PCC_STATE_FL_WB_FLUSHING)
+			printf(", write-back: flushing");
+		else if (state.pccs_flags & PCC_STATE_FL_WB_PENDING)
+			printf(", write-back: pending");
 		printf("\n");
 	}
 	return rc;
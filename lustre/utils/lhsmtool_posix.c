@@ -93,6 +93,7 @@ struct options {
 	int			 o_report_int;
 	unsigned long long	 o_bandwidth;
 	size_t			 o_chunk_size;
+	int			 o_copy_threads;
 	enum ct_action		 o_action;
 	char			*o_event_fifo;
 	char			*o_mnt;
@@ -110,6 +111,7 @@ struct options opt = {
 	.o_copy_xattrs = 1,
 	.o_report_int = REPORT_INTERVAL_DEFAULT,
 	.o_chunk_size = ONE_MB,
+	.o_copy_threads = 1,
 };
 
 /* hsm_copytool_private will hold an open FD on the lustre mount point
@@ -200,6 +202,8 @@ static void usage(const char *name, int rc)
 	"   -f, --event-fifo <path>   Write events stream to fifo\n"
 	"   -p, --hsm-root <path>     Target HSM mount point\n"
 	"   -q, --quiet               Produce less verbose output\n"
+	"   -t, --threads <n>         Number of threads copying the data\n"
+	"                             of each file (default 1)\n"
 	"   -u, --update-interval <s> Interval between progress reports sent\n"
 	"                             to Coordinator\n"
 	"   -v, --verbose             Produce more verbose output\n",
@@ -245,6 +249,7 @@ static int ct_parseopts(int argc, char * const *argv)
 	{ .val = 'p',	.name = "hsm_root",	.has_arg = required_argument },
 	{ .val = 'q',	.name = "quiet",	.has_arg = no_argument },
 	{ .val = 'r',	.name = "rebind",	.has_arg = no_argument },
+	{ .val = 't',	.name = "threads",	.has_arg = required_argument },
 	{ .val = 'u',	.name = "update-interval",
 						.has_arg = required_argument },
 	{ .val = 'u',	.name = "update_interval",
@@ -265,7 +270,7 @@ static int ct_parseopts(int argc, char * const *argv)
 	if (opt.o_archive_id == NULL)
 		return -ENOMEM;
 repeat:
-	while ((c = getopt_long(argc, argv, "A:b:c:f:hiMp:qru:v",
+	while ((c = getopt_long(argc, argv, "A:b:c:f:hiMp:qrt:u:v",
 				long_opts, NULL)) != -1) {
 		switch (c) {
 		case 'A': {
@@ -349,6 +354,15 @@ repeat:
 		case 'r':
 			opt.o_action = CA_REBIND;
 			break;
+		case 't':
+			opt.o_copy_threads = atoi(optarg);
+			if (opt.o_copy_threads < 1) {
+				rc = -EINVAL;
+				CT_ERROR(rc, "bad value for -%c '%s'", c,
+					 optarg);
+				return rc;
+			}
+			break;
 		case 'u':
 			opt.o_report_int = atoi(optarg);
 			if (opt.o_report_int < 0) {
@@ -571,6 +585,209 @@ static int ct_restore_stripe(const char *src, const char *dst, int dst_fd,
 	return rc;
 }
 
+/* State of a data copy shared by the copy threads, see ct_copy_data() */
+struct ct_copy_job {
+	pthread_mutex_t		 cj_mutex;
+	const char		*cj_src;
+	const char		*cj_dst;
+	int			 cj_src_fd;
+	int			 cj_dst_fd;
+	/* next offset to copy, and end of the extent to copy */
+	__u64			 cj_next;
+	__u64			 cj_end;
+	/* bytes copied or skipped as holes */
+	__u64			 cj_done;
+	/* bytes skipped as holes */
+	__u64			 cj_holes;
+	/* first error met by a thread, or cancel by the coordinator */
+	int			 cj_rc;
+	bool			 cj_sparse;
+	/* bandwidth control */
+	time_t			 cj_start_time;
+	time_t			 cj_last_bw_print;
+};
+
+/* sleep if needed, to honor bandwidth limits */
+static void ct_copy_throttle(struct ct_copy_job *job)
+{
+	unsigned long long	write_theory;
+	unsigned long long	excess;
+	struct timespec		delay;
+	time_t			now = time(NULL);
+	int			rc;
+
+	pthread_mutex_lock(&job->cj_mutex);
+	write_theory = (now - job->cj_start_time) * opt.o_bandwidth;
+	if (write_theory >= job->cj_done - job->cj_holes) {
+		pthread_mutex_unlock(&job->cj_mutex);
+		return;
+	}
+
+	excess = job->cj_done - job->cj_holes - write_theory;
+
+	delay.tv_sec = excess / opt.o_bandwidth;
+	delay.tv_nsec = (excess % opt.o_bandwidth) *
+		NSEC_PER_SEC / opt.o_bandwidth;
+
+	if (now >= job->cj_last_bw_print + opt.o_report_int) {
+		CT_TRACE("bandwith control: %lluB/s excess=%llu sleep for %lld.%09lds",
+			 (unsigned long long)opt.o_bandwidth,
+			 (unsigned long long)excess,
+			 (long long)delay.tv_sec, delay.tv_nsec);
+		job->cj_last_bw_print = now;
+	}
+	pthread_mutex_unlock(&job->cj_mutex);
+
+	do {
+		rc = nanosleep(&delay, &delay);
+	} while (rc < 0 && errno == EINTR);
+	if (rc < 0)
+		CT_ERROR(errno, "delay for bandwidth control failed to sleep: "
+			 "residual=%lld.%09lds",
+			 (long long)delay.tv_sec, delay.tv_nsec);
+}
+
+/*
+ * Pick the next chunk to copy, skipping holes of the source file.
+ * Returns the chunk length, 0 when the whole extent is copied or the copy
+ * failed. Called with cj_mutex held.
+ */
+static size_t ct_copy_next_chunk(struct ct_copy_job *job, __u64 *offset)
+{
+	__u64	chunk;
+	off_t	data;
+	off_t	hole;
+
+	if (job->cj_rc < 0 || job->cj_next >= job->cj_end)
+		return 0;
+
+	if (job->cj_sparse) {
+		data = lseek(job->cj_src_fd, job->cj_next, SEEK_DATA);
+		if (data < 0 && errno == ENXIO) {
+			/* only a hole up to the end of file */
+			data = job->cj_end;
+		} else if (data < 0) {
+			/* SEEK_DATA is not supported, copy everything */
+			job->cj_sparse = false;
+			data = job->cj_next;
+		}
+
+		if (data > job->cj_end)
+			data = job->cj_end;
+		if (data > job->cj_next) {
+			job->cj_holes += data - job->cj_next;
+			job->cj_done += data - job->cj_next;
+			job->cj_next = data;
+		}
+		if (job->cj_next >= job->cj_end)
+			return 0;
+	}
+
+	chunk = job->cj_end - job->cj_next;
+	if (chunk > opt.o_chunk_size)
+		chunk = opt.o_chunk_size;
+
+	if (job->cj_sparse) {
+		/* don't read the zeroes of the next hole */
+		hole = lseek(job->cj_src_fd, job->cj_next, SEEK_HOLE);
+		if (hole > job->cj_next && hole - job->cj_next < chunk)
+			chunk = hole - job->cj_next;
+	}
+
+	*offset = job->cj_next;
+	job->cj_next += chunk;
+
+	return chunk;
+}
+
+/*
+ * Copy chunks until the whole extent is copied, or an error happens.
+ * Returns the number of bytes copied by this call when \a once is set,
+ * after a single chunk, or 0 when there is nothing left to copy.
+ */
+static ssize_t ct_copy_chunks(struct ct_copy_job *job, char *buf, bool once)
+{
+	ssize_t	copied = 0;
+	ssize_t	rsize;
+	ssize_t	wsize;
+	size_t	chunk;
+	size_t	pos;
+	__u64	offset;
+	int	rc = 0;
+
+	while (rc == 0) {
+		pthread_mutex_lock(&job->cj_mutex);
+		chunk = ct_copy_next_chunk(job, &offset);
+		pthread_mutex_unlock(&job->cj_mutex);
+		if (chunk == 0)
+			break;
+
+		for (pos = 0; pos < chunk; pos += wsize) {
+			rsize = pread(job->cj_src_fd, buf, chunk - pos,
+				      offset + pos);
+			if (rsize == 0) {
+				/* EOF */
+				wsize = chunk - pos;
+				break;
+			}
+
+			if (rsize < 0) {
+				rc = -errno;
+				CT_ERROR(rc, "cannot read from '%s'",
+					 job->cj_src);
+				break;
+			}
+
+			wsize = pwrite(job->cj_dst_fd, buf, rsize,
+				       offset + pos);
+			if (wsize < 0) {
+				rc = -errno;
+				CT_ERROR(rc, "cannot write to '%s'",
+					 job->cj_dst);
+				break;
+			}
+		}
+
+		pthread_mutex_lock(&job->cj_mutex);
+		if (rc < 0 && job->cj_rc == 0)
+			job->cj_rc = rc;
+		job->cj_done += chunk;
+		pthread_mutex_unlock(&job->cj_mutex);
+		copied += chunk;
+
+		if (opt.o_bandwidth != 0)
+			ct_copy_throttle(job);
+
+		if (once)
+			break;
+	}
+
+	return rc < 0 ? rc : copied;
+}
+
+struct ct_copy_thread {
+	pthread_t		 ct_thread;
+	struct ct_copy_job	*ct_job;
+	char			*ct_buf;
+};
+
+static void *ct_copy_thread(void *data)
+{
+	struct ct_copy_thread *cth = data;
+
+	ct_copy_chunks(cth->ct_job, cth->ct_buf, false);
+
+	return NULL;
+}
+
+/*
+ * Copy the extent of the action from \a src_fd to \a dst_fd.
+ *
+ * With --threads, the extent is split in chunks of --chunk-size bytes,
+ * copied in parallel by the helper threads and the calling thread, which
+ * also reports progress to the coordinator between its own chunks. Holes
+ * of the source file are not copied.
+ */
 static int ct_copy_data(struct hsm_copyaction_private *hcp, const char *src,
 			const char *dst, int src_fd, int dst_fd,
 			const struct hsm_action_item *hai, long hal_flags)
@@ -579,16 +796,16 @@ static int ct_copy_data(struct hsm_copyaction_private *hcp, const char *src,
 	__u64			 offset = hai->hai_extent.offset;
 	struct stat		 src_st;
 	struct stat		 dst_st;
+	struct ct_copy_job	 job;
+	struct ct_copy_thread	*threads = NULL;
+	int			 nthreads = 0;
 	char			*buf = NULL;
-	__u64			 write_total = 0;
 	__u64			 length = hai->hai_extent.length;
 	time_t			 last_report_time;
+	ssize_t			 copied;
 	int			 rc = 0;
+	int			 i;
 	double			 start_ct_now = ct_now();
-	/* Bandwidth Control */
-	time_t			start_time;
-	time_t			now;
-	time_t			last_bw_print;
 
 	if (fstat(src_fd, &src_st) < 0) {
 		rc = -errno;
@@ -627,7 +844,17 @@ static int ct_copy_data(struct hsm_copyaction_private *hcp, const char *src,
 	if (length > src_st.st_size - hai->hai_extent.offset)
 		length = src_st.st_size - hai->hai_extent.offset;
 
-	start_time = last_bw_print = last_report_time = time(NULL);
+	memset(&job, 0, sizeof(job));
+	pthread_mutex_init(&job.cj_mutex, NULL);
+	job.cj_src = src;
+	job.cj_dst = dst;
+	job.cj_src_fd = src_fd;
+	job.cj_dst_fd = dst_fd;
+	job.cj_next = offset;
+	job.cj_end = offset + length;
+	job.cj_sparse = true;
+	job.cj_start_time = job.cj_last_bw_print = time(NULL);
+	last_report_time = job.cj_start_time;
 
 	he.offset = offset;
 	he.length = 0;
@@ -642,102 +869,92 @@ static int ct_copy_data(struct hsm_copyaction_private *hcp, const char *src,
 
 	errno = 0;
 
-	buf = malloc(opt.o_chunk_size);
-	if (buf == NULL) {
+	/* aligned buffers let the file systems do direct I/O if they want */
+	if (posix_memalign((void **)&buf, sysconf(_SC_PAGESIZE),
+			   opt.o_chunk_size) != 0) {
 		rc = -ENOMEM;
 		goto out;
 	}
 
-	CT_TRACE("start copy of %ju bytes from '%s' to '%s'",
-		 (uintmax_t)length, src, dst);
-
-	while (write_total < length) {
-		ssize_t	rsize;
-		ssize_t	wsize;
-		int	chunk = (length - write_total > opt.o_chunk_size) ?
-				 opt.o_chunk_size : length - write_total;
+	CT_TRACE("start copy of %ju bytes from '%s' to '%s' with %d threads",
+		 (uintmax_t)length, src, dst, opt.o_copy_threads);
 
-		rsize = pread(src_fd, buf, chunk, offset);
-		if (rsize == 0)
-			/* EOF */
-			break;
+	/* no need for threads if there is only a chunk to copy */
+	if (opt.o_copy_threads > 1 && length > opt.o_chunk_size) {
+		threads = calloc(opt.o_copy_threads - 1, sizeof(*threads));
+		if (threads == NULL) {
+			rc = -ENOMEM;
+			goto out;
+		}
+	}
 
-		if (rsize < 0) {
-			rc = -errno;
-			CT_ERROR(rc, "cannot read from '%s'", src);
+	for (i = 0; threads != NULL && i < opt.o_copy_threads - 1; i++) {
+		threads[i].ct_job = &job;
+		if (posix_memalign((void **)&threads[i].ct_buf,
+				   sysconf(_SC_PAGESIZE), opt.o_chunk_size)) {
+			CT_WARN("cannot allocate buffer of copy thread %d, "
+				"continuing with %d threads", i + 1, i + 1);
 			break;
 		}
 
-		wsize = pwrite(dst_fd, buf, rsize, offset);
-		if (wsize < 0) {
-			rc = -errno;
-			CT_ERROR(rc, "cannot write to '%s'", dst);
+		rc = pthread_create(&threads[i].ct_thread, NULL,
+				    ct_copy_thread, &threads[i]);
+		if (rc != 0) {
+			CT_WARN("cannot start copy thread %d: %s, "
+				"continuing with %d threads", i + 1,
+				strerror(rc), i + 1);
+			free(threads[i].ct_buf);
+			rc = 0;
 			break;
 		}
+		nthreads++;
+	}
 
-		write_total += wsize;
-		offset += wsize;
-
-		now = time(NULL);
-		/* sleep if needed, to honor bandwidth limits */
-		if (opt.o_bandwidth != 0) {
-			unsigned long long write_theory;
-
-			write_theory = (now - start_time) * opt.o_bandwidth;
-
-			if (write_theory < write_total) {
-				unsigned long long	excess;
-				struct timespec		delay;
+	while (1) {
+		copied = ct_copy_chunks(&job, buf, true);
+		if (copied <= 0)
+			break;
 
-				excess = write_total - write_theory;
+		if (time(NULL) < last_report_time + opt.o_report_int)
+			continue;
 
-				delay.tv_sec = excess / opt.o_bandwidth;
-				delay.tv_nsec = (excess % opt.o_bandwidth) *
-					NSEC_PER_SEC / opt.o_bandwidth;
+		last_report_time = time(NULL);
+		pthread_mutex_lock(&job.cj_mutex);
+		he.length = job.cj_done - (he.offset - offset);
+		pthread_mutex_unlock(&job.cj_mutex);
+		CT_TRACE("%%%ju ", (uintmax_t)(100 *
+			 (he.offset - offset + he.length) / length));
+		/* only give the length of the write since the last
+		 * progress report */
+		rc = llapi_hsm_action_progress(hcp, &he, length, 0);
+		if (rc < 0) {
+			/* Action has been canceled or something wrong
+			 * is happening. Stop copying data. */
+			CT_ERROR(rc, "progress ioctl for copy"
+				 " '%s'->'%s' failed", src, dst);
+			pthread_mutex_lock(&job.cj_mutex);
+			if (job.cj_rc == 0)
+				job.cj_rc = rc;
+			pthread_mutex_unlock(&job.cj_mutex);
+			break;
+		}
+		he.offset += he.length;
+	}
 
-				if (now >= last_bw_print + opt.o_report_int) {
-					CT_TRACE("bandwith control: %lluB/s "
-						 "excess=%llu sleep for "
-						 "%lld.%09lds",
-						 (unsigned long long)opt.o_bandwidth,
-						 (unsigned long long)excess,
-						 (long long)delay.tv_sec,
-						 delay.tv_nsec);
-					last_bw_print = now;
-				}
+	for (i = 0; i < nthreads; i++) {
+		pthread_join(threads[i].ct_thread, NULL);
+		free(threads[i].ct_buf);
+	}
 
-				do {
-					rc = nanosleep(&delay, &delay);
-				} while (rc < 0 && errno == EINTR);
-				if (rc < 0) {
-					CT_ERROR(errno, "delay for bandwidth "
-						 "control failed to sleep: "
-						 "residual=%lld.%09lds",
-						 (long long)delay.tv_sec,
-						 delay.tv_nsec);
-					rc = 0;
-				}
-			}
-		}
+	rc = job.cj_rc;
 
-		now = time(NULL);
-		if (now >= last_report_time + opt.o_report_int) {
-			last_report_time = now;
-			CT_TRACE("%%%ju ", (uintmax_t)(100 * write_total / length));
-			/* only give the length of the write since the last
-			 * progress report */
-			he.length = offset - he.offset;
-			rc = llapi_hsm_action_progress(hcp, &he, length, 0);
-			if (rc < 0) {
-				/* Action has been canceled or something wrong
-				 * is happening. Stop copying data. */
-				CT_ERROR(rc, "progress ioctl for copy"
-					 " '%s'->'%s' failed", src, dst);
-				goto out;
-			}
-			he.offset = offset;
-		}
-		rc = 0;
+	/* the source ends with a hole which was not copied */
+	if (rc == 0 && job.cj_holes != 0 &&
+	    fstat(dst_fd, &dst_st) == 0 && dst_st.st_size < job.cj_end &&
+	    ftruncate(dst_fd, job.cj_end) < 0) {
+		rc = -errno;
+		CT_ERROR(rc, "cannot extend '%s' to size %ju",
+			 dst, (uintmax_t)job.cj_end);
 	}
 
 out:
@@ -761,11 +978,15 @@ out:
 		}
 	}
 
+	if (threads != NULL)
+		free(threads);
 	if (buf != NULL)
 		free(buf);
+	pthread_mutex_destroy(&job.cj_mutex);
 
-	CT_TRACE("copied %ju bytes in %f seconds",
-		 (uintmax_t)length, ct_now() - start_ct_now);
+	CT_TRACE("copied %ju bytes (%ju in holes) in %f seconds",
+		 (uintmax_t)length, (uintmax_t)job.cj_holes,
+		 ct_now() - start_ct_now);
 
 	return rc;
 }
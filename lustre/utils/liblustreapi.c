@@ -71,8 +71,12 @@
 #include <poll.h>
 #include <time.h>
 #include <inttypes.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 #include <libcfs/util/ioctl.h>
+#include <libcfs/util/list.h>
 #include <libcfs/util/param.h>
 #include <libcfs/util/string.h>
 #include <linux/lnet/lnetctl.h>
@@ -4480,6 +4484,77 @@ static bool find_check_lmm_info(struct find_param *param)
 	       param->fp_check_projid;
 }
 
+/*
+ * Whether the entry can be checked against its layout alone, so that the
+ * attributes of a regular file don't need to be fetched with it. The type
+ * of the file is then taken from the dirent.
+ */
+static bool find_check_layout_only(struct find_param *param, DIR *dir,
+				   struct dirent64 *de)
+{
+	if (dir != NULL || de == NULL || de->d_type != DT_REG)
+		return false;
+
+	if (!find_check_lmm_info(param) && !param->fp_obd_uuid)
+		return false;
+
+	return !(param->fp_mdt_uuid ||
+		 param->fp_check_uid || param->fp_check_gid ||
+		 param->fp_atime || param->fp_mtime || param->fp_ctime ||
+		 param->fp_check_size || param->fp_check_blocks ||
+		 param->fp_check_mdt_count || param->fp_check_hash_type);
+}
+
+/*
+ * Get the layout of a regular file in fp_lmd, and fill in the few
+ * attributes checked along with it, see find_check_layout_only().
+ */
+static int find_get_layout(char *path, DIR *parent, struct find_param *param,
+			   struct dirent64 *de)
+{
+	lstatx_t *stx = &param->fp_lmd->lmd_stx;
+	struct stat st;
+	int ret;
+
+	memset(stx, 0, sizeof(*stx));
+	stx->stx_mode = DTTOIF(de->d_type);
+	param->fp_lmd->lmd_flags = 0;
+
+	/* the device is needed to notice a mount point was crossed */
+	if (param->fp_obd_uuid) {
+		if (fstat(dirfd(parent), &st) < 0)
+			return -errno;
+		stx->stx_dev_major = major(st.st_dev);
+		stx->stx_dev_minor = minor(st.st_dev);
+	}
+
+	ret = get_lmd_info(path, parent, NULL, &param->fp_lmd->lmd_lmm,
+			   param->fp_lum_size, GET_LMD_STRIPE);
+	if (ret == 0)
+		return 0;
+
+	switch (errno) {
+	case ENODATA:
+		/* no layout, use the default one, see cb_find_init() */
+		param->fp_lmd->lmd_lmm.lmm_magic = 0;
+		return 0;
+	case ENOTTY:
+		/* not a lustre fs, let get_lmd_info() do a lstat() */
+		return get_lmd_info(path, parent, NULL, param->fp_lmd,
+				    param->fp_lum_size, GET_LMD_INFO);
+	case ENOENT:
+		ret = -errno;
+		llapi_error(LLAPI_MSG_WARN, ret,
+			    "warning: %s does not exist", path);
+		return ret;
+	default:
+		ret = -errno;
+		llapi_error(LLAPI_MSG_ERROR, ret,
+			    "IOC_MDC_GETFILESTRIPE ioctl failed for %s.", path);
+		return ret;
+	}
+}
+
 /*
  * Get file/directory project id.
  * by the open fd resides on.
@@ -4573,8 +4648,11 @@ static int cb_find_init(char *path, DIR *parent, DIR **dirp,
 		}
 
 		param->fp_lmd->lmd_lmm.lmm_magic = 0;
-		ret = get_lmd_info(path, parent, dir, param->fp_lmd,
-				   param->fp_lum_size, GET_LMD_INFO);
+		if (find_check_layout_only(param, dir, de))
+			ret = find_get_layout(path, parent, param, de);
+		else
+			ret = get_lmd_info(path, parent, dir, param->fp_lmd,
+					   param->fp_lum_size, GET_LMD_INFO);
 		if (ret == 0 && param->fp_lmd->lmd_lmm.lmm_magic == 0 &&
 		    find_check_lmm_info(param)) {
 			struct lov_user_md *lmm = &param->fp_lmd->lmd_lmm;
@@ -4909,11 +4987,9 @@ obd_matches:
 	}
 
 foreign:
-	llapi_printf(LLAPI_MSG_NORMAL, "%s", path);
-	if (param->fp_zero_end)
-		llapi_printf(LLAPI_MSG_NORMAL, "%c", '\0');
-	else
-		llapi_printf(LLAPI_MSG_NORMAL, "\n");
+	/* a single call, so that lines printed by find threads don't mix */
+	llapi_printf(LLAPI_MSG_NORMAL, "%s%c", path,
+		     param->fp_zero_end ? '\0' : '\n');
 
 decided:
 	ret = 0;
@@ -5087,8 +5163,330 @@ int llapi_mv(char *path, struct find_param *param)
 	return llapi_migrate_mdt(path, param);
 }
 
+#ifdef HAVE_LIBPTHREAD
+/*
+ * Parallel namespace walk for llapi_find(), when fp_threads > 1.
+ *
+ * Each thread walks whole directories with its own copy of the find_param.
+ * The subdirectories it finds are queued at the head of its own deque, and
+ * it takes its next directory from there, so it goes depth first. A thread
+ * with an empty deque steals from the tail of the others, which holds the
+ * directories closest to the top of the tree and so the largest subtrees.
+ * Matching files are printed in the order they are found.
+ */
+struct find_dir {
+	struct list_head	 fdr_link;
+	unsigned int		 fdr_depth;
+	char			 fdr_path[0];
+};
+
+struct find_pool;
+
+struct find_worker {
+	struct find_pool	*fw_pool;
+	pthread_t		 fw_thread;
+	/* protects fw_dirs */
+	pthread_mutex_t		 fw_lock;
+	struct list_head	 fw_dirs;
+	struct find_param	 fw_param;
+	unsigned int		 fw_seed;
+	int			 fw_rc;
+	char			 fw_path[PATH_MAX + 1];
+};
+
+struct find_pool {
+	/* protects the counters below, taken after fw_lock */
+	pthread_mutex_t		 fpl_lock;
+	pthread_cond_t		 fpl_cond;
+	/* directories in the deques */
+	unsigned int		 fpl_queued;
+	/* directories in the deques or being walked */
+	unsigned int		 fpl_pending;
+	unsigned int		 fpl_idle;
+	unsigned int		 fpl_count;
+	struct find_worker	*fpl_workers;
+};
+
+static int find_dir_push(struct find_worker *fw, const char *path,
+			 unsigned int depth)
+{
+	struct find_pool *pool = fw->fw_pool;
+	struct find_dir *fdr;
+
+	fdr = malloc(sizeof(*fdr) + strlen(path) + 1);
+	if (fdr == NULL)
+		return -ENOMEM;
+	fdr->fdr_depth = depth;
+	strcpy(fdr->fdr_path, path);
+
+	pthread_mutex_lock(&fw->fw_lock);
+	list_add(&fdr->fdr_link, &fw->fw_dirs);
+	pthread_mutex_lock(&pool->fpl_lock);
+	pool->fpl_queued++;
+	pool->fpl_pending++;
+	if (pool->fpl_idle > 0)
+		pthread_cond_signal(&pool->fpl_cond);
+	pthread_mutex_unlock(&pool->fpl_lock);
+	pthread_mutex_unlock(&fw->fw_lock);
+
+	return 0;
+}
+
+/* Take the newest directory of \a fw, or the oldest one if \a steal */
+static struct find_dir *find_dir_take(struct find_worker *fw, bool steal)
+{
+	struct find_pool *pool = fw->fw_pool;
+	struct find_dir *fdr = NULL;
+
+	pthread_mutex_lock(&fw->fw_lock);
+	if (!list_empty(&fw->fw_dirs)) {
+		if (steal)
+			fdr = list_entry(fw->fw_dirs.prev, struct find_dir,
+					 fdr_link);
+		else
+			fdr = list_entry(fw->fw_dirs.next, struct find_dir,
+					 fdr_link);
+		list_del(&fdr->fdr_link);
+		pthread_mutex_lock(&pool->fpl_lock);
+		pool->fpl_queued--;
+		pthread_mutex_unlock(&pool->fpl_lock);
+	}
+	pthread_mutex_unlock(&fw->fw_lock);
+
+	return fdr;
+}
+
+/*
+ * Check a directory and its entries, like llapi_semantic_traverse() does,
+ * but queue the subdirectories instead of walking them.
+ */
+static int find_walk_dir(struct find_worker *fw, struct find_dir *fdr)
+{
+	struct find_param *param = &fw->fw_param;
+	struct dirent64 dir_de = { .d_type = DT_DIR };
+	struct dirent64 *dent;
+	char *path = fw->fw_path;
+	int size = sizeof(fw->fw_path);
+	int len;
+	int ret;
+	DIR *d;
+
+	snprintf(path, size, "%s", fdr->fdr_path);
+	len = strlen(path);
+
+	d = opendir(path);
+	if (d == NULL) {
+		ret = -errno;
+		llapi_error(LLAPI_MSG_ERROR, ret, "%s: Failed to open '%s'",
+			    __func__, path);
+		return ret;
+	}
+
+	param->fp_depth = fdr->fdr_depth;
+	ret = cb_find_init(path, NULL, &d, param,
+			   fdr->fdr_depth == 0 ? NULL : &dir_de);
+	if (ret)
+		goto out;
+
+	while ((dent = readdir64(d)) != NULL) {
+		int rc;
+
+		if (!strcmp(dent->d_name, ".") || !strcmp(dent->d_name, ".."))
+			continue;
+
+		path[len] = 0;
+		if ((len + dent->d_reclen + 2) > size) {
+			llapi_err_noerrno(LLAPI_MSG_ERROR,
+					  "error: %s: string buffer too small",
+					  __func__);
+			break;
+		}
+		strcat(path, "/");
+		strcat(path, dent->d_name);
+
+		if (dent->d_type == DT_UNKNOWN) {
+			lstatx_t *stx = &param->fp_lmd->lmd_stx;
+
+			rc = get_lmd_info(path, d, NULL, param->fp_lmd,
+					  param->fp_lum_size, GET_LMD_INFO);
+			if (rc == 0)
+				dent->d_type = IFTODT(stx->stx_mode);
+			else if (ret == 0)
+				ret = rc;
+
+			if (rc == -ENOENT)
+				continue;
+		}
+
+		switch (dent->d_type) {
+		case DT_UNKNOWN:
+			llapi_err_noerrno(LLAPI_MSG_ERROR,
+					  "error: %s: '%s' is UNKNOWN type %d",
+					  __func__, dent->d_name, dent->d_type);
+			break;
+		case DT_DIR:
+			rc = find_dir_push(fw, path, param->fp_depth);
+			if (rc != 0 && ret == 0)
+				ret = rc;
+			break;
+		default:
+			rc = cb_find_init(path, d, NULL, param, dent);
+			if (rc < 0 && ret == 0) {
+				ret = rc;
+				break;
+			}
+			if (rc == 0)
+				cb_common_fini(path, d, NULL, param, dent);
+		}
+	}
+
+	path[len] = 0;
+	cb_common_fini(path, NULL, &d, param, NULL);
+out:
+	closedir(d);
+
+	return ret;
+}
+
+static void *find_worker_main(void *arg)
+{
+	struct find_worker *fw = arg;
+	struct find_pool *pool = fw->fw_pool;
+	struct find_dir *fdr;
+	unsigned int start;
+	unsigned int i;
+	bool done;
+	int rc;
+
+	while (1) {
+		fdr = find_dir_take(fw, false);
+		start = fdr == NULL ? rand_r(&fw->fw_seed) : 0;
+		for (i = 0; fdr == NULL && i < pool->fpl_count; i++) {
+			struct find_worker *victim;
+
+			victim = &pool->fpl_workers[(start + i) %
+						    pool->fpl_count];
+			if (victim != fw)
+				fdr = find_dir_take(victim, true);
+		}
+
+		if (fdr != NULL) {
+			rc = find_walk_dir(fw, fdr);
+			if (rc < 0 && fw->fw_rc == 0)
+				fw->fw_rc = rc;
+			free(fdr);
+
+			pthread_mutex_lock(&pool->fpl_lock);
+			if (--pool->fpl_pending == 0)
+				pthread_cond_broadcast(&pool->fpl_cond);
+			pthread_mutex_unlock(&pool->fpl_lock);
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->fpl_lock);
+		pool->fpl_idle++;
+		while (pool->fpl_queued == 0 && pool->fpl_pending > 0)
+			pthread_cond_wait(&pool->fpl_cond, &pool->fpl_lock);
+		pool->fpl_idle--;
+		done = pool->fpl_pending == 0;
+		pthread_mutex_unlock(&pool->fpl_lock);
+		if (done)
+			break;
+	}
+
+	return NULL;
+}
+
+static int find_parallel(char *path, struct find_param *param)
+{
+	struct find_pool pool = { .fpl_count = param->fp_threads };
+	struct find_worker *fw;
+	unsigned int started = 0;
+	unsigned int i;
+	int ret = 0;
+	int rc = 0;
+
+	pool.fpl_workers = calloc(pool.fpl_count, sizeof(*pool.fpl_workers));
+	if (pool.fpl_workers == NULL)
+		return -ENOMEM;
+	pthread_mutex_init(&pool.fpl_lock, NULL);
+	pthread_cond_init(&pool.fpl_cond, NULL);
+
+	for (i = 0; i < pool.fpl_count; i++) {
+		fw = &pool.fpl_workers[i];
+		fw->fw_pool = &pool;
+		fw->fw_seed = i + 1;
+		pthread_mutex_init(&fw->fw_lock, NULL);
+		INIT_LIST_HEAD(&fw->fw_dirs);
+	}
+
+	for (i = 0; i < pool.fpl_count; i++) {
+		fw = &pool.fpl_workers[i];
+		/* private buffers, and target indexes set up by each thread */
+		fw->fw_param = *param;
+		fw->fw_param.fp_lmd = NULL;
+		fw->fw_param.fp_lmv_md = NULL;
+		fw->fw_param.fp_obd_indexes = NULL;
+		fw->fw_param.fp_mdt_indexes = NULL;
+		ret = common_param_init(&fw->fw_param, path);
+		if (ret)
+			goto out;
+	}
+
+	ret = find_dir_push(&pool.fpl_workers[0], path, 0);
+	if (ret)
+		goto out;
+
+	for (i = 0; i < pool.fpl_count; i++) {
+		fw = &pool.fpl_workers[i];
+		rc = pthread_create(&fw->fw_thread, NULL, find_worker_main, fw);
+		if (rc) {
+			/* the threads already started do all the work */
+			llapi_error(LLAPI_MSG_WARN, -rc,
+				    "cannot start find thread %u", i);
+			break;
+		}
+		started++;
+	}
+
+	if (started == 0) {
+		ret = -rc;
+		free(find_dir_take(&pool.fpl_workers[0], false));
+		goto out;
+	}
+
+	for (i = 0; i < started; i++) {
+		fw = &pool.fpl_workers[i];
+		pthread_join(fw->fw_thread, NULL);
+		if (fw->fw_rc < 0 && ret == 0)
+			ret = fw->fw_rc;
+	}
+out:
+	for (i = 0; i < pool.fpl_count; i++) {
+		fw = &pool.fpl_workers[i];
+		if (fw->fw_param.fp_mdt_indexes != NULL)
+			free(fw->fw_param.fp_mdt_indexes);
+		find_param_fini(&fw->fw_param);
+		pthread_mutex_destroy(&fw->fw_lock);
+	}
+	pthread_cond_destroy(&pool.fpl_cond);
+	pthread_mutex_destroy(&pool.fpl_lock);
+	free(pool.fpl_workers);
+
+	return ret;
+}
+#endif /* HAVE_LIBPTHREAD */
+
 int llapi_find(char *path, struct find_param *param)
 {
+#ifdef HAVE_LIBPTHREAD
+	struct stat st;
+
+	/* single files are checked by the calling thread */
+	if (param->fp_threads > 1 && strlen(path) <= PATH_MAX &&
+	    stat(path, &st) == 0 && S_ISDIR(st.st_mode))
+		return find_parallel(path, param);
+#endif
         return param_callback(path, cb_find_init, cb_common_fini, param);
 }
 
@@ -57,7 +57,7 @@ static int chlg_dev_path(char *path, size_t path_len, const char *device)
 }
 
 #define CHANGELOG_PRIV_MAGIC 0xCA8E1080
-#define CHANGELOG_BUFFER_SZ  4096
+#define CHANGELOG_BUFFER_SZ  65536
 
 /**
  * Record state for efficient changelog consumption.
@@ -76,6 +76,8 @@ struct changelog_private {
 	size_t				 clp_buf_len;
 	/* Current position in buffer */
 	char				*clp_buf_pos;
+	/* Record returned by llapi_changelog_recv_next() */
+	struct changelog_rec		*clp_rec;
 	/* Read buffer with records read from system */
 	char				 clp_buf[0];
 };
@@ -102,11 +104,15 @@ int llapi_changelog_start(void **priv, enum changelog_send_flag flags,
 	if (rc != 0)
 		return rc;
 
-	/* Set up the receiver control struct */
-	cp = calloc(1, sizeof(*cp) + CHANGELOG_BUFFER_SZ);
+	/* Set up the receiver control struct, followed by the read buffer
+	 * and by a record for llapi_changelog_recv_next() */
+	cp = calloc(1, sizeof(*cp) + CHANGELOG_BUFFER_SZ + CR_MAXSIZE);
 	if (cp == NULL)
 		return -ENOMEM;
 
+	cp->clp_rec = (struct changelog_rec *)(cp->clp_buf +
+					       CHANGELOG_BUFFER_SZ);
+
 	cp->clp_magic = CHANGELOG_PRIV_MAGIC;
 	cp->clp_send_flags = flags;
 
@@ -215,31 +221,22 @@ int llapi_changelog_get_fd(void *priv)
 	return cp->clp_fd;
 }
 
-/** Read the next changelog entry
- * @param priv Opaque private control structure
- * @param rech Changelog record handle; record will be allocated here
- * @return 0 valid message received; rec is set
- *	 <0 error code
- *	 1 EOF
- */
 #define DEFAULT_RECORD_FMT	(CLF_VERSION | CLF_RENAME)
-int llapi_changelog_recv(void *priv, struct changelog_rec **rech)
+
+/**
+ * Copy the next record of the read buffer into \a rec, refilling the buffer
+ * when it is empty, and convert it to the format asked by the reader.
+ *
+ * \retval 0 on success
+ * \retval 1 on EOF
+ * \retval negative errno on failure
+ */
+static int chlg_recv_into(struct changelog_private *cp,
+			  struct changelog_rec *rec)
 {
-	struct changelog_private *cp = priv;
 	enum changelog_rec_flags rec_fmt = DEFAULT_RECORD_FMT;
 	enum changelog_rec_extra_flags rec_extra_fmt = CLFE_INVALID;
 	struct changelog_rec *tmp;
-	int rc = 0;
-
-	if (!cp || (cp->clp_magic != CHANGELOG_PRIV_MAGIC))
-		return -EINVAL;
-
-	if (rech == NULL)
-		return -EINVAL;
-
-	*rech = malloc(CR_MAXSIZE);
-	if (*rech == NULL)
-		return -ENOMEM;
 
 	if (cp->clp_send_flags & CHANGELOG_FLAG_JOBID)
 		rec_fmt |= CLF_JOBID;
@@ -260,30 +257,82 @@ int llapi_changelog_recv(void *priv, struct changelog_rec **rech)
 		ssize_t refresh;
 
 		refresh = chlg_read_bulk(cp);
-		if (refresh == 0) {
+		if (refresh == 0)
 			/* EOF, CHANGELOG_FLAG_FOLLOW ignored for now LU-7659 */
-			rc = 1;
-			goto out_free;
-		} else if (refresh < 0) {
-			rc = refresh;
-			goto out_free;
-		}
+			return 1;
+		else if (refresh < 0)
+			return refresh;
 	}
 
 	/* TODO check changelog_rec_size */
 	tmp = (struct changelog_rec *)cp->clp_buf_pos;
 
-	memcpy(*rech, cp->clp_buf_pos,
-	       changelog_rec_size(tmp) + tmp->cr_namelen);
+	memcpy(rec, cp->clp_buf_pos, changelog_rec_size(tmp) + tmp->cr_namelen);
 
 	cp->clp_buf_pos += changelog_rec_size(tmp) + tmp->cr_namelen;
-	changelog_remap_rec(*rech, rec_fmt, rec_extra_fmt);
+	changelog_remap_rec(rec, rec_fmt, rec_extra_fmt);
 
 	return 0;
+}
+
+/** Read the next changelog entry
+ * @param priv Opaque private control structure
+ * @param rech Changelog record handle; record will be allocated here
+ * @return 0 valid message received; rec is set
+ *	 <0 error code
+ *	 1 EOF
+ */
+int llapi_changelog_recv(void *priv, struct changelog_rec **rech)
+{
+	struct changelog_private *cp = priv;
+	int rc;
+
+	if (!cp || (cp->clp_magic != CHANGELOG_PRIV_MAGIC))
+		return -EINVAL;
+
+	if (rech == NULL)
+		return -EINVAL;
+
+	*rech = malloc(CR_MAXSIZE);
+	if (*rech == NULL)
+		return -ENOMEM;
+
+	rc = chlg_recv_into(cp, *rech);
+	if (rc != 0) {
+		free(*rech);
+		*rech = NULL;
+	}
+
+	return rc;
+}
+
+/**
+ * Read the next changelog entry, without allocating it.
+ *
+ * The record is stored in the reader structure, and remains valid until the
+ * next call or until llapi_changelog_fini(). It must not be passed to
+ * llapi_changelog_free().
+ *
+ * @param priv Opaque private control structure
+ * @param rech Set to the record on success
+ * @return 0 valid message received; rec is set
+ *	 <0 error code
+ *	 1 EOF
+ */
+int llapi_changelog_recv_next(void *priv, struct changelog_rec **rech)
+{
+	struct changelog_private *cp = priv;
+	int rc;
+
+	if (!cp || (cp->clp_magic != CHANGELOG_PRIV_MAGIC))
+		return -EINVAL;
+
+	if (rech == NULL)
+		return -EINVAL;
+
+	rc = chlg_recv_into(cp, cp->clp_rec);
+	*rech = rc == 0 ? cp->clp_rec : NULL;
 
-out_free:
-	free(*rech);
-	*rech = NULL;
 	return rc;
 }
 
@@ -380,3 +429,40 @@ int llapi_changelog_set_xflags(void *priv,
 
 	return 0;
 }
+
+/**
+ * Only deliver the records matching a filter.
+ *
+ * Records are filtered by the kernel before they are copied to userspace.
+ * Just call this function right after llapi_changelog_start().
+ *
+ * @param priv		Opaque private control structure
+ * @param type_mask	Mask of the wanted record types (1 << CL_*), 0 for all
+ * @param jobid		Only deliver records with this jobid, NULL for all
+ *
+ * @return 0 on success, negated errno on failure.
+ */
+int llapi_changelog_set_filter(void *priv, __u64 type_mask, const char *jobid)
+{
+	struct changelog_private *cp = priv;
+	struct changelog_filter filter = { .cf_type_mask = type_mask };
+	int rc;
+
+	if (!cp || cp->clp_magic != CHANGELOG_PRIV_MAGIC)
+		return -EINVAL;
+
+	if (jobid != NULL) {
+		if (strlen(jobid) >= sizeof(filter.cf_jobid))
+			return -ENAMETOOLONG;
+		strncpy(filter.cf_jobid, jobid, sizeof(filter.cf_jobid));
+	}
+
+	rc = ioctl(cp->clp_fd, OBD_IOC_CHLG_FILTER, &filter);
+	if (rc < 0) {
+		rc = -errno;
+		llapi_error(LLAPI_MSG_ERROR, rc,
+			    "cannot set changelog filter");
+	}
+
+	return rc;
+}
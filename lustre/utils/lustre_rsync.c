@@ -118,17 +118,24 @@
 #include <limits.h>
 #include <utime.h>
 #include <time.h>
+#include <pthread.h>
+#include <sys/syscall.h>
 #include <sys/xattr.h>
 #include <linux/types.h>
 
 #include <libcfs/util/string.h>
 #include <lustre/lustreapi.h>
+#include <linux/lustre/lustre_fid.h>
 #include "lustre_rsync.h"
 #include "callvpe.h"
 
 #define REPLICATE_STATUS_VER 1
 #define CLEAR_INTERVAL 100
 #define DEFAULT_RSYNC_THRESHOLD 0xA00000 /* 10 MB */
+#define LR_COPY_BUFSIZE (1 << 20) /* 1 MB */
+/* Records queued or being replayed per replay thread */
+#define LR_REPLAY_WINDOW 4
+#define LR_MAX_THREADS 256
 
 #define TYPE_STR_LEN 16
 
@@ -169,6 +176,14 @@ struct lr_info {
         size_t xsize;
         char *xvalue;
         size_t xvsize;
+
+	/* Variables for the parallel replay, see lr_replay_queue() */
+	struct lr_info *next;
+	struct lu_fid lu_tfid;
+	struct lu_fid lu_pfid;
+	time_t rec_time;
+	unsigned int running:1,
+		     done:1;
 };
 
 struct lr_parent_child_list {
@@ -191,6 +206,12 @@ long long rsync_threshold = DEFAULT_RSYNC_THRESHOLD;
 int quit;       /* Flag to stop processing the changelog; set on the
                    receipt of a signal */
 int abort_on_err = 0;
+int replay_threads = 1; /* Threads replaying the changelog records */
+/* Records replayed, and time of the last one, for the status log */
+long long replay_count;
+time_t replay_time;
+/* Protects parents, which lr_create() changes from the replay threads */
+pthread_mutex_t parents_lock = PTHREAD_MUTEX_INITIALIZER;
 
 char rsync[PATH_MAX + 128];
 char rsync_ver[PATH_MAX * 2];
@@ -204,6 +225,7 @@ struct option long_opts[] = {
 	{ .val = 'm',	.name = "mdt",		.has_arg = required_argument },
 	{ .val = 's',	.name = "source",	.has_arg = required_argument },
 	{ .val = 't',	.name = "target",	.has_arg = required_argument },
+	{ .val = 'T',	.name = "threads",	.has_arg = required_argument },
 	{ .val = 'u',	.name = "user",		.has_arg = required_argument },
 	{ .val = 'v',	.name = "verbose",	.has_arg = no_argument },
 	{ .val = 'x',	.name = "xattr",	.has_arg = required_argument },
@@ -229,6 +251,7 @@ void lr_usage()
                 "\tlustre_rsync -l <log_file>\n"
                 "options:\n"
                 "\t--xattr <yes|no> replicate EAs\n"
+		"\t--threads <n>    replay independent records with n threads\n"
                 "\t--abort-on-err   abort at first err\n"
                 "\t--verbose\n"
                 "\t--dry-run        don't write anything\n");
@@ -336,6 +359,28 @@ int lr_rsync_data(struct lr_info *info)
         return rc;
 }
 
+/* Copy the data in the kernel, without going through a user buffer.
+ * Returns -EXDEV, -ENOSYS, -EINVAL, or -EOPNOTSUPP if this cannot be done
+ * for these files, the offsets of both files are then where the copy
+ * should resume from. */
+static int lr_copy_range(int fd_src, int fd_dest)
+{
+#ifdef __NR_copy_file_range
+	ssize_t rc;
+
+	while (1) {
+		rc = syscall(__NR_copy_file_range, fd_src, NULL, fd_dest, NULL,
+			     LR_COPY_BUFSIZE, 0);
+		if (rc == 0)
+			return 0;
+		if (rc < 0)
+			return -errno;
+	}
+#else
+	return -ENOSYS;
+#endif
+}
+
 int lr_copy_data(struct lr_info *info)
 {
         int fd_src = -1;
@@ -371,7 +416,17 @@ int lr_copy_data(struct lr_info *info)
                 rc = -errno;
                 goto out;
         }
-        bufsize = st_dest.st_blksize;
+
+	rc = lr_copy_range(fd_src, fd_dest);
+	if (rc != -EXDEV && rc != -ENOSYS && rc != -EINVAL &&
+	    rc != -EOPNOTSUPP)
+		goto out_sync;
+	rc = 0;
+
+	/* Copy with large reads and writes, of at least a block */
+	bufsize = st_dest.st_blksize;
+	if (bufsize < LR_COPY_BUFSIZE)
+		bufsize = LR_COPY_BUFSIZE;
 
         if (info->bufsize < bufsize) {
                 /* Grow buffer */
@@ -406,7 +461,10 @@ int lr_copy_data(struct lr_info *info)
 			rsize -= wsize;
 			buf += wsize;
 		} while (rsize > 0);
+		if (rc)
+			break;
 	}
+out_sync:
 	fsync(fd_dest);
 
 out:
@@ -655,8 +713,10 @@ int lr_add_pc(const char *pfid, const char *tfid, const char *name)
 	if (len >= sizeof(p->pc_log.pcl_name))
 		goto out_err;
 
+	pthread_mutex_lock(&parents_lock);
 	p->pc_next = parents;
 	parents = p;
+	pthread_mutex_unlock(&parents_lock);
 	return 0;
 
 out_err:
@@ -1197,6 +1257,9 @@ int lr_parse_line(void *priv, struct lr_info *info)
 	info->is_extended = !!(rec->cr_flags & CLF_RENAME);
 	info->recno = rec->cr_index;
 	info->type = rec->cr_type;
+	info->rec_time = rec->cr_time >> 30;
+	info->lu_tfid = rec->cr_tfid;
+	info->lu_pfid = rec->cr_pfid;
 	snprintf(info->tfid, sizeof(info->tfid), DFID, PFID(&rec->cr_tfid));
 	snprintf(info->pfid, sizeof(info->pfid), DFID, PFID(&rec->cr_pfid));
 
@@ -1234,10 +1297,18 @@ int lr_parse_line(void *priv, struct lr_info *info)
         return 0;
 }
 
+/* Size of the replication parameters, for num_targets targets */
+static size_t lr_status_size(int num_targets)
+{
+	return sizeof(struct lustre_rsync_status) +
+	       num_targets * (PATH_MAX + 1) +
+	       sizeof(struct lustre_rsync_progress);
+}
+
 /* Initialize the replication parameters */
 int lr_init_status()
 {
-        size_t size = sizeof(struct lustre_rsync_status) + PATH_MAX + 1;
+	size_t size = lr_status_size(1);
 
         if (status != NULL)
                 return 0;
@@ -1271,11 +1342,28 @@ int lr_write_log()
         size_t size;
         size_t write_size = status->ls_size;
         struct lr_parent_child_list *curr;
+	struct lustre_rsync_progress lp = { 0 };
         int rc = 0;
 
         if (statuslog == NULL)
                 return 0;
 
+	/* The progress follows the targets, see lr_status_size() */
+	if (write_size >= lr_status_size(status->ls_num_targets)) {
+		lp.lp_checkpoint_time = time(NULL);
+		lp.lp_record_time = replay_time;
+		lp.lp_records = replay_count;
+		lp.lp_errors = errors;
+		lp.lp_threads = replay_threads;
+		/* ls_targets[] doesn't keep the progress aligned */
+		memcpy(status->ls_targets[status->ls_num_targets], &lp,
+		       sizeof(lp));
+		lr_debug(DINFO, "checkpoint at %lld, %lld records, lag %llds\n",
+			 (long long)status->ls_last_recno, replay_count,
+			 replay_time == 0 ? 0LL :
+			 (long long)(lp.lp_checkpoint_time - replay_time));
+	}
+
         lr_backup_log();
 
         fd = open(statuslog, O_WRONLY | O_CREAT | O_SYNC,
@@ -1294,6 +1382,7 @@ int lr_write_log()
                 return -1;
         }
 
+	pthread_mutex_lock(&parents_lock);
         for (curr = parents; curr; curr = curr->pc_next) {
                 size = write(fd, &curr->pc_log, sizeof(curr->pc_log));
                 if (size != sizeof(curr->pc_log)) {
@@ -1303,6 +1392,7 @@ int lr_write_log()
                         break;
                 }
         }
+	pthread_mutex_unlock(&parents_lock);
         close(fd);
         return rc;
 }
@@ -1419,13 +1509,16 @@ int lr_read_log()
 }
 
 /* Clear changelogs every CLEAR_INTERVAL records or at the end of
-   processing. */
-int lr_clear_cl(struct lr_info *info, int force)
+   processing. All the records up to recno must have been replayed. */
+int lr_clear_cl(long long recno, int force)
 {
 	char		mdt_device[LR_NAME_MAXLEN + 1];
 	int		rc = 0;
 
-        if (force || info->recno > status->ls_last_recno + CLEAR_INTERVAL) {
+	if (recno < 0)
+		return 0;
+
+        if (force || recno > status->ls_last_recno + CLEAR_INTERVAL) {
                 if (!noclear && !dryrun) {
                         /* llapi_changelog_clear modifies the mdt
                          * device name so make a copy of it until this
@@ -1435,16 +1528,16 @@ int lr_clear_cl(struct lr_info *info, int force)
 				 status->ls_mdt_device);
                         rc = llapi_changelog_clear(mdt_device,
                                                    status->ls_registration,
-						   info->recno);
+						   recno);
                         if (rc)
 				printf("Changelog clear (%s, %s, %lld) "
 				       "returned %d\n", status->ls_mdt_device,
-				       status->ls_registration, info->recno,
+				       status->ls_registration, recno,
 				       rc);
 		}
 
 		if (!rc && !dryrun) {
-			status->ls_last_recno = info->recno;
+			status->ls_last_recno = recno;
 			lr_write_log();
 		}
 	}
@@ -1518,6 +1611,8 @@ void lr_print_status(struct lr_info *info)
                 printf("Clear changelog after use: no\n");
         if (use_rsync)
                 printf("Using rsync: %s (%s)\n", rsync, rsync_ver);
+	if (replay_threads > 1)
+		printf("Replay threads: %d\n", replay_threads);
 }
 
 void lr_print_failure(struct lr_info *info, int rc)
@@ -1528,12 +1623,275 @@ void lr_print_failure(struct lr_info *info, int rc)
                 info->pfid, info->name);
 }
 
+/* Replay one changelog record on all the targets */
+int lr_replay(struct lr_info *info)
+{
+	int rc = 0;
+
+	lr_debug(DTRACE, "***** Start %lld %s (%d) %s %s %s *****\n",
+		 info->recno, changelog_type2str(info->type),
+		 info->type, info->tfid, info->pfid, info->name);
+
+	switch (info->type) {
+	case CL_CREATE:
+	case CL_MKDIR:
+	case CL_MKNOD:
+	case CL_SOFTLINK:
+		rc = lr_create(info);
+		break;
+	case CL_RMDIR:
+	case CL_UNLINK:
+		rc = lr_remove(info);
+		break;
+	case CL_RENAME:
+		rc = lr_move(info);
+		break;
+	case CL_HARDLINK:
+		rc = lr_link(info);
+		break;
+	case CL_TRUNC:
+	case CL_SETATTR:
+		rc = lr_setattr(info);
+		break;
+	case CL_SETXATTR:
+		rc = lr_setxattr(info);
+		break;
+	case CL_CLOSE:
+	case CL_EXT:
+	case CL_OPEN:
+	case CL_GETXATTR:
+	case CL_DN_OPEN:
+	case CL_LAYOUT:
+	case CL_MARK:
+		/* Nothing needs to be done for these entries */
+		/* fallthrough */
+	default:
+		break;
+	}
+
+	lr_debug(DTRACE, "##### End %lld %s (%d) %s %s %s rc=%d #####\n",
+		 info->recno, changelog_type2str(info->type),
+		 info->type, info->tfid, info->pfid, info->name, rc);
+
+	return rc;
+}
+
+/*
+ * Parallel replay of the changelog records.
+ *
+ * The records are queued in changelog order, and a replay thread picks
+ * the oldest record which doesn't share its target or parent FID with an
+ * older record still queued or being replayed, so the operations on a
+ * file or in a directory are replayed in order. Renames and directory
+ * removals change the paths of whole subtrees, and renames also move the
+ * files kept in SPECIAL_DIR, so they are replayed alone, once all the
+ * older records are done.
+ *
+ * The changelog is cleared, and the status log written, up to the last
+ * record replayed with all the older ones.
+ */
+struct lr_replay_queue {
+	pthread_mutex_t		 lrq_lock;
+	pthread_cond_t		 lrq_cond;
+	/* Records queued or being replayed, in changelog order */
+	struct lr_info		*lrq_head;
+	struct lr_info		*lrq_tail;
+	int			 lrq_count;
+	/* Unused records, with their buffers */
+	struct lr_info		*lrq_free;
+	/* Last record replayed with all the older ones */
+	long long		 lrq_done_recno;
+	int			 lrq_stop;
+};
+
+static struct lr_replay_queue lrq = {
+	.lrq_lock = PTHREAD_MUTEX_INITIALIZER,
+	.lrq_cond = PTHREAD_COND_INITIALIZER,
+	.lrq_done_recno = -1,
+};
+
+static bool lr_fid_conflict(const struct lu_fid *fid, struct lr_info *info)
+{
+	return !fid_is_zero(fid) && (lu_fid_eq(fid, &info->lu_tfid) ||
+				     lu_fid_eq(fid, &info->lu_pfid));
+}
+
+/* Must the record wait for the older ones? Called with lrq_lock held */
+static bool lr_replay_blocked(struct lr_info *info)
+{
+	struct lr_info *older;
+
+	for (older = lrq.lrq_head; older != info; older = older->next) {
+		if (older->done)
+			continue;
+		if (lr_fid_conflict(&info->lu_tfid, older) ||
+		    lr_fid_conflict(&info->lu_pfid, older))
+			return true;
+	}
+
+	return false;
+}
+
+static void *lr_replay_thread(void *arg)
+{
+	struct lr_info *info;
+	int rc;
+
+	pthread_mutex_lock(&lrq.lrq_lock);
+	while (1) {
+		for (info = lrq.lrq_head; info != NULL; info = info->next) {
+			if (!info->running && !info->done &&
+			    !lr_replay_blocked(info))
+				break;
+		}
+		if (info == NULL) {
+			if (lrq.lrq_stop && lrq.lrq_head == NULL)
+				break;
+			pthread_cond_wait(&lrq.lrq_cond, &lrq.lrq_lock);
+			continue;
+		}
+
+		info->running = 1;
+		pthread_mutex_unlock(&lrq.lrq_lock);
+
+		rc = lr_replay(info);
+
+		pthread_mutex_lock(&lrq.lrq_lock);
+		info->running = 0;
+		info->done = 1;
+		if (rc && rc != -ENOENT) {
+			lr_print_failure(info, rc);
+			errors++;
+			if (abort_on_err)
+				quit = 1;
+		}
+
+		/* Retire the records replayed with all the older ones */
+		while (lrq.lrq_head != NULL && lrq.lrq_head->done) {
+			info = lrq.lrq_head;
+			lrq.lrq_head = info->next;
+			if (lrq.lrq_head == NULL)
+				lrq.lrq_tail = NULL;
+			lrq.lrq_count--;
+			lrq.lrq_done_recno = info->recno;
+			replay_time = info->rec_time;
+			replay_count++;
+			info->next = lrq.lrq_free;
+			lrq.lrq_free = info;
+		}
+		pthread_cond_broadcast(&lrq.lrq_cond);
+	}
+	pthread_mutex_unlock(&lrq.lrq_lock);
+
+	return NULL;
+}
+
+/* Hand a record over to the replay threads, and return an unused one */
+static struct lr_info *lr_replay_queue(struct lr_info *info)
+{
+	struct lr_info *next;
+
+	info->next = NULL;
+	info->running = 0;
+	info->done = 0;
+
+	pthread_mutex_lock(&lrq.lrq_lock);
+	if (lrq.lrq_tail != NULL)
+		lrq.lrq_tail->next = info;
+	else
+		lrq.lrq_head = info;
+	lrq.lrq_tail = info;
+	lrq.lrq_count++;
+	pthread_cond_broadcast(&lrq.lrq_cond);
+
+	while (lrq.lrq_free == NULL &&
+	       lrq.lrq_count >= replay_threads * LR_REPLAY_WINDOW)
+		pthread_cond_wait(&lrq.lrq_cond, &lrq.lrq_lock);
+
+	next = lrq.lrq_free;
+	if (next != NULL)
+		lrq.lrq_free = next->next;
+	pthread_mutex_unlock(&lrq.lrq_lock);
+
+	if (next == NULL)
+		next = calloc(1, sizeof(*next));
+
+	return next;
+}
+
+/* Wait until all the queued records are replayed */
+static long long lr_replay_wait(void)
+{
+	long long recno;
+
+	pthread_mutex_lock(&lrq.lrq_lock);
+	while (lrq.lrq_head != NULL)
+		pthread_cond_wait(&lrq.lrq_cond, &lrq.lrq_lock);
+	recno = lrq.lrq_done_recno;
+	pthread_mutex_unlock(&lrq.lrq_lock);
+
+	return recno;
+}
+
+static long long lr_replay_done_recno(void)
+{
+	long long recno;
+
+	pthread_mutex_lock(&lrq.lrq_lock);
+	recno = lrq.lrq_done_recno;
+	pthread_mutex_unlock(&lrq.lrq_lock);
+
+	return recno;
+}
+
+static int lr_replay_start(pthread_t *threads)
+{
+	int i;
+	int rc;
+
+	for (i = 0; i < replay_threads; i++) {
+		rc = pthread_create(&threads[i], NULL, lr_replay_thread, NULL);
+		if (rc) {
+			fprintf(stderr, "Error starting replay thread: %s\n",
+				strerror(rc));
+			/* Go on with the threads started */
+			if (i == 0)
+				return -rc;
+			replay_threads = i;
+			break;
+		}
+	}
+
+	return 0;
+}
+
+static void lr_replay_stop(pthread_t *threads)
+{
+	struct lr_info *info;
+	int i;
+
+	pthread_mutex_lock(&lrq.lrq_lock);
+	lrq.lrq_stop = 1;
+	pthread_cond_broadcast(&lrq.lrq_cond);
+	pthread_mutex_unlock(&lrq.lrq_lock);
+
+	for (i = 0; i < replay_threads; i++)
+		pthread_join(threads[i], NULL);
+
+	while ((info = lrq.lrq_free) != NULL) {
+		lrq.lrq_free = info->next;
+		free(info);
+	}
+}
+
 /* Replicate filesystem operations from src_path to target_path */
 int lr_replicate()
 {
         void *changelog_priv;
         struct lr_info *info;
 	struct lr_info *ext = NULL;
+	pthread_t *threads = NULL;
+	long long done_recno = -1;
         time_t start;
         int xattr_not_supp;
         int i;
@@ -1593,6 +1951,14 @@ int lr_replicate()
 
         lr_print_status(info);
 
+	if (replay_threads > 1) {
+		threads = calloc(replay_threads, sizeof(*threads));
+		if (threads == NULL) {
+			rc = -ENOMEM;
+			goto out;
+		}
+	}
+
 	/* Open changelogs for consumption*/
 	rc = llapi_changelog_start(&changelog_priv,
 				CHANGELOG_FLAG_BLOCK |
@@ -1616,6 +1982,14 @@ int lr_replicate()
 		goto out;
 	}
 
+	if (threads != NULL) {
+		rc = lr_replay_start(threads);
+		if (rc < 0) {
+			llapi_changelog_fini(&changelog_priv);
+			goto out;
+		}
+	}
+
         while (!quit && lr_parse_line(changelog_priv, info) == 0) {
                 rc = 0;
 		if (info->type == CL_RENAME && !info->is_extended) {
@@ -1640,67 +2014,49 @@ int lr_replicate()
                 if (dryrun)
                         continue;
 
-		lr_debug(DTRACE, "***** Start %lld %s (%d) %s %s %s *****\n",
-			 info->recno, changelog_type2str(info->type),
-			 info->type, info->tfid, info->pfid, info->name);
-
-                switch(info->type) {
-                case CL_CREATE:
-                case CL_MKDIR:
-                case CL_MKNOD:
-                case CL_SOFTLINK:
-                        rc = lr_create(info);
-                        break;
-                case CL_RMDIR:
-                case CL_UNLINK:
-                        rc = lr_remove(info);
-                        break;
-                case CL_RENAME:
-			rc = lr_move(info);
-                        break;
-                case CL_HARDLINK:
-                        rc = lr_link(info);
-                        break;
-                case CL_TRUNC:
-                case CL_SETATTR:
-                        rc = lr_setattr(info);
-                        break;
-		case CL_SETXATTR:
-                        rc = lr_setxattr(info);
-                        break;
-		case CL_CLOSE:
-		case CL_EXT:
-		case CL_OPEN:
-		case CL_GETXATTR:
-		case CL_DN_OPEN:
-		case CL_LAYOUT:
-		case CL_MARK:
-			/* Nothing needs to be done for these entries */
-			/* fallthrough */
-		default:
-			break;
+		if (threads != NULL && info->type != CL_RENAME &&
+		    info->type != CL_RMDIR) {
+			info = lr_replay_queue(info);
+			if (info == NULL) {
+				rc = -ENOMEM;
+				break;
+			}
+			lr_clear_cl(lr_replay_done_recno(), 0);
+			continue;
 		}
 
-		lr_debug(DTRACE, "##### End %lld %s (%d) %s %s %s rc=%d #####\n",
-			 info->recno, changelog_type2str(info->type),
-			 info->type, info->tfid, info->pfid, info->name, rc);
+		/* Records changing a subtree are replayed alone */
+		if (threads != NULL)
+			lr_replay_wait();
 
+		rc = lr_replay(info);
                 if (rc && rc != -ENOENT) {
                         lr_print_failure(info, rc);
                         errors++;
                         if (abort_on_err)
                                 break;
                 }
-                lr_clear_cl(info, 0);
+		done_recno = info->recno;
+		replay_time = info->rec_time;
+		replay_count++;
+		lr_clear_cl(done_recno, 0);
         }
 
+	if (threads != NULL) {
+		long long recno = lr_replay_wait();
+
+		if (recno > done_recno)
+			done_recno = recno;
+		lr_replay_stop(threads);
+	}
+
         llapi_changelog_fini(&changelog_priv);
 
         if (errors || verbose)
                 printf("Errors: %d\n", errors);
 
         /* Clear changelog records used so far */
-        lr_clear_cl(info, 1);
+	lr_clear_cl(done_recno, 1);
 
         if (verbose) {
                 printf("lustre_rsync took %ld seconds\n", time(NULL) - start);
@@ -1714,6 +2070,8 @@ out:
 		free(info);
 	if (ext != NULL)
 		free(ext);
+	if (threads != NULL)
+		free(threads);
 
 	return rc;
 }
@@ -1735,7 +2093,7 @@ int main(int argc, char *argv[])
         if ((rc = lr_init_status()) != 0)
                 return rc;
 
-	while ((rc = getopt_long(argc, argv, "as:t:m:u:l:vx:zc:ry:n:d:D:",
+	while ((rc = getopt_long(argc, argv, "as:t:T:m:u:l:vx:zc:ry:n:d:D:",
 				 long_opts, NULL)) >= 0) {
                 switch (rc) {
                 case 'a':
@@ -1758,8 +2116,7 @@ int main(int argc, char *argv[])
                                    ignored. */
                                 status->ls_num_targets = numtargets;
                         }
-                        newsize = sizeof (struct lustre_rsync_status) +
-                                (status->ls_num_targets * (PATH_MAX + 1));
+			newsize = lr_status_size(status->ls_num_targets);
                         if (status->ls_size != newsize) {
                                 status->ls_size = newsize;
                                 status = lr_grow_buf(status, newsize);
@@ -1769,6 +2126,16 @@ int main(int argc, char *argv[])
 			snprintf(status->ls_targets[status->ls_num_targets - 1],
 				 sizeof(status->ls_targets[0]), "%s", optarg);
 			break;
+		case 'T':
+			replay_threads = atoi(optarg);
+			if (replay_threads < 1 ||
+			    replay_threads > LR_MAX_THREADS) {
+				printf("Invalid parameter %s. Specify "
+				       "--threads between 1 and %d\n",
+				       optarg, LR_MAX_THREADS);
+				return -1;
+			}
+			break;
 		case 'm':
 			snprintf(status->ls_mdt_device,
 				 sizeof(status->ls_mdt_device),
@@ -1867,6 +2234,15 @@ int main(int argc, char *argv[])
                 return -1;
         }
 
+	/* Make room for the progress in a status log from an older version */
+	newsize = lr_status_size(status->ls_num_targets);
+	if (status->ls_size < newsize) {
+		status = lr_grow_buf(status, newsize);
+		if (status == NULL)
+			return -ENOMEM;
+		status->ls_size = newsize;
+	}
+
         rc = lr_locate_rsync();
         if (use_rsync && rc != 0) {
                 fprintf(stderr, "Error: unable to locate %s.\n", RSYNC);
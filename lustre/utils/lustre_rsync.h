@@ -53,6 +53,17 @@ struct lustre_rsync_status {
         char    ls_targets[0][PATH_MAX + 1]; /* Target FS path */
 };
 
+/* Progress of the replication, saved after the targets in the status log
+ * and counted in ls_size, so that older versions of lustre_rsync skip it. */
+struct lustre_rsync_progress {
+	__u64	lp_checkpoint_time;   /* Time of this checkpoint */
+	__u64	lp_record_time;       /* Time of the last replicated record */
+	__u64	lp_records;           /* Records replicated by this run */
+	__u64	lp_errors;            /* Records which failed in this run */
+	__u32	lp_threads;           /* Replay threads */
+	__u32	lp_padding;
+};
+
 struct lr_parent_child_log {
         char pcl_pfid[LR_FID_STR_LEN];
         char pcl_tfid[LR_FID_STR_LEN];
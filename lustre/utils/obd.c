@@ -1932,7 +1932,7 @@ int jt_obd_test_getattr(int argc, char **argv)
         <q|v|#(print interval)>                                 verbosity
         <npages[+offset]>                                       blocksize
         <[[<interleave_threads>]t(inc obj by thread#)]obj>      object
-        [p|g<args>]                                             batch */
+        [p|g<args>|c]                                           batch */
 int jt_obd_test_brw(int argc, char **argv)
 {
         struct obd_ioctl_data data;
@@ -1947,6 +1947,7 @@ int jt_obd_test_brw(int argc, char **argv)
         int  nthr_per_obj = 0;
         int  verify = 1;
         int  obj_idx = 0;
+	int  pagebench = 0;
         char *end;
 
         if (argc < 2 || argc > 7) {
@@ -2049,9 +2050,14 @@ int jt_obd_test_brw(int argc, char **argv)
                                 data.ioc_plen1 = strtoull(argv[6] + 1, &end,
                                                           0);
                                 break;
+			case 'c': /* client pages setup only, no I/O */
+				data.ioc_u32_1 |= OBD_BRW_IOC_NOIO;
+				end = argv[6] + 1;
+				pagebench = 1;
+				break;
                         default:
                                 fprintf(stderr, "error: %s: batching '%s' "
-                                        "needs to specify 'p' or 'g'\n",
+					"needs to specify 'p', 'g' or 'c'\n",
                                         jt_cmdname(argv[0]), argv[6]);
                                 return CMD_HELP;
                 }
@@ -2178,6 +2184,9 @@ int jt_obd_test_brw(int argc, char **argv)
                                ((double)i * pages * getpagesize()) /
                                (diff * 1048576.0),
                                ctime(&end.tv_sec));
+		if (verbose != 0 && pagebench && i > 0)
+			printf("%s: %.0f ns per page\n", jt_cmdname(argv[0]),
+			       diff * 1000000000.0 / ((double)i * pages));
         }
 
 #ifdef MAX_THREADS
@@ -613,6 +613,8 @@ check_obd_connect_data(void)
 	CHECK_DEFINE_64X(OBD_CONNECT2_PCC);
 	CHECK_DEFINE_64X(OBD_CONNECT2_ASYNC_DISCARD);
 	CHECK_DEFINE_64X(OBD_CONNECT2_ENCRYPT);
+	CHECK_DEFINE_64X(OBD_CONNECT2_BATCH_BL_AST);
+	CHECK_DEFINE_64X(OBD_CONNECT2_BATCH_GLIMPSE);
 
 	CHECK_VALUE_X(OBD_CKSUM_CRC32);
 	CHECK_VALUE_X(OBD_CKSUM_ADLER);
@@ -1565,6 +1567,18 @@ check_ldlm_ost_lvb(void)
 	CHECK_MEMBER(ost_lvb, lvb_padding);
 }
 
+static void
+check_ost_glimpse_rec(void)
+{
+	BLANK_LINE();
+	CHECK_STRUCT(ost_glimpse_rec);
+	CHECK_MEMBER(ost_glimpse_rec, ogr_oi);
+	CHECK_MEMBER(ost_glimpse_rec, ogr_handle);
+	CHECK_MEMBER(ost_glimpse_rec, ogr_rc);
+	CHECK_MEMBER(ost_glimpse_rec, ogr_padding);
+	CHECK_MEMBER(ost_glimpse_rec, ogr_lvb);
+}
+
 static void
 check_ldlm_lquota_lvb(void)
 {
@@ -2642,6 +2656,7 @@ main(int argc, char **argv)
 	CHECK_VALUE(OST_QUOTACTL);
 	CHECK_VALUE(OST_QUOTA_ADJUST_QUNIT);
 	CHECK_VALUE(OST_LADVISE);
+	CHECK_VALUE(OST_BATCH_GLIMPSE);
 	CHECK_VALUE(OST_LAST_OPC);
 
 	CHECK_DEFINE_64X(OBD_OBJECT_EOF);
@@ -2889,6 +2904,7 @@ main(int argc, char **argv)
 	check_ldlm_reply();
 	check_ldlm_ost_lvb_v1();
 	check_ldlm_ost_lvb();
+	check_ost_glimpse_rec();
 	check_ldlm_lquota_lvb();
 	check_ldlm_gl_lquota_desc();
 	check_ldlm_gl_barrier_desc();
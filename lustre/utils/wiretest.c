@@ -124,7 +124,9 @@ void lustre_assert_wire_constants(void)
 		 (long long)OST_QUOTA_ADJUST_QUNIT);
 	LASSERTF(OST_LADVISE == 21, "found %lld\n",
 		 (long long)OST_LADVISE);
-	LASSERTF(OST_LAST_OPC == 22, "found %lld\n",
+	LASSERTF(OST_BATCH_GLIMPSE == 31, "found %lld\n",
+		 (long long)OST_BATCH_GLIMPSE);
+	LASSERTF(OST_LAST_OPC == 32, "found %lld\n",
 		 (long long)OST_LAST_OPC);
 	LASSERTF(OBD_OBJECT_EOF == 0xffffffffffffffffULL, "found 0x%.16llxULL\n",
 		 OBD_OBJECT_EOF);
@@ -1376,6 +1378,10 @@ void lustre_assert_wire_constants(void)
 		 OBD_CONNECT2_ASYNC_DISCARD);
 	LASSERTF(OBD_CONNECT2_ENCRYPT == 0x8000ULL, "found 0x%.16llxULL\n",
 		 OBD_CONNECT2_ENCRYPT);
+	LASSERTF(OBD_CONNECT2_BATCH_BL_AST == 0x8000000000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_BATCH_BL_AST);
+	LASSERTF(OBD_CONNECT2_BATCH_GLIMPSE == 0x4000000000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT2_BATCH_GLIMPSE);
 	LASSERTF(OBD_CKSUM_CRC32 == 0x00000001UL, "found 0x%.8xUL\n",
 		(unsigned)OBD_CKSUM_CRC32);
 	LASSERTF(OBD_CKSUM_ADLER == 0x00000002UL, "found 0x%.8xUL\n",
@@ -3680,6 +3686,30 @@ void lustre_assert_wire_constants(void)
 	LASSERTF((int)sizeof(((struct ost_lvb *)0)->lvb_padding) == 4, "found %lld\n",
 		 (long long)(int)sizeof(((struct ost_lvb *)0)->lvb_padding));
 
+	/* Checks for struct ost_glimpse_rec */
+	LASSERTF((int)sizeof(struct ost_glimpse_rec) == 88, "found %lld\n",
+		 (long long)(int)sizeof(struct ost_glimpse_rec));
+	LASSERTF((int)offsetof(struct ost_glimpse_rec, ogr_oi) == 0, "found %lld\n",
+		 (long long)(int)offsetof(struct ost_glimpse_rec, ogr_oi));
+	LASSERTF((int)sizeof(((struct ost_glimpse_rec *)0)->ogr_oi) == 16, "found %lld\n",
+		 (long long)(int)sizeof(((struct ost_glimpse_rec *)0)->ogr_oi));
+	LASSERTF((int)offsetof(struct ost_glimpse_rec, ogr_handle) == 16, "found %lld\n",
+		 (long long)(int)offsetof(struct ost_glimpse_rec, ogr_handle));
+	LASSERTF((int)sizeof(((struct ost_glimpse_rec *)0)->ogr_handle) == 8, "found %lld\n",
+		 (long long)(int)sizeof(((struct ost_glimpse_rec *)0)->ogr_handle));
+	LASSERTF((int)offsetof(struct ost_glimpse_rec, ogr_rc) == 24, "found %lld\n",
+		 (long long)(int)offsetof(struct ost_glimpse_rec, ogr_rc));
+	LASSERTF((int)sizeof(((struct ost_glimpse_rec *)0)->ogr_rc) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct ost_glimpse_rec *)0)->ogr_rc));
+	LASSERTF((int)offsetof(struct ost_glimpse_rec, ogr_padding) == 28, "found %lld\n",
+		 (long long)(int)offsetof(struct ost_glimpse_rec, ogr_padding));
+	LASSERTF((int)sizeof(((struct ost_glimpse_rec *)0)->ogr_padding) == 4, "found %lld\n",
+		 (long long)(int)sizeof(((struct ost_glimpse_rec *)0)->ogr_padding));
+	LASSERTF((int)offsetof(struct ost_glimpse_rec, ogr_lvb) == 32, "found %lld\n",
+		 (long long)(int)offsetof(struct ost_glimpse_rec, ogr_lvb));
+	LASSERTF((int)sizeof(((struct ost_glimpse_rec *)0)->ogr_lvb) == 56, "found %lld\n",
+		 (long long)(int)sizeof(((struct ost_glimpse_rec *)0)->ogr_lvb));
+
 	/* Checks for struct lquota_lvb */
 	LASSERTF((int)sizeof(struct lquota_lvb) == 40, "found %lld\n",
 		 (long long)(int)sizeof(struct lquota_lvb));